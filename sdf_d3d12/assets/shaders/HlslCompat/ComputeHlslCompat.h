@@ -10,8 +10,8 @@ using namespace DirectX;
 #include "StructureHlslCompat.h"
 #include "HlslDefines.h"
 
-#define EDIT_DEPENDENCY_THREAD_COUNT 64
 #define AABB_BUILDING_THREADS 128
+#define BRICK_MERGING_THREADS 128
 
 
 enum SDFShape
@@ -50,9 +50,8 @@ struct SDFEditData
 	//				 First bit of operation is union/subtraction
 	//				 Second bit is hard/smooth
 	//			   - Material table index (max 4 materials - only 2 bits required)
-	// Third and Fourth byte - Dependencies (max 1023 dependencies - only 10 bits required)
-	// Dependencies are other shapes in the edit list that this shape depends on
-	// For smooth blending - the things that this shape will smooth blend into must not be culled
+	// Third and Fourth byte - Unused
+	// Dependencies between smooth edits are stored separately, see SDFEditDependencies
 	UINT EditParams;
 
 	float BlendingRange;
@@ -62,14 +61,6 @@ struct SDFEditData
 
 // Constant buffer types
 
-struct EditDependencyParameters
-{
-	UINT SDFEditCount;
-	// Can be computed from the SDF Edit Count:
-	// Max Dependencies = edits * (edits - 1) / 2
-	UINT DependencyPairsCount;
-};
-
 struct BrickEvaluationConstantBuffer
 {
 	// Object-space size of a brick
@@ -84,6 +75,12 @@ struct BrickEvaluationConstantBuffer
 	UINT BrickCount;
 
 	UINT SDFEditCount;
+
+	// If set, group i evaluates the brick in slot g_BrickSlots[i] instead of brick i
+	UINT UseBrickSlots;
+
+	// SDF_BRICK_POOL_PLACEMENT_*
+	UINT BrickPool_Placement;
 };
 
 
@@ -94,6 +91,32 @@ struct BrickBuildParametersConstantBuffer
 	float EvalSpaceSize;
 
 	UINT SDFEditCount;
+
+	// The number of indices that the index buffers can hold
+	UINT IndexCapacity;
+
+	// Only sub-bricks that overlap this region are built
+	XMFLOAT3 RegionMin;
+	XMFLOAT3 RegionMax;
+};
+
+
+struct IncrementalBakeConstantBuffer
+{
+	// The region of the object that is being rebuilt
+	XMFLOAT3 RegionMin;
+	float BrickSize;
+	XMFLOAT3 RegionMax;
+
+	// The number of bricks already in the object
+	UINT BrickCount;
+	// The number of bricks built for the region
+	UINT NewBrickCount;
+	// The number of brick slots that were released
+	UINT ReleasedBrickCount;
+
+	// Where the indices of the new bricks are placed in the object's index buffer
+	UINT IndexOffset;
 };
 
 
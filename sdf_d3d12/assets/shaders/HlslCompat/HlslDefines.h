@@ -8,4 +8,22 @@
 
 #define SDF_VOLUME_STRIDE 4
 
+// How the slots of a brick pool are placed in the brick pool texture
+// Linear placement fills the pool a row at a time, Morton placement keeps consecutive slots close together on every axis
+#define SDF_BRICK_POOL_PLACEMENT_LINEAR 0
+#define SDF_BRICK_POOL_PLACEMENT_MORTON 1
+
+// The maximum number of edits in an edit list
+// Edit testing keeps a two-level bitmask over every edit in groupshared memory,
+// where each of its 32 threads owns a whole number of summary words, so this must be a multiple of 32 * 32 * 32
+#define SDF_EDIT_LIMIT 65536
+
+// The index offset of a brick whose slot has been released by an incremental bake
+// Released bricks have no indices and an inactive AABB, and their slot can be reused by a later bake
+#define SDF_RELEASED_BRICK 0xFFFFFFFF
+
+// The pool slot of a brick of a paged object whose page is not resident in the brick pool
+// Rays pass through these bricks until their page is streamed in
+#define SDF_NON_RESIDENT_BRICK 0xFFFFFFFF
+
 #endif
\ No newline at end of file
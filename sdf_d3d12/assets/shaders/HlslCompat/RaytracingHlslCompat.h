@@ -136,6 +136,7 @@ struct BrickPropertiesConstantBuffer
 	float BrickSize;
 	XMFLOAT3 UVWPerVoxel;
 	UINT BrickCount;
+	UINT BrickPoolPlacement;	// SDF_BRICK_POOL_PLACEMENT_*
 };
 
 #endif
\ No newline at end of file
@@ -26,6 +26,8 @@ struct Brick
 	XMUINT2 SubBrickMask;		// A bit mask of sub-bricks
 	UINT IndexOffset;			// Offset into the index buffer for this bricks indices
 	UINT IndexCount;			// The number of indices this brick has
+	UINT PoolSlot;				// The brick pool slot that holds the voxels of this brick. Bricks with identical voxels may share a slot
+								// Incremental bakes release and rewrite the slots of the bricks they rebuild, so objects with shared slots are only fully baked
 };
 
 
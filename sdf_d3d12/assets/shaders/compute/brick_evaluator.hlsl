@@ -23,9 +23,11 @@ ConstantBuffer<EvalGroupOffset> g_EvalGroupOffset : register(b0);
 ConstantBuffer<BrickEvaluationConstantBuffer> g_BuildParameters : register(b1);
 
 StructuredBuffer<SDFEditData> g_EditList : register(t0);
-StructuredBuffer<uint16_t> g_IndexBuffer : register(t1);
+StructuredBuffer<uint> g_IndexBuffer : register(t1);
 
 StructuredBuffer<Brick> g_BrickBuffer : register(t2);
+// Incremental bakes only evaluate the bricks that were placed into the object
+StructuredBuffer<uint> g_BrickSlots : register(t3);
 
 RWTexture3D<float4> g_OutputTexture : register(u0);
 
@@ -64,7 +66,7 @@ float EvaluateEditList(float3 p, uint GI, out float4 materials)
 		// Load edits
 		GroupMemoryBarrierWithGroupSync();
 
-		if (GI < min(MAX_EDITS_CHUNK, editCount))
+		if (GI < min(MAX_EDITS_CHUNK, editsRemaining))
 		{
 #ifdef DISABLE_EDIT_CULLING
 			gs_Edits[GI] = g_EditList.Load(chunk * MAX_EDITS_CHUNK + GI);
@@ -109,7 +111,12 @@ float EvaluateEditList(float3 p, uint GI, out float4 materials)
 [numthreads(SDF_BRICK_SIZE_VOXELS_ADJACENCY, SDF_BRICK_SIZE_VOXELS_ADJACENCY, SDF_BRICK_SIZE_VOXELS_ADJACENCY)]
 void main(uint3 GroupID : SV_GroupID, uint3 GTid : SV_GroupThreadID, uint GI : SV_GroupIndex)
 {
-	const uint brickIndex = GroupID.x + g_EvalGroupOffset.Offset;
+	uint brickIndex = GroupID.x + g_EvalGroupOffset.Offset;
+	if (g_BuildParameters.UseBrickSlots)
+	{
+		brickIndex = g_BrickSlots[brickIndex];
+	}
+
 	if (GI == 0)
 	{
 		// Which brick is this thread processing
@@ -132,7 +139,7 @@ void main(uint3 GroupID : SV_GroupID, uint3 GTid : SV_GroupThreadID, uint GI : S
 	const float formattedDistance = FormatDistance(nearest, g_BuildParameters.EvalSpace_VoxelsPerUnit);
 
 	// Now calculate where to store the voxel in the brick pool
-	const uint3 brickVoxel = CalculateBrickPoolPosition(brickIndex, g_BuildParameters.BrickCount, g_BuildParameters.BrickPool_BrickCapacityPerAxis) + GTid;
+	const uint3 brickVoxel = CalculateBrickPoolPosition(gs_Brick.PoolSlot, g_BuildParameters.BrickCount, g_BuildParameters.BrickPool_BrickCapacityPerAxis, g_BuildParameters.BrickPool_Placement) + GTid;
 
 	// Store the mapped distance in the volume
 	// As the sum of all components of materials == 1, materials.w can be recovered as 1 - materials.xyz
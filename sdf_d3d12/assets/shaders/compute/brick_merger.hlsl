@@ -0,0 +1,72 @@
+#ifndef BRICKMERGER_HLSL
+#define BRICKMERGER_HLSL
+
+/*
+ *
+ *	Places the bricks built by an incremental bake into the slots of an object
+ *	New bricks fill the free slots first and are then appended to the end of the object.
+ *	Free slots that are left over are released.
+ *
+ */
+
+#define HLSL
+#include "../HlslCompat/ComputeHlslCompat.h"
+
+
+ConstantBuffer<IncrementalBakeConstantBuffer> g_IncrementalParameters : register(b0);
+
+StructuredBuffer<Brick> g_NewBricks : register(t0);
+StructuredBuffer<uint> g_FreeBricks : register(t1);
+
+// Object resources
+RWStructuredBuffer<Brick> g_Bricks : register(u0);
+RWStructuredBuffer<AABB> g_AABBs : register(u1);
+
+// Which slot each new brick was placed in, so that only the new bricks are evaluated
+RWStructuredBuffer<uint> g_BrickSlots : register(u2);
+
+
+[numthreads(BRICK_MERGING_THREADS, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+	const uint newBrickCount = g_IncrementalParameters.NewBrickCount;
+	const uint releasedBrickCount = g_IncrementalParameters.ReleasedBrickCount;
+
+	if (DTid.x < newBrickCount)
+	{
+		const uint slot = DTid.x < releasedBrickCount
+			? g_FreeBricks[DTid.x]
+			: g_IncrementalParameters.BrickCount + DTid.x - releasedBrickCount;
+
+		// The new indices are placed after the existing indices of the object
+		Brick brick = g_NewBricks.Load(DTid.x);
+		brick.IndexOffset += g_IncrementalParameters.IndexOffset;
+		brick.PoolSlot = slot;
+
+		AABB aabb;
+		aabb.TopLeft = brick.TopLeft;
+		aabb.BottomRight = brick.TopLeft + g_IncrementalParameters.BrickSize;
+
+		g_Bricks[slot] = brick;
+		g_AABBs[slot] = aabb;
+		g_BrickSlots[DTid.x] = slot;
+	}
+	else if (DTid.x < releasedBrickCount)
+	{
+		const uint slot = g_FreeBricks[DTid.x];
+
+		Brick brick = g_Bricks[slot];
+		brick.IndexOffset = SDF_RELEASED_BRICK;
+		brick.IndexCount = 0;
+
+		// An AABB with a NaN minimum is inactive, so rays will never intersect the released brick
+		AABB aabb;
+		aabb.TopLeft = asfloat(0x7FC00000).xxx;
+		aabb.BottomRight = aabb.TopLeft;
+
+		g_Bricks[slot] = brick;
+		g_AABBs[slot] = aabb;
+	}
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef BRICKRELEASER_HLSL
+#define BRICKRELEASER_HLSL
+
+/*
+ *
+ *	Finds the bricks of an object that an incremental bake will rebuild,
+ *	and appends their slots to a list of free slots for the new bricks to be placed in
+ *
+ */
+
+#define HLSL
+#include "../HlslCompat/ComputeHlslCompat.h"
+
+#include "../include/brick_helper.hlsli"
+
+
+ConstantBuffer<IncrementalBakeConstantBuffer> g_IncrementalParameters : register(b0);
+
+// The bricks that are currently in the object
+StructuredBuffer<Brick> g_Bricks : register(t0);
+
+RWStructuredBuffer<uint> g_FreeBricks : register(u0);
+RWByteAddressBuffer g_FreeBrickCounter : register(u1);
+// The number of indices that are no longer referenced by any brick
+RWByteAddressBuffer g_ReleasedIndexCounter : register(u2);
+
+
+[numthreads(BRICK_MERGING_THREADS, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+	if (DTid.x >= g_IncrementalParameters.BrickCount)
+	{
+		return;
+	}
+
+	const Brick brick = g_Bricks.Load(DTid.x);
+
+	// Slots that were released by previous bakes can be re-used too
+	const bool released = brick.IndexOffset == SDF_RELEASED_BRICK;
+	if (released || BrickOverlapsRegion(brick.TopLeft, g_IncrementalParameters.BrickSize, g_IncrementalParameters.RegionMin, g_IncrementalParameters.RegionMax))
+	{
+		uint slot;
+		g_FreeBrickCounter.InterlockedAdd(0, 1, slot);
+		g_FreeBricks[slot] = DTid.x;
+
+		if (!released)
+		{
+			uint _;
+			g_ReleasedIndexCounter.InterlockedAdd(0, brick.IndexCount, _);
+		}
+	}
+}
+
+#endif
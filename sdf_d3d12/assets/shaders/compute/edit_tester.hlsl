@@ -13,35 +13,58 @@
 ConstantBuffer<BrickBuildParametersConstantBuffer> g_BuildParameters : register(b0);
 
 StructuredBuffer<SDFEditData> g_EditList : register(t0);
-StructuredBuffer<uint16_t> g_InIndexBuffer : register(t1);
-StructuredBuffer<uint16_t> g_EditDependencyIndices : register(t2);
+StructuredBuffer<uint> g_InIndexBuffer : register(t1);
+StructuredBuffer<uint> g_EditDependencyIndices : register(t2);
+// The dependencies of edit i are stored from g_EditDependencyOffsets[i] to g_EditDependencyOffsets[i + 1]
+StructuredBuffer<uint> g_EditDependencyOffsets : register(t3);
 
 RWStructuredBuffer<Brick> g_Bricks : register(u0);
 
-RWStructuredBuffer<uint16_t> g_OutIndexBuffer : register(u1);
+RWStructuredBuffer<uint> g_OutIndexBuffer : register(u1);
 RWByteAddressBuffer g_OutIndexCounter : register(u2);
+// The largest number of indices that any group required when the index buffer was too small
+RWByteAddressBuffer g_OutIndexOverflow : register(u3);
 
 
 // The brick that this group will process
 groupshared Brick gs_Brick;
 // The offset into the index buffer where this bricks indices are stored
 groupshared uint gs_IndexOffset;
+// If the index buffer cannot fit this bricks indices
+groupshared bool gs_IndexOverflow;
 
 
-// 1024-bit wide mask for indicating edits that apply to this brick
-groupshared uint gs_EditMask[32];
+// A bit for every edit indicating if it applies to this brick
+#define EDIT_MASK_WORDS (SDF_EDIT_LIMIT / 32)
+groupshared uint gs_EditMask[EDIT_MASK_WORDS];
+
+// A bit for every word of the edit mask indicating if any of its edits are set
+// This keeps compacting the mask proportional to the number of relevant edits rather than the edit limit
+#define EDIT_SUMMARY_WORDS (EDIT_MASK_WORDS / 32)
+groupshared uint gs_EditSummary[EDIT_SUMMARY_WORDS];
+
+// Each thread compacts a contiguous range of the mask so that indices remain in ascending order
+#define SUMMARY_WORDS_PER_THREAD (EDIT_SUMMARY_WORDS / EDIT_TESTING_THREADS)
 
 
 // The number of edits per thread
-groupshared uint gs_EditCounts[32];
+groupshared uint gs_EditCounts[EDIT_TESTING_THREADS];
 // For scanning the bitmask
-groupshared uint gs_SIMDScan[32];
+groupshared uint gs_SIMDScan[EDIT_TESTING_THREADS];
 
 
 
 void SetEdit(uint index)
 {
-	InterlockedOr(gs_EditMask[index / 32], (1u << (index % 32)));
+	const uint word = index / 32;
+
+	uint previous;
+	InterlockedOr(gs_EditMask[word], (1u << (index % 32)), previous);
+	if (previous == 0)
+	{
+		// Only the thread that set the first bit of this word needs to mark it in the summary
+		InterlockedOr(gs_EditSummary[word / 32], (1u << (word % 32)));
+	}
 }
 bool IsEditSet(uint index)
 {
@@ -74,25 +97,31 @@ void main(uint3 GroupID : SV_GroupID, uint GI : SV_GroupIndex)
 		// Init GSM
 		gs_Brick = g_Bricks.Load(GroupID.x);
 		gs_IndexOffset = 0;
+		gs_IndexOverflow = false;
 	}
 
-	gs_EditMask[GI] = 0;
+	// Clear the mask
+	for (uint word = GI; word < EDIT_MASK_WORDS; word += EDIT_TESTING_THREADS)
+	{
+		gs_EditMask[word] = 0;
+	}
+	for (uint summaryWord = GI; summaryWord < EDIT_SUMMARY_WORDS; summaryWord += EDIT_TESTING_THREADS)
+	{
+		gs_EditSummary[summaryWord] = 0;
+	}
 	gs_EditCounts[GI] = 0;
 
 	GroupMemoryBarrierWithGroupSync();
 
-	// Each thread will process an edit and determine if its relevant
-	const uint editsPerThread = min((gs_Brick.IndexCount + EDIT_TESTING_THREADS - 1) / EDIT_TESTING_THREADS, 32);
-	// Which index of the brick to begin processing edits from
-	const uint threadIndexOffset = editsPerThread * GI;
 	const float3 brickCentre = gs_Brick.TopLeft + 0.5f * g_BuildParameters.SubBrickSize; // This stage is executed AFTER sub-brick building - so bricks are now sub-brick sized
 
-	for (uint i = threadIndexOffset; i < min(threadIndexOffset + editsPerThread, gs_Brick.IndexCount); i++)
+	// The bricks edits are tested in chunks of one edit per thread, so there is no limit on the number of edits per brick
+	for (uint i = GI; i < gs_Brick.IndexCount; i += EDIT_TESTING_THREADS)
 	{
 		// Test edit i
 
 		// Get the index of i and load the edit
-		const uint index = (uint)g_InIndexBuffer.Load(gs_Brick.IndexOffset + i);
+		const uint index = g_InIndexBuffer.Load(gs_Brick.IndexOffset + i);
 		if (IsEditSet(index))
 			// If this edit has already been tested then skip (could be due to a smooth edit dependency)
 			continue;
@@ -106,8 +135,8 @@ void main(uint3 GroupID : SV_GroupID, uint GI : SV_GroupIndex)
 			if (IsSmoothEdit(edit.EditParams))
 			{
 				// Set all of the smooth edits dependencies too
-				const uint offset = index * (g_BuildParameters.SDFEditCount - 1);
-				const uint dependencyCount = GetDependencyCount(edit.EditParams);
+				const uint offset = g_EditDependencyOffsets.Load(index);
+				const uint dependencyCount = g_EditDependencyOffsets.Load(index + 1) - offset;
 				for (uint dependency = 0; dependency < dependencyCount; dependency++)
 				{
 					SetEdit(g_EditDependencyIndices.Load(offset + dependency));
@@ -119,19 +148,23 @@ void main(uint3 GroupID : SV_GroupID, uint GI : SV_GroupIndex)
 	GroupMemoryBarrierWithGroupSync();
 
 	// Compact the bitmask
-	// Each thread can process 32 bits - one UINT
-	UINT laneScan[32];
-	for (uint bit = 0; bit < 32; bit++)
+	// Each thread counts the edits in its range of the mask, skipping words that the summary shows are empty
+	const uint summaryBegin = GI * SUMMARY_WORDS_PER_THREAD;
+	for (uint s = summaryBegin; s < summaryBegin + SUMMARY_WORDS_PER_THREAD; s++)
 	{
-		const UINT set = (gs_EditMask[GI] >> bit) & 1u;
+		uint summary = gs_EditSummary[s];
+		while (summary)
+		{
+			const uint word = 32 * s + firstbitlow(summary);
+			summary &= summary - 1;
 
-		laneScan[bit] = gs_EditCounts[GI];
-		gs_EditCounts[GI] += set;
+			gs_EditCounts[GI] += countbits(gs_EditMask[word]);
+		}
 	}
 	
 	GroupMemoryBarrierWithGroupSync();
 
-	// Once the in-lane scan is complete, a SIMD scan is performed to work out the offsets for each lane
+	// Once the in-lane count is complete, a SIMD scan is performed to work out the offsets for each lane
 	if (GI != 0)
 	{
 		gs_SIMDScan[GI] = gs_EditCounts[GI - 1];
@@ -143,7 +176,7 @@ void main(uint3 GroupID : SV_GroupID, uint GI : SV_GroupIndex)
 
 	GroupMemoryBarrierWithGroupSync();
 
-	for (uint i = 1; i < 32; i <<= 1)
+	for (uint i = 1; i < EDIT_TESTING_THREADS; i <<= 1)
 	{
 		uint temp;
 		if (GI > i)
@@ -164,24 +197,46 @@ void main(uint3 GroupID : SV_GroupID, uint GI : SV_GroupIndex)
 	if (GI == 0)
 	{
 		// An atomic counter is used to place the edits into the index buffer
-		const uint editCount = gs_SIMDScan[31] + gs_EditCounts[31];
+		const uint editCount = gs_SIMDScan[EDIT_TESTING_THREADS - 1] + gs_EditCounts[EDIT_TESTING_THREADS - 1];
 		g_OutIndexCounter.InterlockedAdd(0, editCount, gs_IndexOffset);
 
+		// The counter keeps counting past the end of the index buffer so that the required capacity is known
+		// The bake is then repeated with a larger index buffer
+		if (gs_IndexOffset + editCount > g_BuildParameters.IndexCapacity)
+		{
+			gs_IndexOverflow = true;
+			g_OutIndexOverflow.InterlockedMax(0, gs_IndexOffset + editCount);
+		}
+
 		// Update the brick with its new index buffer
 		gs_Brick.IndexOffset = gs_IndexOffset;
 		gs_Brick.IndexCount = editCount;
+		// Each brick has its own slot in the brick pool
+		gs_Brick.PoolSlot = GroupID.x;
 		g_Bricks[GroupID.x] = gs_Brick;
 	}
 
 	GroupMemoryBarrierWithGroupSync();
 
+	if (gs_IndexOverflow)
+		return;
+
 	// Place the indices into the index buffer
-	for (uint i = 0; i < 32; i++)
+	uint index = gs_IndexOffset + gs_SIMDScan[GI];
+	for (uint s = summaryBegin; s < summaryBegin + SUMMARY_WORDS_PER_THREAD; s++)
 	{
-		if ((gs_EditMask[GI] >> i) & 1u)
+		uint summary = gs_EditSummary[s];
+		while (summary)
 		{
-			const uint index = gs_IndexOffset + gs_SIMDScan[GI] + laneScan[i];
-			g_OutIndexBuffer[index] = (uint16_t)(32 * GI + i);
+			const uint word = 32 * s + firstbitlow(summary);
+			summary &= summary - 1;
+
+			uint bits = gs_EditMask[word];
+			while (bits)
+			{
+				g_OutIndexBuffer[index++] = 32 * word + firstbitlow(bits);
+				bits &= bits - 1;
+			}
 		}
 	}
 }
@@ -65,6 +65,7 @@ void main(uint3 GroupID : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_G
 		gs_OutBricks[GI].TopLeft = gs_InBrick.TopLeft + g_BuildParameters.SubBrickSize * GTid;
 		gs_OutBricks[GI].IndexOffset = gs_InBrick.IndexOffset; // These will be refined in the next stage
 		gs_OutBricks[GI].IndexCount = gs_InBrick.IndexCount;
+		gs_OutBricks[GI].PoolSlot = 0; // The brick's index is not known until it is placed in global memory
 
 		// Calculate morton code for brick
 		const uint mortonCode = morton3Df(0.5f + (gs_OutBricks[GI].TopLeft / g_BuildParameters.EvalSpaceSize));
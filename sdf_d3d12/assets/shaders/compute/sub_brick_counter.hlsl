@@ -5,6 +5,7 @@
 #define HLSL
 #include "../HlslCompat/ComputeHlslCompat.h"
 
+#include "../include/brick_helper.hlsli"
 #include "../include/sdf_helper.hlsli"
 
 
@@ -18,7 +19,7 @@ ConstantBuffer<BrickBuildParametersConstantBuffer> g_BuildParameters : register(
 // The brick counter should therefore be read-only
 ByteAddressBuffer g_BrickCounter : register(t0);
 StructuredBuffer<SDFEditData> g_EditList : register(t1);
-StructuredBuffer<uint16_t> g_IndexBuffer : register(t2);
+StructuredBuffer<uint> g_IndexBuffer : register(t2);
 
 RWStructuredBuffer<Brick> g_Bricks : register(u0);
 
@@ -53,7 +54,7 @@ float EvaluateEditList(float3 p)
 #ifdef DISABLE_EDIT_CULLING
 		const SDFEditData edit = g_EditList.Load(i);
 #else
-		const uint16_t index = g_IndexBuffer.Load(gs_Brick.IndexOffset + i);
+		const uint index = g_IndexBuffer.Load(gs_Brick.IndexOffset + i);
 		const SDFEditData edit = g_EditList.Load(index);
 #endif
 
@@ -94,9 +95,17 @@ void main(uint3 GroupID : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_G
 
 	// Determine if this thread's sub-region is occupied
 
+	// Sub-bricks outside of the region being built are left untouched
+	const float3 subBrickTopLeft = gs_Brick.TopLeft + g_BuildParameters.SubBrickSize * GTid;
+	const bool inRegion = BrickOverlapsRegion(subBrickTopLeft, g_BuildParameters.SubBrickSize, g_BuildParameters.RegionMin, g_BuildParameters.RegionMax);
+
 	// Calculate the centre of the sub-brick that this thread should evaluate
 	const float3 subBrickCentre = gs_Brick.TopLeft + g_BuildParameters.SubBrickSize * (GTid + 0.5f);
-	const float distance = EvaluateEditList(subBrickCentre);
+	float distance = FLOAT_MAX;
+	if (inRegion)
+	{
+		distance = EvaluateEditList(subBrickCentre);
+	}
 
 	// If there is a distance value of magnitude small enough, that means its possible this sub-brick
 	// could contain geometry and it should be either divided or evaluated
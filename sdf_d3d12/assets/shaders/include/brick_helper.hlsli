@@ -78,18 +78,66 @@ float FormatDistance(float inDistance, float voxelsPerUnit)
 }
 
 
-// Calculates which voxel in the brick pool this thread will map to
-uint3 CalculateBrickPoolPosition(uint brickIndex, uint brickCount, uint3 brickPoolCapacity)
+// Whether a brick overlaps a region of eval space
+// Regions are snapped to brick centres on the CPU, so that the same bricks are
+// found overlapping when they are built and when they are released
+bool BrickOverlapsRegion(float3 brickTopLeft, float brickSize, float3 regionMin, float3 regionMax)
 {
-	// max size for component = ceil(log2(brickCount) / 3)
-	// normalized = (decodeMorton3D(index) / (max size for component))
-	// brickTopLeft = normalized * (capacity - 1)
+	return all(brickTopLeft <= regionMax) && all(brickTopLeft + brickSize >= regionMin);
+}
 
-	//uint3 brickTopLeft = decodeMorton3D(brickIndex);
 
-	//const float maxComponentSize = float(1U << uint(ceil(log2(brickCount) / 3.0f)));
-	//uint3 brickTopLeft = (decodeMorton3D(brickIndex) / maxComponentSize) * (brickPoolCapacity - 1);
-	
+// The length of [corner, corner + side) that is within [0, capacity)
+uint ClippedExtent(uint corner, uint side, uint capacity)
+{
+	return corner < capacity ? min(capacity - corner, side) : 0;
+}
+
+// Calculates the brick that a slot maps to in Morton order
+// The octants of the pool are visited in Morton order, and the parts of octants that lie outside of the pool are skipped,
+// so that every slot maps to a different brick whatever the dimensions of the pool.
+// For a pool that is a power of two cube, this is decodeMorton3D(brickIndex)
+uint3 CalculateMortonBrickPosition(uint brickIndex, uint3 brickPoolCapacity)
+{
+	uint side = 1;
+	while (side < max(brickPoolCapacity.x, max(brickPoolCapacity.y, brickPoolCapacity.z)))
+		side *= 2;
+
+	uint3 origin = uint3(0, 0, 0);
+	while (side > 1)
+	{
+		side /= 2;
+
+		for (uint octant = 0; octant < 8; octant++)
+		{
+			// x is the most significant bit of each level of a Morton code
+			const uint3 corner = origin + uint3((octant >> 2) & 1, (octant >> 1) & 1, octant & 1) * side;
+
+			// The number of bricks of this octant that are inside the pool
+			const uint count = ClippedExtent(corner.x, side, brickPoolCapacity.x)
+							 * ClippedExtent(corner.y, side, brickPoolCapacity.y)
+							 * ClippedExtent(corner.z, side, brickPoolCapacity.z);
+
+			if (brickIndex < count)
+			{
+				origin = corner;
+				break;
+			}
+			brickIndex -= count;
+		}
+	}
+
+	return origin;
+}
+
+// Calculates which voxel in the brick pool this thread will map to
+uint3 CalculateBrickPoolPosition(uint brickIndex, uint brickCount, uint3 brickPoolCapacity, uint placement)
+{
+	if (placement == SDF_BRICK_POOL_PLACEMENT_MORTON)
+	{
+		return CalculateMortonBrickPosition(brickIndex, brickPoolCapacity) * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+	}
+
 	uint3 brickTopLeft;
 	
 	brickTopLeft.x = brickIndex % brickPoolCapacity.x;
@@ -241,11 +241,6 @@ uint GetMaterialTableIndex(uint editParams)
 	return ((editParams >> 10) & 0x00000003);
 }
 
-uint GetDependencyCount(uint editParams)
-{
-	return ((editParams >> 16) & 0x0000FFFF);
-}
-
 bool IsSmoothOperation(SDFOperation op)
 {
 	// smooth if second bit is set
@@ -203,6 +203,10 @@ void SDFIntersectionShader()
 {
 	const Brick brick = l_BrickBuffer[PrimitiveIndex()];
 
+	// The voxels of this brick have not been streamed in
+	if (brick.PoolSlot == SDF_NON_RESIDENT_BRICK)
+		return;
+
 	Ray ray;
 	ray.origin = ObjectRayOrigin() - brick.TopLeft;
 	ray.direction = ObjectRayDirection();
@@ -225,7 +229,7 @@ void SDFIntersectionShader()
 		uvwAABB /= l_BrickProperties.BrickSize;
 
 		// get voxel coordinate of top left of brick
-		const uint3 brickTopLeftVoxel = CalculateBrickPoolPosition(PrimitiveIndex(), l_BrickProperties.BrickCount, l_BrickProperties.BrickPoolDimensions / SDF_BRICK_SIZE_VOXELS_ADJACENCY);
+		const uint3 brickTopLeftVoxel = CalculateBrickPoolPosition(brick.PoolSlot, l_BrickProperties.BrickCount, l_BrickProperties.BrickPoolDimensions / SDF_BRICK_SIZE_VOXELS_ADJACENCY, l_BrickProperties.BrickPoolPlacement);
 
 		// Offset by 1 due to adjacency data
 		// e.g., uvwAABB of (0, 0, 0) actually references the voxel at (1, 1, 1) - not (0, 0, 0)
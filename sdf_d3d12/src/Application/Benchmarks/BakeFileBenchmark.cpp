@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "BakeFileBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "Framework/GameTimer.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+#include "SDF/SDFBakeFile.h"
+
+#include <cfloat>
+
+
+void BakeFileBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Demo", "Bricks", "File (MB)", "Bake (ms)", "Write (ms)", "Open (ms)", "Read (ms)", "Verify (ms)", "Matches" });
+
+	char tempDirectory[MAX_PATH];
+	if (GetTempPathA(MAX_PATH, tempDirectory) == 0)
+	{
+		LOG_ERROR("Failed to find a temporary directory for bake files.");
+		return;
+	}
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+	SDFBakeData loadedData;
+	GameTimer timer;
+
+	const UINT materials[] = { 0, 1, 2, 3 };
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		const SDFEditList editList = demo->BuildEditList(0.0f);
+		const std::string path = std::string(tempDirectory) + demoName + ".sdfbake";
+		const UINT64 sourceHash = SDFBakeFile::CalculateSourceHash(editList, m_BrickSize, factory.GetMaxBrickBuildIterations(), true, factory.GetBrickPoolPlacement());
+
+		// Deduplicated bakes share pool slots, so they can have more bricks than their brick pool holds
+		for (const bool deduplicate : { false, true })
+		{
+			const std::string name = deduplicate ? demoName + " (Deduplicated)" : demoName;
+			factory.SetBrickDeduplicationEnabled(deduplicate);
+
+			// Iterations after a failure are skipped, and the stages that did not run report FLT_MAX
+			bool matches = true;
+			UINT64 fileSize = 0;
+
+			const auto [bestBake, bestWrite, bestOpen, bestRead, bestVerify] = MeasureBest(config, [&]()
+				{
+					std::array<float, 5> times;
+					times.fill(FLT_MAX);
+					if (!matches)
+						return times;
+
+					factory.BakeSDF(editList, m_BrickSize, bakeData);
+					times[0] = factory.GetLastBakeTimings().Total;
+
+					timer.Reset();
+					if (!SDFBakeFile::Write(path, bakeData, materials, ARRAYSIZE(materials), sourceHash))
+					{
+						matches = false;
+						return times;
+					}
+					times[1] = 1000.0f * timer.Tick();
+
+					// The file is opened and read as a loader would, although it is likely to still be in the file cache
+					SDFBakeFile file;
+					timer.Reset();
+					if (!file.Open(path))
+					{
+						matches = false;
+						return times;
+					}
+					times[2] = 1000.0f * timer.Tick();
+
+					file.ReadBakeData(loadedData);
+					times[3] = 1000.0f * timer.Tick();
+
+					matches &= file.VerifyContents();
+					times[4] = 1000.0f * timer.Tick();
+
+					matches &= file.GetHeader().SourceHash == sourceHash;
+					matches &= CompareBakeData(bakeData, loadedData).IsExactMatch();
+
+					fileSize = file.GetHeader().Sections[SDFBakeFileSection::Count - 1].Offset + file.GetHeader().Sections[SDFBakeFileSection::Count - 1].Size;
+					return times;
+				});
+
+			DeleteFileA(path.c_str());
+
+			if (!matches)
+			{
+				LOG_ERROR("Bake file of '{}' does not match the bake it was written from.", name);
+			}
+
+			report.AddRow(name, bakeData.GetBrickCount(), static_cast<double>(fileSize) / (1024.0 * 1024.0),
+				bestBake, bestWrite, bestOpen, bestRead, bestVerify,
+				matches ? "Yes" : "No");
+		}
+	}
+
+	factory.SetBrickDeduplicationEnabled(false);
+}
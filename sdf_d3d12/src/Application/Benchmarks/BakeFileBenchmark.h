@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Bakes each demo with the CPU factory, writes it to a bake file and loads it back
+// Reports the time to load a bake from a file against the time to bake it, and checks that the bake round trips
+// Each demo is also baked with brick deduplication, whose bricks share pool slots
+class BakeFileBenchmark : public BaseBenchmark
+{
+	BakeFileBenchmark() = default;
+public:
+	static BakeFileBenchmark& Get()
+	{
+		static BakeFileBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Bake, write, open and read times of bake files for each demo"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.125f;
+};
@@ -0,0 +1,51 @@
+#include "pch.h"
+#include "Benchmark.h"
+
+#include "BakeFileBenchmark.h"
+#include "BrickCacheBenchmark.h"
+#include "BrickCompressionBenchmark.h"
+#include "BrickCullingBenchmark.h"
+#include "BrickDeduplicationBenchmark.h"
+#include "BrickPagingBenchmark.h"
+#include "BrickPlacementBenchmark.h"
+#include "EditBVHBenchmark.h"
+#include "EditDependencyBenchmark.h"
+#include "EditJournalBenchmark.h"
+#include "EditScalingBenchmark.h"
+#include "PacketEvaluationBenchmark.h"
+#include "PrefixScanBenchmark.h"
+#include "ResourceGrowthBenchmark.h"
+#include "ShaderCacheBenchmark.h"
+
+
+std::map<std::string, BaseBenchmark*> BaseBenchmark::s_Benchmarks;
+
+
+void BaseBenchmark::CreateAllBenchmarks()
+{
+	s_Benchmarks["packet-evaluation"] = &PacketEvaluationBenchmark::Get();
+	s_Benchmarks["brick-culling"] = &BrickCullingBenchmark::Get();
+	s_Benchmarks["edit-dependencies"] = &EditDependencyBenchmark::Get();
+	s_Benchmarks["edit-bvh"] = &EditBVHBenchmark::Get();
+	s_Benchmarks["edit-scaling"] = &EditScalingBenchmark::Get();
+	s_Benchmarks["brick-cache"] = &BrickCacheBenchmark::Get();
+	s_Benchmarks["prefix-scan"] = &PrefixScanBenchmark::Get();
+	s_Benchmarks["resource-growth"] = &ResourceGrowthBenchmark::Get();
+	s_Benchmarks["brick-compression"] = &BrickCompressionBenchmark::Get();
+	s_Benchmarks["brick-deduplication"] = &BrickDeduplicationBenchmark::Get();
+	s_Benchmarks["brick-placement"] = &BrickPlacementBenchmark::Get();
+	s_Benchmarks["bake-file"] = &BakeFileBenchmark::Get();
+	s_Benchmarks["edit-journal"] = &EditJournalBenchmark::Get();
+	s_Benchmarks["brick-paging"] = &BrickPagingBenchmark::Get();
+	s_Benchmarks["shader-cache"] = &ShaderCacheBenchmark::Get();
+}
+
+BaseBenchmark* BaseBenchmark::GetBenchmarkFromName(const std::string& benchmarkName)
+{
+	if (s_Benchmarks.find(benchmarkName) != s_Benchmarks.end())
+	{
+		return s_Benchmarks.at(benchmarkName);
+	}
+
+	return nullptr;
+}
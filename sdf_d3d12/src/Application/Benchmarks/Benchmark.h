@@ -0,0 +1,61 @@
+#pragma once
+
+#include "BenchmarkReport.h"
+
+
+// Settings shared by every benchmark, set from the command line
+struct BenchmarkConfig
+{
+	UINT Iterations = 5;		// How many times each measurement is repeated. The fastest is reported
+	UINT ThreadCount = 0;		// For multithreaded benchmarks. 0 uses every hardware thread
+};
+
+
+// Benchmarks of CPU-side systems that can be run without a window or graphics device
+class BaseBenchmark
+{
+protected:
+	BaseBenchmark() = default;
+public:
+	virtual ~BaseBenchmark() = default;
+
+	DISALLOW_COPY(BaseBenchmark);
+	DISALLOW_MOVE(BaseBenchmark);
+
+	virtual const char* GetDescription() const = 0;
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) = 0;
+
+protected:
+	// Runs an iteration the configured number of times, and returns the fastest to reduce noise
+	// The iteration returns its time, or an array of the times of several stages, each of which is minimised separately
+	// It is always run at least once
+	template<typename Iteration>
+	static auto MeasureBest(const BenchmarkConfig& config, Iteration&& iteration)
+	{
+		auto best = iteration();
+		for (UINT i = 1; i < config.Iterations; i++)
+		{
+			KeepFastest(best, iteration());
+		}
+		return best;
+	}
+
+public:
+	static void CreateAllBenchmarks();
+
+	static BaseBenchmark* GetBenchmarkFromName(const std::string& benchmarkName);
+	static const std::map<std::string, BaseBenchmark*>& GetAllBenchmarks() { return s_Benchmarks; }
+
+private:
+	static void KeepFastest(float& best, float time) { best = (std::min)(best, time); }
+	template<size_t N>
+	static void KeepFastest(std::array<float, N>& best, const std::array<float, N>& times)
+	{
+		for (size_t i = 0; i < N; i++)
+		{
+			best[i] = (std::min)(best[i], times[i]);
+		}
+	}
+
+	static std::map<std::string, BaseBenchmark*> s_Benchmarks;
+};
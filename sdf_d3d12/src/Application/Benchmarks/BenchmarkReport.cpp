@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "BenchmarkReport.h"
+
+#include <fstream>
+
+
+void BenchmarkReport::SetColumns(const std::vector<std::string>& columns)
+{
+	m_Columns = columns;
+	m_Rows.clear();
+}
+
+
+void BenchmarkReport::Log() const
+{
+	// Pad each column to the widest value in it
+	std::vector<size_t> widths(m_Columns.size());
+	for (size_t column = 0; column < m_Columns.size(); column++)
+	{
+		widths.at(column) = m_Columns.at(column).size();
+		for (const auto& row : m_Rows)
+			widths.at(column) = max(widths.at(column), row.at(column).size());
+	}
+
+	auto FormatRow = [&widths](const std::vector<std::string>& row)
+		{
+			std::stringstream stream;
+			for (size_t column = 0; column < row.size(); column++)
+			{
+				stream << std::left << std::setw(static_cast<int>(widths.at(column)) + 2) << row.at(column);
+			}
+			return stream.str();
+		};
+
+	LOG_INFO(FormatRow(m_Columns));
+	for (const auto& row : m_Rows)
+	{
+		LOG_INFO(FormatRow(row));
+	}
+}
+
+
+bool BenchmarkReport::WriteCSV(const std::string& path) const
+{
+	std::ofstream outFile(path);
+	if (!outFile.is_open())
+	{
+		LOG_ERROR("Failed to open benchmark output file: '{}'", path);
+		return false;
+	}
+
+	auto WriteRow = [&outFile](const std::vector<std::string>& row)
+		{
+			for (size_t column = 0; column < row.size(); column++)
+			{
+				outFile << row.at(column) << (column + 1 < row.size() ? "," : "");
+			}
+			outFile << std::endl;
+		};
+
+	WriteRow(m_Columns);
+	for (const auto& row : m_Rows)
+	{
+		WriteRow(row);
+	}
+
+	LOG_INFO("Benchmark results written to '{}'", path);
+	return true;
+}
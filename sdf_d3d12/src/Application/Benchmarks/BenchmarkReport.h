@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Core.h"
+
+#include <sstream>
+#include <iomanip>
+
+
+// A table of benchmark results
+// Every value is stored as a string so that rows can mix types
+class BenchmarkReport
+{
+public:
+	BenchmarkReport() = default;
+	~BenchmarkReport() = default;
+
+	DEFAULT_COPY(BenchmarkReport)
+	DEFAULT_MOVE(BenchmarkReport)
+
+	// Setting the columns will clear any existing rows
+	void SetColumns(const std::vector<std::string>& columns);
+
+	template<typename... Values>
+	void AddRow(const Values&... values)
+	{
+		ASSERT(sizeof...(Values) == m_Columns.size(), "Row does not match the columns of the report!");
+
+		std::vector<std::string> row;
+		row.reserve(sizeof...(Values));
+		(row.push_back(ToString(values)), ...);
+		m_Rows.push_back(std::move(row));
+	}
+
+	inline UINT GetRowCount() const { return static_cast<UINT>(m_Rows.size()); }
+
+	// Logs the report as an aligned table
+	void Log() const;
+	bool WriteCSV(const std::string& path) const;
+
+private:
+	template<typename T>
+	static std::string ToString(const T& value)
+	{
+		std::stringstream stream;
+		stream << std::fixed << std::setprecision(4) << value;
+		return stream.str();
+	}
+
+private:
+	std::vector<std::string> m_Columns;
+	std::vector<std::vector<std::string>> m_Rows;
+};
@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "BenchmarkRunner.h"
+
+#include "Application/Demo/Demos.h"
+
+
+void BenchmarkRunner::ParseCommandLineArgs(args::Subparser& subparser)
+{
+	args::Positional<std::string> benchmarkName(subparser, "Benchmark", "Name of the benchmark to run");
+	args::Flag list(subparser, "List", "List the available benchmarks", { "list" });
+	args::ValueFlag<UINT> iterations(subparser, "Iterations", "Number of times each measurement is repeated", { "iterations" });
+	args::ValueFlag<UINT> threadCount(subparser, "Threads", "Number of worker threads (0 uses every hardware thread)", { "threads" });
+	args::ValueFlag<std::string> output(subparser, "Output", "Path to a csv file to write results to", { "output" });
+
+	subparser.Parse();
+
+	m_Enabled = true;
+
+	if (list)
+		m_ListBenchmarks = true;
+	if (benchmarkName)
+		m_BenchmarkName = benchmarkName.Get();
+	if (iterations)
+		m_Config.Iterations = max(iterations.Get(), 1u);
+	if (threadCount)
+		m_Config.ThreadCount = threadCount.Get();
+	if (output)
+		m_OutputFile = output.Get();
+}
+
+
+bool BenchmarkRunner::Run()
+{
+	// Benchmarks may use the demos as workloads
+	BaseDemo::CreateAllDemos();
+	BaseBenchmark::CreateAllBenchmarks();
+
+	if (m_ListBenchmarks || m_BenchmarkName.empty())
+	{
+		LOG_INFO("Available benchmarks:");
+		for (const auto& [name, benchmark] : BaseBenchmark::GetAllBenchmarks())
+		{
+			LOG_INFO("{}: {}", name, benchmark->GetDescription());
+		}
+		return true;
+	}
+
+	BaseBenchmark* benchmark = BaseBenchmark::GetBenchmarkFromName(m_BenchmarkName);
+	if (!benchmark)
+	{
+		LOG_ERROR("Benchmark '{}' does not exist.", m_BenchmarkName);
+		return false;
+	}
+
+	LOG_INFO("Running benchmark '{}'...", m_BenchmarkName);
+
+	BenchmarkReport report;
+	benchmark->Run(m_Config, report);
+	report.Log();
+
+	if (!m_OutputFile.empty())
+		return report.WriteCSV(m_OutputFile);
+	return true;
+}
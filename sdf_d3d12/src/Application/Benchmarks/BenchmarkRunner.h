@@ -0,0 +1,35 @@
+#pragma once
+
+#include <args.hxx>
+
+#include "Benchmark.h"
+
+
+// Runs benchmarks from the command line
+// No window or graphics device is created
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner() = default;
+	~BenchmarkRunner() = default;
+
+	DISALLOW_COPY(BenchmarkRunner)
+	DEFAULT_MOVE(BenchmarkRunner)
+
+	void ParseCommandLineArgs(args::Subparser& subparser);
+
+	// Runs the selected benchmark
+	// Returns whether it was successful
+	bool Run();
+
+	inline bool IsEnabled() const { return m_Enabled; }
+
+private:
+	bool m_Enabled = false;
+
+	bool m_ListBenchmarks = false;
+	std::string m_BenchmarkName;
+	BenchmarkConfig m_Config;
+
+	std::string m_OutputFile;
+};
@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "BrickCacheBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+
+
+void BrickCacheBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Demo", "Brick Cache", "Bricks Per Frame", "Brick Evaluation Per Frame (ms)", "Hit Rate", "Evictions", "Cache Size (MB)", "Speedup" });
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		// Build the frames up front, so that both runs bake the same animation
+		std::vector<SDFEditList> frames;
+		frames.reserve(m_FrameCount);
+		for (UINT frame = 0; frame < m_FrameCount; frame++)
+		{
+			frames.push_back(demo->BuildEditList(m_FrameTime));
+		}
+
+		float uncachedEvaluation = 0.0f;
+
+		for (const bool enableCache : { false, true })
+		{
+			factory.SetBrickCacheEnabled(enableCache);
+
+			// Each iteration starts with an empty cache, so every iteration finds the same hits
+			size_t brickCount = 0;
+			const float bestEvaluation = MeasureBest(config, [&]()
+				{
+					factory.GetBrickCache().Clear();
+					factory.GetBrickCache().ResetStatistics();
+
+					float evaluation = 0.0f;
+					brickCount = 0;
+					for (const auto& editList : frames)
+					{
+						factory.BakeSDF(editList, m_BrickSize, bakeData);
+						evaluation += factory.GetLastBakeTimings().BrickEvaluation;
+						brickCount += bakeData.GetBrickCount();
+					}
+					return evaluation;
+				});
+			const SDFBrickCache::Statistics statistics = factory.GetBrickCache().GetStatistics();
+
+			if (!enableCache)
+				uncachedEvaluation = bestEvaluation;
+
+			report.AddRow(demoName, enableCache ? "On" : "Off",
+				static_cast<double>(brickCount) / m_FrameCount,
+				static_cast<double>(bestEvaluation) / m_FrameCount,
+				statistics.GetHitRate(), statistics.Evictions,
+				static_cast<double>(factory.GetBrickCache().GetSizeBytes()) / (1024.0 * 1024.0),
+				static_cast<double>(uncachedEvaluation) / max(static_cast<double>(bestEvaluation), 1e-9));
+		}
+	}
+
+	factory.GetBrickCache().Clear();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Compares brick evaluation in the CPU factory with and without the brick cache
+// Each demo is animated for a number of frames, and every frame is baked as the demo scene would
+class BrickCacheBenchmark : public BaseBenchmark
+{
+	BrickCacheBenchmark() = default;
+public:
+	static BrickCacheBenchmark& Get()
+	{
+		static BrickCacheBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Brick evaluation time and cache hit rate over animated frames of each demo"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.0625f;
+	UINT m_FrameCount = 60;
+	float m_FrameTime = 1.0f / 60.0f;
+};
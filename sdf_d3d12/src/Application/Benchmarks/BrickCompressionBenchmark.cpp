@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "BrickCompressionBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "Framework/GameTimer.h"
+#include "SDF/CPU/SDFBrickEncoder.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+
+
+void BrickCompressionBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Demo", "Format", "Bricks", "Bytes/Brick", "Bricks Per RGBA8 Brick", "Encode (ms)",
+		"Max Error (voxels)", "RMS Error", "PSNR (dB)", "Sign Flips", "Uniform Material Bricks" });
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	factory.SetReferenceDistancesEnabled(true);
+
+	SDFBakeData bakeData;
+	SDFEncodedBrickPool encodedPool;
+	GameTimer timer;
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		factory.BakeSDF(demo->BuildEditList(0.0f), m_BrickSize, bakeData);
+		const UINT brickCount = bakeData.GetBrickCount();
+		if (brickCount == 0)
+			continue;
+
+		double rgba8BytesPerBrick = 0.0;
+
+		for (UINT format = 0; format < BrickPoolFormat::Count; format++)
+		{
+			const auto poolFormat = static_cast<BrickPoolFormat::Value>(format);
+
+			const float bestEncode = MeasureBest(config, [&]()
+				{
+					timer.Tick();
+					SDFBrickEncoder::Encode(bakeData, poolFormat, encodedPool);
+					return timer.Tick();
+				});
+
+			const SDFEncodingError error = SDFBrickEncoder::MeasureError(bakeData, encodedPool);
+			if (error.MaterialMismatches > 0)
+			{
+				LOG_ERROR("Brick pool format '{}' does not preserve the materials of {} voxels in demo '{}'.", BrickPoolFormat::GetName(poolFormat), error.MaterialMismatches, demoName);
+			}
+
+			// Includes the material side channel
+			const double bytesPerBrick = static_cast<double>(encodedPool.GetSizeBytes()) / brickCount;
+			if (poolFormat == BrickPoolFormat::RGBA8)
+				rgba8BytesPerBrick = bytesPerBrick;
+
+			report.AddRow(demoName, BrickPoolFormat::GetName(poolFormat), brickCount,
+				bytesPerBrick,
+				rgba8BytesPerBrick / bytesPerBrick,
+				static_cast<double>(bestEncode) * 1000.0,
+				error.GetMaxErrorVoxels(), error.RMSError, error.PSNR,
+				error.SignFlips,
+				encodedPool.GetUniformMaterialBrickCount());
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Encodes the brick pool of each demo in every brick pool format
+// Reports the memory used and the error of the decoded distances against the unquantized distances of the bake
+class BrickCompressionBenchmark : public BaseBenchmark
+{
+	BrickCompressionBenchmark() = default;
+public:
+	static BrickCompressionBenchmark& Get()
+	{
+		static BrickCompressionBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Memory, encoding time and distance error of each brick pool format in each demo"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.125f;
+};
@@ -0,0 +1,47 @@
+#include "pch.h"
+#include "BrickCullingBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+
+
+void BrickCullingBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	static const char* cullingModeNames[] =
+	{
+		"Point Sample",
+		"Interval"
+	};
+	static_assert(ARRAYSIZE(cullingModeNames) == BrickCullingMode::Count);
+
+	report.SetColumns({ "Demo", "Culling", "Bricks", "Indices", "Indices/Brick", "Brick Pool (MB)", "Bake (ms)", "Brick Building (ms)" });
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		const SDFEditList editList = demo->BuildEditList(0.0f);
+
+		for (UINT mode = 0; mode < BrickCullingMode::Count; mode++)
+		{
+			factory.SetCullingMode(static_cast<BrickCullingMode::Value>(mode));
+
+			const auto [bestTotal, bestBrickBuilding] = MeasureBest(config, [&]()
+				{
+					factory.BakeSDF(editList, m_BrickSize, bakeData);
+
+					const auto& timings = factory.GetLastBakeTimings();
+					return std::array<float, 2>{ timings.Total, timings.BrickBuilding };
+				});
+
+			const UINT brickCount = bakeData.GetBrickCount();
+			const size_t indexCount = bakeData.Indices.size();
+			const double brickPoolBytes = static_cast<double>(brickCount) * SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY * 4;
+
+			report.AddRow(demoName, cullingModeNames[mode], brickCount, indexCount,
+				brickCount > 0 ? static_cast<double>(indexCount) / brickCount : 0.0,
+				brickPoolBytes / (1024.0 * 1024.0), bestTotal, bestBrickBuilding);
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Compares point sampled and interval arithmetic culling in the CPU factory
+// Reports the bricks and edit indices that survive, and the time to bake, for each demo
+class BrickCullingBenchmark : public BaseBenchmark
+{
+	BrickCullingBenchmark() = default;
+public:
+	static BrickCullingBenchmark& Get()
+	{
+		static BrickCullingBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Surviving bricks, edit indices and bake time for each culling mode in each demo"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.125f;
+};
@@ -0,0 +1,48 @@
+#include "pch.h"
+#include "BrickDeduplicationBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+
+
+void BrickDeduplicationBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Demo", "Bricks", "Pool Slots", "Deduplication Ratio", "Brick Pool (MB)", "Deduplicated Pool (MB)", "Deduplication (ms)", "Matches" });
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+	SDFBakeData deduplicatedData;
+
+	auto getPoolMB = [](const SDFBakeData& data) { return static_cast<double>(data.BrickPool.size()) / (1024.0 * 1024.0); };
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		const SDFEditList editList = demo->BuildEditList(0.0f);
+
+		factory.SetBrickDeduplicationEnabled(false);
+		factory.BakeSDF(editList, m_BrickSize, bakeData);
+
+		factory.SetBrickDeduplicationEnabled(true);
+
+		const float bestDeduplication = MeasureBest(config, [&]()
+			{
+				factory.BakeSDF(editList, m_BrickSize, deduplicatedData);
+				return factory.GetLastBakeTimings().BrickDeduplication;
+			});
+
+		// Bricks are compared through their pool slots, so sharing slots must not change the contents of any brick
+		const bool matches = CompareBakeData(bakeData, deduplicatedData).IsExactMatch();
+		if (!matches)
+		{
+			LOG_ERROR("Deduplicated bake of demo '{}' does not match the bake without deduplication.", demoName);
+		}
+
+		report.AddRow(demoName, deduplicatedData.GetBrickCount(), deduplicatedData.GetPoolSlotCount(),
+			deduplicatedData.GetDeduplicationRatio(),
+			getPoolMB(bakeData), getPoolMB(deduplicatedData),
+			bestDeduplication,
+			matches ? "Yes" : "No");
+	}
+
+	factory.SetBrickDeduplicationEnabled(false);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Bakes each demo with and without brick deduplication in the CPU factory
+// Reports how many bricks share a pool slot, and the brick pool memory that is saved
+class BrickDeduplicationBenchmark : public BaseBenchmark
+{
+	BrickDeduplicationBenchmark() = default;
+public:
+	static BrickDeduplicationBenchmark& Get()
+	{
+		static BrickDeduplicationBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Pool slots, deduplication ratio and brick pool memory with brick deduplication in each demo"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.125f;
+};
@@ -0,0 +1,189 @@
+#include "pch.h"
+#include "BrickPagingBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "Framework/GameTimer.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+#include "SDF/SDFBrickPageFile.h"
+#include "SDF/SDFBrickResidency.h"
+
+#include <cfloat>
+#include <map>
+#include <tuple>
+
+
+namespace
+{
+	// Checks the voxels of every brick in the page file against the brick in the bake with the same position
+	bool VerifyPageFile(const SDFBrickPageFile& file, const SDFBakeData& bakeData)
+	{
+		std::map<std::tuple<float, float, float>, UINT> bakeBricks;
+		for (UINT i = 0; i < bakeData.GetBrickCount(); i++)
+		{
+			const XMFLOAT3& topLeft = bakeData.Bricks.at(i).TopLeft;
+			bakeBricks.emplace(std::make_tuple(topLeft.x, topLeft.y, topLeft.z), i);
+		}
+
+		const auto& header = file.GetHeader();
+		if (header.BrickCount != bakeBricks.size())
+			return false;
+
+		const Brick* bricks = file.GetBricks();
+		for (UINT i = 0; i < header.BrickCount; i++)
+		{
+			const XMFLOAT3& topLeft = bricks[i].TopLeft;
+			const auto it = bakeBricks.find(std::make_tuple(topLeft.x, topLeft.y, topLeft.z));
+			if (it == bakeBricks.end() || bricks[i].PoolSlot != SDF_NON_RESIDENT_BRICK)
+				return false;
+
+			const UINT page = i / SDFBrickPageFile::s_PageBricks;
+			const UINT pageBrick = i % SDFBrickPageFile::s_PageBricks;
+			const BYTE* pageVoxels = file.GetPageVoxels(page);
+
+			for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+			for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+			for (UINT x = 0; x < SDF_BRICK_SIZE_VOXELS_ADJACENCY; x++)
+			{
+				const size_t offset = (static_cast<size_t>(z) * SDF_BRICK_SIZE_VOXELS_ADJACENCY + y) * SDFBrickPageFile::s_PageRowPitch
+					+ (static_cast<size_t>(pageBrick) * SDF_BRICK_SIZE_VOXELS_ADJACENCY + x) * 4;
+				if (memcmp(pageVoxels + offset, bakeData.GetBrickVoxel(it->second, x, y, z), 4) != 0)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// A path that circles the object twice, weaving in towards its centre and back out, and rising and falling as it goes
+	XMFLOAT3 CalculateCameraPosition(UINT frame, UINT frameCount, const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+	{
+		const float t = static_cast<float>(frame) / static_cast<float>(frameCount);
+		const float angle = 2.0f * XM_2PI * t;
+
+		const XMFLOAT3 centre = { 0.5f * (boundsMin.x + boundsMax.x), 0.5f * (boundsMin.y + boundsMax.y), 0.5f * (boundsMin.z + boundsMax.z) };
+		const XMFLOAT3 extent = { 0.5f * (boundsMax.x - boundsMin.x), 0.5f * (boundsMax.y - boundsMin.y), 0.5f * (boundsMax.z - boundsMin.z) };
+		const float radius = 0.65f + 0.35f * std::cos(3.0f * angle);
+
+		return {
+			centre.x + extent.x * radius * std::cos(angle),
+			centre.y + extent.y * 0.5f * std::sin(5.0f * angle),
+			centre.z + extent.z * radius * std::sin(angle)
+		};
+	}
+}
+
+
+void BrickPagingBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Budget (%)", "Slots", "Pages", "Loads", "Evictions", "Peak Loads", "Deferred Loads", "Streamed (MB)", "Wanted Resident (%)", "Update (us)", "Stage (MB/s)", "Matches" });
+
+	BaseDemo* demo = BaseDemo::GetDemoFromName(m_DemoName);
+	char tempDirectory[MAX_PATH];
+	if (!demo || GetTempPathA(MAX_PATH, tempDirectory) == 0)
+	{
+		LOG_ERROR("Failed to set up brick paging benchmark.");
+		return;
+	}
+	const std::string path = std::string(tempDirectory) + "benchmark.sdfpages";
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+	factory.BakeSDF(demo->BuildEditList(0.0f), m_BrickSize, bakeData);
+
+	GameTimer timer;
+	timer.Reset();
+	if (!SDFBrickPageFile::Write(path, bakeData))
+		return;
+	const float writeTime = 1000.0f * timer.Tick();
+
+	SDFBrickPageFile file;
+	if (!file.Open(path))
+		return;
+	const bool fileMatches = VerifyPageFile(file, bakeData);
+
+	const auto& header = file.GetHeader();
+	LOG_INFO("Wrote {} bricks of demo '{}' to {} pages in {:.1f} ms.", header.BrickCount, m_DemoName, header.PageCount, writeTime);
+
+	XMFLOAT3 boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+	XMFLOAT3 boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (UINT page = 0; page < header.PageCount; page++)
+	{
+		const SDFBrickPage& p = file.GetPages()[page];
+		boundsMin = { (std::min)(boundsMin.x, p.BoundsMin.x), (std::min)(boundsMin.y, p.BoundsMin.y), (std::min)(boundsMin.z, p.BoundsMin.z) };
+		boundsMax = { (std::max)(boundsMax.x, p.BoundsMax.x), (std::max)(boundsMax.y, p.BoundsMax.y), (std::max)(boundsMax.z, p.BoundsMax.z) };
+	}
+
+	// Staging space for the voxels of the pages loaded in one update, as the streamer has
+	const SDFBrickResidency::Settings defaultSettings;
+	std::vector<BYTE> staging(defaultSettings.MaxLoadsPerUpdate * SDFBrickPageFile::s_PageVoxelBytes);
+
+	const float budgets[] = { 0.1f, 0.25f, 0.5f, 1.0f };
+	for (const float budget : budgets)
+	{
+		SDFBrickResidency::Settings settings = defaultSettings;
+		settings.SlotCount = (std::max)(static_cast<UINT>(budget * static_cast<float>(header.PageCount)), 1u);
+
+		SDFBrickResidency residency;
+		UINT64 peakLoads = 0;
+		UINT64 wantedPages = 0;
+		UINT64 wantedResidentPages = 0;
+
+		const auto [bestUpdate, bestStage] = MeasureBest(config, [&]()
+			{
+				residency.Init(file.GetPages(), header.PageCount, settings);
+
+				std::array<float, 2> times = { 0.0f, 0.0f };
+				peakLoads = 0;
+				wantedPages = 0;
+				wantedResidentPages = 0;
+
+				for (UINT frame = 0; frame < m_FrameCount; frame++)
+				{
+					timer.Reset();
+					residency.Update(CalculateCameraPosition(frame, m_FrameCount, boundsMin, boundsMax));
+					times[0] += timer.Tick();
+
+					const auto& loads = residency.GetLoads();
+					for (size_t i = 0; i < loads.size(); i++)
+						memcpy(staging.data() + i * SDFBrickPageFile::s_PageVoxelBytes, file.GetPageVoxels(loads.at(i).Page), SDFBrickPageFile::s_PageVoxelBytes);
+					times[1] += timer.Tick();
+
+					peakLoads = (std::max)(peakLoads, static_cast<UINT64>(loads.size()));
+					wantedPages += residency.GetWantedPageCount();
+					wantedResidentPages += residency.GetWantedResidentPageCount();
+				}
+				return times;
+			});
+
+		const auto& stats = residency.GetStatistics();
+		const double streamedMegabytes = static_cast<double>(stats.Loads * SDFBrickPageFile::s_PageVoxelBytes) / (1024.0 * 1024.0);
+
+		// Every page the residency hands out must be in exactly one slot
+		bool matches = fileMatches;
+		{
+			std::vector<bool> usedSlots(settings.SlotCount, false);
+			UINT residentPages = 0;
+			for (UINT page = 0; page < header.PageCount; page++)
+			{
+				const UINT slot = residency.GetPageSlot(page);
+				if (slot == SDFBrickResidency::s_NotResident)
+					continue;
+
+				matches &= slot < settings.SlotCount && !usedSlots.at(slot);
+				if (slot < settings.SlotCount)
+					usedSlots.at(slot) = true;
+				residentPages++;
+			}
+			matches &= residentPages == residency.GetResidentPageCount();
+		}
+
+		report.AddRow(100.0f * budget, settings.SlotCount, header.PageCount, stats.Loads, stats.Evictions, peakLoads, stats.DeferredLoads, streamedMegabytes,
+			100.0 * static_cast<double>(wantedResidentPages) / static_cast<double>((std::max)(wantedPages, 1ull)),
+			1e6 * static_cast<double>(bestUpdate) / static_cast<double>(m_FrameCount),
+			streamedMegabytes / (std::max)(static_cast<double>(bestStage), 1e-9),
+			matches ? "Yes" : "No");
+	}
+
+	file.Close();
+	DeleteFileA(path.c_str());
+}
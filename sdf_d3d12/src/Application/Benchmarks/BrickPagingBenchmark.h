@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Bakes a demo at a fine brick size with the CPU factory and splits it into a page file,
+// checking that the voxels of every page match the bricks they were gathered from.
+// A camera then flies a path through the object, and the residency of its pages is updated each frame
+// with brick pools that hold different fractions of the pages. The voxels of each loaded page are staged as the streamer would.
+// Reports how much is streamed, and how many of the pages near the camera are resident
+class BrickPagingBenchmark : public BaseBenchmark
+{
+	BrickPagingBenchmark() = default;
+public:
+	static BrickPagingBenchmark& Get()
+	{
+		static BrickPagingBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Page loads, evictions and residency of a paged object along a camera path, for several brick pool budgets"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	std::string m_DemoName = "drops";
+	float m_BrickSize = 0.0625f;
+	UINT m_FrameCount = 2000;
+};
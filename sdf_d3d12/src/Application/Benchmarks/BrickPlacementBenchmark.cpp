@@ -0,0 +1,362 @@
+#include "pch.h"
+#include "BrickPlacementBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+#include "SDF/CPU/SDFHelpers.h"
+
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <unordered_map>
+
+using namespace SDFHelpers;
+
+
+namespace
+{
+	// A set-associative cache with least recently used replacement
+	class CacheSimulator
+	{
+	public:
+		CacheSimulator(UINT sizeBytes, UINT lineBytes, UINT ways)
+			: m_LineBytes(lineBytes)
+			, m_Ways(ways)
+			, m_SetCount(sizeBytes / (lineBytes * ways))
+			, m_Tags(static_cast<size_t>(m_SetCount) * ways, s_InvalidTag)
+		{
+			ASSERT(m_SetCount > 0, "Cache is too small for its associativity");
+		}
+
+		void Access(UINT64 address)
+		{
+			const UINT64 line = address / m_LineBytes;
+			UINT64* set = m_Tags.data() + (line % m_SetCount) * m_Ways;
+
+			// Ways are kept in order of most recent use
+			UINT way = 0;
+			while (way < m_Ways - 1 && set[way] != line)
+				way++;
+
+			if (set[way] == line)
+				m_Hits++;
+			else
+				m_Misses++;
+
+			// Move the line to the front, evicting the least recently used line on a miss
+			for (; way > 0; way--)
+				set[way] = set[way - 1];
+			set[0] = line;
+		}
+
+		inline double GetHitRate() const
+		{
+			const UINT64 accesses = m_Hits + m_Misses;
+			return accesses > 0 ? 100.0 * static_cast<double>(m_Hits) / static_cast<double>(accesses) : 0.0;
+		}
+
+	private:
+		inline static constexpr UINT64 s_InvalidTag = ~0ull;
+
+		UINT m_LineBytes;
+		UINT m_Ways;
+		UINT m_SetCount;
+		std::vector<UINT64> m_Tags;
+
+		UINT64 m_Hits = 0;
+		UINT64 m_Misses = 0;
+	};
+
+
+	// How texel addresses in the brick pool are modelled
+	// Hardware lays textures out in its own swizzled tiles, so neither model predicts hit rates on a particular GPU.
+	// They bracket it: the linear model has no 3D locality within memory, the tiled model has the most that a brick can have.
+	namespace AddressModel
+	{
+		enum Value
+		{
+			// Row-major texels
+			Linear = 0,
+			// Blocks of 8x8x8 texels, in Morton order within each block, with the blocks in row-major order
+			Tiled,
+			Count
+		};
+
+		const char* GetName(Value model)
+		{
+			static const char* names[] =
+			{
+				"Linear",
+				"Tiled"
+			};
+			static_assert(ARRAYSIZE(names) == Count);
+			return names[model];
+		}
+	}
+
+	constexpr UINT s_TexelBytes = 4;
+	constexpr UINT s_TileTexels = 8;
+
+	UINT64 GetTexelAddress(AddressModel::Value model, const XMUINT3& resolution, UINT x, UINT y, UINT z)
+	{
+		if (model == AddressModel::Linear)
+			return s_TexelBytes * ((static_cast<UINT64>(z) * resolution.y + y) * resolution.x + x);
+
+		const UINT tilesX = (resolution.x + s_TileTexels - 1) / s_TileTexels;
+		const UINT tilesY = (resolution.y + s_TileTexels - 1) / s_TileTexels;
+		const UINT64 tile = (static_cast<UINT64>(z / s_TileTexels) * tilesY + y / s_TileTexels) * tilesX + x / s_TileTexels;
+		const UINT texel = BrickHelpers::morton3Du({ x % s_TileTexels, y % s_TileTexels, z % s_TileTexels });
+		return s_TexelBytes * (tile * s_TileTexels * s_TileTexels * s_TileTexels + texel);
+	}
+
+
+	struct TraceResult
+	{
+		UINT64 Samples = 0;
+		UINT SurfaceHits = 0;
+		std::vector<CacheSimulator> Caches[AddressModel::Count];
+	};
+
+	// Sizes of L1, L2 and a large last level cache
+	struct CacheConfig
+	{
+		const char* Name;
+		UINT SizeBytes;
+		UINT LineBytes;
+		UINT Ways;
+	};
+	constexpr std::array<CacheConfig, 3> s_CacheConfigs = { {
+		{ "16KB", 16 * 1024, 64, 4 },
+		{ "256KB", 256 * 1024, 128, 8 },
+		{ "2MB", 2 * 1024 * 1024, 128, 16 },
+	} };
+
+	constexpr UINT s_TileSize = 8;			// Rays are traced in tiles, as a wave would trace them
+	constexpr UINT s_MaxSteps = 128;
+
+
+	// Finds the brick that contains a point from its position on the brick grid
+	class BrickMap
+	{
+	public:
+		explicit BrickMap(const SDFBakeData& data)
+			: m_BrickSize(data.BrickSize)
+		{
+			m_Origin = float3(FLT_MAX);
+			for (const Brick& brick : data.Bricks)
+			{
+				m_Origin.x = (std::min)(m_Origin.x, brick.TopLeft.x);
+				m_Origin.y = (std::min)(m_Origin.y, brick.TopLeft.y);
+				m_Origin.z = (std::min)(m_Origin.z, brick.TopLeft.z);
+			}
+
+			m_Bricks.reserve(data.Bricks.size());
+			for (UINT i = 0; i < data.GetBrickCount(); i++)
+			{
+				const float3 cell = (float3(data.Bricks.at(i).TopLeft) - m_Origin) / m_BrickSize;
+				m_Bricks[GetKey(std::lround(cell.x), std::lround(cell.y), std::lround(cell.z))] = i;
+			}
+		}
+
+		// Returns false if there is no brick at the point
+		bool Find(const float3& p, UINT& outBrick) const
+		{
+			const float3 cell = (p - m_Origin) / m_BrickSize;
+			if (cell.x < 0.0f || cell.y < 0.0f || cell.z < 0.0f)
+				return false;
+
+			const auto it = m_Bricks.find(GetKey(static_cast<long>(cell.x), static_cast<long>(cell.y), static_cast<long>(cell.z)));
+			if (it == m_Bricks.end())
+				return false;
+			outBrick = it->second;
+			return true;
+		}
+
+	private:
+		static UINT64 GetKey(long x, long y, long z)
+		{
+			return (static_cast<UINT64>(x) << 42) | (static_cast<UINT64>(y) << 21) | static_cast<UINT64>(z);
+		}
+
+	private:
+		float m_BrickSize;
+		float3 m_Origin;
+		std::unordered_map<UINT64, UINT> m_Bricks;
+	};
+
+
+	// Samples the distance at a point within a brick, in the same way as the brick pool sampler in the raytracing shader
+	// The address of every texel that is fetched is passed to each cache
+	float SampleBrick(const SDFBakeData& data, const XMUINT3& resolution, UINT brickIndex, const float3& p, TraceResult& result)
+	{
+		const float voxelsPerUnit = SDF_BRICK_SIZE_VOXELS / data.BrickSize;
+		const Brick& brick = data.Bricks.at(brickIndex);
+		const XMUINT3 poolPosition = BrickHelpers::CalculateBrickPoolPosition(brick.PoolSlot, data.BrickPoolDimensions, data.PoolPlacement);
+
+		// Voxels are evaluated half a voxel before the top left of the brick
+		const float3 voxel = (p - float3(brick.TopLeft)) * voxelsPerUnit + 0.5f;
+
+		float sample[3];
+		UINT base[3];
+		float weight[3];
+		sample[0] = clamp(voxel.x, 0.0f, SDF_BRICK_SIZE_VOXELS_ADJACENCY - 1.0f);
+		sample[1] = clamp(voxel.y, 0.0f, SDF_BRICK_SIZE_VOXELS_ADJACENCY - 1.0f);
+		sample[2] = clamp(voxel.z, 0.0f, SDF_BRICK_SIZE_VOXELS_ADJACENCY - 1.0f);
+		for (UINT axis = 0; axis < 3; axis++)
+		{
+			base[axis] = (std::min)(static_cast<UINT>(sample[axis]), SDF_BRICK_SIZE_VOXELS_ADJACENCY - 2u);
+			weight[axis] = sample[axis] - static_cast<float>(base[axis]);
+		}
+
+		float distance = 0.0f;
+		for (UINT corner = 0; corner < 8; corner++)
+		{
+			const UINT x = poolPosition.x + base[0] + (corner & 1);
+			const UINT y = poolPosition.y + base[1] + ((corner >> 1) & 1);
+			const UINT z = poolPosition.z + base[2] + ((corner >> 2) & 1);
+			for (UINT model = 0; model < AddressModel::Count; model++)
+			{
+				const UINT64 address = GetTexelAddress(static_cast<AddressModel::Value>(model), resolution, x, y, z);
+				for (CacheSimulator& cache : result.Caches[model])
+					cache.Access(address);
+			}
+
+			const float w = ((corner & 1) ? weight[0] : 1.0f - weight[0])
+				* (((corner >> 1) & 1) ? weight[1] : 1.0f - weight[1])
+				* (((corner >> 2) & 1) ? weight[2] : 1.0f - weight[2]);
+			const size_t texel = (static_cast<size_t>(z) * resolution.y + y) * resolution.x + x;
+			distance += w * BrickHelpers::SNORM8ToFloat(data.BrickPool.at(4 * texel));
+		}
+
+		result.Samples++;
+		return distance * SDF_VOLUME_STRIDE / voxelsPerUnit;
+	}
+
+	// Sphere traces views of the bake from a few directions
+	void TraceBake(const SDFBakeData& data, UINT resolution, TraceResult& result)
+	{
+		result.Samples = 0;
+		result.SurfaceHits = 0;
+		for (auto& caches : result.Caches)
+		{
+			caches.clear();
+			for (const CacheConfig& config : s_CacheConfigs)
+				caches.emplace_back(config.SizeBytes, config.LineBytes, config.Ways);
+		}
+
+		if (data.GetBrickCount() == 0)
+			return;
+
+		const BrickMap brickMap(data);
+		const XMUINT3 poolResolution = data.GetBrickPoolResolution();
+		const float voxelSize = data.BrickSize / SDF_BRICK_SIZE_VOXELS;
+
+		float3 boundsMin(FLT_MAX);
+		float3 boundsMax(-FLT_MAX);
+		for (const D3D12_RAYTRACING_AABB& aabb : data.AABBs)
+		{
+			boundsMin = { (std::min)(boundsMin.x, aabb.MinX), (std::min)(boundsMin.y, aabb.MinY), (std::min)(boundsMin.z, aabb.MinZ) };
+			boundsMax = { (std::max)(boundsMax.x, aabb.MaxX), (std::max)(boundsMax.y, aabb.MaxY), (std::max)(boundsMax.z, aabb.MaxZ) };
+		}
+		const float3 centre = (boundsMin + boundsMax) * 0.5f;
+		const float radius = 0.5f * length(boundsMax - boundsMin);
+
+		const float3 viewDirections[] = {
+			{ 0.0f, 0.0f, 1.0f },
+			{ 1.0f, 0.0f, 0.0f },
+			{ -0.577f, -0.577f, 0.577f },
+		};
+
+		for (const float3& viewDirection : viewDirections)
+		{
+			const float3 forward = viewDirection / length(viewDirection);
+			const float3 up = fabsf(forward.y) > 0.9f ? float3(1.0f, 0.0f, 0.0f) : float3(0.0f, 1.0f, 0.0f);
+			float3 right = cross(up, forward);
+			right = right / length(right);
+			const float3 cameraUp = cross(forward, right);
+
+			// Frame the bounds of the object with a 60 degree field of view
+			const float3 eye = centre - forward * (2.0f * radius);
+			const float tanHalfFov = 0.577f;
+
+			for (UINT tileY = 0; tileY < resolution; tileY += s_TileSize)
+			for (UINT tileX = 0; tileX < resolution; tileX += s_TileSize)
+			for (UINT y = tileY; y < (std::min)(tileY + s_TileSize, resolution); y++)
+			for (UINT x = tileX; x < (std::min)(tileX + s_TileSize, resolution); x++)
+			{
+				const float u = (2.0f * (static_cast<float>(x) + 0.5f) / resolution - 1.0f) * tanHalfFov;
+				const float v = (1.0f - 2.0f * (static_cast<float>(y) + 0.5f) / resolution) * tanHalfFov;
+				float3 direction = forward + right * u + cameraUp * v;
+				direction = direction / length(direction);
+
+				float t = radius;
+				const float tMax = 3.0f * radius;
+				for (UINT step = 0; step < s_MaxSteps && t < tMax; step++)
+				{
+					const float3 p = eye + direction * t;
+
+					UINT brickIndex;
+					if (!brickMap.Find(p, brickIndex))
+					{
+						// Empty space between bricks is skipped by the acceleration structure on the GPU
+						t += 0.5f * data.BrickSize;
+						continue;
+					}
+
+					const float distance = SampleBrick(data, poolResolution, brickIndex, p, result);
+					if (distance < 0.25f * voxelSize)
+					{
+						result.SurfaceHits++;
+						break;
+					}
+					t += (std::max)(distance, 0.25f * voxelSize);
+				}
+			}
+		}
+	}
+}
+
+
+void BrickPlacementBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	std::vector<std::string> columns = { "Demo", "Placement", "Address Model", "Bricks", "Samples", "Surface Hits" };
+	for (const CacheConfig& cacheConfig : s_CacheConfigs)
+		columns.push_back(std::string(cacheConfig.Name) + " Hit Rate (%)");
+	report.SetColumns(columns);
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+	TraceResult results[BrickPoolPlacement::Count];
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		const SDFEditList editList = demo->BuildEditList(0.0f);
+
+		for (UINT placement = 0; placement < BrickPoolPlacement::Count; placement++)
+		{
+			factory.SetBrickPoolPlacement(static_cast<BrickPoolPlacement::Value>(placement));
+			factory.BakeSDF(editList, m_BrickSize, bakeData);
+
+			TraceResult& result = results[placement];
+			TraceBake(bakeData, m_Resolution, result);
+
+			for (UINT model = 0; model < AddressModel::Count; model++)
+			{
+				const std::vector<CacheSimulator>& caches = result.Caches[model];
+				report.AddRow(demoName, BrickPoolPlacement::GetName(static_cast<BrickPoolPlacement::Value>(placement)),
+					AddressModel::GetName(static_cast<AddressModel::Value>(model)),
+					bakeData.GetBrickCount(), result.Samples, result.SurfaceHits,
+					caches.at(0).GetHitRate(), caches.at(1).GetHitRate(), caches.at(2).GetHitRate());
+			}
+		}
+
+		// Placement only moves bricks within the pool, so every view must trace identically
+		if (results[BrickPoolPlacement::Linear].Samples != results[BrickPoolPlacement::Morton].Samples
+			|| results[BrickPoolPlacement::Linear].SurfaceHits != results[BrickPoolPlacement::Morton].SurfaceHits)
+		{
+			LOG_ERROR("Demo '{}' traces differently with each brick pool placement.", demoName);
+		}
+	}
+
+	factory.SetBrickPoolPlacement(BrickPoolPlacement::Linear);
+}
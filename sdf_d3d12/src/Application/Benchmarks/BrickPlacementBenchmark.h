@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Bakes each demo with each brick pool placement in the CPU factory, then sphere traces a view of it through the brick pool
+// The texels fetched by trilinear samples are replayed through models of set-associative texture caches,
+// with linear and tiled models of the texel addresses
+// Reports the hit rate of each cache, which shows how well the placement keeps neighbouring bricks close in memory
+class BrickPlacementBenchmark : public BaseBenchmark
+{
+	BrickPlacementBenchmark() = default;
+public:
+	static BrickPlacementBenchmark& Get()
+	{
+		static BrickPlacementBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Modelled texture cache hit rates when tracing each demo with each brick pool placement"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.125f;
+	UINT m_Resolution = 256;	// Width and height of each view, in rays
+};
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "EditBVHBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+
+
+void EditBVHBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	static const char* cullingModeNames[] =
+	{
+		"Point Sample",
+		"Interval"
+	};
+	static_assert(ARRAYSIZE(cullingModeNames) == BrickCullingMode::Count);
+
+	report.SetColumns({ "Demo", "Edits", "Culling", "Edit BVH", "Bricks", "Indices", "BVH Build (ms)", "Brick Building (ms)", "Speedup" });
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		const SDFEditList editList = demo->BuildEditList(0.0f);
+
+		for (UINT mode = 0; mode < BrickCullingMode::Count; mode++)
+		{
+			factory.SetCullingMode(static_cast<BrickCullingMode::Value>(mode));
+
+			float linearBrickBuilding = 0.0f;
+			size_t linearIndexCount = 0;
+
+			// Without the BVH first, so that the speedup can be reported
+			for (const bool enableBVH : { false, true })
+			{
+				factory.SetEditBVHEnabled(enableBVH);
+
+				const auto [bestBVHBuild, bestBrickBuilding] = MeasureBest(config, [&]()
+					{
+						factory.BakeSDF(editList, m_BrickSize, bakeData);
+
+						const auto& timings = factory.GetLastBakeTimings();
+						return std::array<float, 2>{ timings.EditBVH, timings.BrickBuilding };
+					});
+
+				if (!enableBVH)
+				{
+					linearBrickBuilding = bestBrickBuilding;
+					linearIndexCount = bakeData.Indices.size();
+				}
+				else if (bakeData.Indices.size() != linearIndexCount)
+				{
+					LOG_ERROR("Edit BVH changed the output of demo '{}': {} indices with the BVH, {} without.", demoName, bakeData.Indices.size(), linearIndexCount);
+				}
+
+				report.AddRow(demoName, editList.GetEditCount(), cullingModeNames[mode], enableBVH ? "On" : "Off",
+					bakeData.GetBrickCount(), bakeData.Indices.size(), bestBVHBuild, bestBrickBuilding,
+					static_cast<double>(linearBrickBuilding) / max(static_cast<double>(bestBrickBuilding), 1e-9));
+			}
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Compares edit testing in the CPU factory with and without the edit BVH
+// Reports the time to build the BVH and the bricks, for each culling mode in each demo
+class EditBVHBenchmark : public BaseBenchmark
+{
+	EditBVHBenchmark() = default;
+public:
+	static EditBVHBenchmark& Get()
+	{
+		static EditBVHBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Brick building time with and without the edit BVH, for each culling mode in each demo"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.0625f;
+};
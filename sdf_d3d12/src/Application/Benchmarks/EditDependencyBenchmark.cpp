@@ -0,0 +1,76 @@
+#include "pch.h"
+#include "EditDependencyBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "Framework/GameTimer.h"
+#include "SDF/SDFEditDependencies.h"
+#include "SDF/CPU/SDFHelpers.h"
+
+
+using namespace SDFHelpers;
+
+
+// Tests every pair of edits in the same way as the old edit_dependency.hlsl
+// Returns the total number of dependencies found
+static UINT FindAllPairsDependencies(const SDFEditData* edits, UINT editCount)
+{
+	UINT dependencyCount = 0;
+	for (UINT indexA = 1; indexA < editCount; indexA++)
+	{
+		const SDFEditData& editA = edits[indexA];
+		if (!IsSmoothEdit(editA.EditParams))
+			continue;
+
+		const float3 pA = -float3(editA.InvTranslation);
+		const float dA = EvaluateBoundingSphere(editA, pA);
+
+		for (UINT indexB = 0; indexB < indexA; indexB++)
+		{
+			const SDFEditData& editB = edits[indexB];
+			const float dB = EvaluateBoundingSphere(editB, pA);
+
+			if (dB + dA <= editA.BlendingRange + editB.BlendingRange)
+				dependencyCount += IsSmoothEdit(editB.EditParams) ? 2 : 1;
+		}
+	}
+	return dependencyCount;
+}
+
+
+void EditDependencyBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Demo", "Edits", "Method", "Pair Tests", "Dependencies", "Time (ms)", "Speedup" });
+
+	SDFEditDependencies dependencies;
+	GameTimer timer;
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		const SDFEditList editList = demo->BuildEditList(0.0f);
+		const UINT editCount = editList.GetEditCount();
+
+		UINT allPairsDependencies = 0;
+		const float allPairsTime = MeasureBest(config, [&]()
+			{
+				timer.Tick();
+				allPairsDependencies = FindAllPairsDependencies(editList.GetEditData(), editCount);
+				return timer.Tick();
+			});
+
+		const float sweepTime = MeasureBest(config, [&]()
+			{
+				timer.Tick();
+				dependencies.Build(editList.GetEditData(), editCount);
+				return timer.Tick();
+			});
+
+		if (dependencies.GetTotalDependencyCount() != allPairsDependencies)
+			LOG_ERROR("Edit dependencies in demo '{}' do not match: {} found by sweep and prune, {} by testing all pairs.",
+				demoName, dependencies.GetTotalDependencyCount(), allPairsDependencies);
+
+		const UINT64 pairCount = static_cast<UINT64>(editCount) * (editCount > 0 ? editCount - 1 : 0) / 2;
+		report.AddRow(demoName, editCount, "All Pairs", pairCount, allPairsDependencies, 1000.0f * allPairsTime, 1.0);
+		report.AddRow(demoName, editCount, "Sweep and Prune", dependencies.GetCandidatePairCount(), dependencies.GetTotalDependencyCount(),
+			1000.0f * sweepTime, static_cast<double>(allPairsTime) / max(static_cast<double>(sweepTime), 1e-9));
+	}
+}
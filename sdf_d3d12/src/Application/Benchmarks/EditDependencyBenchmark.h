@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Compares finding edit dependencies by testing every pair of edits, as the GPU factory used to,
+// against the sweep and prune broad phase in SDFEditDependencies
+class EditDependencyBenchmark : public BaseBenchmark
+{
+	EditDependencyBenchmark() = default;
+public:
+	static EditDependencyBenchmark& Get()
+	{
+		static EditDependencyBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Pair tests and time to find edit dependencies, with and without a broad phase, in each demo"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+};
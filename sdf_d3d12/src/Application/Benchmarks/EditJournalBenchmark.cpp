@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "EditJournalBenchmark.h"
+
+#include "Framework/GameTimer.h"
+#include "Framework/Math.h"
+#include "SDF/SDFEditJournal.h"
+#include "SDF/SDFEditListFile.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <filesystem>
+
+
+namespace
+{
+	struct SessionOperation
+	{
+		SDFEditJournalOp::Value Op;
+		UINT Stroke;	// For AddEdit, the index of the stroke. For SetEvaluationRange, the new range
+		// An undo of an empty edit list does nothing, and is not journaled, as in the editor
+		bool Journaled = true;
+	};
+
+	// A sculpting session of strokes with the occasional undo, and a clear whenever the edit list fills up
+	// The session opens with an undo of the empty list, and one follows every clear
+	// The edit list is kept in step with the session, so that it can be compared against the list a journal replays
+	std::vector<SessionOperation> BuildSession(UINT operationCount, const SDFEditList& strokes, SDFEditList& outEditList)
+	{
+		std::vector<SessionOperation> session;
+		session.reserve(operationCount);
+
+		// The same session is built every run
+		Random::Seed(static_cast<int>(operationCount));
+		bool emptyUndo = true;
+		for (UINT i = 0; i < operationCount; i++)
+		{
+			SessionOperation operation{ SDFEditJournalOp::AddEdit, static_cast<UINT>(Random::Int(static_cast<int>(strokes.GetEditCount()) - 1)) };
+
+			const int roll = Random::Int(999);
+			if (emptyUndo)
+				operation.Op = SDFEditJournalOp::PopEdit;
+			else if (outEditList.GetEditCount() == outEditList.GetMaxEdits())
+				operation.Op = SDFEditJournalOp::Reset;
+			else if (roll < 100 && outEditList.GetEditCount() > 0)
+				operation.Op = SDFEditJournalOp::PopEdit;
+			else if (roll == 999)
+				operation = { SDFEditJournalOp::SetEvaluationRange, static_cast<UINT>(Random::Int(2, 8)) };
+
+			switch (operation.Op)
+			{
+			case SDFEditJournalOp::AddEdit:				outEditList.AddEditData(strokes.GetEditData()[operation.Stroke]); break;
+			case SDFEditJournalOp::PopEdit:				operation.Journaled = outEditList.PopEdit(); break;
+			case SDFEditJournalOp::Reset:				outEditList.Reset(); break;
+			case SDFEditJournalOp::SetEvaluationRange:	outEditList.SetEvaluationRange(static_cast<float>(operation.Stroke)); break;
+			default: break;
+			}
+
+			emptyUndo = operation.Op == SDFEditJournalOp::Reset;
+			session.push_back(operation);
+		}
+
+		return session;
+	}
+
+	UINT64 GetFileSize(const std::string& path)
+	{
+		std::error_code error;
+		const auto size = std::filesystem::file_size(path, error);
+		return error ? 0 : static_cast<UINT64>(size);
+	}
+}
+
+
+void EditJournalBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Operation", "Records", "Size (MB)", "Time (ms)", "Records/s (M)", "Throughput (MB/s)", "Matches" });
+
+	char tempDirectory[MAX_PATH];
+	if (GetTempPathA(MAX_PATH, tempDirectory) == 0)
+	{
+		LOG_ERROR("Failed to find a temporary directory for edit journals.");
+		return;
+	}
+	const std::string journalPath = std::string(tempDirectory) + "benchmark.sdfjournal";
+	const std::string compactedPath = std::string(tempDirectory) + "benchmark-compacted.sdfjournal";
+	const std::string editListPath = std::string(tempDirectory) + "benchmark.sdfedits";
+
+	// Brush strokes scattered through a sculpt
+	SDFEditList strokes(m_StrokeCount);
+	Random::Seed(static_cast<int>(m_StrokeCount));
+	for (UINT i = 0; i < m_StrokeCount; i++)
+	{
+		const Transform transform{ Random::Float(-4.0f, 4.0f), Random::Float(-4.0f, 4.0f), Random::Float(-4.0f, 4.0f) };
+		const SDFOperation op = i % 8 == 7 ? SDF_OP_SMOOTH_SUBTRACTION : SDF_OP_SMOOTH_UNION;
+		strokes.AddEdit(SDFEdit::CreateSphere(transform, Random::Float(0.1f, 0.3f), op, 0.05f, i % 4));
+	}
+
+	SDFEditList expectedList(SDF_EDIT_LIMIT);
+	const std::vector<SessionOperation> session = BuildSession(m_OperationCount, strokes, expectedList);
+	// The journal begins with the evaluation range of the list it was started from
+	const UINT64 journalRecords = 1ull + static_cast<UINT64>(std::count_if(session.begin(), session.end(),
+		[](const SessionOperation& operation) { return operation.Journaled; }));
+
+	GameTimer timer;
+	SDFEditList replayedList(SDF_EDIT_LIMIT);
+
+	auto addRow = [&report](const char* name, UINT64 records, UINT64 size, float time, bool matches)
+		{
+			const double seconds = static_cast<double>(time) / 1000.0;
+			const double megabytes = static_cast<double>(size) / (1024.0 * 1024.0);
+			report.AddRow(name, records, megabytes, time, static_cast<double>(records) / seconds / 1e6, megabytes / seconds, matches ? "Yes" : "No");
+		};
+
+	// Each operation is appended and flushed as the editor would after each stroke
+	{
+		bool opened = true;
+		bool matches = true;
+		const float best = MeasureBest(config, [&]()
+			{
+				DeleteFileA(journalPath.c_str());
+
+				SDFEditJournal journal;
+				SDFEditList startList(SDF_EDIT_LIMIT);
+				opened &= journal.Open(journalPath, startList);
+				if (!opened)
+					return FLT_MAX;
+
+				timer.Reset();
+				for (const auto& operation : session)
+				{
+					if (!operation.Journaled)
+						continue;
+
+					switch (operation.Op)
+					{
+					case SDFEditJournalOp::AddEdit:				journal.RecordAddEdit(strokes.GetEditData()[operation.Stroke]); break;
+					case SDFEditJournalOp::PopEdit:				journal.RecordPopEdit(); break;
+					case SDFEditJournalOp::Reset:				journal.RecordReset(); break;
+					case SDFEditJournalOp::SetEvaluationRange:	journal.RecordSetEvaluationRange(static_cast<float>(operation.Stroke)); break;
+					default: break;
+					}
+				}
+				const float time = 1000.0f * timer.Tick();
+
+				matches &= journal.IsOpen() && journal.GetRecordCount() == journalRecords;
+				return time;
+			});
+		if (!opened)
+			return;
+
+		addRow("Journal Append", journalRecords, GetFileSize(journalPath), best, matches);
+	}
+
+	// Replay the whole session
+	{
+		bool matches = true;
+		const float best = MeasureBest(config, [&]()
+			{
+				SDFEditJournal::ReplayStats stats;
+				timer.Reset();
+				matches &= SDFEditJournal::Replay(journalPath, replayedList, &stats);
+				const float time = 1000.0f * timer.Tick();
+
+				matches &= stats.RecordCount == journalRecords && !stats.TornRecord;
+				matches &= replayedList.GetHash() == expectedList.GetHash();
+				return time;
+			});
+		addRow("Journal Replay", journalRecords, GetFileSize(journalPath), best, matches);
+	}
+
+	// Rewrite the journal as one record per edit, and replay that
+	{
+		bool matches = true;
+		const auto [bestWrite, bestReplay] = MeasureBest(config, [&]()
+			{
+				std::array<float, 2> times;
+				timer.Reset();
+				matches &= SDFEditJournal::WriteCompacted(compactedPath, expectedList);
+				times[0] = 1000.0f * timer.Tick();
+
+				matches &= SDFEditJournal::Replay(compactedPath, replayedList);
+				times[1] = 1000.0f * timer.Tick();
+
+				matches &= replayedList.GetHash() == expectedList.GetHash();
+				return times;
+			});
+
+		const UINT64 records = 1ull + expectedList.GetEditCount();
+		addRow("Journal Compaction", records, GetFileSize(compactedPath), bestWrite, matches);
+		addRow("Compacted Journal Replay", records, GetFileSize(compactedPath), bestReplay, matches);
+	}
+
+	// A record torn part way through is dropped, and everything before it is kept
+	{
+		std::error_code error;
+		std::filesystem::resize_file(journalPath, GetFileSize(journalPath) - 1, error);
+
+		SDFEditJournal::ReplayStats stats;
+		timer.Reset();
+		bool matches = !error && SDFEditJournal::Replay(journalPath, replayedList, &stats);
+		const float time = 1000.0f * timer.Tick();
+
+		matches &= stats.TornRecord && stats.RecordCount == journalRecords - 1;
+		addRow("Torn Journal Replay", stats.RecordCount, stats.ValidSize, time, matches);
+	}
+
+	// Edit list files of a full edit list
+	{
+		SDFEditList fullList(SDF_EDIT_LIMIT);
+		for (UINT i = 0; i < SDF_EDIT_LIMIT; i++)
+			fullList.AddEditData(strokes.GetEditData()[i % m_StrokeCount]);
+
+		bool matches = true;
+		const auto [bestWrite, bestRead] = MeasureBest(config, [&]()
+			{
+				std::array<float, 2> times;
+				timer.Reset();
+				matches &= SDFEditListFile::Write(editListPath, fullList);
+				times[0] = 1000.0f * timer.Tick();
+
+				matches &= SDFEditListFile::Read(editListPath, replayedList);
+				times[1] = 1000.0f * timer.Tick();
+
+				matches &= replayedList.GetHash() == fullList.GetHash();
+				return times;
+			});
+
+		addRow("Edit List Write", fullList.GetEditCount(), GetFileSize(editListPath), bestWrite, matches);
+		addRow("Edit List Read", fullList.GetEditCount(), GetFileSize(editListPath), bestRead, matches);
+	}
+
+	DeleteFileA(journalPath.c_str());
+	DeleteFileA(compactedPath.c_str());
+	DeleteFileA(editListPath.c_str());
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Records a long sculpting session to an edit journal, one flushed record per operation as the editor does,
+// and then replays and compacts it. Edit list files of a full edit list are written and read as well.
+// Every file is read back into an edit list and its hash compared against the list it was written from.
+class EditJournalBenchmark : public BaseBenchmark
+{
+	EditJournalBenchmark() = default;
+public:
+	static EditJournalBenchmark& Get()
+	{
+		static EditJournalBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Append, replay and compaction throughput of edit journals, and of edit list files"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	UINT m_OperationCount = 1'000'000;
+	// How many distinct brush strokes the session is built from
+	UINT m_StrokeCount = 4096;
+};
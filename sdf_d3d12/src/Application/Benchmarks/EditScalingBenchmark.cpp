@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "EditScalingBenchmark.h"
+
+#include "Framework/Math.h"
+#include "SDF/SDFEditList.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+
+
+// Scatters small smooth strokes through a cube, as a sculpt built up from many brush strokes would
+// The cube grows with the edit count so that the density of edits stays the same
+static SDFEditList BuildSculpt(UINT editCount)
+{
+	const float halfExtent = 2.0f * std::cbrt(static_cast<float>(editCount) / 1024.0f);
+	SDFEditList editList(editCount, 2.0f * halfExtent + 1.0f);
+
+	// The same sculpt is built every run
+	Random::Seed(static_cast<int>(editCount));
+	for (UINT edit = 0; edit < editCount; edit++)
+	{
+		const Transform transform{
+			Random::Float(-halfExtent, halfExtent),
+			Random::Float(-halfExtent, halfExtent),
+			Random::Float(-halfExtent, halfExtent)
+		};
+		const float radius = Random::Float(0.1f, 0.3f);
+
+		// Every eighth stroke carves rather than adds
+		const SDFOperation op = edit % 8 == 7 ? SDF_OP_SMOOTH_SUBTRACTION : SDF_OP_SMOOTH_UNION;
+		editList.AddEdit(SDFEdit::CreateSphere(transform, radius, op, 0.05f, edit % 4));
+	}
+
+	return editList;
+}
+
+
+void EditScalingBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Edits", "Bricks", "Indices", "Indices Per Brick", "Index Buffer (MB)",
+		"Dependencies (ms)", "Edit BVH (ms)", "Brick Building (ms)", "Brick Evaluation (ms)", "Total (ms)", "Total Per Edit (us)" });
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+
+	for (UINT editCount = 1024; editCount <= SDF_EDIT_LIMIT; editCount *= 2)
+	{
+		const SDFEditList editList = BuildSculpt(editCount);
+
+		const auto [editDependencies, editBVH, brickBuilding, brickEvaluation, total] = MeasureBest(config, [&]()
+			{
+				factory.BakeSDF(editList, m_BrickSize, bakeData);
+
+				const auto& timings = factory.GetLastBakeTimings();
+				return std::array<float, 5>{ timings.EditDependencies, timings.EditBVH, timings.BrickBuilding, timings.BrickEvaluation, timings.Total };
+			});
+
+		const UINT brickCount = bakeData.GetBrickCount();
+		const size_t indexCount = bakeData.Indices.size();
+		report.AddRow(editCount, brickCount, indexCount,
+			static_cast<double>(indexCount) / max(static_cast<double>(brickCount), 1.0),
+			static_cast<double>(indexCount * sizeof(UINT)) / (1024.0 * 1024.0),
+			editDependencies, editBVH, brickBuilding, brickEvaluation, total,
+			1000.0 * static_cast<double>(total) / static_cast<double>(editCount));
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Bakes synthetic sculpts of 1k to 64k edits with the CPU factory
+// Reports how the stages of the bake and the size of the index buffer scale with the number of edits
+class EditScalingBenchmark : public BaseBenchmark
+{
+	EditScalingBenchmark() = default;
+public:
+	static EditScalingBenchmark& Get()
+	{
+		static EditScalingBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Bake time and index buffer size of synthetic sculpts from 1k to 64k edits"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.125f;
+};
@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "PacketEvaluationBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "Framework/GameTimer.h"
+#include "SDF/CPU/SDFPacketEvaluator.h"
+
+#include <random>
+
+
+void PacketEvaluationBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	static const char* shapeNames[] =
+	{
+		"Sphere",
+		"Box",
+		"Torus",
+		"Octahedron",
+		"BoxFrame",
+		"Fractal"
+	};
+	static_assert(ARRAYSIZE(shapeNames) == SDFEditListSoA::s_ShapeCount);
+
+	report.SetColumns({ "Demo", "Shape", "Edits", "SIMD", "Evaluations/s (M)", "Speedup" });
+
+	std::vector<float> positionsX(m_PointCount);
+	std::vector<float> positionsY(m_PointCount);
+	std::vector<float> positionsZ(m_PointCount);
+	std::vector<float> distances(m_PointCount);
+
+	GameTimer timer;
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		const SDFEditList editList = demo->BuildEditList(0.0f);
+
+		// Points are spread throughout the evaluation space of the demo
+		std::mt19937 generator(0);
+		const float halfRange = 0.5f * editList.GetEvaluationRange();
+		std::uniform_real_distribution<float> distribution(-halfRange, halfRange);
+		for (UINT i = 0; i < m_PointCount; i++)
+		{
+			positionsX.at(i) = distribution(generator);
+			positionsY.at(i) = distribution(generator);
+			positionsZ.at(i) = distribution(generator);
+		}
+
+		// The edit list keeps its edits grouped by shape
+		for (UINT shape = 0; shape < ARRAYSIZE(shapeNames); shape++)
+		{
+			const auto& indices = editList.GetSoA().GetShapeBucket(static_cast<SDFShape>(shape));
+			if (indices.empty())
+				continue;
+
+			SDFPacketEvaluation evaluation;
+			evaluation.Edits = editList.GetEditData();
+			evaluation.Indices = indices.data();
+			evaluation.EditCount = static_cast<UINT>(indices.size());
+			evaluation.PositionsX = positionsX.data();
+			evaluation.PositionsY = positionsY.data();
+			evaluation.PositionsZ = positionsZ.data();
+			evaluation.PointCount = m_PointCount;
+			evaluation.OutDistances = distances.data();
+
+			const double evaluationCount = static_cast<double>(m_PointCount) * evaluation.EditCount;
+			double scalarRate = 0.0;
+
+			for (UINT level = 0; level < SIMDLevel::Count; level++)
+			{
+				if (!SDFPacketEvaluator::IsLevelSupported(static_cast<SIMDLevel::Value>(level)))
+					continue;
+
+				const SDFPacketEvaluator evaluator(static_cast<SIMDLevel::Value>(level));
+
+				const float bestTime = MeasureBest(config, [&]()
+					{
+						timer.Tick();
+						evaluator.Evaluate(evaluation);
+						return timer.Tick();
+					});
+
+				const double rate = evaluationCount / max(static_cast<double>(bestTime), 1e-9);
+				if (level == SIMDLevel::Scalar)
+					scalarRate = rate;
+
+				report.AddRow(demoName, shapeNames[shape], evaluation.EditCount, SDFPacketEvaluator::GetLevelName(evaluator.GetLevel()),
+					rate / 1e6, scalarRate > 0.0 ? rate / scalarRate : 0.0);
+			}
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Measures the throughput of the packet evaluator at each SIMD level,
+// for each shape type used by each of the demos
+class PacketEvaluationBenchmark : public BaseBenchmark
+{
+	PacketEvaluationBenchmark() = default;
+public:
+	static PacketEvaluationBenchmark& Get()
+	{
+		static PacketEvaluationBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Edit evaluations per second for each shape in each demo, at each SIMD level"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	UINT m_PointCount = 4096;
+};
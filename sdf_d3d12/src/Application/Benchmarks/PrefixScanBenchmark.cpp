@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "PrefixScanBenchmark.h"
+
+#include "Framework/GameTimer.h"
+#include "Framework/PrefixScan.h"
+#include "Framework/ThreadPool.h"
+
+#include <algorithm>
+#include <random>
+
+
+void PrefixScanBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Elements", "Variant", "Time (us)", "Elements/s (M)", "Speedup", "Matches Serial" });
+
+	ThreadPool threadPool(config.ThreadCount);
+	PrefixScan prefixScan(&threadPool);
+
+	// Sub-brick counts are between 0 and 64
+	std::mt19937 generator(0);
+	std::uniform_int_distribution<UINT> distribution(0, 64);
+	std::vector<UINT> input(m_MaxElementCount);
+	for (auto& count : input)
+	{
+		count = distribution(generator);
+	}
+
+	std::vector<UINT> reference(static_cast<size_t>(m_MaxElementCount) + 1);
+	std::vector<UINT> output(static_cast<size_t>(m_MaxElementCount) + 1);
+
+	GameTimer timer;
+
+	for (UINT elementCount = m_MinElementCount; elementCount <= m_MaxElementCount; elementCount *= 4)
+	{
+		prefixScan.ExclusiveScan(input.data(), elementCount, reference.data(), PrefixScanVariant::Serial);
+
+		const UINT repeats = (std::max)(m_MinElementsPerMeasurement / elementCount, 1u);
+		float serialTime = 0.0f;
+
+		for (UINT variant = 0; variant < PrefixScanVariant::Count; variant++)
+		{
+			const auto scanVariant = static_cast<PrefixScanVariant::Value>(variant);
+
+			const float bestTime = MeasureBest(config, [&]()
+				{
+					timer.Tick();
+					for (UINT repeat = 0; repeat < repeats; repeat++)
+					{
+						prefixScan.ExclusiveScan(input.data(), elementCount, output.data(), scanVariant);
+					}
+					return timer.Tick() / static_cast<float>(repeats);
+				});
+
+			if (scanVariant == PrefixScanVariant::Serial)
+				serialTime = bestTime;
+
+			const bool matches = std::equal(reference.begin(), reference.begin() + elementCount + 1, output.begin());
+			if (!matches)
+			{
+				LOG_ERROR("Prefix scan variant '{}' does not match the serial scan for {} elements.", PrefixScanVariant::GetName(scanVariant), elementCount);
+			}
+
+			report.AddRow(elementCount, PrefixScanVariant::GetName(scanVariant),
+				static_cast<double>(bestTime) * 1.0e6,
+				static_cast<double>(elementCount) / (static_cast<double>(bestTime) * 1.0e6),
+				static_cast<double>(serialTime) / (std::max)(static_cast<double>(bestTime), 1e-12),
+				matches ? "Yes" : "No");
+		}
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Measures each prefix scan variant over inputs from 64 to 16M elements
+// The inputs are sub-brick counts, as scanned by the brick builder
+class PrefixScanBenchmark : public BaseBenchmark
+{
+	PrefixScanBenchmark() = default;
+public:
+	static PrefixScanBenchmark& Get()
+	{
+		static PrefixScanBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Prefix scan throughput of each variant from 64 to 16M elements"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	UINT m_MinElementCount = 64;
+	UINT m_MaxElementCount = 16 * 1024 * 1024;
+	// Small inputs are scanned repeatedly, so that each measurement covers at least this many elements
+	UINT m_MinElementsPerMeasurement = 1024 * 1024;
+};
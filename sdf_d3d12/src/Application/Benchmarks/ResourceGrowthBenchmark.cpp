@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "ResourceGrowthBenchmark.h"
+
+#include "Application/Demo/Demos.h"
+#include "SDF/SDFGrowthPolicy.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+
+
+namespace
+{
+	struct GrowthResult
+	{
+		UINT Allocations = 0;
+		UINT Reuses = 0;
+		UINT64 PeakCapacity = 0;
+		double AverageUtilization = 0.0;
+	};
+
+	// Follows SDFObject: each resource group has its own resource, and replaced resources are retired for either group to reuse
+	GrowthResult SimulateGrowth(const SDFGrowthPolicy& policy, const std::vector<UINT64>& requiredCounts, bool brickPool)
+	{
+		constexpr size_t maxRetired = 2;
+
+		GrowthResult result;
+		std::array<SDFGrowthPolicy::State, 2> states;
+		std::vector<UINT64> retired;
+
+		for (size_t frame = 0; frame < requiredCounts.size(); frame++)
+		{
+			const UINT64 required = requiredCounts.at(frame);
+			SDFGrowthPolicy::State& state = states.at(frame % 2);
+
+			const UINT64 target = policy.Update(state, required);
+			if (state.Capacity == 0 || target != state.Capacity)
+			{
+				const int reusable = policy.FindReusable(retired, required, target);
+
+				const UINT64 previous = state.Capacity;
+				if (reusable >= 0)
+				{
+					state.Capacity = retired.at(reusable);
+					retired.erase(retired.begin() + reusable);
+					result.Reuses++;
+				}
+				else
+				{
+					// Brick pools are rounded up to whole dimensions
+					if (brickPool)
+					{
+						const XMUINT3 dims = SDFGrowthPolicy::CalculateBrickPoolDimensions(static_cast<UINT>(target));
+						state.Capacity = static_cast<UINT64>(dims.x) * dims.y * dims.z;
+					}
+					else
+					{
+						state.Capacity = (std::max)(target, 1ull);
+					}
+					result.Allocations++;
+				}
+
+				if (previous > 0 && policy.GetSettings().ReuseSlack > 0.0f)
+				{
+					retired.push_back(previous);
+					if (retired.size() > maxRetired)
+						retired.erase(retired.begin());
+				}
+			}
+
+			result.PeakCapacity = (std::max)(result.PeakCapacity, states.at(0).Capacity + states.at(1).Capacity);
+			result.AverageUtilization += static_cast<double>(required) / static_cast<double>(state.Capacity);
+		}
+
+		result.AverageUtilization /= (std::max)(requiredCounts.size(), size_t(1));
+		return result;
+	}
+}
+
+
+void ResourceGrowthBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Demo", "Resource", "Policy", "Allocations", "Reuses", "Peak Capacity", "Average Utilization" });
+
+	SDFFactoryCPU factory(config.ThreadCount);
+	SDFBakeData bakeData;
+
+	const std::pair<const char*, SDFGrowthPolicy> policies[] = {
+		{ "Legacy", SDFGrowthPolicy(SDFGrowthPolicy::GetLegacySettings()) },
+		{ "Amortized", SDFGrowthPolicy() }
+	};
+
+	for (const auto& [demoName, demo] : BaseDemo::GetAllDemos())
+	{
+		// Record the sizes each frame requires
+		std::vector<UINT64> brickCounts;
+		std::vector<UINT64> indexCounts;
+		brickCounts.reserve(m_FrameCount);
+		indexCounts.reserve(m_FrameCount);
+		for (UINT frame = 0; frame < m_FrameCount; frame++)
+		{
+			factory.BakeSDF(demo->BuildEditList(m_FrameTime), m_BrickSize, bakeData);
+			brickCounts.push_back(bakeData.GetBrickCount());
+			indexCounts.push_back(bakeData.Indices.size());
+		}
+
+		for (const auto& [policyName, policy] : policies)
+		{
+			const GrowthResult pool = SimulateGrowth(policy, brickCounts, true);
+			report.AddRow(demoName, "Brick Pool", policyName, pool.Allocations, pool.Reuses, pool.PeakCapacity, pool.AverageUtilization);
+		}
+
+		for (const auto& [policyName, policy] : policies)
+		{
+			// The factory gives index buffers extra headroom, as incremental bakes append to them
+			SDFGrowthPolicy::Settings settings = policy.GetSettings();
+			settings.GrowthHeadroom = (std::max)(settings.GrowthHeadroom, 0.5f);
+
+			const GrowthResult index = SimulateGrowth(SDFGrowthPolicy(settings), indexCounts, false);
+			report.AddRow(demoName, "Index Buffer", policyName, index.Allocations, index.Reuses, index.PeakCapacity, index.AverageUtilization);
+		}
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Replays the brick and index counts of animated demos through the resource growth policy,
+// alternating between the two resource groups as the async factory does
+// Compares the number of allocations and the memory used against the policy the factory used before
+class ResourceGrowthBenchmark : public BaseBenchmark
+{
+	ResourceGrowthBenchmark() = default;
+public:
+	static ResourceGrowthBenchmark& Get()
+	{
+		static ResourceGrowthBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Brick pool and index buffer allocations over animated frames of each demo, for each growth policy"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+
+private:
+	float m_BrickSize = 0.0625f;
+	UINT m_FrameCount = 120;
+	float m_FrameTime = 1.0f / 60.0f;
+};
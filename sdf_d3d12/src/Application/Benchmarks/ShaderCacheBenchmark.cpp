@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "ShaderCacheBenchmark.h"
+
+#include "Framework/GameTimer.h"
+#include "Framework/Hash.h"
+#include "Renderer/D3DPipeline.h"
+#include "Renderer/D3DShaderCompiler.h"
+
+#include <cfloat>
+#include <filesystem>
+#include <functional>
+
+
+namespace
+{
+	struct ShaderPermutation
+	{
+		std::wstring File;
+		const wchar_t* Target;
+		std::vector<std::wstring> Defines;
+	};
+
+	// The permutations that are compiled at startup
+	std::vector<ShaderPermutation> FindShaderPermutations()
+	{
+		std::vector<ShaderPermutation> permutations;
+
+		std::error_code error;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator("assets/shaders/compute", error))
+		{
+			if (entry.path().extension() != ".hlsl")
+				continue;
+
+			// Pipeline sets of the factory are built with and without edit culling
+			permutations.push_back({ entry.path().generic_wstring(), L"cs", {} });
+			permutations.push_back({ entry.path().generic_wstring(), L"cs", { L"DISABLE_EDIT_CULLING" } });
+		}
+		permutations.push_back({ L"assets/shaders/raytracing/raytracing.hlsl", L"lib", {} });
+
+		return permutations;
+	}
+
+	// Returns false if any shader fails to compile
+	// In parallel, each shader is compiled as a task of a pipeline builder, as the factory and renderer compile them
+	bool CompileAll(const std::vector<ShaderPermutation>& permutations, bool parallel, std::vector<UINT64>& outBlobHashes)
+	{
+		outBlobHashes.assign(permutations.size(), 0);
+		std::atomic<bool> succeeded = true;
+
+		auto compile = [&](size_t index)
+			{
+				const auto& permutation = permutations.at(index);
+				ComPtr<IDxcBlob> blob;
+				if (FAILED(D3DShaderCompiler::CompileFromFile(permutation.File.c_str(), L"main", permutation.Target, permutation.Defines, &blob)))
+				{
+					succeeded = false;
+					return;
+				}
+				outBlobHashes.at(index) = Hash::Bytes(blob->GetBufferPointer(), blob->GetBufferSize());
+			};
+
+		if (parallel)
+		{
+			D3DPipelineBuilder builder;
+			for (size_t i = 0; i < permutations.size(); i++)
+				builder.Add([&compile, i]() { compile(i); });
+			builder.Wait();
+		}
+		else
+		{
+			for (size_t i = 0; i < permutations.size() && succeeded; i++)
+				compile(i);
+		}
+
+		return succeeded;
+	}
+}
+
+
+void ShaderCacheBenchmark::Run(const BenchmarkConfig& config, BenchmarkReport& report)
+{
+	report.SetColumns({ "Pass", "Shaders", "Hits", "Hit Rate (%)", "Time (ms)", "Preprocess (ms)", "Compile (ms)", "Saved (ms)", "Matches" });
+
+	char tempDirectory[MAX_PATH];
+	if (GetTempPathA(MAX_PATH, tempDirectory) == 0)
+	{
+		LOG_ERROR("Failed to find a temporary directory for the shader cache.");
+		return;
+	}
+	const std::string cacheDirectory = std::string(tempDirectory) + "benchmark_shader_cache";
+
+	const std::vector<ShaderPermutation> permutations = FindShaderPermutations();
+	std::vector<UINT64> expectedHashes;
+	std::vector<UINT64> blobHashes;
+	GameTimer timer;
+
+	// Runs a pass the configured number of times, and reports the fastest
+	// The cache is prepared before each run by the setup function
+	auto runPass = [&](const char* name, bool parallel, const std::function<void()>& setup)
+		{
+			float best = FLT_MAX;
+			D3DShaderCompiler::CacheStatistics bestStats;
+			bool matches = true;
+
+			for (UINT iteration = 0; iteration < config.Iterations; iteration++)
+			{
+				setup();
+				D3DShaderCompiler::ResetCacheStatistics();
+
+				timer.Reset();
+				matches &= CompileAll(permutations, parallel, blobHashes);
+				const float time = 1000.0f * timer.Tick();
+
+				// Without the cache, every blob is the expected blob
+				if (expectedHashes.empty())
+					expectedHashes = blobHashes;
+				matches &= blobHashes == expectedHashes;
+
+				if (time < best)
+				{
+					best = time;
+					bestStats = D3DShaderCompiler::GetCacheStatistics();
+				}
+			}
+
+			report.AddRow(name, permutations.size(), bestStats.Hits, 100.0f * bestStats.GetHitRate(), best,
+				bestStats.PreprocessTime, bestStats.CompileTime, bestStats.SavedTime, matches ? "Yes" : "No");
+		};
+
+	auto clearCache = [&cacheDirectory]()
+		{
+			std::error_code error;
+			std::filesystem::remove_all(cacheDirectory, error);
+			D3DShaderCompiler::SetCacheDirectory(cacheDirectory);
+		};
+
+	runPass("Uncached", false, []() { D3DShaderCompiler::SetCacheDirectory(""); });
+	runPass("Uncached Parallel", true, []() {});
+	runPass("Cold Cache", false, clearCache);
+	runPass("Cold Cache Parallel", true, clearCache);
+	runPass("Warm Cache", false, []() {});
+	runPass("Warm Cache Parallel", true, []() {});
+	runPass("Half Warm Cache", false, [&]()
+		{
+			clearCache();
+			CompileAll(permutations, false, blobHashes);
+
+			// Every other entry is lost
+			std::vector<std::filesystem::path> entries;
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(cacheDirectory, error))
+				entries.push_back(entry.path());
+			for (size_t i = 1; i < entries.size(); i += 2)
+				std::filesystem::remove(entries.at(i), error);
+		});
+
+	D3DShaderCompiler::SetCacheDirectory("");
+	std::error_code error;
+	std::filesystem::remove_all(cacheDirectory, error);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Benchmark.h"
+
+
+// Compiles every compute shader with each define set the factory uses, and the raytracing library,
+// first with the shader cache disabled, and then through a cache that starts empty, is full, and has lost half its entries
+// Each pass is run both one shader at a time and with every shader compiled in parallel, as pipelines are created
+// Every blob is compared against the blob compiled without the cache
+class ShaderCacheBenchmark : public BaseBenchmark
+{
+	ShaderCacheBenchmark() = default;
+public:
+	static ShaderCacheBenchmark& Get()
+	{
+		static ShaderCacheBenchmark instance;
+		return instance;
+	}
+
+	virtual const char* GetDescription() const override { return "Hit rates and startup time of the shader cache when cold, warm and partially warm, compiling serially and in parallel"; }
+	virtual void Run(const BenchmarkConfig& config, BenchmarkReport& report) override;
+};
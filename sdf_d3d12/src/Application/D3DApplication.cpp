@@ -18,8 +18,10 @@
 #include <iomanip>
 
 #include "Editor.h"
+#include "PagedScene.h"
 #include "Framework/Picker.h"
 #include "Renderer/D3DDebugTools.h"
+#include "Renderer/D3DShaderCompiler.h"
 #include "Demo/DemoScene.h"
 #include "Framework/GuiHelpers.h"
 
@@ -28,6 +30,8 @@ D3DApplication::D3DApplication(UINT width, UINT height, const std::wstring& name
 	: BaseApplication(width, height, name)
 {
 	m_ProfilingDataCollector = std::make_unique<ProfilingDataCollector>(this);
+	m_HeadlessBaker = std::make_unique<HeadlessBaker>();
+	m_BenchmarkRunner = std::make_unique<BenchmarkRunner>();
 }
 
 
@@ -67,6 +71,12 @@ bool D3DApplication::ParseCommandLineArgs(LPWSTR argv[], int argc)
 
 	args::Group applicationFlags(parser, "Application Flags");
 	args::Flag orbitalCamera(applicationFlags, "Orbital Camera", "Enable an orbital camera", { "orbital-camera" });
+	args::ValueFlag<std::string> bakeCache(applicationFlags, "Bake Cache", "Directory to load baked demos from, and to save them to when they are first baked", { "bake-cache" });
+	args::ValueFlag<std::string> editJournal(applicationFlags, "Edit Journal", "Journal to record the edits made in the editor to, which is replayed when the editor is next opened", { "edit-journal" });
+	args::ValueFlag<std::string> brickPages(applicationFlags, "Brick Pages", "Page file to stream the object of the paged scene from", { "brick-pages" });
+	args::ValueFlag<UINT> brickPageBudget(applicationFlags, "Brick Page Budget", "Size of the brick pool that pages are streamed into, in MB", { "brick-page-budget" });
+	args::ValueFlag<std::string> shaderCache(applicationFlags, "Shader Cache", "Directory to cache compiled shaders in", { "shader-cache" });
+	args::Flag noShaderCache(applicationFlags, "No Shader Cache", "Compile every shader from source", { "no-shader-cache" });
 
 #ifdef ENABLE_INSTRUMENTATION
 	// These settings won't do anything in a non-instrumented build
@@ -76,6 +86,15 @@ bool D3DApplication::ParseCommandLineArgs(LPWSTR argv[], int argc)
 		});
 #endif
 
+	args::Command bakeCPUCommand(parser, "bake-cpu", "Bake a demo on the CPU without creating a window", [this](args::Subparser& subparser)
+		{
+			this->m_HeadlessBaker->ParseCommandLineArgs(subparser);
+		});
+	args::Command benchmarkCommand(parser, "benchmark", "Run a CPU benchmark without creating a window", [this](args::Subparser& subparser)
+		{
+			this->m_BenchmarkRunner->ParseCommandLineArgs(subparser);
+		});
+
 	try
 	{
 		parser.ParseCLI(args);
@@ -113,6 +132,30 @@ bool D3DApplication::ParseCommandLineArgs(LPWSTR argv[], int argc)
 
 	if (orbitalCamera)
 		m_UseOrbitalCamera = true;
+	if (bakeCache)
+		m_BakeCacheDirectory = bakeCache.Get();
+	if (editJournal)
+		m_EditJournalPath = editJournal.Get();
+	if (brickPages)
+		m_BrickPagePath = brickPages.Get();
+	if (brickPageBudget)
+		m_BrickPageBudget = (std::max)(brickPageBudget.Get(), 1u);
+	if (shaderCache)
+		m_ShaderCacheDirectory = shaderCache.Get();
+	if (noShaderCache)
+		m_DisableShaderCache = true;
+
+	if (m_HeadlessBaker->IsEnabled())
+	{
+		// Headless mode never creates a window
+		m_HeadlessBaker->Run();
+		return false;
+	}
+	if (m_BenchmarkRunner->IsEnabled())
+	{
+		m_BenchmarkRunner->Run();
+		return false;
+	}
 
 	return true;
 }
@@ -127,6 +170,16 @@ void D3DApplication::OnInit()
 
 	m_TextureLoader = std::make_unique<TextureLoader>();
 
+	// Set up the shader cache before any pipelines are created
+	if (!m_DisableShaderCache)
+	{
+		std::string shaderCacheDirectory = m_ShaderCacheDirectory;
+		char tempDirectory[MAX_PATH];
+		if (shaderCacheDirectory.empty() && GetTempPathA(MAX_PATH, tempDirectory) != 0)
+			shaderCacheDirectory = std::string(tempDirectory) + "sdf_d3d12_shader_cache";
+		D3DShaderCompiler::SetCacheDirectory(shaderCacheDirectory);
+	}
+
 	// Setup camera
 	m_Camera.SetPosition(XMVECTOR{ 0.0f, 0.0f, -10.0f });
 	m_Timer.Reset();
@@ -145,6 +198,7 @@ void D3DApplication::OnInit()
 	m_MaterialManager = std::make_unique<MaterialManager>(4);
 
 	m_Factory = std::make_unique<SDFFactoryHierarchicalAsync>();
+	m_CPUFactory = std::make_unique<SDFFactoryCPU>();
 
 	BaseDemo::CreateAllDemos();
 	if (m_ProfilingDataCollector->InitProfiler())
@@ -201,6 +255,8 @@ void D3DApplication::OnInit()
 	m_PassCB.HeatmapQuantization = 16;
 	m_PassCB.HeatmapHueRange = 0.33f;
 
+	D3DShaderCompiler::GetCacheStatistics().Log();
+
 	LOG_INFO("Application startup complete.");
 }
 
@@ -510,6 +566,10 @@ bool D3DApplication::ImGuiApplicationInfo()
 			{
 				ChangeScene<DemoScene>();
 			}
+			if (ImGui::Button("Open Paged Scene", ImVec2(-FLT_MIN, 0.0f)))
+			{
+				ChangeScene<PagedScene>();
+			}
 		}
 
 		ImGui::Separator();
@@ -15,6 +15,9 @@
 #include "Framework/Camera/Camera.h"
 #include "Framework/Camera/OrbitalCameraController.h"
 #include "SDF/Factory/SDFFactoryHierarchicalAsync.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+#include "Headless/HeadlessBaker.h"
+#include "Benchmarks/BenchmarkRunner.h"
 
 
 // Forward declarations
@@ -46,6 +49,7 @@ public:
 	virtual IDXGISwapChain* GetSwapChain() const override;
 
 	inline const InputManager* GetInputManager() const { return m_InputManager.get(); }
+	inline const Camera& GetCamera() const { return m_Camera; }
 	inline CameraController* GetCameraController() const { return m_CameraController.get(); }
 	inline LightManager* GetLightManager() const { return m_LightManager.get(); }
 	inline MaterialManager* GetMaterialManager() const { return m_MaterialManager.get(); }
@@ -53,6 +57,15 @@ public:
 	inline const Picker* GetPicker() const { return m_Picker.get(); }
 
 	inline SDFFactoryHierarchicalAsync* GetSDFFactory() const { return m_Factory.get(); }
+	inline SDFFactoryCPU* GetCPUSDFFactory() const { return m_CPUFactory.get(); }
+	// Scenes load baked objects from this directory, and save them there when they are first baked. Empty if disabled
+	inline const std::string& GetBakeCacheDirectory() const { return m_BakeCacheDirectory; }
+	// The editor records its edits to this journal, and restores them from it when opened. Empty if disabled
+	inline const std::string& GetEditJournalPath() const { return m_EditJournalPath; }
+	// The paged scene streams its object from this page file. Empty to bake a demo into a temporary page file
+	inline const std::string& GetBrickPagePath() const { return m_BrickPagePath; }
+	// How much of the brick pool of a paged object can be resident at once, in MB
+	inline UINT GetBrickPageBudget() const { return m_BrickPageBudget; }
 
 	inline bool GetPaused() const { return m_Paused; }
 	inline void SetPaused(bool paused) { m_Paused = paused; }
@@ -92,6 +105,13 @@ private:
 	Camera m_Camera;
 
 	bool m_UseOrbitalCamera = false;
+	std::string m_BakeCacheDirectory;
+	std::string m_EditJournalPath;
+	std::string m_BrickPagePath;
+	UINT m_BrickPageBudget = 64;
+	// Empty to cache compiled shaders in the temporary directory
+	std::string m_ShaderCacheDirectory;
+	bool m_DisableShaderCache = false;
 	std::unique_ptr<CameraController> m_CameraController;
 
 	std::unique_ptr<Scene> m_Scene;
@@ -104,6 +124,7 @@ private:
 
 	// Factory
 	std::unique_ptr<SDFFactoryHierarchicalAsync> m_Factory;
+	std::unique_ptr<SDFFactoryCPU> m_CPUFactory;
 
 
 	// GUI
@@ -126,4 +147,6 @@ private:
 	D3DGraphicsContextFlags m_GraphicsContextFlags;
 
 	std::unique_ptr<ProfilingDataCollector> m_ProfilingDataCollector;
+	std::unique_ptr<HeadlessBaker> m_HeadlessBaker;
+	std::unique_ptr<BenchmarkRunner> m_BenchmarkRunner;
 };
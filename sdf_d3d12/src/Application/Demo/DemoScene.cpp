@@ -4,6 +4,9 @@
 #include "Demos.h"
 #include "imgui.h"
 
+#include "Renderer/D3DGraphicsContext.h"
+#include "SDF/SDFBakeFile.h"
+
 
 DemoScene::DemoScene(D3DApplication* application)
 	: Scene(application, 1)
@@ -12,7 +15,7 @@ DemoScene::DemoScene(D3DApplication* application)
 	LoadDemo("drops", m_BrickSize);
 
 	// Build geometry
-	m_Application->GetSDFFactory()->BakeSDFSync(m_BakePipeline, m_Geometry.get(), m_CurrentDemo->BuildEditList(0.0f));
+	BakeOrLoadGeometry();
 	m_Geometry->FlipResources();
 
 	m_Application->GetCameraController()->SetAllowMouseCapture(true);
@@ -64,6 +67,14 @@ bool DemoScene::DisplayGui()
 			}
 		}
 
+		static const char* placements[] = { BrickPoolPlacement::GetName(BrickPoolPlacement::Linear), BrickPoolPlacement::GetName(BrickPoolPlacement::Morton) };
+		static_assert(ARRAYSIZE(placements) == BrickPoolPlacement::Count);
+		int placement = static_cast<int>(m_Geometry->GetNextBrickPoolPlacement());
+		if (ImGui::Combo("Brick Pool Placement", &placement, placements, ARRAYSIZE(placements)))
+		{
+			m_Geometry->SetNextBrickPoolPlacement(static_cast<BrickPoolPlacement::Value>(placement));
+		}
+
 		{
 			SDFFactoryHierarchicalAsync* factory = m_Application->GetSDFFactory();
 			int buildIterations = static_cast<int>(factory->GetMaxBrickBuildIterations());
@@ -74,6 +85,18 @@ bool DemoScene::DisplayGui()
 				// Build iterations of -1 will just iterate until the desired brick size is reached
 				factory->SetMaxBrickBuildIterations(static_cast<UINT>(buildIterations));
 			}
+
+			bool seeding = factory->GetHierarchySeedingEnabled();
+			if (ImGui::Checkbox("Seed Incremental Bakes", &seeding))
+			{
+				factory->SetHierarchySeedingEnabled(seeding);
+			}
+
+			int pipelineDepth = static_cast<int>(factory->GetPipelineDepth());
+			if (ImGui::SliderInt("Bake Pipeline Depth", &pipelineDepth, 1, 4))
+			{
+				factory->SetPipelineDepth(static_cast<UINT>(pipelineDepth));
+			}
 		}
 
 		ImGui::Separator();
@@ -85,6 +108,12 @@ bool DemoScene::DisplayGui()
 			m_BakePipeline = m_EnableEditCulling ? L"Default" : L"NoEditCulling";
 		}
 
+		// The edit list must not change between the GPU and CPU bakes
+		if (!m_Rebuild && ImGui::Button("Validate Against CPU Bake"))
+		{
+			ValidateAgainstCPUBake();
+		}
+
 		ImGui::Separator();
 
 		static char demoName[128];
@@ -106,9 +135,30 @@ bool DemoScene::DisplayGui()
 	return open;
 }
 
+void DemoScene::ValidateAgainstCPUBake() const
+{
+	g_D3DGraphicsContext->WaitForGPUIdle();
+
+	SDFBakeData gpuBake;
+	m_Application->GetSDFFactory()->ReadbackBakeData(m_Geometry.get(), SDFObject::RESOURCES_READ, gpuBake);
+
+	// Bake the same edit list with the same settings on the CPU
+	SDFFactoryCPU* cpuFactory = m_Application->GetCPUSDFFactory();
+	cpuFactory->SetEditCullingEnabled(m_EnableEditCulling);
+	cpuFactory->SetMaxBrickBuildIterations(m_Application->GetSDFFactory()->GetMaxBrickBuildIterations());
+	cpuFactory->SetBrickPoolPlacement(gpuBake.PoolPlacement);
+
+	SDFBakeData cpuBake;
+	cpuFactory->BakeSDF(m_CurrentDemo->BuildEditList(0.0f), m_Geometry->GetNextRebuildBrickSize(), gpuBake.BrickPoolDimensions, cpuBake);
+	LOG_INFO("CPU bake completed in {} ms using {} threads.", cpuFactory->GetLastBakeTimings().Total, cpuFactory->GetThreadCount());
+
+	CompareBakeData(gpuBake, cpuBake).Log();
+}
+
 void DemoScene::LoadDemo(const std::string& name, float brickSize)
 {
 	m_CurrentDemo = BaseDemo::GetDemoFromName(name);
+	m_CurrentDemoName = name;
 	m_BrickSize = brickSize;
 
 	if (m_Geometry)
@@ -116,3 +166,41 @@ void DemoScene::LoadDemo(const std::string& name, float brickSize)
 		m_Geometry->SetNextRebuildBrickSize(m_BrickSize);
 	}
 }
+
+
+void DemoScene::BakeOrLoadGeometry()
+{
+	SDFFactoryHierarchicalAsync* factory = m_Application->GetSDFFactory();
+	const SDFEditList editList = m_CurrentDemo->BuildEditList(0.0f);
+
+	const std::string& cacheDirectory = m_Application->GetBakeCacheDirectory();
+	if (cacheDirectory.empty())
+	{
+		factory->BakeSDFSync(m_BakePipeline, m_Geometry.get(), editList);
+		return;
+	}
+
+	const std::string path = cacheDirectory + "/" + m_CurrentDemoName + ".sdfbake";
+	const UINT64 sourceHash = SDFBakeFile::CalculateSourceHash(editList, m_Geometry->GetNextRebuildBrickSize(),
+		factory->GetMaxBrickBuildIterations(), m_EnableEditCulling, m_Geometry->GetNextBrickPoolPlacement());
+
+	{
+		SDFBakeFile file;
+		if (file.Open(path))
+		{
+			if (file.GetHeader().SourceHash == sourceHash && factory->LoadBakeFileSync(m_Geometry.get(), file))
+			{
+				LOG_INFO("Loaded demo '{}' from bake file '{}'.", m_CurrentDemoName, path);
+				return;
+			}
+			LOG_INFO("Bake file '{}' is out of date - demo '{}' will be baked again.", path, m_CurrentDemoName);
+		}
+		// The file is closed before it is replaced
+	}
+
+	factory->BakeSDFSync(m_BakePipeline, m_Geometry.get(), editList);
+
+	SDFBakeData bakeData;
+	factory->ReadbackBakeData(m_Geometry.get(), SDFObject::RESOURCES_WRITE, bakeData);
+	SDFBakeFile::Write(path, bakeData, m_Geometry->GetMaterialTablePtr(), SDFObject::GetMaxMaterialsPerObject(), sourceHash);
+}
@@ -31,8 +31,17 @@ public:
 		m_BakePipeline = m_EnableEditCulling ? L"Default" : L"NoEditCulling";
 	}
 
+private:
+	// Compares the current geometry against a bake of the same demo by the CPU factory
+	void ValidateAgainstCPUBake() const;
+
+	// Loads the geometry from the bake cache if it holds an up to date bake of the current demo
+	// Otherwise bakes it, and saves the bake to the cache
+	void BakeOrLoadGeometry();
+
 private:
 	BaseDemo* m_CurrentDemo = nullptr;
+	std::string m_CurrentDemoName;
 	float m_BrickSize = 0.125f;
 
 	std::unique_ptr<SDFObject> m_Geometry;
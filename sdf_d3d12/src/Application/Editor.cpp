@@ -5,6 +5,7 @@
 
 #include "Framework/GuiHelpers.h"
 #include "Input/InputManager.h"
+#include "SDF/SDFEditListFile.h"
 
 #include "imgui.h"
 #include "misc/cpp/imgui_stdlib.h"
@@ -12,7 +13,7 @@
 
 Editor::Editor(D3DApplication* application)
 	: Scene(application, 1)
-	, m_EditList(1024, 4.0f)
+	, m_EditList(SDF_EDIT_LIMIT, 4.0f)
 {
 	m_Geometry = std::make_unique<SDFObject>(m_BrickSize, 500'000);
 
@@ -20,6 +21,14 @@ Editor::Editor(D3DApplication* application)
 	// Some geometry is needed in the edit list to begin with
 	m_EditList.AddEdit(SDFEdit::CreateSphere({}, 0.5f));
 
+	// The edits of a previous session replace it, and every edit from now on is recorded
+	const std::string& journalPath = m_Application->GetEditJournalPath();
+	if (!journalPath.empty() && m_Journal.Open(journalPath, m_EditList) && m_EditList.GetEditCount() == 0)
+	{
+		m_EditList.AddEdit(SDFEdit::CreateSphere({}, 0.5f));
+		JournalLastEdit();
+	}
+
 	// Bake geometry to start with
 	m_Application->GetSDFFactory()->BakeSDFSync(L"Default", m_Geometry.get(), m_EditList);
 	m_Geometry->FlipResources();
@@ -64,8 +73,13 @@ void Editor::OnUpdate(float deltaTime)
 
 			edit.Validate();
 
-			m_EditList.AddEdit(edit);
-			m_RebuildNext = true;
+			// A full edit list rejects the edit, in which case nothing has changed
+			if (m_EditList.AddEdit(edit))
+			{
+				JournalLastEdit();
+				m_DirtyRegion.AddEdit(m_EditList, m_EditList.GetEditCount() - 1);
+				m_RebuildNext = true;
+			}
 
 			m_UsingBrush = true;
 			m_ContinuousModeTimer = 0.0f;
@@ -82,12 +96,22 @@ void Editor::OnUpdate(float deltaTime)
 		// Don't rebuild with an empty edit list
 		if (m_EditList.GetEditCount() > 0)
 		{
+			// Always Rebuild is used to measure full bakes
+			if (!m_UseIncremental || m_AlwaysRebuild)
+				m_DirtyRegion = SDFDirtyRegion::Everything();
+
 			SDFFactoryHierarchicalAsync* factory = m_Application->GetSDFFactory();
 			if (m_UseAsync)
-				factory->BakeSDFAsync(L"Default", m_Geometry.get(), m_EditList);
+			{
+				// The object being sculpted is baked ahead of anything else in the queue
+				SDFBakeHints hints;
+				hints.Focused = true;
+				factory->BakeSDFAsync(L"Default", m_Geometry.get(), m_EditList, &m_DirtyRegion, hints);
+			}
 			else
-				factory->BakeSDFSync(L"Default", m_Geometry.get(), m_EditList);
+				factory->BakeSDFSync(L"Default", m_Geometry.get(), m_EditList, &m_DirtyRegion);
 
+			m_DirtyRegion.Clear();
 			m_RebuildNext = false;
 		}
 	}
@@ -111,14 +135,28 @@ bool Editor::DisplayGui()
 
 	ImGui::Checkbox("Always Rebuild", &m_AlwaysRebuild);
 	ImGui::Checkbox("Use Async", &m_UseAsync);
+	ImGui::Checkbox("Incremental Bake", &m_UseIncremental);
+
+	if (m_UseAsync)
+	{
+		const auto statistics = m_Application->GetSDFFactory()->GetQueueStatistics();
+		ImGui::Text("Queue Wait: %.2f ms avg, %.2f ms max", statistics.GetAverageWaitTime() * 1000.0, statistics.MaxWaitTime * 1000.0);
+		ImGui::Text("Dropped Requests: %llu", statistics.DroppedRequests);
+		ImGui::Text("Deadline Misses: %llu", statistics.DeadlineMisses);
+		ImGui::Text("Wake-up Latency: %.3f ms avg, %.3f ms max", statistics.GetAverageWakeUpLatency() * 1000.0, statistics.MaxWakeUpLatency * 1000.0);
+		ImGui::Text("Factory Thread CPU Time: %.2f s", m_Application->GetSDFFactory()->GetThreadCPUTime());
+	}
 
 	ImGui::Separator();
 	{
 		GuiHelpers::DisableScope disable(m_EditList.GetEditCount() == 0);
 
-		if (ImGui::Button("Undo", ImVec2(-FLT_MIN, 0)))
+		if (ImGui::Button("Undo", ImVec2(-FLT_MIN, 0)) && m_EditList.GetEditCount() > 0)
 		{
-			m_EditList.PopEdit();
+			m_DirtyRegion.AddEdit(m_EditList, m_EditList.GetEditCount() - 1);
+			// Only pops that succeed are journaled, as a failed pop would make the journal fail to replay
+			if (m_EditList.PopEdit())
+				m_Journal.RecordPopEdit();
 			m_RebuildNext = true;
 		}
 	}
@@ -128,6 +166,7 @@ bool Editor::DisplayGui()
 	if (ImGui::SliderFloat("Brick Size", &m_BrickSize, 0.0625f, 1.0f))
 	{
 		m_Geometry->SetNextRebuildBrickSize(m_BrickSize);
+		m_DirtyRegion = SDFDirtyRegion::Everything();
 		m_RebuildNext = true;
 	}
 
@@ -138,6 +177,8 @@ bool Editor::DisplayGui()
 			evalRange = 1.0f;
 
 		m_EditList.SetEvaluationRange(evalRange);
+		m_Journal.RecordSetEvaluationRange(evalRange);
+		m_DirtyRegion = SDFDirtyRegion::Everything();
 		m_RebuildNext = true;
 	}
 
@@ -146,18 +187,44 @@ bool Editor::DisplayGui()
 	if (ImGui::Button("Clear All", ImVec2(-FLT_MIN, 0.0f)))
 	{
 		m_EditList.Reset();
+		m_Journal.RecordReset();
 		m_EditList.AddEdit(SDFEdit::CreateSphere({}, 0.5f));
+		JournalLastEdit();
 
+		m_DirtyRegion = SDFDirtyRegion::Everything();
 		m_RebuildNext = true;
 	}
 
 	{	// Display how many edits have been used
-		const float editsUsed = m_EditList.GetEditCount() / 1024.0f;
+		const float editsUsed = static_cast<float>(m_EditList.GetEditCount()) / static_cast<float>(m_EditList.GetMaxEdits());
 		ImGui::Text("Edits Used:");
 		ImGui::SameLine();
 		ImGui::ProgressBar(editsUsed, ImVec2(-FLT_MIN, 0.0f));
 	}
 
+	if (m_Journal.IsOpen())
+		ImGui::Text("Journal Records: %llu", m_Journal.GetRecordCount());
+
+	ImGui::InputText("Edit List File", &m_EditListPath);
+	if (ImGui::Button("Save Edits", ImVec2(-FLT_MIN, 0.0f)))
+	{
+		SDFEditListFile::Write(m_EditListPath, m_EditList);
+	}
+	if (ImGui::Button("Load Edits", ImVec2(-FLT_MIN, 0.0f)))
+	{
+		// Read into a separate list, so that the current edits are kept if the file can't be read
+		SDFEditList editList(m_EditList.GetMaxEdits());
+		if (SDFEditListFile::Read(m_EditListPath, editList) && editList.GetEditCount() > 0)
+		{
+			m_EditList = std::move(editList);
+			if (m_Journal.IsOpen())
+				m_Journal.Rewrite(m_EditList);
+
+			m_DirtyRegion = SDFDirtyRegion::Everything();
+			m_RebuildNext = true;
+		}
+	}
+
 	addTitle("Materials");
 
 	auto setMatSlot = [this](const char* slotLabel, UINT slotIndex) -> bool
@@ -245,3 +312,8 @@ bool Editor::BrushExistsWithName(const std::string& name) const
 	return false;
 }
 
+void Editor::JournalLastEdit()
+{
+	m_Journal.RecordAddEdit(m_EditList.GetEditData()[m_EditList.GetEditCount() - 1]);
+}
+
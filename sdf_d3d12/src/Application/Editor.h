@@ -2,6 +2,8 @@
 
 #include "Scene.h"
 #include "SDF/SDFEditList.h"
+#include "SDF/SDFEditJournal.h"
+#include "SDF/SDFDirtyRegion.h"
 
 
 class Editor : public Scene
@@ -27,6 +29,9 @@ private:
 
 	bool BrushExistsWithName(const std::string& name) const;
 
+	// Records the edit at the end of the edit list to the journal
+	void JournalLastEdit();
+
 private:
 	std::unique_ptr<SDFObject> m_Geometry;
 	SDFGeometryInstance* m_GeometryInstance = nullptr;
@@ -35,12 +40,21 @@ private:
 
 	// The edit list that will be built through user input
 	SDFEditList m_EditList;
+	// Every change to the edit list is recorded here, if a journal is in use
+	SDFEditJournal m_Journal;
+	// Where edit lists are saved to and loaded from
+	std::string m_EditListPath = "edits.sdfedits";
 
 	// If any changes have occurred that should trigger a rebuild
 	bool m_RebuildNext = false;
 	bool m_AlwaysRebuild = false;
 	bool m_UseAsync = true;
 
+	// The region changed by edits since the last bake
+	// Only the bricks within it are rebuilt if incremental bakes are enabled
+	SDFDirtyRegion m_DirtyRegion;
+	bool m_UseIncremental = true;
+
 	// Brushes
 	std::vector<Brush> m_Brushes;
 	size_t m_CurrentBrush;
@@ -0,0 +1,162 @@
+#include "pch.h"
+#include "HeadlessBaker.h"
+
+#include "Application/Demo/Demos.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+#include "SDF/SDFBakeFile.h"
+#include "SDF/SDFBrickPageFile.h"
+#include "Framework/GameTimer.h"
+
+#include <fstream>
+#include <iomanip>
+
+
+void HeadlessBaker::ParseCommandLineArgs(args::Subparser& subparser)
+{
+	args::ValueFlag<std::string> demoName(subparser, "Demo", "Name of the demo to bake", { "demo" });
+	args::ValueFlag<float> brickSize(subparser, "Brick Size", "Size of the bricks to bake", { "brick-size" });
+	args::ValueFlag<UINT> threadCount(subparser, "Threads", "Number of worker threads (0 uses every hardware thread)", { "threads" });
+	args::ValueFlag<UINT> iterations(subparser, "Iterations", "Number of times to bake the demo", { "iterations" });
+	args::Flag noEditCulling(subparser, "No Edit Culling", "Evaluate every edit in every brick", { "no-edit-culling" });
+	args::Flag noEditBVH(subparser, "No Edit BVH", "Test every inherited edit in each brick instead of querying a BVH over the edits", { "no-edit-bvh" });
+	args::Flag intervalCulling(subparser, "Interval Culling", "Cull bricks and edits with interval arithmetic instead of point sampling", { "interval-culling" });
+	args::ValueFlag<std::string> output(subparser, "Output", "Path to a csv file to write timings to", { "output" });
+	args::ValueFlag<std::string> bakeFile(subparser, "Bake File", "Path to write the baked object to, which can be loaded from a bake cache", { "bake-file" });
+	args::ValueFlag<std::string> pageFile(subparser, "Page File", "Path to write the baked object to as pages, which the paged scene can stream", { "page-file" });
+
+	subparser.Parse();
+
+	m_Enabled = true;
+
+	if (demoName)
+		m_DemoName = demoName.Get();
+	if (brickSize)
+		m_BrickSize = brickSize.Get();
+	if (threadCount)
+		m_ThreadCount = threadCount.Get();
+	if (iterations)
+		m_Iterations = max(iterations.Get(), 1u);
+	if (noEditCulling)
+		m_EnableEditCulling = false;
+	if (noEditBVH)
+		m_EnableEditBVH = false;
+	if (intervalCulling)
+		m_CullingMode = BrickCullingMode::Interval;
+	if (output)
+		m_OutputFile = output.Get();
+	if (bakeFile)
+		m_BakeFile = bakeFile.Get();
+	if (pageFile)
+		m_PageFile = pageFile.Get();
+}
+
+
+bool HeadlessBaker::Run()
+{
+	if (m_BrickSize <= 0.0f)
+	{
+		LOG_ERROR("Invalid brick size: {}", m_BrickSize);
+		return false;
+	}
+
+	BaseDemo::CreateAllDemos();
+	BaseDemo* demo = BaseDemo::GetDemoFromName(m_DemoName);
+	if (!demo)
+	{
+		LOG_ERROR("Demo '{}' does not exist.", m_DemoName);
+		return false;
+	}
+
+	SDFFactoryCPU factory(m_ThreadCount);
+	factory.SetEditCullingEnabled(m_EnableEditCulling);
+	factory.SetEditBVHEnabled(m_EnableEditBVH);
+	factory.SetCullingMode(m_CullingMode);
+
+	LOG_INFO("Baking demo '{}' on the CPU with {} threads.", m_DemoName, factory.GetThreadCount());
+
+	std::ofstream outFile;
+	if (!m_OutputFile.empty())
+	{
+		outFile.open(m_OutputFile);
+		if (!outFile.is_open())
+		{
+			LOG_ERROR("Failed to open output file: '{}'", m_OutputFile);
+			return false;
+		}
+		outFile << "Demo,BrickSize,EditCulling,EditBVH,IntervalCulling,Threads,EditCount,BrickCount,IndexCount,EditDependencies,EditBVHBuilding,BrickBuilding,AABBBuilding,BrickEvaluation,Total" << std::endl;
+	}
+
+	const SDFEditList editList = demo->BuildEditList(0.0f);
+
+	SDFBakeData bakeData;
+	for (UINT iteration = 0; iteration < m_Iterations; iteration++)
+	{
+		factory.BakeSDF(editList, m_BrickSize, bakeData);
+
+		const auto& timings = factory.GetLastBakeTimings();
+		LOG_INFO("Bake {}: {} bricks, {} indices", iteration, bakeData.GetBrickCount(), bakeData.Indices.size());
+		LOG_INFO("Edit dependencies: {:.3f} ms, edit BVH: {:.3f} ms, brick building: {:.3f} ms, AABB building: {:.3f} ms, brick evaluation: {:.3f} ms, total: {:.3f} ms",
+			timings.EditDependencies, timings.EditBVH, timings.BrickBuilding, timings.AABBBuilding, timings.BrickEvaluation, timings.Total);
+
+		if (outFile.is_open())
+		{
+			outFile << std::fixed << std::setprecision(4)
+				<< m_DemoName << "," << m_BrickSize << "," << m_EnableEditCulling << "," << m_EnableEditBVH << "," << (m_CullingMode == BrickCullingMode::Interval) << "," << factory.GetThreadCount() << ","
+				<< editList.GetEditCount() << "," << bakeData.GetBrickCount() << "," << bakeData.Indices.size() << ","
+				<< timings.EditDependencies << "," << timings.EditBVH << "," << timings.BrickBuilding << "," << timings.AABBBuilding << ","
+				<< timings.BrickEvaluation << "," << timings.Total << std::endl;
+		}
+	}
+
+	if (!m_BakeFile.empty())
+	{
+		// Objects use their material slots as material IDs until materials are assigned
+		std::vector<UINT> materials(SDFObject::GetMaxMaterialsPerObject());
+		for (UINT slot = 0; slot < materials.size(); slot++)
+			materials.at(slot) = slot;
+
+		// The same source hash that a bake cache checks for, so the file can be copied into one
+		const UINT64 sourceHash = SDFBakeFile::CalculateSourceHash(editList, m_BrickSize, factory.GetMaxBrickBuildIterations(), m_EnableEditCulling, factory.GetBrickPoolPlacement());
+		if (!SDFBakeFile::Write(m_BakeFile, bakeData, materials.data(), static_cast<UINT>(materials.size()), sourceHash))
+			return false;
+
+		GameTimer timer;
+		timer.Reset();
+
+		SDFBakeFile file;
+		SDFBakeData loadedData;
+		if (!file.Open(m_BakeFile))
+			return false;
+		const float openTime = 1000.0f * timer.Tick();
+		file.ReadBakeData(loadedData);
+		const float readTime = 1000.0f * timer.Tick();
+
+		LOG_INFO("Bake file opened in {:.3f} ms and read in {:.3f} ms.", openTime, readTime);
+
+		if (!file.VerifyContents())
+		{
+			LOG_ERROR("Bake file '{}' does not match the hash of its contents.", m_BakeFile);
+			return false;
+		}
+		const SDFBakeComparison comparison = CompareBakeData(bakeData, loadedData);
+		comparison.Log();
+		if (!comparison.IsExactMatch())
+			return false;
+	}
+
+	if (!m_PageFile.empty())
+	{
+		if (!SDFBrickPageFile::Write(m_PageFile, bakeData))
+			return false;
+
+		SDFBrickPageFile file;
+		if (!file.Open(m_PageFile))
+			return false;
+
+		const auto& header = file.GetHeader();
+		LOG_INFO("Page file holds {} bricks in {} pages, which need a brick pool of {:.1f} MB to be fully resident.",
+			header.BrickCount, header.PageCount, static_cast<double>(header.PageCount * SDFBrickPageFile::s_PageVoxelBytes) / (1024.0 * 1024.0));
+	}
+
+	return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Core.h"
+#include "SDF/Factory/SDFFactoryCPU.h"
+
+#include <args.hxx>
+
+
+// Bakes a demo with the CPU factory from the command line
+// No window or graphics device is created, so this can run on machines without a GPU
+class HeadlessBaker
+{
+public:
+	HeadlessBaker() = default;
+	~HeadlessBaker() = default;
+
+	DISALLOW_COPY(HeadlessBaker)
+	DEFAULT_MOVE(HeadlessBaker)
+
+	void ParseCommandLineArgs(args::Subparser& subparser);
+
+	// Performs the bake
+	// Returns whether it was successful
+	bool Run();
+
+	inline bool IsEnabled() const { return m_Enabled; }
+
+private:
+	bool m_Enabled = false;
+
+	std::string m_DemoName = "drops";
+	float m_BrickSize = 0.125f;
+	UINT m_ThreadCount = 0;
+	UINT m_Iterations = 1;
+	bool m_EnableEditCulling = true;
+	bool m_EnableEditBVH = true;
+	BrickCullingMode::Value m_CullingMode = BrickCullingMode::PointSample;
+
+	std::string m_OutputFile;
+	// The last bake is written here, and read back to check that it round trips
+	std::string m_BakeFile;
+	// The last bake is written here as pages
+	std::string m_PageFile;
+};
@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "PagedScene.h"
+
+#include "imgui.h"
+
+#include "D3DApplication.h"
+#include "Demo/Demos.h"
+#include "Renderer/D3DGraphicsContext.h"
+
+
+PagedScene::PagedScene(D3DApplication* application)
+	: Scene(application, 1)
+{
+	std::string path = m_Application->GetBrickPagePath();
+	if (path.empty())
+	{
+		char tempDirectory[MAX_PATH];
+		if (GetTempPathA(MAX_PATH, tempDirectory) != 0)
+			path = std::string(tempDirectory) + s_DemoName + ".sdfpages";
+	}
+
+	if (!OpenOrBakePageFile(path))
+	{
+		LOG_ERROR("Paged scene has no page file - nothing will be displayed.");
+		return;
+	}
+
+	const auto& header = m_PageFile.GetHeader();
+
+	// The pool holds as many pages as fit in the budget, and never more than there are
+	const UINT64 budgetBytes = static_cast<UINT64>(m_Application->GetBrickPageBudget()) * 1024 * 1024;
+	const UINT budgetPages = static_cast<UINT>((std::max)(budgetBytes / SDFBrickPageFile::s_PageVoxelBytes, 1ull));
+	const XMUINT3 poolDimensions = SDFBrickPageFile::CalculateBrickPoolDimensions((std::min)(budgetPages, header.PageCount));
+
+	m_Geometry = std::make_unique<SDFObject>(header.BrickSize, header.BrickCount);
+	if (!m_Application->GetSDFFactory()->LoadBrickPageFileSync(m_Geometry.get(), m_PageFile, poolDimensions))
+	{
+		LOG_ERROR("Failed to load page file '{}'.", path);
+		m_Geometry.reset();
+		return;
+	}
+	m_Geometry->FlipResources();
+
+	m_Streamer.Init(&m_PageFile, m_Geometry.get(), SDFBrickResidency::Settings{});
+	LOG_INFO("Paged scene streams {} pages through {} slots ({:.1f}% resident).",
+		header.PageCount, m_Streamer.GetResidency().GetSettings().SlotCount,
+		100.0f * static_cast<float>(m_Streamer.GetResidency().GetSettings().SlotCount) / static_cast<float>(header.PageCount));
+
+	m_Application->GetCameraController()->SetAllowMouseCapture(true);
+
+	AddGeometry(L"PagedGeometry", m_Geometry.get());
+	CreateGeometryInstance(L"PagedGeometry");
+
+	auto SetupMaterial = [this](UINT mat, UINT slot, const XMFLOAT3& albedo, float roughness, float metalness, float reflectance)
+		{
+			const auto pMat = m_Application->GetMaterialManager()->GetMaterial(mat);
+			pMat->SetAlbedo(albedo);
+			pMat->SetRoughness(roughness);
+			pMat->SetMetalness(metalness);
+			pMat->SetReflectance(reflectance);
+			m_Geometry->SetMaterial(pMat, slot);
+		};
+
+	SetupMaterial(0, 0, { 0.0f, 0.0f, 0.0f }, 0.1f, 0.0f, 0.0f);
+	SetupMaterial(1, 1, { 1.0f, 1.0f, 1.0f }, 0.1f, 0.0f, 0.0f);
+	SetupMaterial(2, 2, { 1.0f, 0.5f, 0.0f }, 0.1f, 0.0f, 0.0f);
+	SetupMaterial(3, 3, { 0.0f, 0.9f, 0.9f }, 0.05f, 1.0f, 1.0f);
+}
+
+PagedScene::~PagedScene()
+{
+	// Pages may still be being copied out of the upload buffers of the streamer
+	m_Streamer.Reset();
+}
+
+
+void PagedScene::OnUpdate(float deltaTime)
+{
+	if (m_Streaming && m_Streamer.IsInitialized())
+	{
+		m_Streamer.Update(m_Application->GetCamera().GetPosition());
+	}
+}
+
+bool PagedScene::DisplayGui()
+{
+	bool open = true;
+
+	if (ImGui::Begin("Paged Scene", &open))
+	{
+		if (m_Streamer.IsInitialized())
+		{
+			const auto& residency = m_Streamer.GetResidency();
+			const auto& stats = residency.GetStatistics();
+
+			ImGui::Checkbox("Streaming", &m_Streaming);
+
+			ImGui::Separator();
+
+			ImGui::Text("Bricks: %u", m_PageFile.GetHeader().BrickCount);
+			ImGui::Text("Pages: %u resident of %u", residency.GetResidentPageCount(), residency.GetPageCount());
+			ImGui::Text("Page Slots: %u (%.1f MB)", residency.GetSettings().SlotCount,
+				static_cast<double>(residency.GetSettings().SlotCount * SDFBrickPageFile::s_PageVoxelBytes) / (1024.0 * 1024.0));
+			ImGui::Text("Wanted Pages Resident: %u of %u", residency.GetWantedResidentPageCount(), residency.GetWantedPageCount());
+
+			ImGui::Separator();
+
+			ImGui::Text("Loads: %llu", stats.Loads);
+			ImGui::Text("Evictions: %llu", stats.Evictions);
+			ImGui::Text("Deferred Loads: %llu", stats.DeferredLoads);
+			ImGui::Text("Streamed This Frame: %.2f MB", static_cast<double>(m_Streamer.GetLastUpdateBytes()) / (1024.0 * 1024.0));
+		}
+		else
+		{
+			ImGui::Text("No page file is loaded.");
+		}
+	}
+	ImGui::End();
+
+	return open;
+}
+
+
+bool PagedScene::OpenOrBakePageFile(const std::string& path)
+{
+	if (path.empty())
+		return false;
+
+	if (m_PageFile.Open(path))
+	{
+		LOG_INFO("Opened page file '{}'.", path);
+		return true;
+	}
+
+	// Bricks far finer than the demo scene, so that there are too many to keep resident at once
+	LOG_INFO("Baking demo '{}' at brick size {} for page file '{}'.", s_DemoName, s_DemoBrickSize, path);
+
+	BaseDemo* demo = BaseDemo::GetDemoFromName(s_DemoName);
+	if (!demo)
+		return false;
+
+	SDFFactoryCPU* cpuFactory = m_Application->GetCPUSDFFactory();
+	SDFBakeData bake;
+	cpuFactory->BakeSDF(demo->BuildEditList(0.0f), s_DemoBrickSize, bake);
+	LOG_INFO("CPU bake completed in {} ms using {} threads.", cpuFactory->GetLastBakeTimings().Total, cpuFactory->GetThreadCount());
+
+	return SDFBrickPageFile::Write(path, bake) && m_PageFile.Open(path);
+}
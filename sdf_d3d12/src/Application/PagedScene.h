@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Scene.h"
+#include "SDF/SDFBrickPageFile.h"
+#include "SDF/SDFBrickPageStreamer.h"
+
+
+// Displays an object from a page file, with only the pages near the camera resident in the brick pool
+// The page file is taken from the command line. If there is none, or it cannot be used,
+// a demo is baked on the CPU at a fine brick size and written to a page file in the temporary directory.
+class PagedScene : public Scene
+{
+public:
+	PagedScene(D3DApplication* application);
+	virtual ~PagedScene() override;
+
+	DISALLOW_COPY(PagedScene)
+	DISALLOW_MOVE(PagedScene)
+
+	void OnUpdate(float deltaTime) override;
+	bool DisplayGui() override;
+
+private:
+	// Opens the page file, or bakes and writes one if it is missing or cannot be used
+	bool OpenOrBakePageFile(const std::string& path);
+
+private:
+	// The file must outlive the streamer, which streams pages straight from its mapping
+	SDFBrickPageFile m_PageFile;
+	std::unique_ptr<SDFObject> m_Geometry;
+	SDFBrickPageStreamer m_Streamer;
+
+	bool m_Streaming = true;
+
+	inline static const char* s_DemoName = "drops";
+	inline static constexpr float s_DemoBrickSize = 0.0625f;
+};
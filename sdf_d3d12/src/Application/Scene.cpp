@@ -162,6 +162,11 @@ void Scene::DisplaySDFObjectDebugInfo() const
 		ImGui::Separator();
 
 		DisplaySize("Total", geometry->GetTotalMemoryUsageBytes(true) / 1024);
+		DisplaySize("Retired Brick Pools", geometry->GetRetiredMemoryUsageBytes() / 1024);
+
+		const auto& allocations = geometry->GetAllocationStatistics();
+		ImGui::Text("Brick Pool Allocations: %u (%u reused, %u shrinks)", allocations.BrickPoolAllocations, allocations.BrickPoolReuses, allocations.BrickPoolShrinks);
+		ImGui::Text("Index Buffer Allocations: %u", allocations.IndexBufferAllocations);
 
 		ImGui::Separator();
 	}
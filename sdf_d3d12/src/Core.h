@@ -4,9 +4,13 @@
 #include "Framework/Exception.h"
 
 
+// Checks the result in every configuration, unlike THROW_IF_FAIL
+// Used by work that runs as thread pool tasks, whose exceptions are passed back to the thread that waits on them
+#define THROW_IF_FAIL_ALWAYS(x) { const HRESULT hr = x; if (FAILED(hr)) { LOG_FATAL(DXException(hr).ToString().c_str()); throw DXException(hr); }}
+
 #ifdef _DEBUG
 
-#define THROW_IF_FAIL(x) { const HRESULT hr = x; if (FAILED(hr)) { LOG_FATAL(DXException(hr).ToString().c_str()); throw; }}
+#define THROW_IF_FAIL(x) THROW_IF_FAIL_ALWAYS(x)
 #define ASSERT(x, msg) if (!(x)) { LOG_ERROR("Debug assertion failed in file ({0}) on line ({1}). Message: {2}", __FILE__, __LINE__, msg); DebugBreak(); }
 #define THROW_IF_FALSE(x, msg) if (!(x)) { LOG_ERROR(msg); DebugBreak(); }
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <malloc.h>
+#include <new>
+
+
+// Allocator for std containers whose storage must be aligned for SIMD loads
+// eg std::vector<float, AlignedAllocator<float, 64>>
+template<typename T, size_t Alignment>
+class AlignedAllocator
+{
+	static_assert(Alignment >= alignof(T), "Alignment is too small for this type!");
+	static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of 2!");
+
+public:
+	using value_type = T;
+
+	template<typename U>
+	struct rebind
+	{
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+	AlignedAllocator() noexcept = default;
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+	T* allocate(size_t count)
+	{
+		void* p = _aligned_malloc(count * sizeof(T), Alignment);
+		if (!p)
+			throw std::bad_alloc();
+		return static_cast<T*>(p);
+	}
+
+	void deallocate(T* p, size_t) noexcept
+	{
+		_aligned_free(p);
+	}
+
+	template<typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+	template<typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <type_traits>
+
+
+// Non-cryptographic hashing for content-addressed data
+// These are 64-bit FNV-1a, so hashes are stable between runs and between machines
+namespace Hash
+{
+	inline constexpr UINT64 s_Seed = 0xCBF29CE484222325ull;
+
+	inline UINT64 Bytes(const void* data, size_t size, UINT64 hash = s_Seed)
+	{
+		const BYTE* bytes = static_cast<const BYTE*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x00000100000001B3ull;
+		}
+		return hash;
+	}
+
+	// Hashes the object representation of a value, so T must have no padding
+	template<typename T>
+	inline UINT64 Value(const T& value, UINT64 hash = s_Seed)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be hashed by value!");
+		return Bytes(&value, sizeof(T), hash);
+	}
+}
@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+	{
+		LOG_TRACE("Failed to open file '{}' for mapping (error {}).", path, GetLastError());
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+	{
+		// Empty files cannot be mapped
+		LOG_WARN("File '{}' is empty or its size could not be read.", path);
+		Close();
+		return false;
+	}
+	m_Size = static_cast<UINT64>(size.QuadPart);
+
+	m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_Mapping)
+	{
+		LOG_ERROR("Failed to create a mapping of file '{}' (error {}).", path, GetLastError());
+		Close();
+		return false;
+	}
+
+	m_Data = static_cast<const BYTE*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_Data)
+	{
+		LOG_ERROR("Failed to map a view of file '{}' (error {}).", path, GetLastError());
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_Data)
+	{
+		UnmapViewOfFile(m_Data);
+		m_Data = nullptr;
+	}
+	if (m_Mapping)
+	{
+		CloseHandle(m_Mapping);
+		m_Mapping = nullptr;
+	}
+	if (m_File != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_File);
+		m_File = INVALID_HANDLE_VALUE;
+	}
+	m_Size = 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Core.h"
+
+
+// A read-only view of a whole file, mapped into the address space of the process
+// Pages are read from disk as they are first touched, so opening a file does not read it.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	DISALLOW_COPY(MappedFile)
+	DISALLOW_MOVE(MappedFile)
+
+	// Returns false if the file could not be opened or mapped
+	// Any file that is already open is closed first
+	bool Open(const std::string& path);
+	void Close();
+
+	inline bool IsOpen() const { return m_Data != nullptr; }
+
+	inline const BYTE* GetData() const { return m_Data; }
+	inline UINT64 GetSize() const { return m_Size; }
+
+private:
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+	HANDLE m_Mapping = nullptr;
+	const BYTE* m_Data = nullptr;
+	UINT64 m_Size = 0;
+};
@@ -0,0 +1,264 @@
+#include "pch.h"
+#include "PrefixScan.h"
+
+#include "ThreadPool.h"
+
+#include <emmintrin.h>
+
+
+namespace PrefixScanVariant
+{
+	const char* GetName(Value variant)
+	{
+		static const char* names[] =
+		{
+			"Serial",
+			"SIMD",
+			"Three Pass",
+			"Look-back"
+		};
+		static_assert(ARRAYSIZE(names) == Count);
+		return names[variant];
+	}
+}
+
+
+namespace
+{
+	// Tile states for the look-back scan
+	enum TileStatus : UINT64
+	{
+		TILE_INVALID = 0,
+		TILE_AGGREGATE,		// The value is the total of this tile only
+		TILE_PREFIX			// The value is the total of this tile and every tile before it
+	};
+
+	inline UINT64 PackTileState(TileStatus status, UINT value) { return (static_cast<UINT64>(status) << 32) | value; }
+	inline TileStatus GetTileStatus(UINT64 state) { return static_cast<TileStatus>(state >> 32); }
+	inline UINT GetTileValue(UINT64 state) { return static_cast<UINT>(state & 0xFFFFFFFFull); }
+}
+
+
+PrefixScan::PrefixScan(ThreadPool* threadPool)
+	: m_ThreadPool(threadPool)
+{
+}
+
+
+UINT PrefixScan::ExclusiveScan(const UINT* input, UINT count, UINT* output, PrefixScanVariant::Value variant)
+{
+	// Threading costs more than it saves for small inputs
+	if ((variant == PrefixScanVariant::ThreePass || variant == PrefixScanVariant::LookBack) && (count < s_MinParallelCount || !m_ThreadPool))
+	{
+		variant = PrefixScanVariant::SIMD;
+	}
+
+	UINT total = 0;
+	switch (variant)
+	{
+	case PrefixScanVariant::Serial:
+		total = Scan_Serial(input, count, output);
+		break;
+	case PrefixScanVariant::SIMD:
+		total = ScanRange_SIMD(input, count, output, 0);
+		break;
+	case PrefixScanVariant::ThreePass:
+		total = Scan_ThreePass(input, count, output);
+		break;
+	case PrefixScanVariant::LookBack:
+		total = Scan_LookBack(input, count, output);
+		break;
+	default:
+		ASSERT(false, "Invalid prefix scan variant!");
+		break;
+	}
+
+	// The final element contains the total, as the factory uses it to size the next level of bricks
+	output[count] = total;
+	return total;
+}
+
+
+UINT PrefixScan::Scan_Serial(const UINT* input, UINT count, UINT* output) const
+{
+	UINT sum = 0;
+	for (UINT i = 0; i < count; i++)
+	{
+		const UINT value = input[i];
+		output[i] = sum;
+		sum += value;
+	}
+	return sum;
+}
+
+UINT PrefixScan::Scan_ThreePass(const UINT* input, UINT count, UINT* output)
+{
+	const UINT blockCount = (count + s_BlockSize - 1) / s_BlockSize;
+	// Enough blocks per task to amortise the cost of scheduling it
+	constexpr UINT blocksPerTask = 64;
+
+	m_BlockSums.resize(blockCount);
+	m_BlockPrefixSums.resize(blockCount + 1);
+
+	// scan_blocks.hlsl: scan each block and record its total
+	m_ThreadPool->ParallelFor(0, blockCount, blocksPerTask, [&](UINT begin, UINT end)
+		{
+			for (UINT block = begin; block < end; block++)
+			{
+				const UINT first = block * s_BlockSize;
+				const UINT blockElements = (std::min)(s_BlockSize, count - first);
+				m_BlockSums.at(block) = ScanRange_SIMD(input + first, blockElements, output + first, 0);
+			}
+		});
+
+	// scan_block_sums.hlsl: scan the block totals
+	// There are 64 times fewer of these, so this is cheap enough to leave on one thread
+	const UINT total = ScanRange_SIMD(m_BlockSums.data(), blockCount, m_BlockPrefixSums.data(), 0);
+
+	// sum_scans.hlsl: add each block's offset on to its elements
+	m_ThreadPool->ParallelFor(0, blockCount, blocksPerTask, [&](UINT begin, UINT end)
+		{
+			for (UINT block = begin; block < end; block++)
+			{
+				const UINT offset = m_BlockPrefixSums.at(block);
+				if (offset == 0)
+					continue;
+
+				const UINT first = block * s_BlockSize;
+				const UINT last = (std::min)(first + s_BlockSize, count);
+				for (UINT i = first; i < last; i++)
+				{
+					output[i] += offset;
+				}
+			}
+		});
+
+	return total;
+}
+
+UINT PrefixScan::Scan_LookBack(const UINT* input, UINT count, UINT* output)
+{
+	const UINT tileCount = (count + s_LookBackTileSize - 1) / s_LookBackTileSize;
+
+	if (tileCount > m_TileStateCapacity)
+	{
+		m_TileStates = std::make_unique<std::atomic<UINT64>[]>(tileCount);
+		m_TileStateCapacity = tileCount;
+	}
+	for (UINT tile = 0; tile < tileCount; tile++)
+	{
+		m_TileStates[tile].store(PackTileState(TILE_INVALID, 0), std::memory_order_relaxed);
+	}
+	m_NextTile = 0;
+
+	auto scanTiles = [this, input, count, output, tileCount]()
+		{
+			while (true)
+			{
+				// Tiles are claimed in order, so every tile that is looked back at has already been claimed by a running thread
+				// This guarantees progress, which would not be the case if tiles were assigned to tasks up front
+				const UINT tile = m_NextTile.fetch_add(1, std::memory_order_relaxed);
+				if (tile >= tileCount)
+					return;
+
+				const UINT first = tile * s_LookBackTileSize;
+				const UINT tileElements = (std::min)(s_LookBackTileSize, count - first);
+
+				UINT exclusive = 0;
+				if (tile == 0)
+				{
+					const UINT aggregate = SumRange_SIMD(input + first, tileElements);
+					m_TileStates[tile].store(PackTileState(TILE_PREFIX, aggregate), std::memory_order_release);
+				}
+				else
+				{
+					// Publish the total of this tile first, so that later tiles can look past it without waiting for its prefix
+					const UINT aggregate = SumRange_SIMD(input + first, tileElements);
+					m_TileStates[tile].store(PackTileState(TILE_AGGREGATE, aggregate), std::memory_order_release);
+
+					for (UINT previous = tile; previous-- > 0;)
+					{
+						UINT64 state = m_TileStates[previous].load(std::memory_order_acquire);
+						while (GetTileStatus(state) == TILE_INVALID)
+						{
+							_mm_pause();
+							state = m_TileStates[previous].load(std::memory_order_acquire);
+						}
+
+						exclusive += GetTileValue(state);
+						if (GetTileStatus(state) == TILE_PREFIX)
+							break;
+					}
+
+					m_TileStates[tile].store(PackTileState(TILE_PREFIX, exclusive + aggregate), std::memory_order_release);
+				}
+
+				ScanRange_SIMD(input + first, tileElements, output + first, exclusive);
+			}
+		};
+
+	// One task per worker, each of which scans tiles until there are none left
+	ThreadPool::TaskGroup group;
+	const UINT taskCount = (std::min)(m_ThreadPool->GetThreadCount(), tileCount);
+	for (UINT task = 0; task < taskCount; task++)
+	{
+		m_ThreadPool->Submit(group, scanTiles);
+	}
+	m_ThreadPool->Wait(group);
+
+	return GetTileValue(m_TileStates[tileCount - 1].load(std::memory_order_acquire));
+}
+
+
+UINT PrefixScan::ScanRange_SIMD(const UINT* input, UINT count, UINT* output, UINT carry)
+{
+	__m128i carry4 = _mm_set1_epi32(static_cast<int>(carry));
+
+	UINT i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+
+		// Inclusive scan of the four lanes
+		__m128i inclusive = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+		inclusive = _mm_add_epi32(inclusive, _mm_slli_si128(inclusive, 8));
+
+		// Subtracting the input from the inclusive scan gives the exclusive scan
+		const __m128i exclusive = _mm_add_epi32(carry4, _mm_sub_epi32(inclusive, values));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), exclusive);
+
+		// Broadcast the last lane to carry it into the next four elements
+		carry4 = _mm_add_epi32(carry4, _mm_shuffle_epi32(inclusive, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+
+	carry = static_cast<UINT>(_mm_cvtsi128_si32(carry4));
+	for (; i < count; i++)
+	{
+		const UINT value = input[i];
+		output[i] = carry;
+		carry += value;
+	}
+	return carry;
+}
+
+UINT PrefixScan::SumRange_SIMD(const UINT* input, UINT count)
+{
+	__m128i sum4 = _mm_setzero_si128();
+
+	UINT i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		sum4 = _mm_add_epi32(sum4, _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+	}
+
+	// Horizontal add of the four lanes
+	sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(2, 3, 0, 1)));
+	UINT sum = static_cast<UINT>(_mm_cvtsi128_si32(sum4));
+
+	for (; i < count; i++)
+	{
+		sum += input[i];
+	}
+	return sum;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Core.h"
+
+#include <atomic>
+
+class ThreadPool;
+
+
+namespace PrefixScanVariant
+{
+	enum Value
+	{
+		// One element at a time on the calling thread. Used as the reference
+		Serial = 0,
+		// Four elements at a time on the calling thread
+		SIMD,
+		// The three passes of the GPU scan, with each pass spread across the thread pool
+		ThreePass,
+		// A single pass over the input, where each tile finds its offset by looking back at the tiles before it
+		LookBack,
+		Count
+	};
+
+	const char* GetName(Value variant);
+}
+
+
+// Exclusive prefix sums of UINT counts, matching the output of the GPU scan in prefix_sum/*.hlsl
+// The GPU scans blocks of 64 elements (scan_blocks), scans the block totals (scan_block_sums),
+// and then adds each scanned total back on to its block (sum_scans).
+// The three pass variant uses the same blocks, so its block sums can be compared against the GPU's.
+class PrefixScan
+{
+public:
+	// SCAN_GROUP_THREADS
+	inline static constexpr UINT s_BlockSize = 64;
+
+	// Multithreaded variants fall back to the SIMD variant below this many elements
+	inline static constexpr UINT s_MinParallelCount = 16384;
+
+public:
+	// Multithreaded variants run on the calling thread if no thread pool is given
+	PrefixScan(ThreadPool* threadPool = nullptr);
+	~PrefixScan() = default;
+
+	DISALLOW_COPY(PrefixScan)
+	DISALLOW_MOVE(PrefixScan)
+
+	// Writes the exclusive prefix sum of count elements to output, which must hold count + 1 elements
+	// The final element is the total of the input. Input and output may be the same array.
+	// Returns the total
+	UINT ExclusiveScan(const UINT* input, UINT count, UINT* output, PrefixScanVariant::Value variant = PrefixScanVariant::ThreePass);
+
+	// The total of each block of 64 elements, as written to g_BlockSumTable by scan_blocks.hlsl
+	// Only valid after a three pass scan of at least s_MinParallelCount elements
+	inline const std::vector<UINT>& GetBlockSums() const { return m_BlockSums; }
+
+private:
+	UINT Scan_Serial(const UINT* input, UINT count, UINT* output) const;
+	UINT Scan_ThreePass(const UINT* input, UINT count, UINT* output);
+	UINT Scan_LookBack(const UINT* input, UINT count, UINT* output);
+
+	// Scans a range with SSE2, adding carry to every element. Returns the carry plus the total of the range
+	static UINT ScanRange_SIMD(const UINT* input, UINT count, UINT* output, UINT carry);
+	static UINT SumRange_SIMD(const UINT* input, UINT count);
+
+private:
+	ThreadPool* m_ThreadPool;
+
+	std::vector<UINT> m_BlockSums;
+	std::vector<UINT> m_BlockPrefixSums;
+
+	// Look-back tiles are much larger than the GPU blocks, so that each task does enough work to outweigh the look-back
+	inline static constexpr UINT s_LookBackTileSize = 64 * s_BlockSize;
+	// The high bits of each tile state hold its status, and the low 32 bits hold its value
+	std::unique_ptr<std::atomic<UINT64>[]> m_TileStates;
+	UINT m_TileStateCapacity = 0;
+	std::atomic<UINT> m_NextTile = 0;
+};
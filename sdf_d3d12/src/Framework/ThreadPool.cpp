@@ -0,0 +1,196 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+
+// Which pool and worker the current thread belongs to
+// Used to push tasks submitted from within a task onto the local queue
+static thread_local const ThreadPool* t_WorkerPool = nullptr;
+static thread_local UINT t_WorkerIndex = 0;
+
+
+ThreadPool::ThreadPool(UINT threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	m_Queues.reserve(threadCount);
+	for (UINT i = 0; i < threadCount; i++)
+	{
+		m_Queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	m_Workers.reserve(threadCount);
+	for (UINT i = 0; i < threadCount; i++)
+	{
+		m_Workers.emplace_back(&ThreadPool::WorkerThreadProc, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(m_SleepMutex);
+		m_Terminate = true;
+	}
+	m_WakeCondition.notify_all();
+
+	for (auto& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+
+void ThreadPool::Submit(TaskGroup& group, Task task)
+{
+	group.m_PendingTasks.fetch_add(1, std::memory_order_relaxed);
+
+	WorkerQueue& queue = *m_Queues.at(GetLocalQueueIndex());
+	{
+		std::lock_guard lock(queue.Mutex);
+		queue.Tasks.push_back({ std::move(task), &group });
+	}
+
+	{
+		// Take the sleep lock so a worker cannot miss this task between checking the count and sleeping
+		std::lock_guard lock(m_SleepMutex);
+		m_QueuedTaskCount.fetch_add(1, std::memory_order_release);
+	}
+	m_WakeCondition.notify_one();
+}
+
+void ThreadPool::Wait(TaskGroup& group)
+{
+	const UINT queueIndex = GetLocalQueueIndex();
+	while (!group.IsComplete())
+	{
+		// Help out rather than block, this also prevents deadlocks when waiting from inside a task
+		if (!TryExecuteTask(queueIndex))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	std::exception_ptr exception;
+	{
+		std::lock_guard lock(group.m_ExceptionMutex);
+		std::swap(exception, group.m_Exception);
+	}
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
+void ThreadPool::ParallelFor(UINT begin, UINT end, UINT grainSize, const std::function<void(UINT, UINT)>& func)
+{
+	if (begin >= end)
+		return;
+
+	grainSize = max(grainSize, 1u);
+
+	if (end - begin <= grainSize)
+	{
+		// Not worth distributing
+		func(begin, end);
+		return;
+	}
+
+	TaskGroup group;
+	for (UINT chunkBegin = begin; chunkBegin < end; chunkBegin += min(grainSize, end - chunkBegin))
+	{
+		const UINT chunkEnd = chunkBegin + min(grainSize, end - chunkBegin);
+		Submit(group, [&func, chunkBegin, chunkEnd]() { func(chunkBegin, chunkEnd); });
+	}
+	Wait(group);
+}
+
+
+void ThreadPool::WorkerThreadProc(UINT workerIndex)
+{
+	t_WorkerPool = this;
+	t_WorkerIndex = workerIndex;
+
+	while (true)
+	{
+		if (TryExecuteTask(workerIndex))
+			continue;
+
+		std::unique_lock lock(m_SleepMutex);
+		m_WakeCondition.wait(lock, [this]()
+			{
+				return m_Terminate || m_QueuedTaskCount.load(std::memory_order_acquire) > 0;
+			});
+
+		if (m_Terminate)
+			return;
+	}
+}
+
+
+bool ThreadPool::PopTask(UINT queueIndex, QueuedTask& task)
+{
+	WorkerQueue& queue = *m_Queues.at(queueIndex);
+	std::lock_guard lock(queue.Mutex);
+	if (queue.Tasks.empty())
+		return false;
+
+	// Newest task first - it is most likely to still be in cache
+	task = std::move(queue.Tasks.back());
+	queue.Tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::StealTask(UINT thiefIndex, QueuedTask& task)
+{
+	const UINT queueCount = static_cast<UINT>(m_Queues.size());
+	for (UINT i = 1; i < queueCount; i++)
+	{
+		WorkerQueue& queue = *m_Queues.at((thiefIndex + i) % queueCount);
+		std::lock_guard lock(queue.Mutex);
+		if (queue.Tasks.empty())
+			continue;
+
+		// Steal the oldest task, which is likely to be the largest piece of work
+		task = std::move(queue.Tasks.front());
+		queue.Tasks.pop_front();
+		return true;
+	}
+	return false;
+}
+
+bool ThreadPool::TryExecuteTask(UINT workerIndex)
+{
+	QueuedTask task;
+	if (!PopTask(workerIndex, task) && !StealTask(workerIndex, task))
+		return false;
+
+	m_QueuedTaskCount.fetch_sub(1, std::memory_order_relaxed);
+
+	// The group must always be told the task is complete, or its waiter would never return
+	// An exception is held for the waiter rather than unwinding this thread
+	try
+	{
+		task.Function();
+	}
+	catch (...)
+	{
+		std::lock_guard lock(task.Group->m_ExceptionMutex);
+		if (!task.Group->m_Exception)
+		{
+			task.Group->m_Exception = std::current_exception();
+		}
+	}
+	task.Group->m_PendingTasks.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+
+UINT ThreadPool::GetLocalQueueIndex()
+{
+	if (t_WorkerPool == this)
+		return t_WorkerIndex;
+	return m_NextExternalQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<UINT>(m_Queues.size());
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Core.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+
+// A work-stealing thread pool
+// Each worker owns a queue of tasks. Workers pop work from the back of their own queue
+// and steal from the front of other workers' queues when they run out of work.
+// Threads that wait on a task group will also execute tasks until the group is complete,
+// so tasks are free to submit and wait on further work.
+// An exception thrown by a task is passed back to the thread that waits on its group.
+// THROW_IF_FAIL does not check in release builds, so tasks whose failures must reach the waiter use THROW_IF_FAIL_ALWAYS.
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	// Counts outstanding tasks so that a set of tasks can be waited on
+	class TaskGroup
+	{
+	public:
+		TaskGroup() = default;
+		~TaskGroup() = default;
+
+		DISALLOW_COPY(TaskGroup)
+		DISALLOW_MOVE(TaskGroup)
+
+		inline bool IsComplete() const { return m_PendingTasks.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class ThreadPool;
+		std::atomic<UINT> m_PendingTasks = 0;
+
+		// The first exception thrown by a task in the group, until it is rethrown by Wait
+		std::mutex m_ExceptionMutex;
+		std::exception_ptr m_Exception;
+	};
+
+public:
+	// A thread count of 0 will create one worker for each hardware thread
+	ThreadPool(UINT threadCount = 0);
+	~ThreadPool();
+
+	DISALLOW_COPY(ThreadPool)
+	DISALLOW_MOVE(ThreadPool)
+
+	void Submit(TaskGroup& group, Task task);
+
+	// Executes tasks until every task in the group has completed
+	// If any task in the group threw, the first exception is rethrown once they have all completed
+	void Wait(TaskGroup& group);
+
+	// Splits the range [begin, end) into chunks of at most grainSize elements
+	// func will be called with the range of each chunk, and ParallelFor will return once all chunks have completed
+	void ParallelFor(UINT begin, UINT end, UINT grainSize, const std::function<void(UINT, UINT)>& func);
+
+	inline UINT GetThreadCount() const { return static_cast<UINT>(m_Workers.size()); }
+
+private:
+	struct QueuedTask
+	{
+		Task Function;
+		TaskGroup* Group = nullptr;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex Mutex;
+		std::deque<QueuedTask> Tasks;
+	};
+
+	void WorkerThreadProc(UINT workerIndex);
+
+	bool PopTask(UINT queueIndex, QueuedTask& task);
+	bool StealTask(UINT thiefIndex, QueuedTask& task);
+	bool TryExecuteTask(UINT workerIndex);
+
+	// Returns the index of the queue the calling thread should push to and pop from
+	UINT GetLocalQueueIndex();
+
+private:
+	std::vector<std::thread> m_Workers;
+	std::vector<std::unique_ptr<WorkerQueue>> m_Queues;
+
+	// Used to put idle workers to sleep
+	std::mutex m_SleepMutex;
+	std::condition_variable m_WakeCondition;
+	std::atomic<UINT> m_QueuedTaskCount = 0;
+	std::atomic<bool> m_Terminate = false;
+
+	// Threads outside of the pool distribute their tasks round-robin
+	std::atomic<UINT> m_NextExternalQueue = 0;
+};
@@ -69,6 +69,22 @@ public:
 		return value;
 	}
 
+	// Reads the first elementCount elements in a single map
+	// This is only valid for buffers allocated without alignment
+	void ReadElements(UINT elementCount, T* pOut) const
+	{
+		ASSERT(elementCount <= m_ElementCount, "Out of bounds access");
+		ASSERT(m_ElementStride == sizeof(T), "Cannot read aligned elements contiguously");
+
+		T* pData;
+
+		const CD3DX12_RANGE readRange(0, static_cast<SIZE_T>(elementCount) * m_ElementStride);
+
+		THROW_IF_FAIL(m_ReadbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pData)));
+		memcpy(pOut, pData, static_cast<size_t>(elementCount) * sizeof(T));
+		m_ReadbackBuffer->Unmap(0, nullptr);
+	}
+
 private:
 	ComPtr<ID3D12Resource> m_ReadbackBuffer;
 
@@ -6,7 +6,60 @@
 #include "D3DShaderCompiler.h"
 
 
+namespace
+{
+	// Shared by every builder. Each worker has its own shader compiler, so the pool is kept small
+	ThreadPool& GetPipelineThreadPool()
+	{
+		static ThreadPool pool((std::min)(std::thread::hardware_concurrency(), 8u));
+		return pool;
+	}
+}
+
+
+D3DPipelineBuilder::~D3DPipelineBuilder()
+{
+	// Only reached with tasks outstanding if the builder is unwound by an exception, which must not be replaced by another
+	try
+	{
+		Wait();
+	}
+	catch (const std::exception& e)
+	{
+		LOG_ERROR("Pipeline creation failed while the builder was destroyed: {}", e.what());
+	}
+}
+
+void D3DPipelineBuilder::Add(ThreadPool::Task task)
+{
+	GetPipelineThreadPool().Submit(m_Group, std::move(task));
+}
+
+void D3DPipelineBuilder::Wait()
+{
+	GetPipelineThreadPool().Wait(m_Group);
+}
+
+
 D3DComputePipeline::D3DComputePipeline(D3DComputePipelineDesc* desc)
+{
+	CreateRootSignature(desc);
+	CreatePipelineState(desc->Shader, desc->EntryPoint, desc->Defines);
+}
+
+D3DComputePipeline::D3DComputePipeline(D3DComputePipelineDesc* desc, D3DPipelineBuilder& builder)
+{
+	// Root signatures are cheap to create, and the root parameters of the description are usually on the caller's stack
+	CreateRootSignature(desc);
+
+	builder.Add([this, shader = std::wstring(desc->Shader), entryPoint = std::wstring(desc->EntryPoint), defines = desc->Defines]()
+		{
+			CreatePipelineState(shader.c_str(), entryPoint.c_str(), defines);
+		});
+}
+
+
+void D3DComputePipeline::CreateRootSignature(const D3DComputePipelineDesc* desc)
 {
 	const auto device = g_D3DGraphicsContext->GetDevice();
 
@@ -17,43 +70,42 @@ D3DComputePipeline::D3DComputePipeline(D3DComputePipelineDesc* desc)
 		featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
 	}
 
+	// Create a default sampler
+	D3D12_STATIC_SAMPLER_DESC samplerDesc = {};
+	samplerDesc.Filter = D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR;
+	samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	samplerDesc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	samplerDesc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	samplerDesc.MipLODBias = 0;
+	samplerDesc.MaxAnisotropy = 0;
+	samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+	samplerDesc.BorderColor = D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK;
+	samplerDesc.MinLOD = 0;
+	samplerDesc.MaxLOD = D3D12_FLOAT32_MAX;
+	samplerDesc.ShaderRegister = 0;
+	samplerDesc.RegisterSpace = 0;
+	samplerDesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
 	// Create the compute root signature
-	{
-		// Create a default sampler
-		D3D12_STATIC_SAMPLER_DESC samplerDesc = {};
-		samplerDesc.Filter = D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR;
-		samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-		samplerDesc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-		samplerDesc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-		samplerDesc.MipLODBias = 0;
-		samplerDesc.MaxAnisotropy = 0;
-		samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-		samplerDesc.BorderColor = D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK;
-		samplerDesc.MinLOD = 0;
-		samplerDesc.MaxLOD = D3D12_FLOAT32_MAX;
-		samplerDesc.ShaderRegister = 0;
-		samplerDesc.RegisterSpace = 0;
-		samplerDesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-
-		CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-		rootSignatureDesc.Init_1_1(desc->NumRootParameters, desc->RootParameters, 1, &samplerDesc, D3D12_ROOT_SIGNATURE_FLAG_NONE);
-
-		ComPtr<ID3DBlob> signature;
-		THROW_IF_FAIL(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, nullptr));
-		THROW_IF_FAIL(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_RootSignature)));
-	}
+	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init_1_1(desc->NumRootParameters, desc->RootParameters, 1, &samplerDesc, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+	ComPtr<ID3DBlob> signature;
+	THROW_IF_FAIL(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, nullptr));
+	THROW_IF_FAIL(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_RootSignature)));
+}
+
+void D3DComputePipeline::CreatePipelineState(const wchar_t* shader, const wchar_t* entryPoint, const std::vector<std::wstring>& defines)
+{
+	ComPtr<IDxcBlob> computeShader;
+	THROW_IF_FAIL_ALWAYS(D3DShaderCompiler::CompileFromFile(shader, entryPoint, L"cs", defines, &computeShader));
 
 	// Create the compute pipeline state
-	{
-		ComPtr<IDxcBlob> computeShader;
-		THROW_IF_FAIL(D3DShaderCompiler::CompileFromFile(desc->Shader, desc->EntryPoint, L"cs", desc->Defines, &computeShader));
-
-		D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
-		psoDesc.pRootSignature = m_RootSignature.Get();
-		psoDesc.CS.pShaderBytecode = computeShader->GetBufferPointer();
-		psoDesc.CS.BytecodeLength = computeShader->GetBufferSize();
-		THROW_IF_FAIL(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&m_PipelineState)));
-	}
+	D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+	psoDesc.pRootSignature = m_RootSignature.Get();
+	psoDesc.CS.pShaderBytecode = computeShader->GetBufferPointer();
+	psoDesc.CS.BytecodeLength = computeShader->GetBufferSize();
+	THROW_IF_FAIL_ALWAYS(g_D3DGraphicsContext->GetDevice()->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&m_PipelineState)));
 }
 
 
@@ -1,8 +1,34 @@
 #pragma once
 
+#include "Framework/ThreadPool.h"
+
 using Microsoft::WRL::ComPtr;
 
 
+// Creates pipelines as tasks on a pool of worker threads, so that their shaders are compiled in parallel
+// Tasks start as soon as they are added, and Wait joins them. Pipelines created by the builder must not be used until it has been waited on
+class D3DPipelineBuilder
+{
+public:
+	D3DPipelineBuilder() = default;
+	// Waits for any tasks that are still running, without rethrowing their exceptions
+	~D3DPipelineBuilder();
+
+	DISALLOW_COPY(D3DPipelineBuilder)
+	DISALLOW_MOVE(D3DPipelineBuilder)
+
+	// Anything the task references must remain valid until the builder has been waited on
+	void Add(ThreadPool::Task task);
+
+	// Returns once every task has completed. The calling thread executes tasks while it waits
+	// If a task threw, such as when a shader fails to compile, its exception is rethrown here
+	void Wait();
+	inline bool IsComplete() const { return m_Group.IsComplete(); }
+
+private:
+	ThreadPool::TaskGroup m_Group;
+};
+
 
 struct D3DComputePipelineDesc
 {
@@ -21,12 +47,19 @@ class D3DComputePipeline
 {
 public:
 	D3DComputePipeline(D3DComputePipelineDesc* desc);
+	// Creates the root signature immediately, and compiles the shader and creates the pipeline state as a task of the builder
+	// The description does not need to outlive the constructor
+	D3DComputePipeline(D3DComputePipelineDesc* desc, D3DPipelineBuilder& builder);
 
 	void Bind(ID3D12GraphicsCommandList* commandList) const;
 
 	inline ID3D12RootSignature* GetRootSignature() const { return m_RootSignature.Get(); }
 	inline ID3D12PipelineState* GetPipelineState() const { return m_PipelineState.Get(); }
 
+protected:
+	void CreateRootSignature(const D3DComputePipelineDesc* desc);
+	void CreatePipelineState(const wchar_t* shader, const wchar_t* entryPoint, const std::vector<std::wstring>& defines);
+
 protected:
 	ComPtr<ID3D12RootSignature> m_RootSignature;
 	ComPtr<ID3D12PipelineState> m_PipelineState;
@@ -2,17 +2,99 @@
 #include "D3DShaderCompiler.h"
 
 #include "Core.h"
+#include "Framework/GameTimer.h"
+#include "Framework/Hash.h"
+
+#include <filesystem>
+#include <fstream>
+
+
+namespace
+{
+	// Each cache entry is one file, named by its key, holding this header followed by the compiled blob
+	struct CacheEntryHeader
+	{
+		UINT Magic;
+		UINT Version;
+		UINT64 Key;
+		UINT64 BlobHash;
+		UINT64 BlobSize;
+		float CompileTime;	// In ms
+		UINT Padding;
+	};
+	static_assert(std::is_trivially_copyable_v<CacheEntryHeader>, "Cache entry headers are written directly to disk!");
+
+	constexpr UINT s_CacheMagic = 0x43534453;	// "SDSC"
+	// Increment this whenever the layout of cache entries changes
+	constexpr UINT s_CacheVersion = 1;
+
+	// DXC objects must not be used by more than one thread at once, so each thread that compiles shaders has its own
+	// They are created on the first compilation of each thread, and released when it exits
+	struct ThreadCompiler
+	{
+		ComPtr<IDxcUtils> Utils;
+		ComPtr<IDxcCompiler3> Compiler;
+		ComPtr<IDxcIncludeHandler> IncludeHandler;
+	};
+
+	ThreadCompiler& GetThreadCompiler()
+	{
+		static thread_local std::unique_ptr<ThreadCompiler> t_Compiler;
+		if (!t_Compiler)
+		{
+			t_Compiler = std::make_unique<ThreadCompiler>();
+			THROW_IF_FAIL_ALWAYS(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&t_Compiler->Utils)));
+			THROW_IF_FAIL_ALWAYS(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&t_Compiler->Compiler)));
+			THROW_IF_FAIL_ALWAYS(t_Compiler->Utils->CreateDefaultIncludeHandler(&t_Compiler->IncludeHandler));
+		}
+		return *t_Compiler;
+	}
+
+	UINT64 HashString(const wchar_t* str, UINT64 hash)
+	{
+		// The terminator is included, so that the boundaries between strings change the hash
+		return Hash::Bytes(str, (wcslen(str) + 1) * sizeof(wchar_t), hash);
+	}
+}
+
+
+void D3DShaderCompiler::CacheStatistics::Log() const
+{
+	LOG_INFO("Shader cache: {} of {} shaders loaded from the cache ({:.1f}% hit rate), {} written.", Hits, Lookups, 100.0f * GetHitRate(), Writes);
+	LOG_INFO("Shader cache: {:.1f} ms preprocessing, {:.1f} ms loading, {:.1f} ms compiling, {:.1f} ms saved.", PreprocessTime, LoadTime, CompileTime, SavedTime);
+}
+
 
 D3DShaderCompiler::D3DShaderCompiler()
 {
-	THROW_IF_FAIL(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_Utils)));
-	THROW_IF_FAIL(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_Compiler)));
+	const ComPtr<IDxcCompiler3>& compiler = GetThreadCompiler().Compiler;
 
-	THROW_IF_FAIL(m_Utils->CreateDefaultIncludeHandler(&m_IncludeHandler));
+	m_CompilerVersionHash = Hash::s_Seed;
+	ComPtr<IDxcVersionInfo> versionInfo;
+	if (SUCCEEDED(compiler.As(&versionInfo)))
+	{
+		UINT32 major = 0, minor = 0;
+		versionInfo->GetVersion(&major, &minor);
+		m_CompilerVersionHash = Hash::Value(major, m_CompilerVersionHash);
+		m_CompilerVersionHash = Hash::Value(minor, m_CompilerVersionHash);
+	}
+	// Builds of the same version can differ, so the commit is hashed as well when it is available
+	ComPtr<IDxcVersionInfo2> versionInfo2;
+	if (SUCCEEDED(compiler.As(&versionInfo2)))
+	{
+		UINT32 commitCount = 0;
+		char* commitHash = nullptr;
+		if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash)) && commitHash)
+		{
+			m_CompilerVersionHash = Hash::Value(commitCount, m_CompilerVersionHash);
+			m_CompilerVersionHash = Hash::Bytes(commitHash, strlen(commitHash), m_CompilerVersionHash);
+			CoTaskMemFree(commitHash);
+		}
+	}
 }
 
 
-HRESULT D3DShaderCompiler::CompileFromFileImpl(const wchar_t* file, const wchar_t* entryPoint, const wchar_t* target, const std::vector<std::wstring>& defines, ComPtr<IDxcBlob>* ppBlob) const
+HRESULT D3DShaderCompiler::CompileFromFileImpl(const wchar_t* file, const wchar_t* entryPoint, const wchar_t* target, const std::vector<std::wstring>& defines, ComPtr<IDxcBlob>* ppBlob)
 {
 	// format target
 	std::wstring targetStr = target;
@@ -46,9 +128,11 @@ HRESULT D3DShaderCompiler::CompileFromFileImpl(const wchar_t* file, const wchar_
 	}
 
 
+	const ThreadCompiler& threadCompiler = GetThreadCompiler();
+
     // Open source file.  
 	ComPtr<IDxcBlobEncoding> pSource = nullptr;
-	HRESULT result = m_Utils->LoadFile(file, nullptr, &pSource);
+	HRESULT result = threadCompiler.Utils->LoadFile(file, nullptr, &pSource);
 
 	// Check for success
 	if (FAILED(result))
@@ -61,12 +145,41 @@ HRESULT D3DShaderCompiler::CompileFromFileImpl(const wchar_t* file, const wchar_
 	Source.Size = pSource->GetBufferSize();
 	Source.Encoding = DXC_CP_ACP;
 
+	GameTimer timer;
+
+	// Look for the shader in the cache
+	UINT64 cacheKey = 0;
+	bool cacheable = false;
+	if (!m_CacheDirectory.empty())
+	{
+		timer.Reset();
+		cacheable = CalculateCacheKey(Source, args, cacheKey);
+		const float preprocessTime = 1000.0f * timer.Tick();
+
+		float cachedCompileTime = 0.0f;
+		const bool hit = cacheable && LoadCachedBlob(cacheKey, ppBlob, cachedCompileTime);
+		const float loadTime = 1000.0f * timer.Tick();
+
+		std::lock_guard lock(m_StatisticsMutex);
+		m_CacheStatistics.Lookups++;
+		m_CacheStatistics.PreprocessTime += preprocessTime;
+		if (hit)
+		{
+			m_CacheStatistics.Hits++;
+			m_CacheStatistics.LoadTime += loadTime;
+			m_CacheStatistics.SavedTime += cachedCompileTime - preprocessTime - loadTime;
+			return S_OK;
+		}
+	}
+
+	timer.Reset();
+
 	ComPtr<IDxcResult> pResults;
-	m_Compiler->Compile(
+	threadCompiler.Compiler->Compile(
 		&Source,                // Source buffer.
 		args.data(),                // Array of pointers to arguments.
 		static_cast<UINT32>(args.size()),      // Number of arguments.
-		m_IncludeHandler.Get(), // User-provided interface to handle #include directives (optional).
+		threadCompiler.IncludeHandler.Get(), // User-provided interface to handle #include directives (optional).
 		IID_PPV_ARGS(&pResults) // Compiler output status, buffer, and errors.
 	);
 
@@ -100,6 +213,17 @@ HRESULT D3DShaderCompiler::CompileFromFileImpl(const wchar_t* file, const wchar_
 		return result;
 	}
 
+	const float compileTime = 1000.0f * timer.Tick();
+	{
+		std::lock_guard lock(m_StatisticsMutex);
+		m_CacheStatistics.CompileTime += compileTime;
+	}
+
+	if (cacheable)
+	{
+		StoreCachedBlob(cacheKey, ppBlob->Get(), compileTime);
+	}
+
 	return result;
 }
 
@@ -111,3 +235,134 @@ void D3DShaderCompiler::SetShaderModelImpl(const wchar_t* major, const wchar_t*
 	m_ShaderModelExtension = L"_" + majorStr + L"_" + minorStr;
 }
 
+void D3DShaderCompiler::SetCacheDirectoryImpl(const std::string& directory)
+{
+	m_CacheDirectory = directory;
+	if (m_CacheDirectory.empty())
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(m_CacheDirectory, error);
+	if (error)
+	{
+		LOG_WARN("Failed to create shader cache directory '{}': {} - shaders will not be cached.", m_CacheDirectory, error.message());
+		m_CacheDirectory.clear();
+		return;
+	}
+
+	LOG_INFO("Caching compiled shaders in '{}'.", m_CacheDirectory);
+}
+
+D3DShaderCompiler::CacheStatistics D3DShaderCompiler::GetCacheStatisticsImpl() const
+{
+	std::lock_guard lock(m_StatisticsMutex);
+	return m_CacheStatistics;
+}
+
+void D3DShaderCompiler::ResetCacheStatisticsImpl()
+{
+	std::lock_guard lock(m_StatisticsMutex);
+	m_CacheStatistics = {};
+}
+
+
+bool D3DShaderCompiler::CalculateCacheKey(const DxcBuffer& source, const std::vector<LPCWSTR>& args, UINT64& outKey) const
+{
+	// The preprocessed source has every include expanded and every define applied,
+	// so an edit to any file the shader includes changes the key, while an edit to a comment does not
+	std::vector<LPCWSTR> preprocessArgs = args;
+	preprocessArgs.push_back(L"-P");
+
+	const ThreadCompiler& threadCompiler = GetThreadCompiler();
+	ComPtr<IDxcResult> pResults;
+	HRESULT result = threadCompiler.Compiler->Compile(&source, preprocessArgs.data(), static_cast<UINT32>(preprocessArgs.size()), threadCompiler.IncludeHandler.Get(), IID_PPV_ARGS(&pResults));
+	if (FAILED(result) || FAILED(pResults->GetStatus(&result)) || FAILED(result))
+		return false;
+
+	ComPtr<IDxcBlobUtf8> pPreprocessed;
+	if (FAILED(pResults->GetOutput(DXC_OUT_HLSL, IID_PPV_ARGS(&pPreprocessed), nullptr)) || !pPreprocessed)
+		return false;
+
+	UINT64 key = m_CompilerVersionHash;
+	for (const auto arg : args)
+	{
+		key = HashString(arg, key);
+	}
+	outKey = Hash::Bytes(pPreprocessed->GetStringPointer(), pPreprocessed->GetStringLength(), key);
+	return true;
+}
+
+std::string D3DShaderCompiler::GetCachePath(UINT64 key) const
+{
+	char name[32];
+	sprintf_s(name, "%016llx.dxil", key);
+	return m_CacheDirectory + "/" + name;
+}
+
+bool D3DShaderCompiler::LoadCachedBlob(UINT64 key, ComPtr<IDxcBlob>* ppBlob, float& outCompileTime) const
+{
+	std::ifstream file(GetCachePath(key), std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	CacheEntryHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+		|| header.Magic != s_CacheMagic || header.Version != s_CacheVersion || header.Key != key || header.BlobSize > UINT32_MAX)
+	{
+		return false;
+	}
+
+	std::vector<BYTE> blob(header.BlobSize);
+	if (!file.read(reinterpret_cast<char*>(blob.data()), static_cast<std::streamsize>(blob.size())))
+		return false;
+
+	// Anything torn or corrupted is compiled again, and the entry replaced
+	if (Hash::Bytes(blob.data(), blob.size()) != header.BlobHash)
+	{
+		LOG_WARN("Shader cache entry '{}' is corrupt and will be replaced.", GetCachePath(key));
+		return false;
+	}
+
+	ComPtr<IDxcBlobEncoding> pBlob;
+	if (FAILED(GetThreadCompiler().Utils->CreateBlob(blob.data(), static_cast<UINT32>(blob.size()), DXC_CP_ACP, &pBlob)) || FAILED(pBlob.As(ppBlob)))
+		return false;
+
+	outCompileTime = header.CompileTime;
+	return true;
+}
+
+void D3DShaderCompiler::StoreCachedBlob(UINT64 key, IDxcBlob* blob, float compileTime)
+{
+	CacheEntryHeader header = {};
+	header.Magic = s_CacheMagic;
+	header.Version = s_CacheVersion;
+	header.Key = key;
+	header.BlobHash = Hash::Bytes(blob->GetBufferPointer(), blob->GetBufferSize());
+	header.BlobSize = blob->GetBufferSize();
+	header.CompileTime = compileTime;
+
+	// Written beside the entry and then moved into place, so a reader never sees a partial entry
+	// The temporary file is named by thread, as two threads may compile the same shader at once
+	const std::string path = GetCachePath(key);
+	const std::string tempPath = path + "." + std::to_string(GetCurrentThreadId()) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(static_cast<const char*>(blob->GetBufferPointer()), static_cast<std::streamsize>(blob->GetBufferSize()));
+		if (!file.good())
+		{
+			LOG_WARN("Failed to write shader cache entry '{}'.", tempPath);
+			return;
+		}
+	}
+
+	if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		LOG_WARN("Failed to move shader cache entry into place at '{}' (error {}).", path, GetLastError());
+		DeleteFileA(tempPath.c_str());
+		return;
+	}
+
+	std::lock_guard lock(m_StatisticsMutex);
+	m_CacheStatistics.Writes++;
+}
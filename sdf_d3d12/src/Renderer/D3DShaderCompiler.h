@@ -1,14 +1,35 @@
 #pragma once
 
 #include <dxcapi.h>
+#include <mutex>
 
 using Microsoft::WRL::ComPtr;
 
 
 class D3DShaderCompiler
 {
+public:
+	struct CacheStatistics
+	{
+		UINT Lookups = 0;			// Compilations that looked in the cache
+		UINT Hits = 0;
+		UINT Writes = 0;
+
+		// In ms
+		float PreprocessTime = 0.0f;	// Preprocessing sources to find their keys
+		float LoadTime = 0.0f;			// Reading the blobs of hits
+		float CompileTime = 0.0f;		// Compiling misses, and anything compiled with the cache disabled
+		// The time that hits took to compile when they were cached, less the time to preprocess and load them
+		float SavedTime = 0.0f;
+
+		inline float GetHitRate() const { return Lookups > 0 ? static_cast<float>(Hits) / static_cast<float>(Lookups) : 0.0f; }
+
+		void Log() const;
+	};
+
 public:
 
+	// Can be called from any number of threads at once
 	static HRESULT CompileFromFile(
 		const wchar_t* file,
 		const wchar_t* entryPoint,
@@ -27,6 +48,22 @@ public:
 		Get().SetShaderModelImpl(major, minor);
 	}
 
+	// Compiled shaders are cached in this directory, and loaded from it when their source is unchanged
+	// An empty directory disables the cache
+	static void SetCacheDirectory(const std::string& directory)
+	{
+		Get().SetCacheDirectoryImpl(directory);
+	}
+
+	static CacheStatistics GetCacheStatistics()
+	{
+		return Get().GetCacheStatisticsImpl();
+	}
+	static void ResetCacheStatistics()
+	{
+		Get().ResetCacheStatisticsImpl();
+	}
+
 private:
 	inline static D3DShaderCompiler& Get()
 	{
@@ -42,14 +79,32 @@ private:
 		const wchar_t* target,
 		const std::vector<std::wstring>& defines,
 		ComPtr<IDxcBlob>* ppBlob
-	) const;
+	);
 
 	void SetShaderModelImpl(const wchar_t* major, const wchar_t* minor);
+	void SetCacheDirectoryImpl(const std::string& directory);
+	CacheStatistics GetCacheStatisticsImpl() const;
+	void ResetCacheStatisticsImpl();
 
-private:
-	ComPtr<IDxcUtils> m_Utils;
-	ComPtr<IDxcCompiler3> m_Compiler;
-	ComPtr<IDxcIncludeHandler> m_IncludeHandler;
+	// The key of a shader is a hash of its preprocessed source, which takes in everything it includes,
+	// the arguments it is compiled with, which hold its defines, entry point and shader model, and the compiler version
+	// Returns false if the source could not be preprocessed
+	bool CalculateCacheKey(const DxcBuffer& source, const std::vector<LPCWSTR>& args, UINT64& outKey) const;
 
+	std::string GetCachePath(UINT64 key) const;
+	// Returns false if there is no valid entry for the key
+	bool LoadCachedBlob(UINT64 key, ComPtr<IDxcBlob>* ppBlob, float& outCompileTime) const;
+	void StoreCachedBlob(UINT64 key, IDxcBlob* blob, float compileTime);
+
+private:
+	// Compilers are created for each thread that compiles shaders, so any number of shaders can be compiled at once
+	// The shader model and cache directory must not be changed while anything is being compiled
 	std::wstring m_ShaderModelExtension = L"_6_5"; // e.g. "_6_5"
+
+	std::string m_CacheDirectory;
+	// Hashed into every key, so that a new compiler never loads blobs from an old one
+	UINT64 m_CompilerVersionHash = 0;
+
+	mutable std::mutex m_StatisticsMutex;
+	CacheStatistics m_CacheStatistics;
 };
@@ -115,6 +115,9 @@ LightManager::~LightManager()
 
 void LightManager::CreatePipelines()
 {
+	// The shaders are compiled in parallel
+	D3DPipelineBuilder builder;
+
 	{
 		using namespace IrradianceMapPipelineSignature;
 
@@ -135,7 +138,7 @@ void LightManager::CreatePipelines()
 		desc.Shader = L"assets/shaders/compute/environment/irradiance.hlsl";
 		desc.EntryPoint = L"main";
 
-		m_Pipelines[GlobalLightingPipeline::IrradianceMap] = std::make_unique<D3DComputePipeline>(&desc);
+		m_Pipelines[GlobalLightingPipeline::IrradianceMap] = std::make_unique<D3DComputePipeline>(&desc, builder);
 	}
 
 	{
@@ -153,7 +156,7 @@ void LightManager::CreatePipelines()
 		desc.Shader = L"assets/shaders/compute/environment/brdf_integration.hlsl";
 		desc.EntryPoint = L"main";
 
-		m_Pipelines[GlobalLightingPipeline::BRDFIntegration] = std::make_unique<D3DComputePipeline>(&desc);
+		m_Pipelines[GlobalLightingPipeline::BRDFIntegration] = std::make_unique<D3DComputePipeline>(&desc, builder);
 	}
 
 	{
@@ -176,8 +179,10 @@ void LightManager::CreatePipelines()
 		desc.Shader = L"assets/shaders/compute/environment/prefiltered_environment.hlsl";
 		desc.EntryPoint = L"main";
 
-		m_Pipelines[GlobalLightingPipeline::PreFilteredEnvironmentMap] = std::make_unique<D3DComputePipeline>(&desc);
+		m_Pipelines[GlobalLightingPipeline::PreFilteredEnvironmentMap] = std::make_unique<D3DComputePipeline>(&desc, builder);
 	}
+
+	builder.Wait();
 }
 
 void LightManager::CreateResources()
@@ -5,6 +5,7 @@
 
 #include "Application/Scene.h"
 #include "RaytracingSceneDefines.h"
+#include "Renderer/D3DPipeline.h"
 #include "Renderer/D3DShaderCompiler.h"
 #include "Renderer/ShaderTable.h"
 
@@ -32,6 +33,7 @@ void PopulateLocalRootParams(const SDFObject* object, LocalRootSignatureParams::
 {
 	rootArgs.brickProperties.BrickSize = object->GetBrickSize(SDFObject::RESOURCES_READ);
 	rootArgs.brickProperties.BrickCount = object->GetBrickCount(SDFObject::RESOURCES_READ);
+	rootArgs.brickProperties.BrickPoolPlacement = object->GetBrickPoolPlacement(SDFObject::RESOURCES_READ);
 
 	rootArgs.brickProperties.BrickPoolDimensions = object->GetBrickPoolResolution(SDFObject::RESOURCES_READ);
 	const XMVECTOR uvwPerBrick = XMVECTOR({ 1.0f, 1.0f, 1.0f, 1.0f }) / XMLoadUInt3(&rootArgs.brickProperties.BrickPoolDimensions);
@@ -48,19 +50,31 @@ void PopulateLocalRootParams(const SDFObject* object, LocalRootSignatureParams::
 Raytracer::Raytracer()
 {
 	LOG_INFO("Initializing raytracer...");
+
+	// The shader library is compiled on a worker while everything else is created
+	// The library is declared first, so that if anything below throws, the builder waits for the task before the library is destroyed
+	ComPtr<IDxcBlob> library;
+	D3DPipelineBuilder builder;
+	builder.Add([&library]()
+		{
+			THROW_IF_FAIL_ALWAYS(D3DShaderCompiler::CompileFromFile(L"assets/shaders/raytracing/raytracing.hlsl", L"main", L"lib", {}, &library));
+		});
+
 	// Create resources
 
 	// Create root signatures for the shaders.
 	CreateRootSignatures();
 
-	// Create a raytracing pipeline state object which defines the binding of shaders, state and resources to be used during raytracing.
-	CreateRaytracingPipelineStateObject();
-
 	// Create an output 2D texture to store the raytracing result to.
 	CreateRaytracingOutputResource();
 
 	CreateSamplers();
 
+	builder.Wait();
+
+	// Create a raytracing pipeline state object which defines the binding of shaders, state and resources to be used during raytracing.
+	CreateRaytracingPipelineStateObject(library.Get());
+
 	LOG_INFO("Raytracing initialization complete.");
 }
 
@@ -213,7 +227,7 @@ void Raytracer::CreateRootSignatures()
 
 
 
-void Raytracer::CreateRaytracingPipelineStateObject()
+void Raytracer::CreateRaytracingPipelineStateObject(IDxcBlob* library)
 {
 	LOG_INFO("Create pipeline state object...");
 
@@ -222,9 +236,7 @@ void Raytracer::CreateRaytracingPipelineStateObject()
 	// DXIL library
 	const auto lib = raytracingPipeline.CreateSubobject<CD3DX12_DXIL_LIBRARY_SUBOBJECT>();
 
-	ComPtr<IDxcBlob> blob;
-	THROW_IF_FAIL(D3DShaderCompiler::CompileFromFile(L"assets/shaders/raytracing/raytracing.hlsl", L"main", L"lib", {}, &blob));
-	D3D12_SHADER_BYTECODE libdxil = CD3DX12_SHADER_BYTECODE(blob->GetBufferPointer(), blob->GetBufferSize());
+	D3D12_SHADER_BYTECODE libdxil = CD3DX12_SHADER_BYTECODE(library->GetBufferPointer(), library->GetBufferSize());
 
 	lib->SetDXILLibrary(&libdxil);
 	// Define which shader exports to surface from the library.
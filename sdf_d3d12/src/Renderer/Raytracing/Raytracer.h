@@ -9,6 +9,7 @@ using Microsoft::WRL::ComPtr;
 
 class ShaderTable;
 class Scene;
+struct IDxcBlob;
 
 
 class Raytracer
@@ -49,7 +50,7 @@ private:
 	// Init
 	void SerializeAndCreateRaytracingRootSignature(D3D12_ROOT_SIGNATURE_DESC& desc, ComPtr<ID3D12RootSignature>* rootSig) const;
 	void CreateRootSignatures();
-	void CreateRaytracingPipelineStateObject();
+	void CreateRaytracingPipelineStateObject(IDxcBlob* library);
 	void CreateRaytracingOutputResource();
 	void CreateSamplers();
 
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "HlslCompat/HlslDefines.h"
+
+
+namespace BrickPoolPlacement
+{
+	enum Value
+	{
+		// Slots fill the pool a row at a time
+		Linear = SDF_BRICK_POOL_PLACEMENT_LINEAR,
+		// Consecutive slots are close together on every axis, so spatially adjacent bricks share more of the texture cache
+		Morton = SDF_BRICK_POOL_PLACEMENT_MORTON,
+		Count
+	};
+
+	inline const char* GetName(Value placement)
+	{
+		static const char* names[] =
+		{
+			"Linear",
+			"Morton"
+		};
+		static_assert(ARRAYSIZE(names) == Count);
+		return names[placement];
+	}
+}
+
+
+// CPU implementations of the functions in brick_helper.hlsli
+// Any change to brick_helper.hlsli must be reflected here.
+
+namespace BrickHelpers
+{
+	// Expands a 10-bit integer into 30 bits
+	// by inserting 2 zeros after each bit.
+	inline UINT expandBits(UINT v)
+	{
+		v = (v * 0x00010001u) & 0xFF0000FFu;
+		v = (v * 0x00000101u) & 0x0F00F00Fu;
+		v = (v * 0x00000011u) & 0xC30C30C3u;
+		v = (v * 0x00000005u) & 0x49249249u;
+		return v;
+	}
+
+	// Calculates a 30-bit Morton code for the
+	// given 3D point located within the unit cube [0,1].
+	inline UINT morton3Df(float x, float y, float z)
+	{
+		x = min(max(x * 1024.0f, 0.0f), 1023.0f);
+		y = min(max(y * 1024.0f, 0.0f), 1023.0f);
+		z = min(max(z * 1024.0f, 0.0f), 1023.0f);
+		const UINT xx = expandBits(static_cast<UINT>(x));
+		const UINT yy = expandBits(static_cast<UINT>(y));
+		const UINT zz = expandBits(static_cast<UINT>(z));
+		return xx * 4 + yy * 2 + zz;
+	}
+
+	// Calculates a 30-bit Morton code for the
+	// given 3D point located within the range [0,1023].
+	inline UINT morton3Du(XMUINT3 p)
+	{
+		p.x = min(p.x, 1023u);
+		p.y = min(p.y, 1023u);
+		p.z = min(p.z, 1023u);
+		const UINT xx = expandBits(p.x);
+		const UINT yy = expandBits(p.y);
+		const UINT zz = expandBits(p.z);
+		return xx * 4 + yy * 2 + zz;
+	}
+
+	// Takes a 30 bit integer and compacts it into 10 bits
+	// By removing ever 2nd and 3rd bit
+	inline UINT compactBits(UINT x)
+	{
+		x &= 0x09249249;
+		x = (x ^ (x >> 2)) & 0x030c30c3;
+		x = (x ^ (x >> 4)) & 0x0300f00f;
+		x = (x ^ (x >> 8)) & 0xff0000ff;
+		x = (x ^ (x >> 16)) & 0x000003ff;
+		return x;
+	}
+
+	inline XMUINT3 decodeMorton3D(UINT v)
+	{
+		return { compactBits(v >> 2), compactBits(v >> 1), compactBits(v) };
+	}
+
+
+	// Takes a distance from evaluation space and then maps it to a distance to be stored in a brick
+	inline float FormatDistance(float inDistance, float voxelsPerUnit)
+	{
+		// Calculate the distance value in terms of voxels
+		const float voxelDistance = inDistance * voxelsPerUnit;
+
+		// Now map the distance such that 1 = SDF_VOLUME_STRIDE number of voxels
+		return min(max(voxelDistance / SDF_VOLUME_STRIDE, -1.0f), 1.0f);
+	}
+
+	// The length of [corner, corner + side) that is within [0, capacity)
+	inline UINT ClippedExtent(UINT corner, UINT side, UINT capacity)
+	{
+		return corner < capacity ? min(capacity - corner, side) : 0;
+	}
+
+	// Calculates the brick that a slot maps to in Morton order
+	// The octants of the pool are visited in Morton order, and the parts of octants that lie outside of the pool are skipped,
+	// so that every slot maps to a different brick whatever the dimensions of the pool.
+	// For a pool that is a power of two cube, this is decodeMorton3D(brickIndex)
+	inline XMUINT3 CalculateMortonBrickPosition(UINT brickIndex, const XMUINT3& brickPoolCapacity)
+	{
+		UINT side = 1;
+		while (side < max(brickPoolCapacity.x, max(brickPoolCapacity.y, brickPoolCapacity.z)))
+			side *= 2;
+
+		XMUINT3 origin = { 0, 0, 0 };
+		while (side > 1)
+		{
+			side /= 2;
+
+			for (UINT octant = 0; octant < 8; octant++)
+			{
+				// x is the most significant bit of each level of a Morton code
+				const XMUINT3 corner = {
+					origin.x + ((octant >> 2) & 1) * side,
+					origin.y + ((octant >> 1) & 1) * side,
+					origin.z + (octant & 1) * side
+				};
+
+				// The number of bricks of this octant that are inside the pool
+				const UINT count = ClippedExtent(corner.x, side, brickPoolCapacity.x)
+								 * ClippedExtent(corner.y, side, brickPoolCapacity.y)
+								 * ClippedExtent(corner.z, side, brickPoolCapacity.z);
+
+				if (brickIndex < count)
+				{
+					origin = corner;
+					break;
+				}
+				brickIndex -= count;
+			}
+		}
+
+		return origin;
+	}
+
+	// Calculates the voxel in the brick pool that the first voxel of a brick maps to
+	inline XMUINT3 CalculateBrickPoolPosition(UINT brickIndex, const XMUINT3& brickPoolCapacity, BrickPoolPlacement::Value placement = BrickPoolPlacement::Linear)
+	{
+		if (placement == BrickPoolPlacement::Morton)
+		{
+			const XMUINT3 brickTopLeft = CalculateMortonBrickPosition(brickIndex, brickPoolCapacity);
+			return {
+				brickTopLeft.x * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+				brickTopLeft.y * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+				brickTopLeft.z * SDF_BRICK_SIZE_VOXELS_ADJACENCY
+			};
+		}
+
+		XMUINT3 brickTopLeft;
+
+		brickTopLeft.x = brickIndex % brickPoolCapacity.x;
+		brickIndex /= brickPoolCapacity.x;
+		brickTopLeft.y = brickIndex % brickPoolCapacity.y;
+		brickIndex /= brickPoolCapacity.y;
+		brickTopLeft.z = brickIndex;
+
+		return {
+			brickTopLeft.x * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+			brickTopLeft.y * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+			brickTopLeft.z * SDF_BRICK_SIZE_VOXELS_ADJACENCY
+		};
+	}
+
+
+	// Converts a float to a signed normalized 8-bit value following the D3D conversion rules,
+	// as performed when writing to an R8G8B8A8_SNORM texture
+	inline INT8 FloatToSNORM8(float v)
+	{
+		if (v != v) // NaN
+			return 0;
+		v = min(max(v, -1.0f), 1.0f) * 127.0f;
+		return static_cast<INT8>(v >= 0.0f ? v + 0.5f : v - 0.5f);
+	}
+
+	inline float SNORM8ToFloat(INT8 v)
+	{
+		// -128 and -127 both map to -1
+		return max(static_cast<float>(v) / 127.0f, -1.0f);
+	}
+
+	// As above, for R16_SNORM textures
+	inline INT16 FloatToSNORM16(float v)
+	{
+		if (v != v) // NaN
+			return 0;
+		v = min(max(v, -1.0f), 1.0f) * 32767.0f;
+		return static_cast<INT16>(v >= 0.0f ? v + 0.5f : v - 0.5f);
+	}
+
+	inline float SNORM16ToFloat(INT16 v)
+	{
+		return max(static_cast<float>(v) / 32767.0f, -1.0f);
+	}
+}
@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "SDFBrickCache.h"
+
+#include "Framework/Hash.h"
+
+
+SDFBrickCache::SDFBrickCache(size_t budgetBytes)
+	: m_BudgetBytes(budgetBytes)
+{
+}
+
+
+UINT64 SDFBrickCache::BuildKey(const XMFLOAT3& topLeft, float brickSize, UINT64 editsHash)
+{
+	UINT64 key = Hash::Value(topLeft);
+	key = Hash::Value(brickSize, key);
+	return Hash::Value(editsHash, key);
+}
+
+
+const INT8* SDFBrickCache::Find(UINT64 key)
+{
+	const auto it = m_Lookup.find(key);
+	if (it == m_Lookup.end())
+	{
+		m_Statistics.Misses++;
+		return nullptr;
+	}
+
+	m_Statistics.Hits++;
+
+	// Move to the front of the list
+	m_Bricks.splice(m_Bricks.begin(), m_Bricks, it->second);
+	return it->second->Voxels.data();
+}
+
+void SDFBrickCache::Insert(UINT64 key, const BrickVoxels& voxels)
+{
+	const auto it = m_Lookup.find(key);
+	if (it != m_Lookup.end())
+	{
+		it->second->Voxels = voxels;
+		m_Bricks.splice(m_Bricks.begin(), m_Bricks, it->second);
+		return;
+	}
+
+	m_Bricks.push_front({ key, voxels });
+	m_Lookup[key] = m_Bricks.begin();
+
+	EvictToBudget();
+}
+
+
+void SDFBrickCache::Clear()
+{
+	m_Bricks.clear();
+	m_Lookup.clear();
+}
+
+void SDFBrickCache::SetBudget(size_t budgetBytes)
+{
+	m_BudgetBytes = budgetBytes;
+	EvictToBudget();
+}
+
+
+void SDFBrickCache::EvictToBudget()
+{
+	while (!m_Bricks.empty() && GetSizeBytes() > m_BudgetBytes)
+	{
+		m_Lookup.erase(m_Bricks.back().Key);
+		m_Bricks.pop_back();
+		m_Statistics.Evictions++;
+	}
+}
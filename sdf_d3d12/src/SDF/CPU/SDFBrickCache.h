@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Core.h"
+#include "HlslCompat/HlslDefines.h"
+
+#include <list>
+#include <unordered_map>
+
+
+// A least recently used cache of evaluated bricks, shared between bakes
+// Bricks are keyed by their content: their position, their size and the edits in their index list.
+// A brick with the same key is made of the same voxels, so a rebake can copy it instead of evaluating it again.
+// Keys are 64-bit hashes, and collisions are assumed not to happen.
+class SDFBrickCache
+{
+public:
+	inline static constexpr UINT s_VoxelCount = SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+	// R8G8B8A8_SNORM voxels, tightly packed in the same order as the brick pool
+	inline static constexpr size_t s_BrickBytes = 4 * s_VoxelCount;
+	using BrickVoxels = std::array<INT8, s_BrickBytes>;
+
+	inline static constexpr size_t s_DefaultBudget = 64ull * 1024 * 1024;
+
+	struct Statistics
+	{
+		UINT64 Hits = 0;
+		UINT64 Misses = 0;
+		UINT64 Evictions = 0;
+
+		inline float GetHitRate() const { return Hits + Misses > 0 ? static_cast<float>(Hits) / static_cast<float>(Hits + Misses) : 0.0f; }
+	};
+
+public:
+	SDFBrickCache(size_t budgetBytes = s_DefaultBudget);
+	~SDFBrickCache() = default;
+
+	DISALLOW_COPY(SDFBrickCache)
+	DEFAULT_MOVE(SDFBrickCache)
+
+	// editsHash is the hash of the edits in the brick's index list, in the order they are evaluated
+	static UINT64 BuildKey(const XMFLOAT3& topLeft, float brickSize, UINT64 editsHash);
+
+	// Returns the cached voxels and marks them as most recently used, or nullptr on a miss
+	// The pointer remains valid until the next call to Insert, SetBudget or Clear
+	const INT8* Find(UINT64 key);
+	// Evicts the least recently used bricks if the cache is over budget
+	void Insert(UINT64 key, const BrickVoxels& voxels);
+
+	void Clear();
+
+	// Setting a smaller budget evicts bricks immediately
+	void SetBudget(size_t budgetBytes);
+	inline size_t GetBudget() const { return m_BudgetBytes; }
+
+	inline UINT GetBrickCount() const { return static_cast<UINT>(m_Bricks.size()); }
+	inline size_t GetSizeBytes() const { return m_Bricks.size() * s_BrickBytes; }
+
+	inline const Statistics& GetStatistics() const { return m_Statistics; }
+	inline void ResetStatistics() { m_Statistics = {}; }
+
+private:
+	void EvictToBudget();
+
+private:
+	struct Entry
+	{
+		UINT64 Key;
+		BrickVoxels Voxels;
+	};
+
+	size_t m_BudgetBytes;
+
+	// Ordered from most to least recently used
+	std::list<Entry> m_Bricks;
+	std::unordered_map<UINT64, std::list<Entry>::iterator> m_Lookup;
+
+	Statistics m_Statistics;
+};
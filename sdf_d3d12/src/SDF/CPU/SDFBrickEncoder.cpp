@@ -0,0 +1,450 @@
+#include "pch.h"
+#include "SDFBrickEncoder.h"
+
+#include "SDF/SDFBakeData.h"
+#include "SDF/CPU/BrickHelpers.h"
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+
+namespace BrickPoolFormat
+{
+	const char* GetName(Value format)
+	{
+		static const char* names[] =
+		{
+			"RGBA8",
+			"R8 + Materials",
+			"R16 + Materials",
+			"BC4 + Materials"
+		};
+		static_assert(ARRAYSIZE(names) == Count);
+		return names[format];
+	}
+
+	UINT GetBytesPerBrick(Value format)
+	{
+		constexpr UINT voxels = SDFBrickEncoder::s_VoxelsPerBrick;
+		switch (format)
+		{
+		case RGBA8:
+			return 4 * voxels;
+		case R8:
+			return voxels;
+		case R16:
+			return 2 * voxels;
+		case BC4:
+			return voxels / (SDFBrickEncoder::s_BC4BlockSize * SDFBrickEncoder::s_BC4BlockSize) * SDFBrickEncoder::s_BC4BlockBytes;
+		default:
+			ASSERT(false, "Invalid brick pool format!");
+			return 0;
+		}
+	}
+}
+
+
+UINT SDFEncodedBrickPool::GetUniformMaterialBrickCount() const
+{
+	UINT count = 0;
+	for (const UINT material : BrickMaterials)
+	{
+		if (material & s_UniformMaterialFlag)
+			count++;
+	}
+	return count;
+}
+
+void SDFEncodedBrickPool::Clear()
+{
+	Format = BrickPoolFormat::RGBA8;
+	BrickCount = 0;
+
+	Distances.clear();
+	BrickMaterials.clear();
+	MaterialVoxels.clear();
+}
+
+
+void SDFEncodingError::Log() const
+{
+	LOG_INFO("Encoding error over {} voxels:", VoxelCount);
+	LOG_INFO("Max error: {:.5f} ({:.3f} voxels)", MaxError, GetMaxErrorVoxels());
+	LOG_INFO("RMS error: {:.5f} (PSNR {:.2f} dB)", RMSError, PSNR);
+	LOG_INFO("Sign flips: {}", SignFlips);
+	LOG_INFO("Material mismatches: {}", MaterialMismatches);
+}
+
+
+namespace
+{
+	constexpr UINT s_BlocksPerAxis = SDF_BRICK_SIZE_VOXELS_ADJACENCY / SDFBrickEncoder::s_BC4BlockSize;
+	constexpr UINT s_BlockVoxels = SDFBrickEncoder::s_BC4BlockSize * SDFBrickEncoder::s_BC4BlockSize;
+	constexpr UINT s_PaletteSize = 8;
+
+	// Larger than the squared error between any two values in [-1, 1],
+	// so a voxel only moves to the other side of the surface if no palette entry keeps it on its own side
+	constexpr float s_SignFlipPenalty = 4.0f;
+
+	inline UINT GetVoxelIndex(UINT x, UINT y, UINT z)
+	{
+		return (z * SDF_BRICK_SIZE_VOXELS_ADJACENCY + y) * SDF_BRICK_SIZE_VOXELS_ADJACENCY + x;
+	}
+
+	// Calls func(blockVoxel, brickVoxel) for each voxel of each BC4 block of a brick, in the order the blocks are stored
+	template<typename Func>
+	void ForEachBlockVoxel(UINT block, Func func)
+	{
+		const UINT blockX = block % s_BlocksPerAxis;
+		const UINT blockY = (block / s_BlocksPerAxis) % s_BlocksPerAxis;
+		const UINT z = block / (s_BlocksPerAxis * s_BlocksPerAxis);
+
+		for (UINT y = 0; y < SDFBrickEncoder::s_BC4BlockSize; y++)
+		for (UINT x = 0; x < SDFBrickEncoder::s_BC4BlockSize; x++)
+		{
+			func(y * SDFBrickEncoder::s_BC4BlockSize + x,
+				GetVoxelIndex(blockX * SDFBrickEncoder::s_BC4BlockSize + x, blockY * SDFBrickEncoder::s_BC4BlockSize + y, z));
+		}
+	}
+
+	// The eight values a BC4_SNORM block can decode to
+	void BuildBC4Palette(INT8 red0, INT8 red1, float* outPalette)
+	{
+		const float e0 = BrickHelpers::SNORM8ToFloat(red0);
+		const float e1 = BrickHelpers::SNORM8ToFloat(red1);
+
+		outPalette[0] = e0;
+		outPalette[1] = e1;
+		if (red0 > red1)
+		{
+			// Six interpolated values
+			for (UINT i = 1; i <= 6; i++)
+				outPalette[i + 1] = (static_cast<float>(7 - i) * e0 + static_cast<float>(i) * e1) / 7.0f;
+		}
+		else
+		{
+			// Four interpolated values, and the two extremes
+			for (UINT i = 1; i <= 4; i++)
+				outPalette[i + 1] = (static_cast<float>(5 - i) * e0 + static_cast<float>(i) * e1) / 5.0f;
+			outPalette[6] = -1.0f;
+			outPalette[7] = 1.0f;
+		}
+	}
+
+	// Chooses the palette entry for each value, and returns the total cost
+	float FitBC4Palette(const float* values, const float* palette, UINT* outIndices)
+	{
+		float total = 0.0f;
+		for (UINT i = 0; i < s_BlockVoxels; i++)
+		{
+			float bestCost = FLT_MAX;
+			for (UINT entry = 0; entry < s_PaletteSize; entry++)
+			{
+				const float difference = values[i] - palette[entry];
+				float cost = difference * difference;
+				if ((values[i] < 0.0f) != (palette[entry] < 0.0f))
+					cost += s_SignFlipPenalty;
+
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					outIndices[i] = entry;
+				}
+			}
+			total += bestCost;
+		}
+		return total;
+	}
+
+	void EncodeMaterials(const INT8* materials, UINT brickIndex, SDFEncodedBrickPool& pool)
+	{
+		bool uniform = true;
+		for (UINT voxel = 1; voxel < SDFBrickEncoder::s_VoxelsPerBrick && uniform; voxel++)
+		{
+			uniform = memcmp(materials, materials + 3 * voxel, 3) == 0;
+		}
+
+		if (uniform)
+		{
+			pool.BrickMaterials.at(brickIndex) = SDFEncodedBrickPool::s_UniformMaterialFlag
+				| static_cast<UINT>(static_cast<UINT8>(materials[0]))
+				| static_cast<UINT>(static_cast<UINT8>(materials[1])) << 8
+				| static_cast<UINT>(static_cast<UINT8>(materials[2])) << 16;
+		}
+		else
+		{
+			const size_t firstVoxel = pool.MaterialVoxels.size() / 3;
+			ASSERT(firstVoxel < SDFEncodedBrickPool::s_UniformMaterialFlag, "Too many material voxels!");
+
+			pool.BrickMaterials.at(brickIndex) = static_cast<UINT>(firstVoxel);
+			pool.MaterialVoxels.insert(pool.MaterialVoxels.end(), materials, materials + 3 * SDFBrickEncoder::s_VoxelsPerBrick);
+		}
+	}
+}
+
+
+namespace SDFBrickEncoder
+{
+	void Encode(const SDFBakeData& data, BrickPoolFormat::Value format, SDFEncodedBrickPool& outPool)
+	{
+		outPool.Clear();
+		outPool.Format = format;
+		outPool.BrickCount = data.GetBrickCount();
+
+		const UINT bytesPerBrick = BrickPoolFormat::GetBytesPerBrick(format);
+		outPool.Distances.resize(static_cast<size_t>(outPool.BrickCount) * bytesPerBrick);
+		if (format != BrickPoolFormat::RGBA8)
+			outPool.BrickMaterials.resize(outPool.BrickCount);
+
+		const bool hasReference = !data.ReferenceDistances.empty();
+
+		std::array<float, s_VoxelsPerBrick> distances;
+		std::array<INT8, 3 * s_VoxelsPerBrick> materials;
+
+		for (UINT brickIndex = 0; brickIndex < outPool.BrickCount; brickIndex++)
+		{
+			UINT8* dest = outPool.Distances.data() + static_cast<size_t>(brickIndex) * bytesPerBrick;
+
+			for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+			for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+			for (UINT x = 0; x < SDF_BRICK_SIZE_VOXELS_ADJACENCY; x++)
+			{
+				const UINT voxel = GetVoxelIndex(x, y, z);
+				const INT8* texel = data.GetBrickVoxel(brickIndex, x, y, z);
+
+				// The RGBA8 format is the pool as it was baked
+				if (format == BrickPoolFormat::RGBA8)
+					memcpy(dest + 4 * voxel, texel, 4);
+
+				distances.at(voxel) = hasReference
+					? data.ReferenceDistances.at(static_cast<size_t>(brickIndex) * s_VoxelsPerBrick + voxel)
+					: BrickHelpers::SNORM8ToFloat(texel[0]);
+				memcpy(materials.data() + 3 * voxel, texel + 1, 3);
+			}
+
+			switch (format)
+			{
+			case BrickPoolFormat::RGBA8:
+				break;
+			case BrickPoolFormat::R8:
+				for (UINT voxel = 0; voxel < s_VoxelsPerBrick; voxel++)
+					dest[voxel] = static_cast<UINT8>(BrickHelpers::FloatToSNORM8(distances.at(voxel)));
+				break;
+			case BrickPoolFormat::R16:
+				for (UINT voxel = 0; voxel < s_VoxelsPerBrick; voxel++)
+				{
+					const INT16 value = BrickHelpers::FloatToSNORM16(distances.at(voxel));
+					memcpy(dest + 2 * voxel, &value, sizeof(INT16));
+				}
+				break;
+			case BrickPoolFormat::BC4:
+				for (UINT block = 0; block < s_VoxelsPerBrick / s_BlockVoxels; block++)
+				{
+					float values[s_BlockVoxels];
+					ForEachBlockVoxel(block, [&](UINT blockVoxel, UINT voxel) { values[blockVoxel] = distances.at(voxel); });
+					EncodeBC4Block(values, dest + block * s_BC4BlockBytes);
+				}
+				break;
+			default:
+				ASSERT(false, "Invalid brick pool format!");
+				break;
+			}
+
+			if (format != BrickPoolFormat::RGBA8)
+				EncodeMaterials(materials.data(), brickIndex, outPool);
+		}
+	}
+
+	void DecodeBrick(const SDFEncodedBrickPool& pool, UINT brickIndex, float* outDistances, INT8* outMaterials)
+	{
+		ASSERT(brickIndex < pool.BrickCount, "Out of bounds brick access");
+
+		const UINT bytesPerBrick = BrickPoolFormat::GetBytesPerBrick(pool.Format);
+		const UINT8* src = pool.Distances.data() + static_cast<size_t>(brickIndex) * bytesPerBrick;
+
+		switch (pool.Format)
+		{
+		case BrickPoolFormat::RGBA8:
+			for (UINT voxel = 0; voxel < s_VoxelsPerBrick; voxel++)
+			{
+				outDistances[voxel] = BrickHelpers::SNORM8ToFloat(static_cast<INT8>(src[4 * voxel]));
+				memcpy(outMaterials + 3 * voxel, src + 4 * voxel + 1, 3);
+			}
+			// There is no side channel
+			return;
+		case BrickPoolFormat::R8:
+			for (UINT voxel = 0; voxel < s_VoxelsPerBrick; voxel++)
+				outDistances[voxel] = BrickHelpers::SNORM8ToFloat(static_cast<INT8>(src[voxel]));
+			break;
+		case BrickPoolFormat::R16:
+			for (UINT voxel = 0; voxel < s_VoxelsPerBrick; voxel++)
+			{
+				INT16 value;
+				memcpy(&value, src + 2 * voxel, sizeof(INT16));
+				outDistances[voxel] = BrickHelpers::SNORM16ToFloat(value);
+			}
+			break;
+		case BrickPoolFormat::BC4:
+			for (UINT block = 0; block < s_VoxelsPerBrick / s_BlockVoxels; block++)
+			{
+				float values[s_BlockVoxels];
+				DecodeBC4Block(src + block * s_BC4BlockBytes, values);
+				ForEachBlockVoxel(block, [&](UINT blockVoxel, UINT voxel) { outDistances[voxel] = values[blockVoxel]; });
+			}
+			break;
+		default:
+			ASSERT(false, "Invalid brick pool format!");
+			return;
+		}
+
+		const UINT material = pool.BrickMaterials.at(brickIndex);
+		if (material & SDFEncodedBrickPool::s_UniformMaterialFlag)
+		{
+			const INT8 uniform[3] = {
+				static_cast<INT8>(material & 0xFF),
+				static_cast<INT8>((material >> 8) & 0xFF),
+				static_cast<INT8>((material >> 16) & 0xFF)
+			};
+			for (UINT voxel = 0; voxel < s_VoxelsPerBrick; voxel++)
+				memcpy(outMaterials + 3 * voxel, uniform, 3);
+		}
+		else
+		{
+			memcpy(outMaterials, pool.MaterialVoxels.data() + 3 * static_cast<size_t>(material), 3 * s_VoxelsPerBrick);
+		}
+	}
+
+	SDFEncodingError MeasureError(const SDFBakeData& data, const SDFEncodedBrickPool& pool)
+	{
+		ASSERT(!data.ReferenceDistances.empty(), "Measuring encoding error requires reference distances!");
+		ASSERT(pool.BrickCount == data.GetBrickCount(), "Pool was not encoded from this bake!");
+
+		SDFEncodingError result;
+		double squaredError = 0.0;
+
+		std::array<float, s_VoxelsPerBrick> distances;
+		std::array<INT8, 3 * s_VoxelsPerBrick> materials;
+
+		for (UINT brickIndex = 0; brickIndex < pool.BrickCount; brickIndex++)
+		{
+			DecodeBrick(pool, brickIndex, distances.data(), materials.data());
+
+			for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+			for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+			for (UINT x = 0; x < SDF_BRICK_SIZE_VOXELS_ADJACENCY; x++)
+			{
+				const UINT voxel = GetVoxelIndex(x, y, z);
+				const float reference = data.ReferenceDistances.at(static_cast<size_t>(brickIndex) * s_VoxelsPerBrick + voxel);
+				const float decoded = distances.at(voxel);
+
+				const double error = std::abs(static_cast<double>(decoded) - static_cast<double>(reference));
+				result.MaxError = (std::max)(result.MaxError, error);
+				squaredError += error * error;
+
+				if ((reference < 0.0f) != (decoded < 0.0f))
+					result.SignFlips++;
+
+				if (memcmp(materials.data() + 3 * voxel, data.GetBrickVoxel(brickIndex, x, y, z) + 1, 3) != 0)
+					result.MaterialMismatches++;
+			}
+		}
+
+		result.VoxelCount = static_cast<UINT64>(pool.BrickCount) * s_VoxelsPerBrick;
+		if (result.VoxelCount > 0)
+			result.RMSError = std::sqrt(squaredError / static_cast<double>(result.VoxelCount));
+
+		// The distance channel spans [-1, 1]
+		result.PSNR = result.RMSError > 0.0 ? 20.0 * std::log10(2.0 / result.RMSError) : std::numeric_limits<double>::infinity();
+		return result;
+	}
+
+	void EncodeBC4Block(const float* values, UINT8* outBlock)
+	{
+		float minValue = FLT_MAX;
+		float maxValue = -FLT_MAX;
+		// The range of the values that are not at either extreme, which the six value mode can encode exactly
+		float minInterior = FLT_MAX;
+		float maxInterior = -FLT_MAX;
+		for (UINT i = 0; i < s_BlockVoxels; i++)
+		{
+			minValue = (std::min)(minValue, values[i]);
+			maxValue = (std::max)(maxValue, values[i]);
+			if (std::abs(values[i]) < 1.0f)
+			{
+				minInterior = (std::min)(minInterior, values[i]);
+				maxInterior = (std::max)(maxInterior, values[i]);
+			}
+		}
+		if (minInterior > maxInterior)
+		{
+			minInterior = 0.0f;
+			maxInterior = 0.0f;
+		}
+
+		float bestCost = FLT_MAX;
+		INT8 bestRed0 = 0;
+		INT8 bestRed1 = 0;
+		UINT bestIndices[s_BlockVoxels] = {};
+
+		auto tryEndpoints = [&](INT red0, INT red1)
+			{
+				if (red0 < -127 || red0 > 127 || red1 < -127 || red1 > 127)
+					return;
+
+				float palette[s_PaletteSize];
+				UINT indices[s_BlockVoxels];
+				BuildBC4Palette(static_cast<INT8>(red0), static_cast<INT8>(red1), palette);
+
+				const float cost = FitBC4Palette(values, palette, indices);
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestRed0 = static_cast<INT8>(red0);
+					bestRed1 = static_cast<INT8>(red1);
+					memcpy(bestIndices, indices, sizeof(indices));
+				}
+			};
+
+		// Start from the quantized bounds of the values, and try the neighbouring endpoints,
+		// as rounding each endpoint independently is not always the best pair
+		const INT maxRed = BrickHelpers::FloatToSNORM8(maxValue);
+		const INT minRed = BrickHelpers::FloatToSNORM8(minValue);
+		const INT maxInteriorRed = BrickHelpers::FloatToSNORM8(maxInterior);
+		const INT minInteriorRed = BrickHelpers::FloatToSNORM8(minInterior);
+		for (INT d0 = -1; d0 <= 1; d0++)
+		for (INT d1 = -1; d1 <= 1; d1++)
+		{
+			// Eight value mode requires red0 > red1
+			if (maxRed + d0 > minRed + d1)
+				tryEndpoints(maxRed + d0, minRed + d1);
+
+			// Six value mode requires red0 <= red1, and also decodes to -1 and 1
+			if (minInteriorRed + d0 <= maxInteriorRed + d1)
+				tryEndpoints(minInteriorRed + d0, maxInteriorRed + d1);
+		}
+
+		outBlock[0] = static_cast<UINT8>(bestRed0);
+		outBlock[1] = static_cast<UINT8>(bestRed1);
+
+		// 3-bit indices, with the first voxel in the lowest bits
+		UINT64 bits = 0;
+		for (UINT i = 0; i < s_BlockVoxels; i++)
+			bits |= static_cast<UINT64>(bestIndices[i]) << (3 * i);
+		for (UINT byte = 0; byte < 6; byte++)
+			outBlock[2 + byte] = static_cast<UINT8>((bits >> (8 * byte)) & 0xFF);
+	}
+
+	void DecodeBC4Block(const UINT8* block, float* outValues)
+	{
+		float palette[s_PaletteSize];
+		BuildBC4Palette(static_cast<INT8>(block[0]), static_cast<INT8>(block[1]), palette);
+
+		UINT64 bits = 0;
+		for (UINT byte = 0; byte < 6; byte++)
+			bits |= static_cast<UINT64>(block[2 + byte]) << (8 * byte);
+
+		for (UINT i = 0; i < s_BlockVoxels; i++)
+			outValues[i] = palette[(bits >> (3 * i)) & 0x7];
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Core.h"
+#include "HlslCompat/HlslDefines.h"
+
+struct SDFBakeData;
+
+
+namespace BrickPoolFormat
+{
+	enum Value
+	{
+		// Distance and three material weights in every voxel. The format the factories write
+		RGBA8 = 0,
+		// R8_SNORM distance, with materials in a sparse side channel
+		R8,
+		// R16_SNORM distance, with materials in a sparse side channel
+		R16,
+		// BC4_SNORM distance, with materials in a sparse side channel
+		// Each 4x4 block of a slice of a brick is stored as two endpoints and a 3-bit index per voxel
+		BC4,
+		Count
+	};
+
+	const char* GetName(Value format);
+	// The size of the distance (or RGBA8) data of one brick
+	UINT GetBytesPerBrick(Value format);
+}
+
+
+// A brick pool converted to one of the brick pool formats
+// Bricks are stored one after another, rather than in the 3D layout of the brick pool texture,
+// so that any brick can be uploaded into any slot of a pool of that format.
+struct SDFEncodedBrickPool
+{
+	// Marks a brick whose voxels all have the same material, which is stored in the low 24 bits of its material entry
+	inline static constexpr UINT s_UniformMaterialFlag = 0x80000000u;
+
+	BrickPoolFormat::Value Format = BrickPoolFormat::RGBA8;
+	UINT BrickCount = 0;
+
+	// GetBytesPerBrick(Format) bytes per brick
+	// BC4 blocks are in x, y, z order within each brick, and voxels in x, y order within each block
+	std::vector<UINT8> Distances;
+
+	// The sparse material side channel, for every format other than RGBA8
+	// Each brick has one entry: either a uniform material, or the index of its first voxel in MaterialVoxels
+	std::vector<UINT> BrickMaterials;
+	// Three SNORM8 material weights per voxel, for only the bricks that contain more than one material
+	std::vector<INT8> MaterialVoxels;
+
+	inline size_t GetSizeBytes() const { return Distances.size() + BrickMaterials.size() * sizeof(UINT) + MaterialVoxels.size(); }
+	UINT GetUniformMaterialBrickCount() const;
+
+	void Clear();
+};
+
+
+// The difference between decoded distances and the reference distances they were encoded from
+struct SDFEncodingError
+{
+	UINT64 VoxelCount = 0;
+
+	// In the units of the distance channel, where 1 is SDF_VOLUME_STRIDE voxels
+	double MaxError = 0.0;
+	double RMSError = 0.0;
+	// Relative to the full range of the distance channel, [-1, 1]
+	double PSNR = 0.0;
+
+	// Voxels that decode to the other side of the surface
+	UINT64 SignFlips = 0;
+	// Voxels whose material weights do not match the RGBA8 pool exactly
+	UINT64 MaterialMismatches = 0;
+
+	inline double GetMaxErrorVoxels() const { return MaxError * SDF_VOLUME_STRIDE; }
+
+	void Log() const;
+};
+
+
+// Reference CPU encoders and decoders for the brick pool formats
+// These define the contents of a brick in each format, and are written for clarity rather than speed.
+namespace SDFBrickEncoder
+{
+	inline constexpr UINT s_VoxelsPerBrick = SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+	inline constexpr UINT s_BC4BlockSize = 4;
+	inline constexpr UINT s_BC4BlockBytes = 8;
+
+	// Encodes the bricks of a bake
+	// Distances are encoded from the reference distances if the bake has them, otherwise from the RGBA8 pool
+	void Encode(const SDFBakeData& data, BrickPoolFormat::Value format, SDFEncodedBrickPool& outPool);
+
+	// Decodes one brick to a distance and three SNORM8 material weights per voxel, in x, y, z order
+	void DecodeBrick(const SDFEncodedBrickPool& pool, UINT brickIndex, float* outDistances, INT8* outMaterials);
+
+	// Compares every decoded voxel against the reference distances and RGBA8 materials of the bake it was encoded from
+	// The bake must have reference distances
+	SDFEncodingError MeasureError(const SDFBakeData& data, const SDFEncodedBrickPool& pool);
+
+	// Encodes 16 values in [-1, 1], in x, y order, as a BC4_SNORM block
+	// Voxels are kept on the same side of the surface wherever the block allows it
+	void EncodeBC4Block(const float* values, UINT8* outBlock);
+	// Decodes a BC4_SNORM block following the D3D decoding rules
+	void DecodeBC4Block(const UINT8* block, float* outValues);
+}
@@ -0,0 +1,136 @@
+#include "pch.h"
+#include "SDFEditBVH.h"
+
+#include "SDFHelpers.h"
+#include "BrickHelpers.h"
+
+#include <algorithm>
+#include <cfloat>
+
+
+using namespace SDFHelpers;
+
+
+void SDFEditBVH::Build(const SDFEditData* edits, UINT editCount)
+{
+	m_EditCount = editCount;
+	m_Nodes.clear();
+	m_UnboundedEdits.clear();
+	m_SortedEdits.clear();
+
+	m_EditMin.resize(editCount);
+	m_EditMax.resize(editCount);
+
+	float3 centreMin(FLT_MAX), centreMax(-FLT_MAX);
+	for (UINT i = 0; i < editCount; i++)
+	{
+		const SDFEditData& edit = edits[i];
+
+		const SDFShape shape = GetShape(edit.EditParams);
+		if (shape >= SDF_SHAPE_FRACTAL)
+		{
+			m_UnboundedEdits.push_back(i);
+			continue;
+		}
+
+		// Apply blending range for smooth edits
+		// 1.74f == sqrt(3)
+		float radius = boundingSphereRadius(shape, edit.ShapeParams) * edit.Scale;
+		if (IsSmoothEdit(edit.EditParams))
+			radius += 1.74f * edit.BlendingRange;
+
+		const float3 centre = -float3(edit.InvTranslation);
+		// Pad by the rounding error of evaluating the edit
+		radius = max(radius, 0.0f);
+		radius += 1e-4f * (fabsf(centre.x) + fabsf(centre.y) + fabsf(centre.z) + radius) + 1e-5f;
+
+		m_EditMin.at(i) = { centre.x - radius, centre.y - radius, centre.z - radius };
+		m_EditMax.at(i) = { centre.x + radius, centre.y + radius, centre.z + radius };
+
+		m_SortedEdits.push_back({ 0, i });
+		centreMin = { min(centreMin.x, centre.x), min(centreMin.y, centre.y), min(centreMin.z, centre.z) };
+		centreMax = { max(centreMax.x, centre.x), max(centreMax.y, centre.y), max(centreMax.z, centre.z) };
+	}
+
+	if (m_SortedEdits.size() < 2)
+		return;
+
+	// Morton codes are calculated from the position of each centre within the bounds of all centres
+	const float3 extent = centreMax - centreMin;
+	const float3 invExtent = {
+		extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+		extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+		extent.z > 0.0f ? 1.0f / extent.z : 0.0f
+	};
+	for (auto& [code, edit] : m_SortedEdits)
+	{
+		const float3 p = (-float3(edits[edit].InvTranslation) - centreMin) * invExtent;
+		code = BrickHelpers::morton3Df(p.x, p.y, p.z);
+	}
+	std::sort(m_SortedEdits.begin(), m_SortedEdits.end());
+
+	// A binary tree over n leaves has n - 1 internal nodes
+	m_Nodes.reserve(m_SortedEdits.size() - 1);
+	BuildNode(0, static_cast<UINT>(m_SortedEdits.size()) - 1);
+}
+
+UINT SDFEditBVH::BuildNode(UINT first, UINT last)
+{
+	if (first == last)
+		return m_SortedEdits.at(first).second | s_LeafBit;
+
+	const UINT firstCode = m_SortedEdits.at(first).first;
+	const UINT lastCode = m_SortedEdits.at(last).first;
+
+	UINT split;
+	if (firstCode == lastCode)
+	{
+		// Identical codes are split down the middle
+		split = (first + last) / 2;
+	}
+	else
+	{
+		// Find the highest bit that differs within the range
+		// The codes are sorted, so the range is split where that bit becomes set
+		UINT highestBit = 31;
+		while (!(((firstCode ^ lastCode) >> highestBit) & 1u))
+			highestBit--;
+
+		const auto begin = m_SortedEdits.begin() + first;
+		const auto end = m_SortedEdits.begin() + last + 1;
+		const auto upper = std::partition_point(begin, end, [highestBit](const std::pair<UINT, UINT>& e) { return !((e.first >> highestBit) & 1u); });
+		split = static_cast<UINT>(upper - m_SortedEdits.begin()) - 1;
+	}
+
+	const UINT index = static_cast<UINT>(m_Nodes.size());
+	m_Nodes.emplace_back();
+
+	const UINT left = BuildNode(first, split);
+	const UINT right = BuildNode(split + 1, last);
+
+	auto childBounds = [this](UINT child, XMFLOAT3& outMin, XMFLOAT3& outMax)
+		{
+			if (child & s_LeafBit)
+			{
+				outMin = m_EditMin.at(child & ~s_LeafBit);
+				outMax = m_EditMax.at(child & ~s_LeafBit);
+			}
+			else
+			{
+				outMin = m_Nodes.at(child).Min;
+				outMax = m_Nodes.at(child).Max;
+			}
+		};
+
+	XMFLOAT3 leftMin, leftMax, rightMin, rightMax;
+	childBounds(left, leftMin, leftMax);
+	childBounds(right, rightMin, rightMax);
+
+	Node& node = m_Nodes.at(index);
+	node.Left = left;
+	node.Right = right;
+	node.Min = { min(leftMin.x, rightMin.x), min(leftMin.y, rightMin.y), min(leftMin.z, rightMin.z) };
+	node.Max = { max(leftMax.x, rightMax.x), max(leftMax.y, rightMax.y), max(leftMax.z, rightMax.z) };
+
+	return index;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Core.h"
+#include "HlslCompat/ComputeHlslCompat.h"
+
+
+// A linear BVH over the bounds of the edits in an edit list
+// Edits are sorted along a Morton curve through their centres, and the hierarchy is formed by splitting
+// each range of edits where the highest bit of their Morton codes changes.
+//
+// Each edit is bounded by its bounding sphere, expanded by sqrt(3) times the blending range for smooth edits,
+// as edit_tester.hlsl does. Every exact distance field is at least the distance to this bound,
+// so an edit whose bounds do not overlap a query box cannot be closer to the box than the query margin.
+// Fractal edits are only a distance estimate, so they are returned by every query.
+class SDFEditBVH
+{
+public:
+	// The depth of a tree built from 30-bit Morton codes is at most 30 plus the levels splitting identical codes
+	inline static constexpr UINT s_MaxDepth = 64;
+
+	struct Node
+	{
+		XMFLOAT3 Min;
+		UINT Left;		// Index of a node, or of an edit if the leaf bit is set
+		XMFLOAT3 Max;
+		UINT Right;
+	};
+	inline static constexpr UINT s_LeafBit = 0x80000000;
+
+public:
+	SDFEditBVH() = default;
+	~SDFEditBVH() = default;
+
+	DEFAULT_COPY(SDFEditBVH)
+	DEFAULT_MOVE(SDFEditBVH)
+
+	void Build(const SDFEditData* edits, UINT editCount);
+
+	// Calls func with the index of every edit whose bounds overlap the box
+	template<typename Func>
+	void Query(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, Func&& func) const;
+
+	// Getters
+	inline UINT GetEditCount() const { return m_EditCount; }
+	inline UINT GetNodeCount() const { return static_cast<UINT>(m_Nodes.size()); }
+	inline const std::vector<Node>& GetNodes() const { return m_Nodes; }
+
+private:
+	UINT BuildNode(UINT first, UINT last);
+
+	static bool Overlaps(const XMFLOAT3& minA, const XMFLOAT3& maxA, const XMFLOAT3& minB, const XMFLOAT3& maxB)
+	{
+		return minA.x <= maxB.x && maxA.x >= minB.x
+			&& minA.y <= maxB.y && maxA.y >= minB.y
+			&& minA.z <= maxB.z && maxA.z >= minB.z;
+	}
+
+private:
+	UINT m_EditCount = 0;
+
+	std::vector<Node> m_Nodes;						// The root is node 0
+	std::vector<UINT> m_UnboundedEdits;				// Edits that are returned by every query
+
+	// Bounds of each edit, indexed by edit
+	std::vector<XMFLOAT3> m_EditMin;
+	std::vector<XMFLOAT3> m_EditMax;
+
+	// Morton code and edit index of each bounded edit, sorted by code
+	std::vector<std::pair<UINT, UINT>> m_SortedEdits;
+};
+
+
+template<typename Func>
+void SDFEditBVH::Query(const XMFLOAT3& boxMin, const XMFLOAT3& boxMax, Func&& func) const
+{
+	for (const UINT edit : m_UnboundedEdits)
+	{
+		func(edit);
+	}
+
+	if (m_SortedEdits.empty())
+		return;
+
+	if (m_SortedEdits.size() == 1)
+	{
+		// A single edit has no nodes
+		const UINT edit = m_SortedEdits.at(0).second;
+		if (Overlaps(boxMin, boxMax, m_EditMin.at(edit), m_EditMax.at(edit)))
+			func(edit);
+		return;
+	}
+
+	UINT stack[s_MaxDepth + 1];
+	UINT stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = m_Nodes[stack[--stackSize]];
+		if (!Overlaps(boxMin, boxMax, node.Min, node.Max))
+			continue;
+
+		for (const UINT child : { node.Left, node.Right })
+		{
+			if (child & s_LeafBit)
+			{
+				const UINT edit = child & ~s_LeafBit;
+				if (Overlaps(boxMin, boxMax, m_EditMin[edit], m_EditMax[edit]))
+					func(edit);
+			}
+			else
+			{
+				ASSERT(stackSize <= s_MaxDepth, "BVH is too deep!");
+				stack[stackSize++] = child;
+			}
+		}
+	}
+}
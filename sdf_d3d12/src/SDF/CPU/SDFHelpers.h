@@ -0,0 +1,359 @@
+#pragma once
+
+#include "HlslCompat/ComputeHlslCompat.h"
+
+
+// CPU implementations of the functions in sdf_helper.hlsli
+// These are written to mirror the shader code operation-for-operation so that
+// the CPU factory produces the same results as the GPU factory.
+// Any change to sdf_helper.hlsli must be reflected here.
+
+namespace SDFHelpers
+{
+	// Minimal HLSL-like vector types so that the shader code can be mirrored directly
+
+	struct float3
+	{
+		float x, y, z;
+
+		float3() = default;
+		constexpr float3(float x, float y, float z) : x(x), y(y), z(z) {}
+		explicit constexpr float3(float s) : x(s), y(s), z(s) {}
+		constexpr float3(const XMFLOAT3& v) : x(v.x), y(v.y), z(v.z) {}
+
+		inline float3 operator-() const { return { -x, -y, -z }; }
+	};
+
+	inline float3 operator+(const float3& a, const float3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	inline float3 operator-(const float3& a, const float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline float3 operator*(const float3& a, const float3& b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+	inline float3 operator+(const float3& a, float s) { return { a.x + s, a.y + s, a.z + s }; }
+	inline float3 operator+(float s, const float3& a) { return { s + a.x, s + a.y, s + a.z }; }
+	inline float3 operator-(const float3& a, float s) { return { a.x - s, a.y - s, a.z - s }; }
+	inline float3 operator*(const float3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+	inline float3 operator*(float s, const float3& a) { return { s * a.x, s * a.y, s * a.z }; }
+	inline float3 operator/(const float3& a, float s) { return { a.x / s, a.y / s, a.z / s }; }
+
+	struct float4
+	{
+		float x, y, z, w;
+
+		float4() = default;
+		constexpr float4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+		constexpr float4(const float3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+		constexpr float4(const XMFLOAT4& v) : x(v.x), y(v.y), z(v.z), w(v.w) {}
+
+		inline float3 xyz() const { return { x, y, z }; }
+	};
+
+	inline float4 operator+(const float4& a, const float4& b) { return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+	inline float4 operator-(const float4& a, const float4& b) { return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+	inline float4 operator*(const float4& a, const float4& b) { return { a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w }; }
+	inline float4 operator*(const float4& a, float s) { return { a.x * s, a.y * s, a.z * s, a.w * s }; }
+	inline float4 operator/(const float4& a, float s) { return { a.x / s, a.y / s, a.z / s, a.w / s }; }
+
+
+	// Intrinsics
+	// min and max are macros on windows, so the vector versions are prefixed
+
+	inline float dot(const float3& a, const float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline float dot(const float4& a, const float4& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+	inline float length(const float3& v) { return sqrtf(dot(v, v)); }
+	inline float length(const float4& v) { return sqrtf(dot(v, v)); }
+	inline float3 cross(const float3& a, const float3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	inline float3 abs(const float3& v) { return { fabsf(v.x), fabsf(v.y), fabsf(v.z) }; }
+	inline float3 vmax(const float3& v, float s) { return { max(v.x, s), max(v.y, s), max(v.z, s) }; }
+	inline float clamp(float v, float lo, float hi) { return min(max(v, lo), hi); }
+	inline float saturate(float v) { return clamp(v, 0.0f, 1.0f); }
+	inline float4 lerp(const float4& a, const float4& b, float t) { return a + (b - a) * t; }
+
+
+	//
+	// QUATERNIONS (Quaternion.hlsli)
+	//
+
+	inline float4 qmul(const float4& q1, const float4& q2)
+	{
+		const float3 v = q2.xyz() * q1.w + q1.xyz() * q2.w + cross(q1.xyz(), q2.xyz());
+		return { v, q1.w * q2.w - dot(q1.xyz(), q2.xyz()) };
+	}
+
+	inline float3 rotate_vector(const float3& v, const float4& r)
+	{
+		const float4 r_c = r * float4(-1, -1, -1, 1);
+		return qmul(r, qmul(float4(v, 0), r_c)).xyz();
+	}
+
+
+	//
+	// PRIMITIVES
+	//
+
+	inline float sdSphere(const float3& p, float r)
+	{
+		return length(p) - r;
+	}
+
+	inline float sdBox(const float3& p, const float3& b)
+	{
+		const float3 q = abs(p) - b;
+		return length(vmax(q, 0.0f)) + min(max(q.x, max(q.y, q.z)), 0.0f);
+	}
+
+	inline float sdTorus(const float3& p, float tx, float ty)
+	{
+		const float qx = sqrtf(p.x * p.x + p.z * p.z) - tx;
+		return sqrtf(qx * qx + p.y * p.y) - ty;
+	}
+
+	inline float sdOctahedron(float3 p, float s)
+	{
+		p = abs(p);
+		const float m = p.x + p.y + p.z - s;
+		float3 q;
+		if (3.0f * p.x < m)
+			q = p;
+		else if (3.0f * p.y < m)
+			q = { p.y, p.z, p.x };
+		else if (3.0f * p.z < m)
+			q = { p.z, p.x, p.y };
+		else
+			return m * 0.57735027f;
+
+		const float k = clamp(0.5f * (q.z - q.y + s), 0.0f, s);
+		return length(float3(q.x, q.y - s + k, q.z - k));
+	}
+
+	inline float sdBoxFrame(float3 p, const float3& b, float e)
+	{
+		p = abs(p) - b;
+		const float3 q = abs(p + e) - e;
+		return min(min(
+			length(vmax(float3(p.x, q.y, q.z), 0.0f)) + min(max(p.x, max(q.y, q.z)), 0.0f),
+			length(vmax(float3(q.x, p.y, q.z), 0.0f)) + min(max(q.x, max(p.y, q.z)), 0.0f)),
+			length(vmax(float3(q.x, q.y, p.z), 0.0f)) + min(max(q.x, max(q.y, p.z)), 0.0f));
+	}
+
+	inline float sdFractal(float3 p)
+	{
+		constexpr float3 a1 = float3(1.0f, 1.0f, 1.0f);
+		constexpr float3 a2 = float3(-1.0f, -1.0f, 1.0f);
+		constexpr float3 a3 = float3(1.0f, -1.0f, -1.0f);
+		constexpr float3 a4 = float3(-1.0f, 1.0f, -1.0f);
+		int n = 0;
+		while (n < 15)
+		{
+			float3 c = a1;
+			float dist = length(p - a1);
+			float d = length(p - a2);
+			if (d < dist)
+			{
+				c = a2;
+				dist = d;
+			}
+			d = length(p - a3);
+			if (d < dist)
+			{
+				c = a3;
+				dist = d;
+			}
+			d = length(p - a4);
+			if (d < dist)
+			{
+				c = a4;
+			}
+			p = 2.0f * p - c;
+			n++;
+		}
+
+		return length(p) * powf(2.0f, static_cast<float>(-n)) - 0.005f;
+	}
+
+	inline float sdPrimitive(const float3& p, SDFShape prim, const XMFLOAT4& param)
+	{
+		switch (prim)
+		{
+		case SDF_SHAPE_SPHERE:
+			return sdSphere(p, param.x);
+		case SDF_SHAPE_BOX:
+			return sdBox(p, { param.x, param.y, param.z });
+		case SDF_SHAPE_TORUS:
+			return sdTorus(p, param.x, param.y);
+		case SDF_SHAPE_OCTAHEDRON:
+			return sdOctahedron(p, param.x);
+		case SDF_SHAPE_BOX_FRAME:
+			return sdBoxFrame(p, { param.x, param.y, param.z }, param.w);
+		case SDF_SHAPE_FRACTAL:
+			return sdFractal(p);
+		default:
+			return 0.0f;
+		}
+	}
+
+
+	//
+	// OPERATIONS
+	//
+
+	inline float opUnion(float a, float b)
+	{
+		return min(a, b);
+	}
+
+	inline float opSubtraction(float a, float b)
+	{
+		return max(a, -b);
+	}
+
+	inline float opSmoothUnion(float a, float b, float r)
+	{
+		const float e = max(r - fabsf(a - b), 0.0f);
+		return min(a, b) - e * e * 0.25f / r;
+	}
+
+	inline float opSmoothSubtraction(float a, float b, float r)
+	{
+		const float e = max(r - fabsf(a - b), 0.0f);
+		return max(a, -b) + e * e * 0.125f / r;
+	}
+
+	inline float3 opTransform(const float3& p, const float4& q, const float3& t)
+	{
+		return rotate_vector(p + t, q);
+	}
+
+	inline float opPrimitive(float a, float b, SDFOperation op, float k)
+	{
+		switch (op)
+		{
+		case SDF_OP_UNION:
+			return opUnion(a, b);
+		case SDF_OP_SUBTRACTION:
+			return opSubtraction(a, b);
+		case SDF_OP_SMOOTH_UNION:
+			return opSmoothUnion(a, b, k);
+		case SDF_OP_SMOOTH_SUBTRACTION:
+			return opSmoothSubtraction(a, b, k);
+		default:
+			return a;
+		}
+	}
+
+
+	// Operations with material interpolation parameters
+	inline float4 opUnion_Material(float a, float b, const float4& ta, const float4& tb)
+	{
+		return a < b ? ta : tb;
+	}
+
+	inline float4 opSmoothUnion_Material(float a, float b, const float4& ta, const float4& tb, float r)
+	{
+		const float e = saturate(r - (b - a) / r);
+		return lerp(ta, tb, e);
+	}
+
+	inline float4 opPrimitive_Material(float a, float b, const float4& ta, const float4& tb, SDFOperation op, float k)
+	{
+		switch (op)
+		{
+		case SDF_OP_UNION:
+			return opUnion_Material(a, b, ta, tb);
+		case SDF_OP_SMOOTH_UNION:
+			return opSmoothUnion_Material(a, b, ta, tb, k);
+		default:
+			return ta;
+		}
+	}
+
+
+	//
+	// BOUNDING SPHERES
+	// Gives the distance to the surface of a bounding sphere for each primitive
+	//
+
+	inline float boundingSphereRadius(SDFShape prim, const XMFLOAT4& param)
+	{
+		switch (prim)
+		{
+		case SDF_SHAPE_SPHERE:
+			return param.x;
+		case SDF_SHAPE_BOX:
+			return length(float3(param.x, param.y, param.z));
+		case SDF_SHAPE_TORUS:
+			return param.x + param.y;
+		case SDF_SHAPE_OCTAHEDRON:
+			return 1.75f * param.x;
+		case SDF_SHAPE_BOX_FRAME:
+			return length(float3(param.x, param.y, param.z)) + param.w;
+		case SDF_SHAPE_FRACTAL:
+			return 1.75f /*sqrt(3)*/;
+		default:
+			return 0.0f;
+		}
+	}
+
+	inline float boundingSpherePrimitive(const float3& p, SDFShape prim, const XMFLOAT4& param)
+	{
+		if (prim > SDF_SHAPE_FRACTAL)
+			return 0.0f;
+		return sdSphere(p, boundingSphereRadius(prim, param));
+	}
+
+
+	//
+	// HELPERS
+	//
+
+	inline SDFShape GetShape(UINT editParams)
+	{
+		return static_cast<SDFShape>(editParams & 0x000000FF);
+	}
+
+	inline SDFOperation GetOperation(UINT editParams)
+	{
+		return static_cast<SDFOperation>((editParams >> 8) & 0x00000003);
+	}
+
+	inline UINT GetMaterialTableIndex(UINT editParams)
+	{
+		return (editParams >> 10) & 0x00000003;
+	}
+
+	inline bool IsSmoothOperation(SDFOperation op)
+	{
+		// smooth if second bit is set
+		return op & 2;
+	}
+
+	inline bool IsSmoothEdit(UINT editParams)
+	{
+		// smooth if second bit of op is set
+		return editParams & 0x00000200;
+	}
+
+
+	//
+	// EDIT EVALUATION
+	// The transform-evaluate-scale sequence that every shader performs for an edit
+	//
+
+	inline float EvaluateEdit(const SDFEditData& edit, const float3& p)
+	{
+		// apply primitive transform
+		const float3 p_transformed = opTransform(p, edit.InvRotation, edit.InvTranslation) / edit.Scale;
+
+		// evaluate primitive
+		const float dist = sdPrimitive(p_transformed, GetShape(edit.EditParams), edit.ShapeParams);
+		return dist * edit.Scale;
+	}
+
+	inline float EvaluateBoundingSphere(const SDFEditData& edit, const float3& p)
+	{
+		// apply primitive transform
+		const float3 p_transformed = opTransform(p, edit.InvRotation, edit.InvTranslation) / edit.Scale;
+
+		// evaluate primitive
+		const float dist = boundingSpherePrimitive(p_transformed, GetShape(edit.EditParams), edit.ShapeParams);
+		return dist * edit.Scale;
+	}
+}
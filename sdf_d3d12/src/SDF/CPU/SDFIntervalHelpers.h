@@ -0,0 +1,227 @@
+#pragma once
+
+#include "SDFHelpers.h"
+
+#include <cfloat>
+
+
+// Interval arithmetic versions of the functions in SDFHelpers
+// Each function returns a range that contains every value the scalar function can take over a box,
+// which allows a whole brick to be classified at once instead of sampling its centre.
+//
+// Every shape is bounded using the fact that it is a distance field, so can change by at most
+// the distance moved: the range is its value at the centre plus or minus the half-diagonal of the box.
+// Sphere, box and torus are also bounded directly by interval arithmetic, and the tighter of the two is used.
+// The fractal is only a distance estimate, so its range is no more conservative than sampling it.
+//
+// The bounds are widened slightly at the end of an edit to absorb floating point rounding.
+
+namespace SDFIntervalHelpers
+{
+	using SDFHelpers::float3;
+	using SDFHelpers::float4;
+
+	struct Interval
+	{
+		float lo, hi;
+
+		Interval() = default;
+		constexpr Interval(float lo, float hi) : lo(lo), hi(hi) {}
+		explicit constexpr Interval(float s) : lo(s), hi(s) {}
+
+		inline bool Contains(float v) const { return lo <= v && v <= hi; }
+	};
+
+	inline Interval operator+(const Interval& a, const Interval& b) { return { a.lo + b.lo, a.hi + b.hi }; }
+	inline Interval operator-(const Interval& a, const Interval& b) { return { a.lo - b.hi, a.hi - b.lo }; }
+	inline Interval operator-(const Interval& a) { return { -a.hi, -a.lo }; }
+	inline Interval operator+(const Interval& a, float s) { return { a.lo + s, a.hi + s }; }
+	inline Interval operator-(const Interval& a, float s) { return { a.lo - s, a.hi - s }; }
+	// s must not be negative
+	inline Interval operator*(const Interval& a, float s) { return { a.lo * s, a.hi * s }; }
+
+	inline Interval imin(const Interval& a, const Interval& b) { return { min(a.lo, b.lo), min(a.hi, b.hi) }; }
+	inline Interval imax(const Interval& a, const Interval& b) { return { max(a.lo, b.lo), max(a.hi, b.hi) }; }
+	inline Interval imin(const Interval& a, float s) { return { min(a.lo, s), min(a.hi, s) }; }
+	inline Interval imax(const Interval& a, float s) { return { max(a.lo, s), max(a.hi, s) }; }
+
+	inline Interval iabs(const Interval& a)
+	{
+		if (a.lo >= 0.0f)
+			return a;
+		if (a.hi <= 0.0f)
+			return -a;
+		return { 0.0f, max(-a.lo, a.hi) };
+	}
+
+	// The range of the square of a non-negative interval
+	inline Interval isqr(const Interval& a) { return { a.lo * a.lo, a.hi * a.hi }; }
+
+	// The range of the length of a vector whose components are non-negative intervals
+	inline Interval ilength(const Interval& x, const Interval& y)
+	{
+		const Interval l2 = isqr(x) + isqr(y);
+		return { sqrtf(l2.lo), sqrtf(l2.hi) };
+	}
+
+	inline Interval ilength(const Interval& x, const Interval& y, const Interval& z)
+	{
+		const Interval l2 = isqr(x) + isqr(y) + isqr(z);
+		return { sqrtf(l2.lo), sqrtf(l2.hi) };
+	}
+
+
+	// An axis-aligned box in the space of an edit
+	struct IntervalBox
+	{
+		float3 Centre;
+		float3 Extents;	// Half the size of the box on each axis
+
+		inline Interval X() const { return { Centre.x - Extents.x, Centre.x + Extents.x }; }
+		inline Interval Y() const { return { Centre.y - Extents.y, Centre.y + Extents.y }; }
+		inline Interval Z() const { return { Centre.z - Extents.z, Centre.z + Extents.z }; }
+
+		inline float HalfDiagonal() const { return SDFHelpers::length(Extents); }
+	};
+
+	// The box containing every point of box after opTransform
+	// rotate_vector is linear, so the rotated box is bounded by the absolute rotated axes
+	inline IntervalBox opTransform(const IntervalBox& box, const float4& q, const float3& t)
+	{
+		const float3 axisX = SDFHelpers::rotate_vector({ 1.0f, 0.0f, 0.0f }, q);
+		const float3 axisY = SDFHelpers::rotate_vector({ 0.0f, 1.0f, 0.0f }, q);
+		const float3 axisZ = SDFHelpers::rotate_vector({ 0.0f, 0.0f, 1.0f }, q);
+
+		const float3 e = box.Extents;
+		return {
+			SDFHelpers::opTransform(box.Centre, q, t),
+			SDFHelpers::abs(axisX) * e.x + SDFHelpers::abs(axisY) * e.y + SDFHelpers::abs(axisZ) * e.z
+		};
+	}
+
+
+	//
+	// PRIMITIVES
+	//
+
+	inline Interval sdSphere(const IntervalBox& p, float r)
+	{
+		return ilength(iabs(p.X()), iabs(p.Y()), iabs(p.Z())) - r;
+	}
+
+	inline Interval sdBox(const IntervalBox& p, const float3& b)
+	{
+		const Interval qx = iabs(p.X()) - b.x;
+		const Interval qy = iabs(p.Y()) - b.y;
+		const Interval qz = iabs(p.Z()) - b.z;
+		return ilength(imax(qx, 0.0f), imax(qy, 0.0f), imax(qz, 0.0f)) + imin(imax(qx, imax(qy, qz)), 0.0f);
+	}
+
+	inline Interval sdTorus(const IntervalBox& p, float tx, float ty)
+	{
+		const Interval qx = ilength(iabs(p.X()), iabs(p.Z())) - tx;
+		return ilength(iabs(qx), iabs(p.Y())) - ty;
+	}
+
+	// Bounds a distance field from its value at the centre of the box
+	// radius is the half-diagonal of the box before it was transformed, as rotation inflates the box
+	inline Interval sdLipschitz(const float3& p, float radius, SDFShape prim, const XMFLOAT4& param)
+	{
+		const float d = SDFHelpers::sdPrimitive(p, prim, param);
+		return { d - radius, d + radius };
+	}
+
+	inline Interval intersect(const Interval& a, const Interval& b)
+	{
+		return { max(a.lo, b.lo), min(a.hi, b.hi) };
+	}
+
+	inline Interval sdPrimitive(const IntervalBox& p, float radius, SDFShape prim, const XMFLOAT4& param)
+	{
+		const Interval bound = sdLipschitz(p.Centre, radius, prim, param);
+		switch (prim)
+		{
+		case SDF_SHAPE_SPHERE:
+			return intersect(sdSphere(p, param.x), bound);
+		case SDF_SHAPE_BOX:
+			return intersect(sdBox(p, { param.x, param.y, param.z }), bound);
+		case SDF_SHAPE_TORUS:
+			return intersect(sdTorus(p, param.x, param.y), bound);
+		case SDF_SHAPE_OCTAHEDRON:
+		case SDF_SHAPE_BOX_FRAME:
+		case SDF_SHAPE_FRACTAL:
+			return bound;
+		default:
+			return Interval(0.0f);
+		}
+	}
+
+
+	//
+	// OPERATIONS
+	//
+
+	// The range of e = max(r - abs(a - b), 0) used by the smooth operations
+	inline Interval SmoothBlendFactor(const Interval& a, const Interval& b, float r)
+	{
+		const Interval d = iabs(a - b);
+		return { max(r - d.hi, 0.0f), max(r - d.lo, 0.0f) };
+	}
+
+	inline Interval opSmoothUnion(const Interval& a, const Interval& b, float r)
+	{
+		const Interval e = SmoothBlendFactor(a, b, r);
+		const Interval m = imin(a, b);
+		return { m.lo - e.hi * e.hi * 0.25f / r, m.hi - e.lo * e.lo * 0.25f / r };
+	}
+
+	inline Interval opSmoothSubtraction(const Interval& a, const Interval& b, float r)
+	{
+		const Interval e = SmoothBlendFactor(a, b, r);
+		const Interval m = imax(a, -b);
+		return { m.lo + e.lo * e.lo * 0.125f / r, m.hi + e.hi * e.hi * 0.125f / r };
+	}
+
+	inline Interval opPrimitive(const Interval& a, const Interval& b, SDFOperation op, float k)
+	{
+		// Smooth operations with no blending range divide by zero, so they are bounded as hard operations
+		if (k <= 0.0f)
+			op = static_cast<SDFOperation>(op & 1);
+
+		switch (op)
+		{
+		case SDF_OP_UNION:
+			return imin(a, b);
+		case SDF_OP_SUBTRACTION:
+			return imax(a, -b);
+		case SDF_OP_SMOOTH_UNION:
+			return opSmoothUnion(a, b, k);
+		case SDF_OP_SMOOTH_SUBTRACTION:
+			return opSmoothSubtraction(a, b, k);
+		default:
+			return a;
+		}
+	}
+
+
+	//
+	// EDIT EVALUATION
+	//
+
+	// The range of EvaluateEdit over a world space box
+	inline Interval EvaluateEdit(const SDFEditData& edit, const IntervalBox& box)
+	{
+		// apply primitive transform
+		IntervalBox p_transformed = opTransform(box, edit.InvRotation, edit.InvTranslation);
+		p_transformed.Centre = p_transformed.Centre / edit.Scale;
+		p_transformed.Extents = p_transformed.Extents / edit.Scale;
+
+		// evaluate primitive
+		const float radius = box.HalfDiagonal() / edit.Scale;
+		const Interval dist = sdPrimitive(p_transformed, radius, SDFHelpers::GetShape(edit.EditParams), edit.ShapeParams) * edit.Scale;
+
+		// Widen by the rounding error of the scalar evaluation
+		const float error = 1e-5f * (fabsf(dist.lo) + fabsf(dist.hi) + box.HalfDiagonal()) + FLT_EPSILON;
+		return { dist.lo - error, dist.hi + error };
+	}
+}
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "SDFPacketEvaluator.h"
+
+#include "SDFHelpers.h"
+
+#include <intrin.h>
+#include <cfloat>
+
+
+// Implemented in the instruction set specific translation units
+void EvaluatePackets_SSE(const SDFPacketEvaluation& evaluation);
+void EvaluatePackets_AVX2(const SDFPacketEvaluation& evaluation);
+void EvaluatePackets_AVX512(const SDFPacketEvaluation& evaluation);
+
+
+namespace
+{
+	// Reference implementation that evaluates one point at a time
+	void EvaluatePackets_Scalar(const SDFPacketEvaluation& evaluation)
+	{
+		using namespace SDFHelpers;
+
+		const bool blendMaterials = evaluation.OutMaterials[0] != nullptr;
+
+		for (UINT point = 0; point < evaluation.PointCount; point++)
+		{
+			const float3 p{ evaluation.PositionsX[point], evaluation.PositionsY[point], evaluation.PositionsZ[point] };
+
+			float nearest = FLT_MAX;
+			float4 materials = float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+			for (UINT i = 0; i < evaluation.EditCount; i++)
+			{
+				const UINT index = evaluation.Indices ? evaluation.Indices[i] : i;
+				const SDFEditData& edit = evaluation.Edits[index];
+
+				const float dist = EvaluateEdit(edit, p);
+
+				if (blendMaterials)
+				{
+					const UINT material = GetMaterialTableIndex(edit.EditParams);
+					const float4 matContribution(material == 0 ? 1.0f : 0.0f, material == 1 ? 1.0f : 0.0f, material == 2 ? 1.0f : 0.0f, material == 3 ? 1.0f : 0.0f);
+					materials = opPrimitive_Material(nearest, dist, materials, matContribution, GetOperation(edit.EditParams), edit.BlendingRange * 0.5f);
+				}
+
+				// combine with scene
+				nearest = opPrimitive(nearest, dist, GetOperation(edit.EditParams), edit.BlendingRange);
+			}
+
+			evaluation.OutDistances[point] = nearest;
+			if (blendMaterials)
+			{
+				evaluation.OutMaterials[0][point] = materials.x;
+				evaluation.OutMaterials[1][point] = materials.y;
+				evaluation.OutMaterials[2][point] = materials.z;
+				evaluation.OutMaterials[3][point] = materials.w;
+			}
+		}
+	}
+
+
+	SIMDLevel::Value DetectHighestSupportedLevel()
+	{
+		int cpuInfo[4];
+
+		__cpuid(cpuInfo, 0);
+		const int maxLeaf = cpuInfo[0];
+
+		__cpuid(cpuInfo, 1);
+		const bool osxsave = cpuInfo[2] & (1 << 27);
+		const bool avx = cpuInfo[2] & (1 << 28);
+		if (!osxsave || !avx || maxLeaf < 7)
+			return SIMDLevel::SSE;
+
+		// The OS must also save the extended register state on context switches
+		const UINT64 xcr0 = _xgetbv(0);
+		const bool osSavesYMM = (xcr0 & 0x06) == 0x06;
+		const bool osSavesZMM = (xcr0 & 0xE6) == 0xE6;
+
+		__cpuidex(cpuInfo, 7, 0);
+		const bool avx2 = cpuInfo[1] & (1 << 5);
+		const bool avx512f = cpuInfo[1] & (1 << 16);
+
+		if (avx512f && osSavesZMM)
+			return SIMDLevel::AVX512;
+		if (avx2 && osSavesYMM)
+			return SIMDLevel::AVX2;
+		return SIMDLevel::SSE;
+	}
+}
+
+
+SDFPacketEvaluator::SDFPacketEvaluator()
+	: SDFPacketEvaluator(GetHighestSupportedLevel())
+{
+}
+
+SDFPacketEvaluator::SDFPacketEvaluator(SIMDLevel::Value level)
+{
+	if (!IsLevelSupported(level))
+	{
+		LOG_WARN("{} is not supported by this CPU.", GetLevelName(level));
+		level = GetHighestSupportedLevel();
+	}
+
+	m_Level = level;
+	switch (m_Level)
+	{
+	case SIMDLevel::SSE:	m_Evaluate = EvaluatePackets_SSE; break;
+	case SIMDLevel::AVX2:	m_Evaluate = EvaluatePackets_AVX2; break;
+	case SIMDLevel::AVX512:	m_Evaluate = EvaluatePackets_AVX512; break;
+	default:				m_Evaluate = EvaluatePackets_Scalar; break;
+	}
+}
+
+
+void SDFPacketEvaluator::Evaluate(const SDFPacketEvaluation& evaluation) const
+{
+	ASSERT(evaluation.Edits || evaluation.EditCount == 0, "No edits to evaluate!");
+	ASSERT(evaluation.OutDistances || evaluation.PointCount == 0, "No output for distances!");
+
+	m_Evaluate(evaluation);
+}
+
+
+SIMDLevel::Value SDFPacketEvaluator::GetHighestSupportedLevel()
+{
+	static const SIMDLevel::Value s_HighestLevel = DetectHighestSupportedLevel();
+	return s_HighestLevel;
+}
+
+bool SDFPacketEvaluator::IsLevelSupported(SIMDLevel::Value level)
+{
+	return level < SIMDLevel::Count && level <= GetHighestSupportedLevel();
+}
+
+
+UINT SDFPacketEvaluator::GetPacketWidth(SIMDLevel::Value level)
+{
+	switch (level)
+	{
+	case SIMDLevel::SSE:	return 4;
+	case SIMDLevel::AVX2:	return 8;
+	case SIMDLevel::AVX512:	return 16;
+	default:				return 1;
+	}
+}
+
+const char* SDFPacketEvaluator::GetLevelName(SIMDLevel::Value level)
+{
+	switch (level)
+	{
+	case SIMDLevel::Scalar:	return "Scalar";
+	case SIMDLevel::SSE:	return "SSE";
+	case SIMDLevel::AVX2:	return "AVX2";
+	case SIMDLevel::AVX512:	return "AVX-512";
+	default:				return "Unknown";
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Core.h"
+#include "HlslCompat/ComputeHlslCompat.h"
+
+
+namespace SIMDLevel
+{
+	enum Value
+	{
+		Scalar = 0,
+		SSE,		// 4 points per packet
+		AVX2,		// 8 points per packet
+		AVX512,		// 16 points per packet
+		Count
+	};
+}
+
+
+// The inputs and outputs of a packet evaluation
+// Positions and outputs are structure-of-arrays with PointCount elements
+struct SDFPacketEvaluation
+{
+	const SDFEditData* Edits = nullptr;
+	const UINT* Indices = nullptr;	// Indices into Edits to evaluate, or null to evaluate Edits in order
+	UINT EditCount = 0;
+
+	const float* PositionsX = nullptr;
+	const float* PositionsY = nullptr;
+	const float* PositionsZ = nullptr;
+	UINT PointCount = 0;
+
+	float* OutDistances = nullptr;
+	// Optional material weights, blended the same as the brick evaluator
+	// Either all or none of these must be set
+	// This is a plain array as the kernels must not call library code (see SDFPacketKernel.h)
+	float* OutMaterials[4] = { nullptr, nullptr, nullptr, nullptr };
+};
+
+
+// Evaluates an edit list at many points at once using SIMD
+// The results are identical to the scalar functions in SDFHelpers, which mirror sdf_helper.hlsli
+class SDFPacketEvaluator
+{
+public:
+	SDFPacketEvaluator();
+	SDFPacketEvaluator(SIMDLevel::Value level);
+	~SDFPacketEvaluator() = default;
+
+	DEFAULT_COPY(SDFPacketEvaluator)
+	DEFAULT_MOVE(SDFPacketEvaluator)
+
+	void Evaluate(const SDFPacketEvaluation& evaluation) const;
+
+	inline SIMDLevel::Value GetLevel() const { return m_Level; }
+	inline UINT GetPacketWidth() const { return GetPacketWidth(m_Level); }
+
+	// The highest level supported by both this build and the CPU
+	static SIMDLevel::Value GetHighestSupportedLevel();
+	static bool IsLevelSupported(SIMDLevel::Value level);
+
+	static UINT GetPacketWidth(SIMDLevel::Value level);
+	static const char* GetLevelName(SIMDLevel::Value level);
+
+private:
+	using EvaluateFunction = void(*)(const SDFPacketEvaluation&);
+
+	SIMDLevel::Value m_Level = SIMDLevel::Scalar;
+	EvaluateFunction m_Evaluate = nullptr;
+};
@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "SDFPacketKernel.h"
+
+#include <immintrin.h>
+
+
+// This file is compiled with /arch:AVX2
+// It must only be called once SDFPacketEvaluator has checked that the CPU supports AVX2
+
+namespace
+{
+	struct PacketAVX2
+	{
+		static constexpr UINT Width = 8;
+		using Mask = __m256;
+
+		__m256 v;
+
+		static inline PacketAVX2 Set(float s) { return { _mm256_set1_ps(s) }; }
+		static inline PacketAVX2 Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+		inline void Store(float* p) const { _mm256_storeu_ps(p, v); }
+	};
+
+	inline PacketAVX2 operator+(const PacketAVX2& a, const PacketAVX2& b) { return { _mm256_add_ps(a.v, b.v) }; }
+	inline PacketAVX2 operator-(const PacketAVX2& a, const PacketAVX2& b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	inline PacketAVX2 operator*(const PacketAVX2& a, const PacketAVX2& b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	inline PacketAVX2 operator/(const PacketAVX2& a, const PacketAVX2& b) { return { _mm256_div_ps(a.v, b.v) }; }
+	inline PacketAVX2 operator-(const PacketAVX2& a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+
+	inline PacketAVX2 Min(const PacketAVX2& a, const PacketAVX2& b) { return { _mm256_min_ps(a.v, b.v) }; }
+	inline PacketAVX2 Max(const PacketAVX2& a, const PacketAVX2& b) { return { _mm256_max_ps(a.v, b.v) }; }
+	inline PacketAVX2 Sqrt(const PacketAVX2& a) { return { _mm256_sqrt_ps(a.v) }; }
+	inline PacketAVX2 Abs(const PacketAVX2& a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+
+	inline PacketAVX2::Mask Less(const PacketAVX2& a, const PacketAVX2& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+	inline PacketAVX2 Select(const PacketAVX2::Mask& mask, const PacketAVX2& a, const PacketAVX2& b)
+	{
+		return { _mm256_blendv_ps(b.v, a.v, mask) };
+	}
+}
+
+
+void EvaluatePackets_AVX2(const SDFPacketEvaluation& evaluation)
+{
+	SDFPacketKernel::Evaluate<PacketAVX2>(evaluation);
+}
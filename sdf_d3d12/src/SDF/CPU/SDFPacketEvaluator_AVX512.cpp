@@ -0,0 +1,49 @@
+#include "pch.h"
+#include "SDFPacketKernel.h"
+
+#include <immintrin.h>
+
+
+// This file is compiled with /arch:AVX512
+// It must only be called once SDFPacketEvaluator has checked that the CPU supports AVX-512F
+
+namespace
+{
+	struct PacketAVX512
+	{
+		static constexpr UINT Width = 16;
+		using Mask = __mmask16;
+
+		__m512 v;
+
+		static inline PacketAVX512 Set(float s) { return { _mm512_set1_ps(s) }; }
+		static inline PacketAVX512 Load(const float* p) { return { _mm512_loadu_ps(p) }; }
+		inline void Store(float* p) const { _mm512_storeu_ps(p, v); }
+	};
+
+	inline PacketAVX512 operator+(const PacketAVX512& a, const PacketAVX512& b) { return { _mm512_add_ps(a.v, b.v) }; }
+	inline PacketAVX512 operator-(const PacketAVX512& a, const PacketAVX512& b) { return { _mm512_sub_ps(a.v, b.v) }; }
+	inline PacketAVX512 operator*(const PacketAVX512& a, const PacketAVX512& b) { return { _mm512_mul_ps(a.v, b.v) }; }
+	inline PacketAVX512 operator/(const PacketAVX512& a, const PacketAVX512& b) { return { _mm512_div_ps(a.v, b.v) }; }
+	inline PacketAVX512 operator-(const PacketAVX512& a)
+	{
+		return { _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32(0x80000000))) };
+	}
+
+	inline PacketAVX512 Min(const PacketAVX512& a, const PacketAVX512& b) { return { _mm512_min_ps(a.v, b.v) }; }
+	inline PacketAVX512 Max(const PacketAVX512& a, const PacketAVX512& b) { return { _mm512_max_ps(a.v, b.v) }; }
+	inline PacketAVX512 Sqrt(const PacketAVX512& a) { return { _mm512_sqrt_ps(a.v) }; }
+	inline PacketAVX512 Abs(const PacketAVX512& a) { return { _mm512_abs_ps(a.v) }; }
+
+	inline PacketAVX512::Mask Less(const PacketAVX512& a, const PacketAVX512& b) { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ); }
+	inline PacketAVX512 Select(const PacketAVX512::Mask& mask, const PacketAVX512& a, const PacketAVX512& b)
+	{
+		return { _mm512_mask_blend_ps(mask, b.v, a.v) };
+	}
+}
+
+
+void EvaluatePackets_AVX512(const SDFPacketEvaluation& evaluation)
+{
+	SDFPacketKernel::Evaluate<PacketAVX512>(evaluation);
+}
@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "SDFPacketKernel.h"
+
+#include <immintrin.h>
+
+
+// SSE2 is part of x64, so this can always be used
+
+namespace
+{
+	struct PacketSSE
+	{
+		static constexpr UINT Width = 4;
+		using Mask = __m128;
+
+		__m128 v;
+
+		static inline PacketSSE Set(float s) { return { _mm_set1_ps(s) }; }
+		static inline PacketSSE Load(const float* p) { return { _mm_loadu_ps(p) }; }
+		inline void Store(float* p) const { _mm_storeu_ps(p, v); }
+	};
+
+	inline PacketSSE operator+(const PacketSSE& a, const PacketSSE& b) { return { _mm_add_ps(a.v, b.v) }; }
+	inline PacketSSE operator-(const PacketSSE& a, const PacketSSE& b) { return { _mm_sub_ps(a.v, b.v) }; }
+	inline PacketSSE operator*(const PacketSSE& a, const PacketSSE& b) { return { _mm_mul_ps(a.v, b.v) }; }
+	inline PacketSSE operator/(const PacketSSE& a, const PacketSSE& b) { return { _mm_div_ps(a.v, b.v) }; }
+	inline PacketSSE operator-(const PacketSSE& a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+
+	// minps/maxps return the second operand when either is NaN or both are zero, the same as the min/max macros
+	inline PacketSSE Min(const PacketSSE& a, const PacketSSE& b) { return { _mm_min_ps(a.v, b.v) }; }
+	inline PacketSSE Max(const PacketSSE& a, const PacketSSE& b) { return { _mm_max_ps(a.v, b.v) }; }
+	inline PacketSSE Sqrt(const PacketSSE& a) { return { _mm_sqrt_ps(a.v) }; }
+	inline PacketSSE Abs(const PacketSSE& a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+
+	inline PacketSSE::Mask Less(const PacketSSE& a, const PacketSSE& b) { return _mm_cmplt_ps(a.v, b.v); }
+	inline PacketSSE Select(const PacketSSE::Mask& mask, const PacketSSE& a, const PacketSSE& b)
+	{
+		return { _mm_or_ps(_mm_and_ps(mask, a.v), _mm_andnot_ps(mask, b.v)) };
+	}
+}
+
+
+void EvaluatePackets_SSE(const SDFPacketEvaluation& evaluation)
+{
+	SDFPacketKernel::Evaluate<PacketSSE>(evaluation);
+}
@@ -0,0 +1,380 @@
+#pragma once
+
+#include "SDFPacketEvaluator.h"
+
+#include <cfloat>
+
+
+// Packet implementations of the functions in sdf_helper.hlsli, templated on the packet type
+// Each function is written operation-for-operation the same as its scalar version in SDFHelpers.h,
+// so that every lane produces exactly the same result as the scalar code.
+// This relies on multiplies and adds not being contracted into FMAs, so these files must not use /fp:contract or /fp:fast.
+//
+// This header must only be included by the translation unit that implements an instruction set.
+// Those translation units are compiled with different architecture flags,
+// so every function here is static to stop the linker sharing code between them.
+// For the same reason the kernels must not call any inline library functions (eg std containers),
+// as the linker could pick the AVX compiled copy for use by the rest of the application.
+//
+// A packet type P must provide:
+//   P::Width, P::Mask
+//   P::Set(float), P::Load(const float*), p.Store(float*)
+//   operators + - * / and unary -
+//   Min(a, b), Max(a, b), Sqrt(a), Abs(a)  - where Min and Max follow the semantics of the min/max macros
+//   Less(a, b) -> P::Mask, Select(mask, a, b) -> mask ? a : b
+
+namespace SDFPacketKernel
+{
+	template<typename P>
+	struct PacketFloat3
+	{
+		P x, y, z;
+	};
+
+	template<typename P>
+	static inline P Dot(const PacketFloat3<P>& a, const PacketFloat3<P>& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	template<typename P>
+	static inline P Length(const PacketFloat3<P>& v)
+	{
+		return Sqrt(Dot(v, v));
+	}
+
+	template<typename P>
+	static inline PacketFloat3<P> Abs(const PacketFloat3<P>& v)
+	{
+		return { Abs(v.x), Abs(v.y), Abs(v.z) };
+	}
+
+	template<typename P>
+	static inline PacketFloat3<P> Max(const PacketFloat3<P>& v, const P& s)
+	{
+		return { Max(v.x, s), Max(v.y, s), Max(v.z, s) };
+	}
+
+
+	//
+	// QUATERNIONS
+	// The rotation is the same for every lane, but it is broadcast to keep the order of operations identical
+	//
+
+	template<typename P>
+	static inline PacketFloat3<P> RotateVector(const PacketFloat3<P>& v, const XMFLOAT4& r)
+	{
+		const P rx = P::Set(r.x), ry = P::Set(r.y), rz = P::Set(r.z), rw = P::Set(r.w);
+		const P zero = P::Set(0.0f);
+
+		// r_c = r * float4(-1, -1, -1, 1)
+		const P cx = rx * P::Set(-1.0f), cy = ry * P::Set(-1.0f), cz = rz * P::Set(-1.0f), cw = rw * P::Set(1.0f);
+
+		// t = qmul(float4(v, 0), r_c)
+		const P tx = cx * zero + v.x * cw + (v.y * cz - v.z * cy);
+		const P ty = cy * zero + v.y * cw + (v.z * cx - v.x * cz);
+		const P tz = cz * zero + v.z * cw + (v.x * cy - v.y * cx);
+		const P tw = zero * cw - (v.x * cx + v.y * cy + v.z * cz);
+
+		// qmul(r, t).xyz
+		return {
+			tx * rw + rx * tw + (ry * tz - rz * ty),
+			ty * rw + ry * tw + (rz * tx - rx * tz),
+			tz * rw + rz * tw + (rx * ty - ry * tx)
+		};
+	}
+
+
+	//
+	// PRIMITIVES
+	//
+
+	template<typename P>
+	static inline P sdSphere(const PacketFloat3<P>& p, const P& r)
+	{
+		return Length(p) - r;
+	}
+
+	template<typename P>
+	static inline P sdBox(const PacketFloat3<P>& p, const PacketFloat3<P>& b)
+	{
+		const PacketFloat3<P> a = Abs(p);
+		const PacketFloat3<P> q = { a.x - b.x, a.y - b.y, a.z - b.z };
+		return Length(Max(q, P::Set(0.0f))) + Min(Max(q.x, Max(q.y, q.z)), P::Set(0.0f));
+	}
+
+	template<typename P>
+	static inline P sdTorus(const PacketFloat3<P>& p, const P& tx, const P& ty)
+	{
+		const P qx = Sqrt(p.x * p.x + p.z * p.z) - tx;
+		return Sqrt(qx * qx + p.y * p.y) - ty;
+	}
+
+	template<typename P>
+	static inline P sdOctahedron(const PacketFloat3<P>& p_in, const P& s)
+	{
+		const PacketFloat3<P> p = Abs(p_in);
+		const P m = p.x + p.y + p.z - s;
+
+		const P three = P::Set(3.0f);
+		const auto c1 = Less(three * p.x, m);
+		const auto c2 = Less(three * p.y, m);
+		const auto c3 = Less(three * p.z, m);
+
+		// Select the swizzle of the first condition that is true in each lane
+		const PacketFloat3<P> q = {
+			Select(c1, p.x, Select(c2, p.y, p.z)),
+			Select(c1, p.y, Select(c2, p.z, p.x)),
+			Select(c1, p.z, Select(c2, p.x, p.y))
+		};
+
+		const P k = Min(Max(P::Set(0.5f) * (q.z - q.y + s), P::Set(0.0f)), s);
+		const P l = Length(PacketFloat3<P>{ q.x, q.y - s + k, q.z - k });
+
+		return Select(c1, l, Select(c2, l, Select(c3, l, m * P::Set(0.57735027f))));
+	}
+
+	template<typename P>
+	static inline P sdBoxFrame(const PacketFloat3<P>& p_in, const PacketFloat3<P>& b, const P& e)
+	{
+		const PacketFloat3<P> a = Abs(p_in);
+		const PacketFloat3<P> p = { a.x - b.x, a.y - b.y, a.z - b.z };
+		const PacketFloat3<P> q = { Abs(p.x + e) - e, Abs(p.y + e) - e, Abs(p.z + e) - e };
+
+		const P zero = P::Set(0.0f);
+		const P d0 = Length(Max(PacketFloat3<P>{ p.x, q.y, q.z }, zero)) + Min(Max(p.x, Max(q.y, q.z)), zero);
+		const P d1 = Length(Max(PacketFloat3<P>{ q.x, p.y, q.z }, zero)) + Min(Max(q.x, Max(p.y, q.z)), zero);
+		const P d2 = Length(Max(PacketFloat3<P>{ q.x, q.y, p.z }, zero)) + Min(Max(q.x, Max(q.y, p.z)), zero);
+		return Min(Min(d0, d1), d2);
+	}
+
+	template<typename P>
+	static inline P sdFractal(PacketFloat3<P> p)
+	{
+		const PacketFloat3<P> a[4] = {
+			{ P::Set(1.0f), P::Set(1.0f), P::Set(1.0f) },
+			{ P::Set(-1.0f), P::Set(-1.0f), P::Set(1.0f) },
+			{ P::Set(1.0f), P::Set(-1.0f), P::Set(-1.0f) },
+			{ P::Set(-1.0f), P::Set(1.0f), P::Set(-1.0f) }
+		};
+
+		constexpr int iterations = 15;
+		for (int n = 0; n < iterations; n++)
+		{
+			PacketFloat3<P> c = a[0];
+			P dist = Length(PacketFloat3<P>{ p.x - a[0].x, p.y - a[0].y, p.z - a[0].z });
+			for (int i = 1; i < 4; i++)
+			{
+				const P d = Length(PacketFloat3<P>{ p.x - a[i].x, p.y - a[i].y, p.z - a[i].z });
+				const auto closer = Less(d, dist);
+				c = { Select(closer, a[i].x, c.x), Select(closer, a[i].y, c.y), Select(closer, a[i].z, c.z) };
+				dist = Select(closer, d, dist);
+			}
+
+			const P two = P::Set(2.0f);
+			p = { two * p.x - c.x, two * p.y - c.y, two * p.z - c.z };
+		}
+
+		// 2^-15 is exact, matching powf(2.0f, -15.0f)
+		return Length(p) * P::Set(1.0f / 32768.0f) - P::Set(0.005f);
+	}
+
+	template<typename P>
+	static inline P sdPrimitive(const PacketFloat3<P>& p, SDFShape prim, const XMFLOAT4& param)
+	{
+		switch (prim)
+		{
+		case SDF_SHAPE_SPHERE:
+			return sdSphere(p, P::Set(param.x));
+		case SDF_SHAPE_BOX:
+			return sdBox(p, { P::Set(param.x), P::Set(param.y), P::Set(param.z) });
+		case SDF_SHAPE_TORUS:
+			return sdTorus(p, P::Set(param.x), P::Set(param.y));
+		case SDF_SHAPE_OCTAHEDRON:
+			return sdOctahedron(p, P::Set(param.x));
+		case SDF_SHAPE_BOX_FRAME:
+			return sdBoxFrame(p, { P::Set(param.x), P::Set(param.y), P::Set(param.z) }, P::Set(param.w));
+		case SDF_SHAPE_FRACTAL:
+			return sdFractal(p);
+		default:
+			return P::Set(0.0f);
+		}
+	}
+
+
+	//
+	// OPERATIONS
+	// The operation is the same for every lane so it is chosen outside of the packet
+	//
+
+	template<typename P>
+	static inline P opSmoothUnion(const P& a, const P& b, const P& r)
+	{
+		const P e = Max(r - Abs(a - b), P::Set(0.0f));
+		return Min(a, b) - e * e * P::Set(0.25f) / r;
+	}
+
+	template<typename P>
+	static inline P opSmoothSubtraction(const P& a, const P& b, const P& r)
+	{
+		const P e = Max(r - Abs(a - b), P::Set(0.0f));
+		return Max(a, -b) + e * e * P::Set(0.125f) / r;
+	}
+
+	template<typename P>
+	static inline P opPrimitive(const P& a, const P& b, SDFOperation op, float k)
+	{
+		switch (op)
+		{
+		case SDF_OP_UNION:
+			return Min(a, b);
+		case SDF_OP_SUBTRACTION:
+			return Max(a, -b);
+		case SDF_OP_SMOOTH_UNION:
+			return opSmoothUnion(a, b, P::Set(k));
+		case SDF_OP_SMOOTH_SUBTRACTION:
+			return opSmoothSubtraction(a, b, P::Set(k));
+		default:
+			return a;
+		}
+	}
+
+	// Blends the material weights in place, matching opPrimitive_Material
+	// The contribution of an edit is 1 in the channel of its material and 0 elsewhere
+	template<typename P>
+	static inline void opPrimitive_Material(const P& a, const P& b, P (&materials)[4], UINT material, SDFOperation op, float k)
+	{
+		switch (op)
+		{
+		case SDF_OP_UNION:
+		{
+			const auto closer = Less(a, b);
+			for (UINT i = 0; i < 4; i++)
+				materials[i] = Select(closer, materials[i], P::Set(i == material ? 1.0f : 0.0f));
+			break;
+		}
+		case SDF_OP_SMOOTH_UNION:
+		{
+			const P r = P::Set(k);
+			const P e = Min(Max(r - (b - a) / r, P::Set(0.0f)), P::Set(1.0f));
+			for (UINT i = 0; i < 4; i++)
+				materials[i] = materials[i] + (P::Set(i == material ? 1.0f : 0.0f) - materials[i]) * e;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+
+	//
+	// EVALUATION
+	//
+
+	template<typename P>
+	static inline P EvaluateEdit(const SDFEditData& edit, const PacketFloat3<P>& p)
+	{
+		// apply primitive transform
+		const PacketFloat3<P> translated = {
+			p.x + P::Set(edit.InvTranslation.x),
+			p.y + P::Set(edit.InvTranslation.y),
+			p.z + P::Set(edit.InvTranslation.z)
+		};
+		const PacketFloat3<P> rotated = RotateVector(translated, edit.InvRotation);
+
+		const P scale = P::Set(edit.Scale);
+		const PacketFloat3<P> p_transformed = { rotated.x / scale, rotated.y / scale, rotated.z / scale };
+
+		// evaluate primitive
+		const P dist = sdPrimitive(p_transformed, static_cast<SDFShape>(edit.EditParams & 0xFF), edit.ShapeParams);
+		return dist * scale;
+	}
+
+	template<typename P>
+	static void EvaluatePacket(const SDFPacketEvaluation& evaluation, const PacketFloat3<P>& p, P& nearest, P (&materials)[4], bool blendMaterials)
+	{
+		nearest = P::Set(FLT_MAX);
+		for (UINT i = 0; i < 4; i++)
+			materials[i] = P::Set(0.0f);
+
+		for (UINT i = 0; i < evaluation.EditCount; i++)
+		{
+			const UINT index = evaluation.Indices ? evaluation.Indices[i] : i;
+			const SDFEditData& edit = evaluation.Edits[index];
+
+			const SDFOperation op = static_cast<SDFOperation>((edit.EditParams >> 8) & 0x3);
+			const P dist = EvaluateEdit(edit, p);
+
+			if (blendMaterials)
+			{
+				const UINT material = (edit.EditParams >> 10) & 0x3;
+				opPrimitive_Material(nearest, dist, materials, material, op, edit.BlendingRange * 0.5f);
+			}
+
+			// combine with scene
+			nearest = opPrimitive(nearest, dist, op, edit.BlendingRange);
+		}
+	}
+
+	// Evaluates every point in the evaluation
+	// The final partial packet is evaluated using padded copies of the positions
+	template<typename P>
+	static void Evaluate(const SDFPacketEvaluation& evaluation)
+	{
+		constexpr UINT width = P::Width;
+		const bool blendMaterials = evaluation.OutMaterials[0] != nullptr;
+
+		P nearest;
+		P materials[4];
+
+		UINT point = 0;
+		for (; point + width <= evaluation.PointCount; point += width)
+		{
+			const PacketFloat3<P> p = {
+				P::Load(evaluation.PositionsX + point),
+				P::Load(evaluation.PositionsY + point),
+				P::Load(evaluation.PositionsZ + point)
+			};
+
+			EvaluatePacket(evaluation, p, nearest, materials, blendMaterials);
+
+			nearest.Store(evaluation.OutDistances + point);
+			if (blendMaterials)
+			{
+				for (UINT i = 0; i < 4; i++)
+					materials[i].Store(evaluation.OutMaterials[i] + point);
+			}
+		}
+
+		const UINT remaining = evaluation.PointCount - point;
+		if (remaining > 0)
+		{
+			alignas(64) float x[width] = {};
+			alignas(64) float y[width] = {};
+			alignas(64) float z[width] = {};
+			for (UINT i = 0; i < remaining; i++)
+			{
+				x[i] = evaluation.PositionsX[point + i];
+				y[i] = evaluation.PositionsY[point + i];
+				z[i] = evaluation.PositionsZ[point + i];
+			}
+
+			EvaluatePacket(evaluation, PacketFloat3<P>{ P::Load(x), P::Load(y), P::Load(z) }, nearest, materials, blendMaterials);
+
+			alignas(64) float out[width];
+			nearest.Store(out);
+			for (UINT i = 0; i < remaining; i++)
+				evaluation.OutDistances[point + i] = out[i];
+
+			if (blendMaterials)
+			{
+				for (UINT m = 0; m < 4; m++)
+				{
+					materials[m].Store(out);
+					for (UINT i = 0; i < remaining; i++)
+						evaluation.OutMaterials[m][point + i] = out[i];
+				}
+			}
+		}
+	}
+}
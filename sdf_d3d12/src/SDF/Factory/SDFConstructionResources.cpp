@@ -3,33 +3,13 @@
 
 #include "Framework/Math.h"
 #include "Renderer/D3DGraphicsContext.h"
+#include "SDF/CPU/BrickHelpers.h"
 
+#include <algorithm>
 
 
-UINT expandBits(UINT v)
-{
-	v = (v * 0x00010001u) & 0xFF0000FFu;
-	v = (v * 0x00000101u) & 0x0F00F00Fu;
-	v = (v * 0x00000011u) & 0xC30C30C3u;
-	v = (v * 0x00000005u) & 0x49249249u;
-	return v;
-}
-
-// Calculates a 30-bit Morton code for the
-// given 3D point located within the range [0,1023].
-UINT morton3Du(XMUINT3 p)
-{
-	p.x = min(p.x, 1023u);
-	p.y = min(p.y, 1023u);
-	p.z = min(p.z, 1023u);
-	unsigned int xx = expandBits(p.x);
-	unsigned int yy = expandBits(p.y);
-	unsigned int zz = expandBits(p.z);
-	return xx * 4 + yy * 2 + zz;
-}
 
-
-void SDFConstructionResources::AllocateResources(UINT brickCapacity, const SDFEditList& editList, float evalSpaceSize)
+void SDFConstructionResources::AllocateResources(UINT brickCapacity, const SDFEditList& editList, float evalSpaceSize, const XMFLOAT3& regionMin, const XMFLOAT3& regionMax)
 {
 	const auto device = g_D3DGraphicsContext->GetDevice();
 
@@ -39,23 +19,28 @@ void SDFConstructionResources::AllocateResources(UINT brickCapacity, const SDFEd
 		m_Allocated = true;
 
 		m_IndexCounter.Allocate(device, L"Index Counters");
+		m_IndexOverflowCounter.Allocate(device, L"Index Overflow Counter");
 
-		constexpr UINT dependencyCount = 1024 * 1023;
-		m_EditDependencies.Allocate(device, dependencyCount * sizeof(UINT), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Edit Dependency Indices");
-		m_EditDependenciesUpload.Allocate(device, dependencyCount, 0, L"Edit Dependency Upload");
-		m_EditDependenciesUpload.SetElements(0, m_EditDependenciesUpload.GetElementCount(), 0);
+		AllocateEditDependencyIndices(s_MinEditDependencyCapacity);
 
 		for (auto& counter : m_SubBrickCounters)
 		{
 			counter.Allocate(device, L"Sub Brick Counters");
 		}
 
-		m_BrickUpload.Allocate(device, 64, 0, L"Brick upload");
+		m_BrickUpload.Allocate(device, s_MaxSeedBricks, 0, L"Brick upload");
+		m_InitialBrickCountUpload.Allocate(device, 1, 0, L"Initial Brick Count Upload");
 		m_BrickCounterReadback.Allocate(device, 1, 0, L"Brick Counter Readback");
 
 		m_IndexCounterReadback.Allocate(device, 1, 0, L"Index Counter Readback");
+		m_IndexOverflowReadback.Allocate(device, 1, 0, L"Index Overflow Readback");
 
 		m_CommandBuffer.Allocate(device, s_NumCommands * sizeof(D3D12_DISPATCH_ARGUMENTS), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Indirect Dispatch Command Buffer");
+
+		m_FreeBrickCounter.Allocate(device, L"Free Brick Counter");
+		m_ReleasedIndexCounter.Allocate(device, L"Released Index Counter");
+		m_FreeBrickCounterReadback.Allocate(device, 1, 0, L"Free Brick Counter Readback");
+		m_ReleasedIndexCounterReadback.Allocate(device, 1, 0, L"Released Index Counter Readback");
 	}
 
 	// Allocate new brick-capacity-dependent resources whenever the required brick capacity increases
@@ -75,6 +60,7 @@ void SDFConstructionResources::AllocateResources(UINT brickCapacity, const SDFEd
 		m_BlockPrefixSumsBuffer.Allocate(device, blockWidth, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Block prefix sums buffer");
 		m_BlockPrefixSumsOutputBuffer.Allocate(device, blockWidth, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Block prefix sums output buffer");
 		m_PrefixSumsBuffer.Allocate(device, width, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Prefix sums buffer");
+		m_BrickSlotBuffer.Allocate(device, width, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Brick slot buffer");
 	}
 
 	// Allocate a new edit buffer whenever the required edit capacity increases
@@ -82,15 +68,6 @@ void SDFConstructionResources::AllocateResources(UINT brickCapacity, const SDFEd
 	{
 		m_EditBuffer.Allocate(editList.GetEditCount());
 
-		// Worst case: every brick uses every edit
-		// Max Indices = Bricks * Edits
-		const UINT indexBufferCapacity = editList.GetEditCount() * m_BrickCapacity;
-		const UINT64 indexBufferWidth = indexBufferCapacity * sizeof(UINT16);
-		for (auto& indexBuffer : m_IndexBuffers)
-		{
-			indexBuffer.Allocate(device, indexBufferWidth, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Index Buffer");
-		}
-
 		// Upload only needs to contain data for the first 64 bricks
 		m_IndexUpload.Allocate(device, editList.GetEditCount(), 0, L"Index Upload");
 
@@ -101,27 +78,68 @@ void SDFConstructionResources::AllocateResources(UINT brickCapacity, const SDFEd
 		}
 	}
 
+	// The worst case of every brick using every edit grows with bricks * edits, which is far too large for big edit lists
+	// Instead the index buffers start large enough for the first iteration, where each of the 64 bricks can use every edit,
+	// and are grown whenever the edit tester reports that they overflowed
+	const UINT64 initialIndexCapacity = (std::max)(64ull * editList.GetEditCount(), static_cast<UINT64>(s_MinIndexCapacity));
+	if (initialIndexCapacity > m_IndexCapacity)
+	{
+		AllocateIndexBuffers(static_cast<UINT>((std::min)(initialIndexCapacity, static_cast<UINT64>(UINT_MAX))));
+	}
+
 	// Always populate the resources with new data
 	m_EditBuffer.Populate(editList);
 
+	// Only edits that are close together need to be tested for dependencies, which is much cheaper on the CPU
+	// than dispatching a thread for every pair of edits on the GPU
+	m_EditDependencies.Build(editList.GetEditData(), editList.GetEditCount());
+
+	const UINT offsetCount = editList.GetEditCount() + 1;
+	if (offsetCount > m_EditDependencyOffsetsUpload.GetElementCount())
+	{
+		m_EditDependencyOffsets.Allocate(device, offsetCount * sizeof(UINT), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_NONE, L"Edit Dependency Offsets");
+		m_EditDependencyOffsetsUpload.Allocate(device, offsetCount, 0, L"Edit Dependency Offsets Upload");
+	}
+
+	const UINT dependencyCount = m_EditDependencies.GetTotalDependencyCount();
+	if (dependencyCount > m_EditDependencyIndicesUpload.GetElementCount())
+	{
+		// Leave room to grow, as edit lists are often rebuilt with small changes
+		AllocateEditDependencyIndices(2 * dependencyCount);
+	}
+
+	m_EditDependencyOffsetsUpload.CopyElements(0, offsetCount, m_EditDependencies.GetOffsets().data());
+	if (dependencyCount > 0)
+		m_EditDependencyIndicesUpload.CopyElements(0, dependencyCount, m_EditDependencies.GetIndices().data());
+
 	// Populate initial constant buffer params
 	m_BuildParamsCB.SDFEditCount = editList.GetEditCount();
+	m_BuildParamsCB.IndexCapacity = m_IndexCapacity;
 	// The brick size will be different for each dispatch
 	m_BuildParamsCB.BrickSize = evalSpaceSize / 4.0f; // size of entire evaluation space
 	m_BuildParamsCB.SubBrickSize = m_BuildParamsCB.BrickSize / 4.0f; // brick size will quarter with each dispatch
 	m_BuildParamsCB.EvalSpaceSize = evalSpaceSize; // This will not get reduced between iterations
+	m_BuildParamsCB.RegionMin = regionMin;
+	m_BuildParamsCB.RegionMax = regionMax;
 
 	// Create and upload initial bricks
+	// Every edit is relevant to the initial bricks
+	m_Seeded = false;
+	m_InitialBrickCount = 64;
+	m_InitialIndexCount = editList.GetEditCount();
+	m_InitialBrickCountUpload.CopyElement(0, m_InitialBrickCount);
+
 	Brick initialBrick;
 	initialBrick.SubBrickMask = { 0, 0 };
 	initialBrick.IndexOffset = 0;
 	initialBrick.IndexCount = editList.GetEditCount();
+	initialBrick.PoolSlot = 0;
 
 	for (UINT x = 0; x < 4; x++)
 	for (UINT y = 0; y < 4; y++)
 	for (UINT z = 0; z < 4; z++)
 	{
-		const UINT index = morton3Du({ x, y, z });
+		const UINT index = BrickHelpers::morton3Du({ x, y, z });
 
 		initialBrick.TopLeft = {
 			-0.5f * evalSpaceSize + (static_cast<float>(x) * m_BuildParamsCB.BrickSize),
@@ -134,6 +152,153 @@ void SDFConstructionResources::AllocateResources(UINT brickCapacity, const SDFEd
 }
 
 
+void SDFConstructionResources::SeedBricks(const SDFEditList& editList, float seedBrickSize)
+{
+	const float evalSpaceSize = m_BuildParamsCB.EvalSpaceSize;
+	const XMFLOAT3& regionMin = m_BuildParamsCB.RegionMin;
+	const XMFLOAT3& regionMax = m_BuildParamsCB.RegionMax;
+
+	UINT seedMin[3], seedMax[3];
+	CalculateSeedRange(regionMin, regionMax, evalSpaceSize, seedBrickSize, seedMin, seedMax);
+
+	const UINT seedCount = (seedMax[0] - seedMin[0] + 1) * (seedMax[1] - seedMin[1] + 1) * (seedMax[2] - seedMin[2] + 1);
+	ASSERT(seedCount <= s_MaxSeedBricks && seedCount <= m_BrickCapacity, "Too many seed bricks!");
+
+	const float origin = -0.5f * evalSpaceSize;
+
+	// A seed brick would have been built with the edits that the edit tester found within a seed brick size of its centre
+	// Every edit whose bounds are that close to any seed is a superset of those, and they are kept in edit order
+	{
+		const float margin = seedBrickSize;
+		const XMFLOAT3 queryMin = {
+			origin + static_cast<float>(seedMin[0]) * seedBrickSize - margin,
+			origin + static_cast<float>(seedMin[1]) * seedBrickSize - margin,
+			origin + static_cast<float>(seedMin[2]) * seedBrickSize - margin
+		};
+		const XMFLOAT3 queryMax = {
+			origin + static_cast<float>(seedMax[0] + 1) * seedBrickSize + margin,
+			origin + static_cast<float>(seedMax[1] + 1) * seedBrickSize + margin,
+			origin + static_cast<float>(seedMax[2] + 1) * seedBrickSize + margin
+		};
+
+		m_EditBVH.Build(editList.GetEditData(), editList.GetEditCount());
+
+		m_SeedEditMask.assign(editList.GetEditCount(), false);
+		m_EditBVH.Query(queryMin, queryMax, [this](UINT edit)
+			{
+				m_SeedEditMask.at(edit) = true;
+
+				// The edit tester also keeps the dependencies of relevant smooth edits
+				const UINT* dependencies = m_EditDependencies.GetDependencies(edit);
+				for (UINT i = 0; i < m_EditDependencies.GetDependencyCount(edit); i++)
+				{
+					m_SeedEditMask.at(dependencies[i]) = true;
+				}
+			});
+
+		m_InitialIndexCount = static_cast<UINT>(std::count(m_SeedEditMask.begin(), m_SeedEditMask.end(), true));
+		if (m_InitialIndexCount > m_SeedIndexUpload.GetElementCount())
+		{
+			m_SeedIndexUpload.Allocate(g_D3DGraphicsContext->GetDevice(), editList.GetEditCount(), 0, L"Seed Index Upload");
+		}
+
+		UINT index = 0;
+		for (UINT edit = 0; edit < editList.GetEditCount(); edit++)
+		{
+			if (m_SeedEditMask.at(edit))
+				m_SeedIndexUpload.CopyElement(index++, edit);
+		}
+	}
+
+	Brick seed;
+	seed.SubBrickMask = { 0, 0 };
+	seed.IndexOffset = 0;
+	seed.IndexCount = m_InitialIndexCount;
+	seed.PoolSlot = 0;
+
+	UINT index = 0;
+	for (UINT z = seedMin[2]; z <= seedMax[2]; z++)
+	for (UINT y = seedMin[1]; y <= seedMax[1]; y++)
+	for (UINT x = seedMin[0]; x <= seedMax[0]; x++)
+	{
+		seed.TopLeft = {
+			origin + static_cast<float>(x) * seedBrickSize,
+			origin + static_cast<float>(y) * seedBrickSize,
+			origin + static_cast<float>(z) * seedBrickSize
+		};
+		m_BrickUpload.CopyElement(index++, seed);
+	}
+
+	m_Seeded = true;
+	m_InitialBrickCount = seedCount;
+	m_InitialBrickCountUpload.CopyElement(0, m_InitialBrickCount);
+
+	m_BuildParamsCB.BrickSize = seedBrickSize;
+	m_BuildParamsCB.SubBrickSize = seedBrickSize / 4.0f;
+}
+
+UINT SDFConstructionResources::CalculateSeedRange(const XMFLOAT3& regionMin, const XMFLOAT3& regionMax, float evalSpaceSize, float seedBrickSize, UINT outMin[3], UINT outMax[3])
+{
+	const float origin = -0.5f * evalSpaceSize;
+	const int bricksPerAxis = static_cast<int>(std::round(evalSpaceSize / seedBrickSize));
+
+	const float mins[3] = { regionMin.x, regionMin.y, regionMin.z };
+	const float maxs[3] = { regionMax.x, regionMax.y, regionMax.z };
+
+	UINT count = 1;
+	for (UINT axis = 0; axis < 3; axis++)
+	{
+		outMin[axis] = static_cast<UINT>(std::clamp(static_cast<int>(std::floor((mins[axis] - origin) / seedBrickSize)), 0, bricksPerAxis - 1));
+		outMax[axis] = static_cast<UINT>(std::clamp(static_cast<int>(std::floor((maxs[axis] - origin) / seedBrickSize)), 0, bricksPerAxis - 1));
+		count *= outMax[axis] - outMin[axis] + 1;
+	}
+	return count;
+}
+
+
+void SDFConstructionResources::AllocateEditDependencyIndices(UINT capacity)
+{
+	const auto device = g_D3DGraphicsContext->GetDevice();
+
+	const UINT64 width = static_cast<UINT64>(capacity) * sizeof(UINT);
+	m_EditDependencyIndices.Allocate(device, width, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_NONE, L"Edit Dependency Indices");
+	m_EditDependencyIndicesUpload.Allocate(device, capacity, 0, L"Edit Dependency Indices Upload");
+}
+
+void SDFConstructionResources::GrowIndexBuffers(UINT requiredCapacity)
+{
+	if (requiredCapacity <= m_IndexCapacity)
+		return;
+
+	// At least double the capacity so that repeated overflows are rare
+	const UINT64 capacity = (std::max)(static_cast<UINT64>(requiredCapacity), 2ull * m_IndexCapacity);
+	AllocateIndexBuffers(static_cast<UINT>((std::min)(capacity, static_cast<UINT64>(UINT_MAX))));
+}
+
+void SDFConstructionResources::AllocateIndexBuffers(UINT capacity)
+{
+	const auto device = g_D3DGraphicsContext->GetDevice();
+
+	m_IndexCapacity = capacity;
+
+	const UINT64 width = static_cast<UINT64>(m_IndexCapacity) * sizeof(UINT);
+	for (auto& indexBuffer : m_IndexBuffers)
+	{
+		indexBuffer.Allocate(device, width, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Index Buffer");
+	}
+}
+
+void SDFConstructionResources::AllocateFreeBrickBuffer(UINT objectBrickCount)
+{
+	if (objectBrickCount <= m_FreeBrickCapacity)
+		return;
+
+	m_FreeBrickCapacity = objectBrickCount;
+
+	const UINT64 width = static_cast<UINT64>(m_FreeBrickCapacity) * sizeof(UINT);
+	m_FreeBrickBuffer.Allocate(g_D3DGraphicsContext->GetDevice(), width, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"Free brick buffer");
+}
+
 void SDFConstructionResources::SwapBuffersAndRefineBrickSize()
 {
 	m_CurrentReadBuffers = 1 - m_CurrentReadBuffers;
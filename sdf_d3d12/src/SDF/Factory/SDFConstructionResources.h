@@ -8,7 +8,9 @@
 #include "Renderer/Buffer/UploadBuffer.h"
 
 #include "HlslCompat/ComputeHlslCompat.h"
+#include "SDF/SDFEditDependencies.h"
 #include "SDF/SDFEditList.h"
+#include "SDF/CPU/SDFEditBVH.h"
 
 // An encapsulation of all temporary resources required to perform an SDF object build
 // These are encapsulated to make the construction pipeline neater and more readable
@@ -23,7 +25,21 @@ public:
 	DEFAULT_MOVE(SDFConstructionResources)
 
 	// Don't call while a previous construction using this object is in flight!
-	void AllocateResources(UINT brickCapacity, const SDFEditList& editList, float evalSpaceSize);
+	// Only sub-bricks that overlap the region will be built
+	void AllocateResources(UINT brickCapacity, const SDFEditList& editList, float evalSpaceSize, const XMFLOAT3& regionMin, const XMFLOAT3& regionMax);
+	// Replaces the initial bricks with every brick of size seedBrickSize that overlaps the region,
+	// so that brick building starts part way down the hierarchy
+	// Must be called after AllocateResources, with the same edit list
+	void SeedBricks(const SDFEditList& editList, float seedBrickSize);
+	// Finds the range of bricks of size seedBrickSize that overlap the region, and returns how many there are
+	static UINT CalculateSeedRange(const XMFLOAT3& regionMin, const XMFLOAT3& regionMax, float evalSpaceSize, float seedBrickSize, UINT outMin[3], UINT outMax[3]);
+	inline static constexpr UINT GetMaxSeedBrickCount() { return s_MaxSeedBricks; }
+	inline UINT GetBrickCapacity() const { return m_BrickCapacity; }
+	// Grow the index buffers after a construction overflowed them
+	// AllocateResources must be called again before the construction is repeated
+	void GrowIndexBuffers(UINT requiredCapacity);
+	// The free list must be able to hold every brick of the object being baked into
+	void AllocateFreeBrickBuffer(UINT objectBrickCount);
 	void SwapBuffersAndRefineBrickSize();
 
 	// Getters
@@ -31,10 +47,15 @@ public:
 	inline DefaultBuffer& GetReadIndexBuffer() { return m_IndexBuffers.at(m_CurrentReadBuffers); }
 	inline DefaultBuffer& GetWriteIndexBuffer() { return m_IndexBuffers.at(1 - m_CurrentReadBuffers); }
 
+	inline UINT GetIndexCapacity() const { return m_IndexCapacity; }
 	inline CounterResource& GetIndexCounter() { return m_IndexCounter; }
+	inline CounterResource& GetIndexOverflowCounter() { return m_IndexOverflowCounter; }
 
-	inline DefaultBuffer& GetEditDependencyBuffer() { return m_EditDependencies; }
-	inline UploadBuffer<UINT16>& GetEditDependencyUploadBuffer() { return m_EditDependenciesUpload; }
+	inline const SDFEditDependencies& GetEditDependencies() const { return m_EditDependencies; }
+	inline DefaultBuffer& GetEditDependencyOffsetBuffer() { return m_EditDependencyOffsets; }
+	inline UploadBuffer<UINT>& GetEditDependencyOffsetUploadBuffer() { return m_EditDependencyOffsetsUpload; }
+	inline DefaultBuffer& GetEditDependencyIndexBuffer() { return m_EditDependencyIndices; }
+	inline UploadBuffer<UINT>& GetEditDependencyIndexUploadBuffer() { return m_EditDependencyIndicesUpload; }
 
 	inline BrickBuildParametersConstantBuffer& GetBrickBuildParams() { return m_BuildParamsCB; }
 	inline BrickEvaluationConstantBuffer& GetBrickEvalParams() { return m_BrickEvalCB; }
@@ -50,25 +71,57 @@ public:
 	inline DefaultBuffer& GetBlockPrefixSumsOutputBuffer() { return m_BlockPrefixSumsOutputBuffer; }
 	inline DefaultBuffer& GetPrefixSumsBuffer() { return m_PrefixSumsBuffer; }
 
-	inline UploadBuffer<UINT16>& GetIndexUploadBuffer() { return m_IndexUpload; }
+	// The initial bricks, and the edits they are built from, which all initial bricks share
+	inline UINT GetInitialBrickCount() const { return m_InitialBrickCount; }
+	inline UINT GetInitialIndexCount() const { return m_InitialIndexCount; }
+	inline UploadBuffer<UINT>& GetInitialIndexUploadBuffer() { return m_Seeded ? m_SeedIndexUpload : m_IndexUpload; }
+	inline UploadBuffer<UINT>& GetInitialBrickCountUploadBuffer() { return m_InitialBrickCountUpload; }
+
 	inline ReadbackBuffer<UINT>& GetIndexCounterReadbackBuffer() { return m_IndexCounterReadback; }
+	inline ReadbackBuffer<UINT>& GetIndexOverflowReadbackBuffer() { return m_IndexOverflowReadback; }
 
 	inline UploadBuffer<Brick>& GetBrickUploadBuffer() { return m_BrickUpload; }
 	inline ReadbackBuffer<UINT>& GetBrickCounterReadbackBuffer() { return m_BrickCounterReadback; }
 
 	inline DefaultBuffer& GetCommandBuffer() { return m_CommandBuffer; }
 
+	// Incremental bakes
+	inline IncrementalBakeConstantBuffer& GetIncrementalParams() { return m_IncrementalCB; }
+
+	inline DefaultBuffer& GetFreeBrickBuffer() { return m_FreeBrickBuffer; }
+	inline DefaultBuffer& GetBrickSlotBuffer() { return m_BrickSlotBuffer; }
+
+	inline CounterResource& GetFreeBrickCounter() { return m_FreeBrickCounter; }
+	inline CounterResource& GetReleasedIndexCounter() { return m_ReleasedIndexCounter; }
+	inline ReadbackBuffer<UINT>& GetFreeBrickCounterReadbackBuffer() { return m_FreeBrickCounterReadback; }
+	inline ReadbackBuffer<UINT>& GetReleasedIndexCounterReadbackBuffer() { return m_ReleasedIndexCounterReadback; }
+
 protected:
+	void AllocateEditDependencyIndices(UINT capacity);
+	void AllocateIndexBuffers(UINT capacity);
+
+protected:
+	inline static constexpr UINT s_MinEditDependencyCapacity = 1024;
+	inline static constexpr UINT s_MinIndexCapacity = 1 << 20;
+	// Each seed brick is one group of the first dispatch
+	inline static constexpr UINT s_MaxSeedBricks = 4096;
+
 	UINT m_BrickCapacity = 0;
+	UINT m_IndexCapacity = 0;
 	bool m_Allocated = false;
 
 	// Edits
 	SDFEditBuffer m_EditBuffer;
 	std::array<DefaultBuffer, 2> m_IndexBuffers;
 	CounterResource m_IndexCounter;
+	CounterResource m_IndexOverflowCounter;			// The index count required by the edit tester if the index buffers were too small
 
-	DefaultBuffer m_EditDependencies;
-	UploadBuffer<UINT16> m_EditDependenciesUpload;
+	// Edit dependencies are found on the CPU and uploaded as compressed sparse rows
+	SDFEditDependencies m_EditDependencies;
+	DefaultBuffer m_EditDependencyOffsets;					// (edits + 1) offsets into the dependency indices
+	UploadBuffer<UINT> m_EditDependencyOffsetsUpload;
+	DefaultBuffer m_EditDependencyIndices;					// The dependencies of every edit, in order
+	UploadBuffer<UINT> m_EditDependencyIndicesUpload;
 
 	// Constant buffers
 	BrickBuildParametersConstantBuffer m_BuildParamsCB;
@@ -87,14 +140,36 @@ protected:
 	DefaultBuffer m_PrefixSumsBuffer;				// The final prefix sums output buffer
 
 	// Utility buffers to set and read values
-	UploadBuffer<UINT16> m_IndexUpload;				// An upload buffer for the index data for each brick
+	UploadBuffer<UINT> m_IndexUpload;				// An upload buffer for the index data for each brick
 	ReadbackBuffer<UINT> m_IndexCounterReadback;	// used to read the value of the index counter
+	ReadbackBuffer<UINT> m_IndexOverflowReadback;
 
 	UploadBuffer<Brick> m_BrickUpload;				// An upload buffer for bricks is required to send the initial brick to the GPU
 	ReadbackBuffer<UINT32> m_BrickCounterReadback;	// Used to read the value of a counter
 
+	// Seeded constructions start from bricks part way down the hierarchy, which share the edits that can affect the region
+	UINT m_InitialBrickCount = 64;
+	UINT m_InitialIndexCount = 0;
+	bool m_Seeded = false;
+	UploadBuffer<UINT> m_InitialBrickCountUpload;	// Sets the brick counter and the first dispatch
+	UploadBuffer<UINT> m_SeedIndexUpload;
+	SDFEditBVH m_EditBVH;
+	std::vector<bool> m_SeedEditMask;
+
 	// Command buffer for indirect dispatching
 	// This will contain 4 arguments
 	inline static constexpr UINT s_NumCommands = 4;
 	DefaultBuffer m_CommandBuffer;
+
+	// Incremental bakes
+	IncrementalBakeConstantBuffer m_IncrementalCB;
+	// The slots of the object's bricks that can be replaced, and which slot each new brick was placed in
+	// An object can have more bricks than a construction, so the free list is allocated when the object is known
+	DefaultBuffer m_FreeBrickBuffer;
+	UINT m_FreeBrickCapacity = 0;
+	DefaultBuffer m_BrickSlotBuffer;
+	CounterResource m_FreeBrickCounter;
+	CounterResource m_ReleasedIndexCounter;
+	ReadbackBuffer<UINT> m_FreeBrickCounterReadback;
+	ReadbackBuffer<UINT> m_ReleasedIndexCounterReadback;
 };
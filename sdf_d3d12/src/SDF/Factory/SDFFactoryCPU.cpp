@@ -0,0 +1,861 @@
+#include "pch.h"
+#include "SDFFactoryCPU.h"
+
+#include "SDF/SDFEditList.h"
+#include "SDF/SDFObject.h"
+#include "SDF/CPU/SDFHelpers.h"
+#include "SDF/CPU/BrickHelpers.h"
+#include "Framework/Hash.h"
+
+#include <algorithm>
+#include <cfloat>
+
+
+using namespace SDFHelpers;
+
+
+// Number of items processed by each task in each stage
+// Bricks become more expensive to process in the later stages
+static constexpr UINT s_BrickCountingGrainSize = 16;
+static constexpr UINT s_EditTestingGrainSize = 64;
+static constexpr UINT s_AABBGrainSize = 4096;
+static constexpr UINT s_EvaluationGrainSize = 4;
+static constexpr UINT s_CacheKeyGrainSize = 256;
+static constexpr UINT s_DeduplicationGrainSize = 64;
+
+static constexpr UINT s_VoxelsPerBrick = SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+
+
+SDFFactoryCPU::SDFFactoryCPU(UINT threadCount)
+{
+	m_ThreadPool = std::make_unique<ThreadPool>(threadCount);
+	m_PrefixScan = std::make_unique<PrefixScan>(m_ThreadPool.get());
+	LOG_INFO("CPU SDF factory created with {} threads.", m_ThreadPool->GetThreadCount());
+}
+
+
+void SDFFactoryCPU::BakeSDF(const SDFEditList& editList, float brickSize, SDFBakeData& outData)
+{
+	BakeSDF(editList, brickSize, { 0, 0, 0 }, outData);
+}
+
+void SDFFactoryCPU::BakeSDF(const SDFEditList& editList, float brickSize, const XMUINT3& brickPoolDimensions, SDFBakeData& outData)
+{
+	ASSERT(brickSize > 0.0f, "Invalid brick size!");
+
+	bool fitBrickPool = true;
+
+	m_Timer.Reset();
+	m_Timings = {};
+
+	{
+		// Set up construction data
+
+		// Determine eval space size
+		// It should be a multiple of the smallest brick size
+		// Therefore the final iteration will build bricks of the desired size
+		float evalSpaceSize = brickSize;
+		while (evalSpaceSize < editList.GetEvaluationRange())
+		{
+			evalSpaceSize *= 4.0f;
+		}
+
+		m_Edits.assign(editList.GetEditData(), editList.GetEditData() + editList.GetEditCount());
+		m_EditsSoA = editList.GetSoA();
+
+		m_EditHashes.resize(editList.GetEditCount());
+		for (UINT i = 0; i < editList.GetEditCount(); i++)
+		{
+			m_EditHashes.at(i) = editList.GetEditHash(i);
+		}
+
+		m_BuildParams.SDFEditCount = editList.GetEditCount();
+		m_BuildParams.BrickSize = evalSpaceSize / 4.0f;
+		m_BuildParams.SubBrickSize = m_BuildParams.BrickSize / 4.0f;
+		m_BuildParams.EvalSpaceSize = evalSpaceSize;
+
+		// Find the size of the bricks that will be output, which may be limited by the iteration count
+		float outputBrickSize = m_BuildParams.BrickSize;
+		UINT iterations = 0;
+		for (float subBrickSize = m_BuildParams.SubBrickSize; subBrickSize >= brickSize && iterations++ < m_MaxBrickBuildIterations; subBrickSize /= 4.0f)
+		{
+			outputBrickSize = subBrickSize;
+		}
+		m_VoxelSize = outputBrickSize / SDF_BRICK_SIZE_VOXELS;
+	}
+
+	BuildEditDependencies();
+	m_Timings.EditDependencies = 1000.0f * m_Timer.Tick();
+
+	if (m_EnableEditBVH)
+		m_EditBVH.Build(m_Edits.data(), m_BuildParams.SDFEditCount);
+	m_Timings.EditBVH = 1000.0f * m_Timer.Tick();
+
+	BuildInitialBricks();
+
+	// Multiple iterations will be made until the brick size is small enough
+	UINT iterations = 0;
+	while (m_BuildParams.SubBrickSize >= brickSize && iterations++ < m_MaxBrickBuildIterations)
+	{
+		CountSubBricks();
+		ScanSubBrickCounts();
+		BuildSubBricks();
+		TestEdits();
+
+		SwapBuffersAndRefineBrickSize();
+	}
+	m_Timings.BrickBuilding = 1000.0f * m_Timer.Tick();
+
+	{
+		// Copy out the bricks and indices
+		outData.Clear();
+
+		outData.BrickSize = m_BuildParams.BrickSize;
+		outData.EvalSpaceSize = m_BuildParams.EvalSpaceSize;
+		outData.PoolPlacement = m_BrickPoolPlacement;
+		outData.Bricks = GetReadBricks();
+		outData.Indices = GetReadIndices();
+
+		const UINT brickCount = outData.GetBrickCount();
+		if (brickPoolDimensions.x * brickPoolDimensions.y * brickPoolDimensions.z >= brickCount && brickPoolDimensions.x > 0)
+		{
+			outData.BrickPoolDimensions = brickPoolDimensions;
+			fitBrickPool = false;
+		}
+		else
+		{
+			if (brickPoolDimensions.x > 0)
+				LOG_WARN("Brick pool is too small for {} bricks, an optimal brick pool will be used instead.", brickCount);
+			outData.BrickPoolDimensions = SDFObject::CalculateBrickPoolDimensions(brickCount);
+		}
+	}
+
+	BuildAABBs(outData);
+	m_Timings.AABBBuilding = 1000.0f * m_Timer.Tick();
+
+	EvaluateBricks(outData);
+	m_Timings.BrickEvaluation = 1000.0f * m_Timer.Tick();
+
+	if (m_EnableBrickDeduplication)
+		DeduplicateBricks(outData, fitBrickPool);
+	m_Timings.BrickDeduplication = 1000.0f * m_Timer.Tick();
+
+	m_Timings.Total = 1000.0f * m_Timer.GetTimeSinceReset();
+}
+
+
+void SDFFactoryCPU::BuildEditDependencies()
+{
+	// Dependencies are always stored in ascending order rather than the order the shader's atomics resolved in
+	m_EditDependencies.Build(m_Edits.data(), m_BuildParams.SDFEditCount);
+}
+
+void SDFFactoryCPU::BuildInitialBricks()
+{
+	const UINT editCount = m_BuildParams.SDFEditCount;
+	const float evalSpaceSize = m_BuildParams.EvalSpaceSize;
+
+	// Every edit is relevant to the initial bricks
+	auto& indices = GetReadIndices();
+	indices.resize(editCount);
+	for (UINT edit = 0; edit < editCount; edit++)
+	{
+		indices.at(edit) = edit;
+	}
+
+	Brick initialBrick;
+	initialBrick.SubBrickMask = { 0, 0 };
+	initialBrick.IndexOffset = 0;
+	initialBrick.IndexCount = editCount;
+	initialBrick.PoolSlot = 0;
+
+	auto& bricks = GetReadBricks();
+	bricks.resize(64);
+	for (UINT x = 0; x < 4; x++)
+	for (UINT y = 0; y < 4; y++)
+	for (UINT z = 0; z < 4; z++)
+	{
+		const UINT index = BrickHelpers::morton3Du({ x, y, z });
+
+		initialBrick.TopLeft = {
+			-0.5f * evalSpaceSize + (static_cast<float>(x) * m_BuildParams.BrickSize),
+			-0.5f * evalSpaceSize + (static_cast<float>(y) * m_BuildParams.BrickSize),
+			-0.5f * evalSpaceSize + (static_cast<float>(z) * m_BuildParams.BrickSize)
+		};
+
+		bricks.at(index) = initialBrick;
+	}
+}
+
+void SDFFactoryCPU::CountSubBricks()
+{
+	auto& bricks = GetReadBricks();
+	const UINT* indices = GetReadIndices().data();
+	const UINT brickCount = static_cast<UINT>(bricks.size());
+
+	m_SubBrickCounts.resize(brickCount);
+
+	const float subBrickSize = m_BuildParams.SubBrickSize;
+	const bool intervalCulling = m_CullingMode == BrickCullingMode::Interval;
+
+	m_ThreadPool->ParallelFor(0, brickCount, s_BrickCountingGrainSize, [&](UINT begin, UINT end)
+		{
+			for (UINT brickIndex = begin; brickIndex < end; brickIndex++)
+			{
+				Brick& brick = bricks.at(brickIndex);
+				UINT subBrickCount = 0;
+
+				for (UINT z = 0; z < 4; z++)
+				for (UINT y = 0; y < 4; y++)
+				for (UINT x = 0; x < 4; x++)
+				{
+					// Calculate the centre of the sub-brick
+					const float3 subBrickCentre = float3(brick.TopLeft) + subBrickSize * (float3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) + 0.5f);
+
+					bool occupied;
+					if (intervalCulling)
+					{
+						// The sub-brick is occupied if the surface could pass within half a voxel of it
+						// The output bricks are nested inside this sub-brick, so this keeps every brick that could contain geometry
+						const SDFIntervalHelpers::IntervalBox box = { subBrickCentre, float3(0.5f * subBrickSize) };
+						const SDFIntervalHelpers::Interval distance = EvaluateEditListInterval(brick, indices, box);
+						occupied = distance.lo < 0.5f * m_VoxelSize && distance.hi > -0.5f * m_VoxelSize;
+					}
+					else
+					{
+						// If there is a distance value of magnitude small enough, that means its possible this sub-brick
+						// could contain geometry and it should be either divided or evaluated
+						const float distance = EvaluateEditList(brick, indices, { subBrickCentre.x, subBrickCentre.y, subBrickCentre.z });
+						occupied = fabsf(distance) < subBrickSize;
+					}
+
+					if (occupied)
+					{
+						subBrickCount++;
+
+						// Set the bit corresponding to this brick, in SV_GroupIndex order
+						const UINT GI = x + 4 * y + 16 * z;
+						if (GI < 32)
+							brick.SubBrickMask.x |= 1u << GI;
+						else
+							brick.SubBrickMask.y |= 1u << (GI - 32);
+					}
+				}
+
+				m_SubBrickCounts.at(brickIndex) = subBrickCount;
+			}
+		});
+}
+
+void SDFFactoryCPU::ScanSubBrickCounts()
+{
+	// Exclusive prefix sum, as produced by the three GPU scan passes
+	// The final element contains the total number of sub-bricks
+	const UINT count = static_cast<UINT>(m_SubBrickCounts.size());
+	m_PrefixSums.resize(static_cast<size_t>(count) + 1);
+	m_PrefixScan->ExclusiveScan(m_SubBrickCounts.data(), count, m_PrefixSums.data(), PrefixScanVariant::ThreePass);
+}
+
+void SDFFactoryCPU::BuildSubBricks()
+{
+	const auto& inBricks = GetReadBricks();
+	auto& outBricks = GetWriteBricks();
+
+	const UINT inBrickCount = static_cast<UINT>(inBricks.size());
+	outBricks.resize(m_PrefixSums.at(inBrickCount));
+
+	const float subBrickSize = m_BuildParams.SubBrickSize;
+	const float evalSpaceSize = m_BuildParams.EvalSpaceSize;
+
+	m_ThreadPool->ParallelFor(0, inBrickCount, s_BrickCountingGrainSize, [&](UINT begin, UINT end)
+		{
+			struct SubBrick
+			{
+				UINT MortonCode;
+				UINT GI;
+			};
+			std::array<SubBrick, 64> subBricks;
+
+			for (UINT brickIndex = begin; brickIndex < end; brickIndex++)
+			{
+				const Brick& inBrick = inBricks.at(brickIndex);
+
+				// Gather the sub-bricks in SV_GroupIndex order
+				UINT subBrickCount = 0;
+				for (UINT GI = 0; GI < 64; GI++)
+				{
+					const UINT buildBrick = GI < 32 ? (inBrick.SubBrickMask.x & (1u << GI)) : (inBrick.SubBrickMask.y & (1u << (GI - 32)));
+					if (buildBrick == 0)
+						continue;
+
+					const float3 topLeft = float3(inBrick.TopLeft) + subBrickSize * float3(static_cast<float>(GI % 4), static_cast<float>((GI / 4) % 4), static_cast<float>(GI / 16));
+					const float3 normalized = 0.5f + topLeft / evalSpaceSize;
+					subBricks.at(subBrickCount++) = { BrickHelpers::morton3Df(normalized.x, normalized.y, normalized.z), GI };
+				}
+
+				// Sort bricks based on morton code
+				// The shader breaks ties by SV_GroupIndex, which a stable sort preserves
+				std::stable_sort(subBricks.begin(), subBricks.begin() + subBrickCount, [](const SubBrick& a, const SubBrick& b)
+					{
+						return a.MortonCode < b.MortonCode;
+					});
+
+				const UINT prefixSum = m_PrefixSums.at(brickIndex);
+				for (UINT i = 0; i < subBrickCount; i++)
+				{
+					const UINT GI = subBricks.at(i).GI;
+
+					Brick& outBrick = outBricks.at(prefixSum + i);
+					outBrick.SubBrickMask = { 0, 0 };
+					outBrick.TopLeft = {
+						inBrick.TopLeft.x + subBrickSize * static_cast<float>(GI % 4),
+						inBrick.TopLeft.y + subBrickSize * static_cast<float>((GI / 4) % 4),
+						inBrick.TopLeft.z + subBrickSize * static_cast<float>(GI / 16)
+					};
+					outBrick.IndexOffset = inBrick.IndexOffset; // These will be refined in the next stage
+					outBrick.IndexCount = inBrick.IndexCount;
+					outBrick.PoolSlot = 0;
+				}
+			}
+		});
+}
+
+void SDFFactoryCPU::TestEdits()
+{
+	auto& bricks = GetWriteBricks();
+	const auto& inIndices = GetReadIndices();
+	auto& outIndices = GetWriteIndices();
+
+	const UINT brickCount = static_cast<UINT>(bricks.size());
+	const UINT editCount = m_BuildParams.SDFEditCount;
+	const float subBrickSize = m_BuildParams.SubBrickSize;
+	const bool intervalCulling = m_CullingMode == BrickCullingMode::Interval;
+	// Beyond this distance the brick pool saturates, so an edit further away cannot change the baked values
+	const float relevanceRange = SDF_VOLUME_STRIDE * m_VoxelSize;
+
+	if (m_BrickEdits.size() < brickCount)
+	{
+		m_BrickEdits.resize(brickCount);
+	}
+
+	m_ThreadPool->ParallelFor(0, brickCount, s_EditTestingGrainSize, [&](UINT begin, UINT end)
+		{
+			// Mask for indicating edits that apply to a brick
+			// The relevant edits are also listed in the brick's edit list as they are set,
+			// so the mask never needs to be scanned and only the bits that were set need to be cleared
+			std::vector<UINT> editMask((editCount + 31) / 32);
+			// Edits whose bounds are near the brick
+			std::vector<UINT> candidateMask((editCount + 31) / 32);
+			std::vector<UINT> candidates;
+
+			for (UINT brickIndex = begin; brickIndex < end; brickIndex++)
+			{
+				const Brick& brick = bricks.at(brickIndex);
+
+				auto& brickEdits = m_BrickEdits.at(brickIndex);
+				brickEdits.clear();
+
+				auto setEdit = [&](UINT index)
+					{
+						UINT& word = editMask[index / 32];
+						const UINT bit = 1u << (index % 32);
+						if (!(word & bit))
+						{
+							word |= bit;
+							brickEdits.push_back(index);
+						}
+					};
+
+				// This stage is executed AFTER sub-brick building - so bricks are now sub-brick sized
+				const float3 brickCentre = float3(brick.TopLeft) + 0.5f * subBrickSize;
+				// Voxels are sampled up to half a voxel outside of the brick
+				const SDFIntervalHelpers::IntervalBox brickBox = { brickCentre, float3(0.5f * subBrickSize + 0.5f * m_VoxelSize) };
+
+				auto testEdit = [&](UINT index)
+					{
+						const SDFEditData& edit = m_Edits.at(index);
+
+						// Apply blending range for smooth edits
+						// 1.74f == sqrt(3)
+						const bool smooth = m_EditsSoA.IsSmooth(index);
+						const float blendingRange = smooth ? 1.74f * edit.BlendingRange : 0.0f;
+
+						bool relevant;
+						if (intervalCulling)
+						{
+							relevant = SDFIntervalHelpers::EvaluateEdit(edit, brickBox).lo - blendingRange < relevanceRange;
+						}
+						else
+						{
+							float dist = EvaluateEdit(edit, brickCentre);
+							if (smooth)
+								dist -= blendingRange;
+							relevant = dist < subBrickSize;
+						}
+
+						if (relevant)
+						{
+							setEdit(index);
+
+							if (smooth)
+							{
+								// Set all of the smooth edits dependencies too
+								const UINT* dependencies = m_EditDependencies.GetDependencies(index);
+								const UINT dependencyCount = m_EditDependencies.GetDependencyCount(index);
+								for (UINT dependency = 0; dependency < dependencyCount; dependency++)
+								{
+									setEdit(dependencies[dependency]);
+								}
+							}
+						}
+					};
+
+				// The shader skips edits that were already set by another edit's dependencies.
+				// That makes its result depend on the order threads run in, so here every inherited edit is tested.
+				if (!m_EnableEditBVH)
+				{
+					for (UINT i = 0; i < brick.IndexCount; i++)
+					{
+						testEdit(inIndices.at(brick.IndexOffset + i));
+					}
+				}
+				else
+				{
+					// Edits can only be relevant within this distance of the point or box that they are tested against
+					// The interval bound of an edit is no lower than its value at the centre minus the half-diagonal
+					float queryExtent = intervalCulling ? brickBox.HalfDiagonal() + relevanceRange : subBrickSize;
+					// Pad by the rounding error of evaluating the edit
+					queryExtent += 1e-4f * (fabsf(brickCentre.x) + fabsf(brickCentre.y) + fabsf(brickCentre.z) + queryExtent) + 1e-5f;
+
+					// Edits outside of the query cannot be relevant, so only the edits inside it need to be tested
+					const XMFLOAT3 queryMin = { brickCentre.x - queryExtent, brickCentre.y - queryExtent, brickCentre.z - queryExtent };
+					const XMFLOAT3 queryMax = { brickCentre.x + queryExtent, brickCentre.y + queryExtent, brickCentre.z + queryExtent };
+
+					candidates.clear();
+					m_EditBVH.Query(queryMin, queryMax, [&](UINT index)
+						{
+							candidateMask.at(index / 32) |= 1u << (index % 32);
+							candidates.push_back(index);
+						});
+
+					if (brick.IndexCount == editCount)
+					{
+						// Every edit was inherited, which is always the case in the first iterations
+						for (const UINT index : candidates)
+						{
+							testEdit(index);
+						}
+					}
+					else
+					{
+						for (UINT i = 0; i < brick.IndexCount; i++)
+						{
+							const UINT index = inIndices.at(brick.IndexOffset + i);
+							if ((candidateMask.at(index / 32) >> (index % 32)) & 1u)
+								testEdit(index);
+						}
+					}
+
+					for (const UINT index : candidates)
+					{
+						candidateMask.at(index / 32) = 0;
+					}
+				}
+
+				// Edits must be evaluated in the order they appear in the edit list
+				std::sort(brickEdits.begin(), brickEdits.end());
+				for (const UINT index : brickEdits)
+				{
+					editMask[index / 32] = 0;
+				}
+			}
+		});
+
+	// The shader places each brick's indices with an atomic counter,
+	// here they are placed in brick order so that the output is deterministic
+	UINT indexCount = 0;
+	for (UINT brickIndex = 0; brickIndex < brickCount; brickIndex++)
+	{
+		Brick& brick = bricks.at(brickIndex);
+		brick.IndexOffset = indexCount;
+		brick.IndexCount = static_cast<UINT>(m_BrickEdits.at(brickIndex).size());
+		brick.PoolSlot = brickIndex;
+		indexCount += brick.IndexCount;
+	}
+
+	outIndices.resize(indexCount);
+	m_ThreadPool->ParallelFor(0, brickCount, s_EditTestingGrainSize, [&](UINT begin, UINT end)
+		{
+			for (UINT brickIndex = begin; brickIndex < end; brickIndex++)
+			{
+				const auto& brickEdits = m_BrickEdits.at(brickIndex);
+				std::copy(brickEdits.begin(), brickEdits.end(), outIndices.begin() + bricks.at(brickIndex).IndexOffset);
+			}
+		});
+}
+
+void SDFFactoryCPU::SwapBuffersAndRefineBrickSize()
+{
+	m_CurrentReadBuffers = 1 - m_CurrentReadBuffers;
+
+	m_BuildParams.BrickSize = m_BuildParams.SubBrickSize;
+	m_BuildParams.SubBrickSize = m_BuildParams.BrickSize / 4.0f;
+}
+
+void SDFFactoryCPU::BuildAABBs(SDFBakeData& outData) const
+{
+	const UINT brickCount = outData.GetBrickCount();
+	outData.AABBs.resize(brickCount);
+
+	m_ThreadPool->ParallelFor(0, brickCount, s_AABBGrainSize, [&](UINT begin, UINT end)
+		{
+			for (UINT brickIndex = begin; brickIndex < end; brickIndex++)
+			{
+				// Build a raytracing AABB from this brick
+				const Brick& brick = outData.Bricks.at(brickIndex);
+				auto& aabb = outData.AABBs.at(brickIndex);
+
+				aabb.MinX = brick.TopLeft.x;
+				aabb.MinY = brick.TopLeft.y;
+				aabb.MinZ = brick.TopLeft.z;
+				aabb.MaxX = brick.TopLeft.x + outData.BrickSize;
+				aabb.MaxY = brick.TopLeft.y + outData.BrickSize;
+				aabb.MaxZ = brick.TopLeft.z + outData.BrickSize;
+			}
+		});
+}
+
+void SDFFactoryCPU::EvaluateBricks(SDFBakeData& outData)
+{
+	const UINT brickCount = outData.GetBrickCount();
+	const UINT editCount = m_BuildParams.SDFEditCount;
+
+	const XMUINT3 resolution = outData.GetBrickPoolResolution();
+	outData.BrickPool.assign(4ull * resolution.x * resolution.y * resolution.z, 0);
+
+	const float voxelsPerUnit = SDF_BRICK_SIZE_VOXELS / outData.BrickSize;
+
+	if (m_EnableReferenceDistances)
+		outData.ReferenceDistances.resize(static_cast<size_t>(brickCount) * s_VoxelsPerBrick);
+	else
+		outData.ReferenceDistances.clear();
+
+	const bool useCache = m_EnableBrickCache && !m_EnableReferenceDistances;
+	if (useCache)
+		FindCachedBricks(outData);
+
+	m_ThreadPool->ParallelFor(0, brickCount, s_EvaluationGrainSize, [&](UINT begin, UINT end)
+		{
+			// Voxel data for one brick at a time, in structure-of-arrays form for the packet evaluator
+			alignas(64) float positionsX[s_VoxelsPerBrick];
+			alignas(64) float positionsY[s_VoxelsPerBrick];
+			alignas(64) float positionsZ[s_VoxelsPerBrick];
+			alignas(64) float distances[s_VoxelsPerBrick];
+			alignas(64) float materialsX[s_VoxelsPerBrick];
+			alignas(64) float materialsY[s_VoxelsPerBrick];
+			alignas(64) float materialsZ[s_VoxelsPerBrick];
+			alignas(64) float materialsW[s_VoxelsPerBrick];
+
+			for (UINT brickIndex = begin; brickIndex < end; brickIndex++)
+			{
+				const Brick& brick = outData.Bricks.at(brickIndex);
+				const UINT count = m_EnableEditCulling ? brick.IndexCount : editCount;
+
+				const XMUINT3 brickTopLeft = BrickHelpers::CalculateBrickPoolPosition(brick.PoolSlot, outData.BrickPoolDimensions, outData.PoolPlacement);
+
+				if (useCache && m_CachedBricks.at(brickIndex))
+				{
+					// Copy the cached brick into the pool a row at a time
+					const INT8* cached = m_CachedBricks.at(brickIndex);
+					for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+					for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+					{
+						const size_t voxel = (static_cast<size_t>(brickTopLeft.z + z) * resolution.y + (brickTopLeft.y + y)) * resolution.x + brickTopLeft.x;
+						memcpy(outData.BrickPool.data() + 4 * voxel, cached, 4 * SDF_BRICK_SIZE_VOXELS_ADJACENCY);
+						cached += 4 * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+					}
+					continue;
+				}
+
+				// Calculate the point in space that each voxel represents
+				// such that voxel (0,0,0) goes to (-0.5, -0.5, -0.5) and (7,7,7) goes to (6.5, 6.5, 6.5)
+				UINT voxelIndex = 0;
+				for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+				for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+				for (UINT x = 0; x < SDF_BRICK_SIZE_VOXELS_ADJACENCY; x++)
+				{
+					const float3 evaluationPosition = float3(brick.TopLeft)
+						+ (float3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) - 0.5f) / voxelsPerUnit;
+
+					positionsX[voxelIndex] = evaluationPosition.x;
+					positionsY[voxelIndex] = evaluationPosition.y;
+					positionsZ[voxelIndex] = evaluationPosition.z;
+					voxelIndex++;
+				}
+
+				// Evaluate SDF volume
+				SDFPacketEvaluation evaluation;
+				evaluation.Edits = m_Edits.data();
+				evaluation.Indices = m_EnableEditCulling ? outData.Indices.data() + brick.IndexOffset : nullptr;
+				evaluation.EditCount = count;
+				evaluation.PositionsX = positionsX;
+				evaluation.PositionsY = positionsY;
+				evaluation.PositionsZ = positionsZ;
+				evaluation.PointCount = s_VoxelsPerBrick;
+				evaluation.OutDistances = distances;
+				evaluation.OutMaterials[0] = materialsX;
+				evaluation.OutMaterials[1] = materialsY;
+				evaluation.OutMaterials[2] = materialsZ;
+				evaluation.OutMaterials[3] = materialsW;
+				m_PacketEvaluator.Evaluate(evaluation);
+
+				voxelIndex = 0;
+				for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+				for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+				for (UINT x = 0; x < SDF_BRICK_SIZE_VOXELS_ADJACENCY; x++)
+				{
+					float4 materials(materialsX[voxelIndex], materialsY[voxelIndex], materialsZ[voxelIndex], materialsW[voxelIndex]);
+					if (length(materials) == 0.0f)
+						materials = float4(1.0f, 0.0f, 0.0f, 0.0f);
+
+					// Make sure the sum of components = 1
+					materials = materials / (materials.x + materials.y + materials.z + materials.w);
+
+					const float formattedDistance = BrickHelpers::FormatDistance(distances[voxelIndex], voxelsPerUnit);
+					if (m_EnableReferenceDistances)
+						outData.ReferenceDistances.at(static_cast<size_t>(brickIndex) * s_VoxelsPerBrick + voxelIndex) = formattedDistance;
+					voxelIndex++;
+
+					// Store the voxel in the brick pool
+					// As the sum of all components of materials == 1, materials.w can be recovered as 1 - materials.xyz
+					const size_t voxel = (static_cast<size_t>(brickTopLeft.z + z) * resolution.y + (brickTopLeft.y + y)) * resolution.x + (brickTopLeft.x + x);
+					INT8* texel = outData.BrickPool.data() + 4 * voxel;
+					texel[0] = BrickHelpers::FloatToSNORM8(formattedDistance);
+					texel[1] = BrickHelpers::FloatToSNORM8(materials.x);
+					texel[2] = BrickHelpers::FloatToSNORM8(materials.y);
+					texel[3] = BrickHelpers::FloatToSNORM8(materials.z);
+				}
+			}
+		});
+
+	if (useCache)
+		CacheEvaluatedBricks(outData);
+}
+
+
+void SDFFactoryCPU::FindCachedBricks(const SDFBakeData& data)
+{
+	const UINT brickCount = data.GetBrickCount();
+	const UINT editCount = m_BuildParams.SDFEditCount;
+
+	// Without culling every brick is evaluated with every edit
+	UINT64 allEditsHash = Hash::s_Seed;
+	if (!m_EnableEditCulling)
+	{
+		for (UINT i = 0; i < editCount; i++)
+			allEditsHash = Hash::Value(m_EditHashes.at(i), allEditsHash);
+	}
+
+	m_BrickKeys.resize(brickCount);
+	m_ThreadPool->ParallelFor(0, brickCount, s_CacheKeyGrainSize, [&](UINT begin, UINT end)
+		{
+			for (UINT brickIndex = begin; brickIndex < end; brickIndex++)
+			{
+				const Brick& brick = data.Bricks.at(brickIndex);
+
+				UINT64 editsHash = allEditsHash;
+				if (m_EnableEditCulling)
+				{
+					for (UINT i = 0; i < brick.IndexCount; i++)
+						editsHash = Hash::Value(m_EditHashes.at(data.Indices.at(brick.IndexOffset + i)), editsHash);
+				}
+
+				m_BrickKeys.at(brickIndex) = SDFBrickCache::BuildKey(brick.TopLeft, data.BrickSize, editsHash);
+			}
+		});
+
+	// The cache is not thread safe, so is only accessed between the parallel stages
+	m_CachedBricks.resize(brickCount);
+	for (UINT brickIndex = 0; brickIndex < brickCount; brickIndex++)
+	{
+		m_CachedBricks.at(brickIndex) = m_BrickCache.Find(m_BrickKeys.at(brickIndex));
+	}
+}
+
+void SDFFactoryCPU::CacheEvaluatedBricks(const SDFBakeData& data)
+{
+	const XMUINT3 resolution = data.GetBrickPoolResolution();
+
+	SDFBrickCache::BrickVoxels voxels;
+	for (UINT brickIndex = 0; brickIndex < data.GetBrickCount(); brickIndex++)
+	{
+		if (m_CachedBricks.at(brickIndex))
+			continue;
+
+		// Gather the brick out of the pool
+		const XMUINT3 brickTopLeft = BrickHelpers::CalculateBrickPoolPosition(data.Bricks.at(brickIndex).PoolSlot, data.BrickPoolDimensions, data.PoolPlacement);
+		INT8* dest = voxels.data();
+		for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+		for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+		{
+			const size_t voxel = (static_cast<size_t>(brickTopLeft.z + z) * resolution.y + (brickTopLeft.y + y)) * resolution.x + brickTopLeft.x;
+			memcpy(dest, data.BrickPool.data() + 4 * voxel, 4 * SDF_BRICK_SIZE_VOXELS_ADJACENCY);
+			dest += 4 * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+		}
+
+		m_BrickCache.Insert(m_BrickKeys.at(brickIndex), voxels);
+	}
+
+	// Inserting may have evicted bricks that were found
+	m_CachedBricks.clear();
+}
+
+
+void SDFFactoryCPU::DeduplicateBricks(SDFBakeData& outData, bool fitBrickPool)
+{
+	const UINT brickCount = outData.GetBrickCount();
+	if (brickCount == 0)
+		return;
+
+	const XMUINT3 resolution = outData.GetBrickPoolResolution();
+	constexpr size_t rowBytes = 4 * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+
+	// The byte offset of a row of a brick in a pool
+	auto getRowOffset = [](const XMUINT3& poolResolution, const XMUINT3& brickTopLeft, UINT y, UINT z)
+		{
+			const size_t voxel = (static_cast<size_t>(brickTopLeft.z + z) * poolResolution.y + (brickTopLeft.y + y)) * poolResolution.x + brickTopLeft.x;
+			return 4 * voxel;
+		};
+
+	// Hash the voxels of every brick
+	m_BrickContentHashes.resize(brickCount);
+	m_ThreadPool->ParallelFor(0, brickCount, s_DeduplicationGrainSize, [&](UINT begin, UINT end)
+		{
+			for (UINT brickIndex = begin; brickIndex < end; brickIndex++)
+			{
+				const XMUINT3 brickTopLeft = BrickHelpers::CalculateBrickPoolPosition(outData.Bricks.at(brickIndex).PoolSlot, outData.BrickPoolDimensions, outData.PoolPlacement);
+
+				UINT64 hash = Hash::s_Seed;
+				for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+				for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+				{
+					hash = Hash::Bytes(outData.BrickPool.data() + getRowOffset(resolution, brickTopLeft, y, z), rowBytes, hash);
+				}
+				m_BrickContentHashes.at(brickIndex) = hash;
+			}
+		});
+
+	auto voxelsMatch = [&](UINT brickA, UINT brickB)
+		{
+			const XMUINT3 topLeftA = BrickHelpers::CalculateBrickPoolPosition(outData.Bricks.at(brickA).PoolSlot, outData.BrickPoolDimensions, outData.PoolPlacement);
+			const XMUINT3 topLeftB = BrickHelpers::CalculateBrickPoolPosition(outData.Bricks.at(brickB).PoolSlot, outData.BrickPoolDimensions, outData.PoolPlacement);
+			const INT8* pool = outData.BrickPool.data();
+			for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+			for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+			{
+				if (memcmp(pool + getRowOffset(resolution, topLeftA, y, z), pool + getRowOffset(resolution, topLeftB, y, z), rowBytes) != 0)
+					return false;
+			}
+			return true;
+		};
+
+	// Slots are assigned in brick order so that the output is deterministic
+	// Bricks with the same hash are compared voxel by voxel, so a collision can never share a slot
+	std::vector<UINT> slots(brickCount);
+	m_UniqueBricks.clear();
+	m_SlotLookup.clear();
+	for (UINT brickIndex = 0; brickIndex < brickCount; brickIndex++)
+	{
+		const UINT64 hash = m_BrickContentHashes.at(brickIndex);
+
+		UINT slot = static_cast<UINT>(m_UniqueBricks.size());
+		const auto [first, last] = m_SlotLookup.equal_range(hash);
+		for (auto it = first; it != last; ++it)
+		{
+			if (voxelsMatch(brickIndex, m_UniqueBricks.at(it->second)))
+			{
+				slot = it->second;
+				break;
+			}
+		}
+
+		if (slot == m_UniqueBricks.size())
+		{
+			m_UniqueBricks.push_back(brickIndex);
+			m_SlotLookup.emplace(hash, slot);
+		}
+		slots.at(brickIndex) = slot;
+	}
+
+	const UINT slotCount = static_cast<UINT>(m_UniqueBricks.size());
+	if (slotCount == brickCount)
+		return;
+
+	// Compact the pool so that it only contains the deduplicated slots
+	const XMUINT3 dimensions = fitBrickPool ? SDFObject::CalculateBrickPoolDimensions(slotCount) : outData.BrickPoolDimensions;
+	const XMUINT3 compactResolution = {
+		dimensions.x * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+		dimensions.y * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+		dimensions.z * SDF_BRICK_SIZE_VOXELS_ADJACENCY
+	};
+	std::vector<INT8> compactPool(4ull * compactResolution.x * compactResolution.y * compactResolution.z, 0);
+
+	m_ThreadPool->ParallelFor(0, slotCount, s_DeduplicationGrainSize, [&](UINT begin, UINT end)
+		{
+			for (UINT slot = begin; slot < end; slot++)
+			{
+				const XMUINT3 srcTopLeft = BrickHelpers::CalculateBrickPoolPosition(outData.Bricks.at(m_UniqueBricks.at(slot)).PoolSlot, outData.BrickPoolDimensions, outData.PoolPlacement);
+				const XMUINT3 destTopLeft = BrickHelpers::CalculateBrickPoolPosition(slot, dimensions, outData.PoolPlacement);
+				for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+				for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+				{
+					memcpy(compactPool.data() + getRowOffset(compactResolution, destTopLeft, y, z), outData.BrickPool.data() + getRowOffset(resolution, srcTopLeft, y, z), rowBytes);
+				}
+			}
+		});
+
+	for (UINT brickIndex = 0; brickIndex < brickCount; brickIndex++)
+	{
+		outData.Bricks.at(brickIndex).PoolSlot = slots.at(brickIndex);
+	}
+	outData.BrickPool = std::move(compactPool);
+	outData.BrickPoolDimensions = dimensions;
+}
+
+
+float SDFFactoryCPU::EvaluateEditList(const Brick& brick, const UINT* indices, const XMFLOAT3& p) const
+{
+	const UINT editCount = m_EnableEditCulling ? brick.IndexCount : m_BuildParams.SDFEditCount;
+
+	// Evaluate SDF list
+	float nearest = FLT_MAX;
+
+	for (UINT i = 0; i < editCount; i++)
+	{
+		// Load the edit index
+		const UINT index = m_EnableEditCulling ? indices[brick.IndexOffset + i] : i;
+		const SDFEditData& edit = m_Edits.at(index);
+
+		// combine with scene
+		nearest = opPrimitive(nearest, EvaluateEdit(edit, p), GetOperation(edit.EditParams), edit.BlendingRange);
+	}
+
+	return nearest;
+}
+
+SDFIntervalHelpers::Interval SDFFactoryCPU::EvaluateEditListInterval(const Brick& brick, const UINT* indices, const SDFIntervalHelpers::IntervalBox& box) const
+{
+	const UINT editCount = m_EnableEditCulling ? brick.IndexCount : m_BuildParams.SDFEditCount;
+
+	SDFIntervalHelpers::Interval nearest(FLT_MAX);
+
+	for (UINT i = 0; i < editCount; i++)
+	{
+		const UINT index = m_EnableEditCulling ? indices[brick.IndexOffset + i] : i;
+		const SDFEditData& edit = m_Edits.at(index);
+
+		nearest = SDFIntervalHelpers::opPrimitive(nearest, SDFIntervalHelpers::EvaluateEdit(edit, box), GetOperation(edit.EditParams), edit.BlendingRange);
+	}
+
+	return nearest;
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "Core.h"
+
+#include "Framework/GameTimer.h"
+#include "Framework/PrefixScan.h"
+#include "Framework/ThreadPool.h"
+#include "HlslCompat/ComputeHlslCompat.h"
+#include "SDF/SDFBakeData.h"
+#include "SDF/SDFEditDependencies.h"
+#include "SDF/SDFEditListSoA.h"
+#include "SDF/CPU/SDFBrickCache.h"
+#include "SDF/CPU/SDFEditBVH.h"
+#include "SDF/CPU/SDFIntervalHelpers.h"
+#include "SDF/CPU/SDFPacketEvaluator.h"
+
+#include <unordered_map>
+
+
+class SDFEditList;
+
+
+namespace BrickCullingMode
+{
+	enum Value
+	{
+		// Sample the field at the centre of a brick, as the GPU factory does
+		PointSample = 0,
+		// Bound the field over the whole brick with interval arithmetic
+		// This removes bricks and edits that point sampling has to keep, but will not match the GPU factory
+		Interval,
+		Count
+	};
+}
+
+
+// A CPU implementation of the hierarchical SDF factory
+// Every stage of the GPU factory is reproduced on a work-stealing thread pool,
+// and each stage follows its compute shader so that the output is the same as the GPU factory's.
+// This requires no graphics device, so can be used for headless baking and for validating the GPU factory.
+class SDFFactoryCPU
+{
+public:
+	// Timings of the most recent bake, in milliseconds
+	struct BakeTimings
+	{
+		float EditDependencies = 0.0f;
+		float EditBVH = 0.0f;
+		float BrickBuilding = 0.0f;
+		float AABBBuilding = 0.0f;
+		float BrickEvaluation = 0.0f;
+		float BrickDeduplication = 0.0f;
+		float Total = 0.0f;
+	};
+
+public:
+	// A thread count of 0 will use every hardware thread
+	SDFFactoryCPU(UINT threadCount = 0);
+	~SDFFactoryCPU() = default;
+
+	DISALLOW_COPY(SDFFactoryCPU)
+	DEFAULT_MOVE(SDFFactoryCPU)
+
+	// Bakes the edit list into bricks of size brickSize
+	// The brick pool will be sized to fit the bricks in the same way as SDFObject
+	void BakeSDF(const SDFEditList& editList, float brickSize, SDFBakeData& outData);
+	// Bakes into a brick pool of the specified dimensions, which must be able to contain every brick
+	// Useful to reproduce the layout of an object's existing brick pool
+	void BakeSDF(const SDFEditList& editList, float brickSize, const XMUINT3& brickPoolDimensions, SDFBakeData& outData);
+
+	inline void SetMaxBrickBuildIterations(UINT maxIterations) { m_MaxBrickBuildIterations = maxIterations; }
+	inline UINT GetMaxBrickBuildIterations() const { return m_MaxBrickBuildIterations; }
+
+	// Equivalent to the NoEditCulling pipeline set of the GPU factory
+	inline void SetEditCullingEnabled(bool enabled) { m_EnableEditCulling = enabled; }
+	inline bool GetEditCullingEnabled() const { return m_EnableEditCulling; }
+
+	// Edit testing queries a BVH over the edits for the edits near each brick, instead of testing every edit the brick inherited
+	// The BVH only removes edits that cannot be relevant, so this does not change the output
+	inline void SetEditBVHEnabled(bool enabled) { m_EnableEditBVH = enabled; }
+	inline bool GetEditBVHEnabled() const { return m_EnableEditBVH; }
+
+	inline void SetCullingMode(BrickCullingMode::Value mode) { m_CullingMode = mode; }
+	inline BrickCullingMode::Value GetCullingMode() const { return m_CullingMode; }
+
+	// Brick evaluation uses the highest SIMD level supported by the CPU by default
+	// Cached bricks may have been evaluated at a different level, so changing it clears the brick cache
+	inline void SetSIMDLevel(SIMDLevel::Value level) { m_PacketEvaluator = SDFPacketEvaluator(level); m_BrickCache.Clear(); }
+	inline SIMDLevel::Value GetSIMDLevel() const { return m_PacketEvaluator.GetLevel(); }
+
+	// Brick evaluation copies bricks whose position, size and edits match a brick from a previous bake
+	// This is disabled by default, as repeated bakes of the same edit list would only measure the cache
+	inline void SetBrickCacheEnabled(bool enabled) { m_EnableBrickCache = enabled; }
+	inline bool GetBrickCacheEnabled() const { return m_EnableBrickCache; }
+	inline SDFBrickCache& GetBrickCache() { return m_BrickCache; }
+	inline const SDFBrickCache& GetBrickCache() const { return m_BrickCache; }
+
+	// Brick evaluation also outputs the unquantized distance of every voxel to SDFBakeData::ReferenceDistances
+	// Cached bricks have no unquantized distances, so the brick cache is not used while this is enabled
+	inline void SetReferenceDistancesEnabled(bool enabled) { m_EnableReferenceDistances = enabled; }
+	inline bool GetReferenceDistancesEnabled() const { return m_EnableReferenceDistances; }
+
+	// After evaluation, bricks with identical voxels are given the same pool slot, and the pool is compacted to the slots that are used
+	// If the bake was given brick pool dimensions the pool keeps them, otherwise it is shrunk to fit the slots
+	inline void SetBrickDeduplicationEnabled(bool enabled) { m_EnableBrickDeduplication = enabled; }
+	inline bool GetBrickDeduplicationEnabled() const { return m_EnableBrickDeduplication; }
+
+	inline void SetBrickPoolPlacement(BrickPoolPlacement::Value placement) { m_BrickPoolPlacement = placement; }
+	inline BrickPoolPlacement::Value GetBrickPoolPlacement() const { return m_BrickPoolPlacement; }
+
+	inline UINT GetThreadCount() const { return m_ThreadPool->GetThreadCount(); }
+	inline const BakeTimings& GetLastBakeTimings() const { return m_Timings; }
+
+private:
+	// SDF Bake stages
+	// Each corresponds to the compute shader of the same stage in the GPU factory
+	void BuildEditDependencies();
+	void BuildInitialBricks();
+	void CountSubBricks();														// sub_brick_counter.hlsl
+	void ScanSubBrickCounts();													// prefix_sum/*.hlsl
+	void BuildSubBricks();														// sub_brick_builder.hlsl
+	void TestEdits();															// edit_tester.hlsl
+	void SwapBuffersAndRefineBrickSize();
+	void BuildAABBs(SDFBakeData& outData) const;								// aabb_builder.hlsl
+	void EvaluateBricks(SDFBakeData& outData);									// brick_evaluator.hlsl
+	void DeduplicateBricks(SDFBakeData& outData, bool fitBrickPool);
+
+	// Finds the cache key of every brick, and the bricks that are already in the cache
+	void FindCachedBricks(const SDFBakeData& data);
+	// Adds the bricks that were evaluated to the cache
+	void CacheEvaluatedBricks(const SDFBakeData& data);
+
+	// Evaluates every edit in the brick (or every edit if culling is disabled) at a point
+	float EvaluateEditList(const Brick& brick, const UINT* indices, const XMFLOAT3& p) const;
+	// Bounds the same over a box
+	SDFIntervalHelpers::Interval EvaluateEditListInterval(const Brick& brick, const UINT* indices, const SDFIntervalHelpers::IntervalBox& box) const;
+
+	inline std::vector<Brick>& GetReadBricks() { return m_Bricks.at(m_CurrentReadBuffers); }
+	inline std::vector<Brick>& GetWriteBricks() { return m_Bricks.at(1 - m_CurrentReadBuffers); }
+	inline std::vector<UINT>& GetReadIndices() { return m_Indices.at(m_CurrentReadBuffers); }
+	inline std::vector<UINT>& GetWriteIndices() { return m_Indices.at(1 - m_CurrentReadBuffers); }
+
+private:
+	std::unique_ptr<ThreadPool> m_ThreadPool;
+	std::unique_ptr<PrefixScan> m_PrefixScan;
+	SDFPacketEvaluator m_PacketEvaluator;
+
+	UINT m_MaxBrickBuildIterations = -1;
+	bool m_EnableEditCulling = true;
+	bool m_EnableEditBVH = true;
+	bool m_EnableBrickCache = false;
+	bool m_EnableReferenceDistances = false;
+	bool m_EnableBrickDeduplication = false;
+	BrickPoolPlacement::Value m_BrickPoolPlacement = BrickPoolPlacement::Linear;
+	BrickCullingMode::Value m_CullingMode = BrickCullingMode::PointSample;
+
+	GameTimer m_Timer;
+	BakeTimings m_Timings;
+
+	// Construction data
+	// These are the CPU equivalent of SDFConstructionResources, and are kept between bakes to avoid re-allocation
+	BrickBuildParametersConstantBuffer m_BuildParams;
+	float m_VoxelSize = 0.0f;				// The size of a voxel in the bricks that will be output
+	std::vector<SDFEditData> m_Edits;
+	std::vector<UINT64> m_EditHashes;
+	SDFEditListSoA m_EditsSoA;				// Decoded copy of the edits for the culling loops
+	SDFEditDependencies m_EditDependencies;
+	SDFEditBVH m_EditBVH;
+
+	UINT m_CurrentReadBuffers = 0;
+	std::array<std::vector<Brick>, 2> m_Bricks;
+	std::array<std::vector<UINT>, 2> m_Indices;
+
+	std::vector<UINT> m_SubBrickCounts;
+	std::vector<UINT> m_PrefixSums;
+
+	// The edits relevant to each brick, before they are compacted into the index buffer
+	std::vector<std::vector<UINT>> m_BrickEdits;
+
+	SDFBrickCache m_BrickCache;
+	// The cache key of each brick, and its cached voxels if it was found in the cache
+	std::vector<UINT64> m_BrickKeys;
+	std::vector<const INT8*> m_CachedBricks;
+
+	// Deduplication data
+	std::vector<UINT64> m_BrickContentHashes;
+	std::vector<UINT> m_UniqueBricks;		// The brick whose voxels fill each deduplicated slot
+	std::unordered_multimap<UINT64, UINT> m_SlotLookup;
+};
@@ -9,6 +9,8 @@
 
 #include "HlslCompat/ComputeHlslCompat.h"
 
+#include "SDF/SDFBakeFile.h"
+#include "SDF/SDFBrickPageFile.h"
 #include "SDF/SDFEditList.h"
 #include "SDF/SDFObject.h"
 
@@ -19,17 +21,6 @@
 #include "Renderer/Profiling/GPUProfiler.h"
 
 
-namespace EditDependencySignature
-{
-	enum Value
-	{
-		ParametersSlot = 0,
-		EditListSlot,
-		DependencyIndicesSlot,
-		Count
-	};
-}
-
 namespace BrickCounterSignature
 {
 	enum Value
@@ -88,10 +79,12 @@ namespace EditTesterSignature
 		BuildParameterSlot = 0,
 		EditListSlot,
 		InIndexBufferSlot,
-		EditDependenciesSlot,
+		EditDependencyIndicesSlot,
+		EditDependencyOffsetsSlot,
 		BrickSlot,
 		OutIndexBufferSlot,
 		OutIndexCounterSlot,
+		OutIndexOverflowSlot,
 		Count
 	};
 }
@@ -107,6 +100,33 @@ namespace AABBBuilderSignature
 	};
 }
 
+namespace BrickReleaserSignature
+{
+	enum Value
+	{
+		IncrementalParameterSlot = 0,
+		BricksSlot,
+		FreeBricksSlot,
+		FreeBrickCounterSlot,
+		ReleasedIndexCounterSlot,
+		Count
+	};
+}
+
+namespace BrickMergerSignature
+{
+	enum Value
+	{
+		IncrementalParameterSlot = 0,
+		NewBricksSlot,
+		FreeBricksSlot,
+		BricksSlot,
+		AABBsSlot,
+		BrickSlotsSlot,
+		Count
+	};
+}
+
 namespace BrickEvaluatorSignature
 {
 	enum Value
@@ -116,23 +136,89 @@ namespace BrickEvaluatorSignature
 		EditListSlot,
 		IndexBufferSlot,
 		BrickBufferSlot,
+		BrickSlotsSlot,
 		BrickPoolSlot,
 		Count
 	};
 }
 
 
+// Whether the write resources of an object can be updated by only rebuilding the bricks within a region
+static bool CanBakeIncrementally(const SDFObject* object, const SDFDirtyRegion& region, float evalSpaceSize)
+{
+	if (region.IsEverything() || object->GetBrickCount(SDFObject::RESOURCES_WRITE) == 0)
+		return false;
+
+	// The existing bricks must lie on the same grid as the bricks that will be built
+	if (object->GetBrickSize(SDFObject::RESOURCES_WRITE) != object->GetNextRebuildBrickSize()
+		|| object->GetEvalSpaceSize(SDFObject::RESOURCES_WRITE) != evalSpaceSize)
+		return false;
+
+	// The existing bricks must be in the same places in the pool as the bricks that will be evaluated
+	if (object->GetBrickPoolPlacement(SDFObject::RESOURCES_WRITE) != object->GetNextBrickPoolPlacement())
+		return false;
+
+	// Releasing a shared slot would change the bricks outside of the region that still use it
+	if (object->HasSharedPoolSlots(SDFObject::RESOURCES_WRITE))
+		return false;
+
+	// The indices of released bricks are only reclaimed by a full bake
+	if (2 * object->GetReleasedIndexCount(SDFObject::RESOURCES_WRITE) > object->GetIndexCount(SDFObject::RESOURCES_WRITE))
+		return false;
+
+	return true;
+}
+
+// Expands a region by how far beyond it the bricks can change, and then snaps it outwards to the centres of the
+// final bricks so that the bricks built within the region and the bricks released from the object are always the same
+static void SnapRegionToBricks(const SDFDirtyRegion& region, float evalSpaceSize, float brickSize, XMFLOAT3& outMin, XMFLOAT3& outMax)
+{
+	// Whether a brick exists depends on the distance at its centre being within a brick size of the surface,
+	// and its voxels extend half a voxel beyond it
+	const float padding = brickSize + brickSize / SDF_BRICK_SIZE_VOXELS;
+	const float origin = -0.5f * evalSpaceSize;
+
+	auto snap = [origin, brickSize](float v)
+		{
+			return origin + (std::floor((v - origin) / brickSize) + 0.5f) * brickSize;
+		};
+
+	outMin = { snap(region.GetMin().x - padding), snap(region.GetMin().y - padding), snap(region.GetMin().z - padding) };
+	outMax = { snap(region.GetMax().x + padding), snap(region.GetMax().y + padding), snap(region.GetMax().z + padding) };
+}
+
+// Finds the smallest bricks that brick building can start from when only the region is rebuilt
+// Seed bricks must be few enough to dispatch, and at least one iteration must remain to refine them
+// Returns the number of iterations that starting from the seed bricks skips, or 0 to start from the root bricks
+static UINT FindSeedBrickSize(const XMFLOAT3& regionMin, const XMFLOAT3& regionMax, float evalSpaceSize, float brickSize, UINT maxSeedCount, UINT maxIterations, float& outSeedBrickSize)
+{
+	outSeedBrickSize = evalSpaceSize / 4.0f;
+
+	UINT skippedIterations = 0;
+	UINT seedMin[3], seedMax[3];
+	while (skippedIterations + 1 < maxIterations)
+	{
+		const float nextBrickSize = outSeedBrickSize / 4.0f;
+		if (nextBrickSize / 4.0f < brickSize)
+			break;
+		if (SDFConstructionResources::CalculateSeedRange(regionMin, regionMax, evalSpaceSize, nextBrickSize, seedMin, seedMax) > maxSeedCount)
+			break;
+
+		outSeedBrickSize = nextBrickSize;
+		skippedIterations++;
+	}
+
+	return skippedIterations;
+}
+
+
+
 SDFFactoryHierarchical::SDFFactoryHierarchical()
 {
 	const auto device = g_D3DGraphicsContext->GetDevice();
 
-	// Create command allocator and list
-	THROW_IF_FAIL(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&m_CommandAllocator)));
-	m_CommandAllocator->SetName(L"Hierarchical Factory Command Allocator");
-	THROW_IF_FAIL(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, m_CommandAllocator.Get(), nullptr, IID_PPV_ARGS(&m_CommandList)));
-	m_CommandList->SetName(L"Hierarchical Factory Command List");
-
-	THROW_IF_FAIL(m_CommandList->Close());
+	// Create command allocators, lists and construction resources
+	CreateContexts(m_RequestedPipelineDepth);
 
 	// Create indirect execution objects
 	{
@@ -174,20 +260,20 @@ SDFFactoryHierarchical::SDFFactoryHierarchical()
 	// Allocate and populate upload buffers
 	{
 		m_CounterUploadZero.Allocate(device, 1, 0, L"Counters Upload Zero");
-		// One counter needs to be able to be reset to 64
-		m_CounterUpload64.Allocate(device, 1, 0, L"Counters Upload 64");
-
 		m_CounterUploadZero.CopyElement(0, 0);
-		m_CounterUpload64.CopyElement(0, 64);
 	}
 
-	CreatePipelineSet(L"Default", {});
-	CreatePipelineSet(L"NoEditCulling", { L"DISABLE_EDIT_CULLING" });
+	THROW_IF_FALSE(CreatePipelineSet(L"Default", {}), "The default pipeline set could not be created!");
+	// Only needed once edit culling is disabled, so it is created in the background
+	CreatePipelineSetAsync(L"NoEditCulling", { L"DISABLE_EDIT_CULLING" });
 }
 
 
-void SDFFactoryHierarchical::BakeSDFSync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList)
+void SDFFactoryHierarchical::BakeSDFSync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion* dirtyRegion)
 {
+	// The region is recorded even if the bake cannot be performed now, so that it is rebuilt by the next bake
+	object->InvalidateRegion(dirtyRegion ? *dirtyRegion : SDFDirtyRegion::Everything());
+
 	// Check object is not being constructed anywhere else
 	// It's okay if the resource is in the switching state - we're going to wait on the render queue anyway
 	const auto state = object->GetResourcesState(SDFObject::RESOURCES_WRITE);
@@ -196,6 +282,7 @@ void SDFFactoryHierarchical::BakeSDFSync(const std::wstring& pipelineName, SDFOb
 		LOG_TRACE("Object in use by async bake - sync bake cannot be performed.");
 		return;
 	}
+	OnSyncBakeAccepted(pipelineName, object, editList);
 
 	LOG_TRACE("-----SDF Factory Synchronous Bake Begin--------");
 	PIXBeginEvent(PIX_COLOR_INDEX(12), L"SDF Bake Synchronous");
@@ -212,7 +299,7 @@ void SDFFactoryHierarchical::BakeSDFSync(const std::wstring& pipelineName, SDFOb
 	// Make the compute queue wait until the render queue has finished its work
 	computeQueue->InsertWaitForQueue(directQueue);
 
-	PerformSDFBake_CPUBlocking(pipelineName, object, editList);
+	PerformSDFBake_CPUBlocking(pipelineName, object, editList, object->TakeStaleRegion(SDFObject::RESOURCES_WRITE));
 
 	// The rendering queue should wait until these operations have completed
 	directQueue->InsertWaitForQueue(computeQueue);
@@ -229,270 +316,1097 @@ void SDFFactoryHierarchical::BakeSDFSync(const std::wstring& pipelineName, SDFOb
 }
 
 
-void SDFFactoryHierarchical::CreatePipelineSet(const std::wstring& name, const std::vector<std::wstring>& defines)
+void SDFFactoryHierarchical::BakeSDFBatchSync(const std::wstring& pipelineName, const std::vector<BatchItem>& items)
 {
-	ASSERT(m_Pipelines.find(name) == m_Pipelines.end(), "Pipeline already exists with that name!");
-
-	m_Pipelines.emplace(name, PipelineSet{});
-	PipelineSet& pipelineSet = m_Pipelines.at(name);
+	std::vector<BakeJob> jobs;
+	jobs.reserve(items.size());
 
+	for (const auto& item : items)
 	{
-		using namespace EditDependencySignature;
-
-		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
-		rootParams[ParametersSlot].InitAsConstants(SizeOfInUint32(EditDependencyParameters), 0);
-		rootParams[EditListSlot].InitAsUnorderedAccessView(0);
-		rootParams[DependencyIndicesSlot].InitAsUnorderedAccessView(1);
+		item.Object->InvalidateRegion(item.DirtyRegion ? *item.DirtyRegion : SDFDirtyRegion::Everything());
 
-		D3DComputePipelineDesc desc;
-		desc.NumRootParameters = ARRAYSIZE(rootParams);
-		desc.RootParameters = rootParams;
-		desc.Shader = L"assets/shaders/compute/edit_dependency.hlsl";
-		desc.EntryPoint = L"main";
-		desc.Defines = defines;
+		const auto state = item.Object->GetResourcesState(SDFObject::RESOURCES_WRITE);
+		if (!(state == SDFObject::READY_COMPUTE || state == SDFObject::SWITCHING))
+		{
+			LOG_TRACE("Object in use by async bake - it will not be included in the batch.");
+			continue;
+		}
+		OnSyncBakeAccepted(pipelineName, item.Object, *item.EditList);
 
-		pipelineSet[SDFFactoryPipeline::EditDependency] = std::make_unique<D3DComputePipeline>(&desc);
+		BakeJob job;
+		job.Object = item.Object;
+		job.EditList = item.EditList;
+		jobs.push_back(std::move(job));
 	}
 
-	{
-		using namespace BrickCounterSignature;
-
-		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
-		rootParams[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickBuildParametersConstantBuffer), 0);
-		rootParams[BrickCounterSlot].InitAsShaderResourceView(0);
-		rootParams[EditListSlot].InitAsShaderResourceView(1);
-		rootParams[IndexBufferSlot].InitAsShaderResourceView(2);
-		rootParams[BricksSlot].InitAsUnorderedAccessView(0);
-		rootParams[CountTableSlot].InitAsUnorderedAccessView(1);
+	if (jobs.empty())
+		return;
 
-		D3DComputePipelineDesc desc;
-		desc.NumRootParameters = ARRAYSIZE(rootParams);
-		desc.RootParameters = rootParams;
-		desc.Shader = L"assets/shaders/compute/sub_brick_counter.hlsl";
-		desc.EntryPoint = L"main";
-		desc.Defines = defines;
+	LOG_TRACE("-----SDF Factory Synchronous Batch Bake Begin--------");
+	PIXBeginEvent(PIX_COLOR_INDEX(12), L"SDF Batch Bake Synchronous");
 
-		pipelineSet[SDFFactoryPipeline::BrickCounter] = std::make_unique<D3DComputePipeline>(&desc);
+	for (auto& job : jobs)
+	{
+		job.Object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTING);
+		job.StaleRegion = job.Object->TakeStaleRegion(SDFObject::RESOURCES_WRITE);
 	}
 
-	{
-		using namespace ScanThreadGroupCalculatorSignature;
+	const auto directQueue = g_D3DGraphicsContext->GetDirectCommandQueue();
+	const auto computeQueue = g_D3DGraphicsContext->GetComputeCommandQueue();
 
-		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
-		rootParams[BrickCounterSlot].InitAsShaderResourceView(0);
-		rootParams[IndirectCommandArgumentSlot].InitAsUnorderedAccessView(0);
+	PIXBeginEvent(PIX_COLOR_INDEX(14), L"Wait for previous bake");
+	computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+	PIXEndEvent();
+	computeQueue->InsertWaitForQueue(directQueue);
 
-		D3DComputePipelineDesc desc;
-		desc.NumRootParameters = ARRAYSIZE(rootParams);
-		desc.RootParameters = rootParams;
-		desc.Shader = L"assets/shaders/compute/scan_thread_group_calculator.hlsl";
-		desc.EntryPoint = L"main";
-		desc.Defines = defines;
+	PerformSDFBatchBake_CPUBlocking(pipelineName, jobs);
 
-		pipelineSet[SDFFactoryPipeline::ScanGroupCountCalculator] = std::make_unique<D3DComputePipeline>(&desc);
-	}
+	directQueue->InsertWaitForQueue(computeQueue);
+
+	PIXBeginEvent(PIX_COLOR_INDEX(13), L"Wait for bake completion");
+	computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+	PIXEndEvent();
 
+	for (const auto& job : jobs)
 	{
-		using namespace BrickScanSignature;
+		job.Object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTED);
+	}
 
-		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
-		rootParams[CountTableSlot].InitAsShaderResourceView(0);
-		rootParams[NumberOfCountsSlot].InitAsShaderResourceView(1);
-		rootParams[BlockPrefixSumTableSlot].InitAsUnorderedAccessView(0);
-		rootParams[BlockPrefixSumOutputTableSlot].InitAsUnorderedAccessView(1);
-		rootParams[PrefixSumTableSlot].InitAsUnorderedAccessView(2);
+	PIXEndEvent();
+	LOG_TRACE("-----SDF Factory Synchronous Batch Bake Complete-----");
+}
 
-		D3DComputePipelineDesc desc;
-		desc.NumRootParameters = ARRAYSIZE(rootParams);
-		desc.RootParameters = rootParams;
-		desc.EntryPoint = L"main";
-		desc.Defines = defines;
 
-		desc.Shader = L"assets/shaders/compute/prefix_sum/scan_blocks.hlsl";
-		pipelineSet[SDFFactoryPipeline::ScanBlocks] = std::make_unique<D3DComputePipeline>(&desc);
+void SDFFactoryHierarchical::ReadbackBakeData(SDFObject* object, SDFObject::ResourceGroup res, SDFBakeData& outData)
+{
+	outData.Clear();
 
-		desc.Shader = L"assets/shaders/compute/prefix_sum/scan_block_sums.hlsl";
-		pipelineSet[SDFFactoryPipeline::ScanBlockSums] = std::make_unique<D3DComputePipeline>(&desc);
+	const auto device = g_D3DGraphicsContext->GetDevice();
+	const auto computeQueue = g_D3DGraphicsContext->GetComputeCommandQueue();
 
-		desc.Shader = L"assets/shaders/compute/prefix_sum/sum_scans.hlsl";
-		pipelineSet[SDFFactoryPipeline::SumScans] = std::make_unique<D3DComputePipeline>(&desc);
-	}
+	// Make sure any previous bake has completed
+	computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
 
-	{
-		using namespace BrickBuilderSignature;
+	const UINT brickCount = object->GetBrickCount(res);
+	outData.BrickSize = object->GetBrickSize(res);
+	outData.EvalSpaceSize = object->GetEvalSpaceSize(res);
+	outData.BrickPoolDimensions = object->GetBrickPoolDimensions(res);
+	outData.PoolPlacement = object->GetBrickPoolPlacement(res);
+	if (brickCount == 0)
+		return;
 
-		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
-		rootParams[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickBuildParametersConstantBuffer), 0);
-		rootParams[InBrickCounterSlot].InitAsShaderResourceView(0);
-		rootParams[InBricksSlot].InitAsShaderResourceView(1);
-		rootParams[PrefixSumTableSlot].InitAsShaderResourceView(2);
-		rootParams[OutBrickCounterSlot].InitAsUnorderedAccessView(0);
-		rootParams[OutBricksSlot].InitAsUnorderedAccessView(1);
+	ID3D12Resource* brickBuffer = object->GetBrickBuffer(res);
+	ID3D12Resource* aabbBuffer = object->GetAABBBuffer(res);
+	ID3D12Resource* indexBuffer = object->GetIndexBuffer(res);
+	ID3D12Resource* brickPool = object->GetBrickPool(res);
 
-		D3DComputePipelineDesc desc;
-		desc.NumRootParameters = ARRAYSIZE(rootParams);
-		desc.RootParameters = rootParams;
-		desc.Shader = L"assets/shaders/compute/sub_brick_builder.hlsl";
-		desc.EntryPoint = L"main";
-		desc.Defines = defines;
+	// The index buffer may be larger than the number of indices actually used
+	const UINT indexCapacity = static_cast<UINT>(indexBuffer->GetDesc().Width / sizeof(UINT));
 
-		pipelineSet[SDFFactoryPipeline::BrickBuilder] = std::make_unique<D3DComputePipeline>(&desc);
-	}
+	ReadbackBuffer<Brick> brickReadback;
+	brickReadback.Allocate(device, brickCount, 0, L"Brick Readback");
+	ReadbackBuffer<D3D12_RAYTRACING_AABB> aabbReadback;
+	aabbReadback.Allocate(device, brickCount, 0, L"AABB Readback");
+	ReadbackBuffer<UINT> indexReadback;
+	indexReadback.Allocate(device, indexCapacity, 0, L"Index Readback");
 
-	{
-		using namespace EditTesterSignature;
+	// Texture readback must respect the copyable footprint of the brick pool
+	const D3D12_RESOURCE_DESC poolDesc = brickPool->GetDesc();
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT poolFootprint;
+	UINT poolRowCount;
+	UINT64 poolRowSize;
+	UINT64 poolTotalBytes;
+	device->GetCopyableFootprints(&poolDesc, 0, 1, 0, &poolFootprint, &poolRowCount, &poolRowSize, &poolTotalBytes);
 
-		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
-		rootParams[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickBuildParametersConstantBuffer), 0);
-		rootParams[EditListSlot].InitAsShaderResourceView(0);
-		rootParams[InIndexBufferSlot].InitAsShaderResourceView(1);
-		rootParams[EditDependenciesSlot].InitAsShaderResourceView(2);
-		rootParams[BrickSlot].InitAsUnorderedAccessView(0);
-		rootParams[OutIndexBufferSlot].InitAsUnorderedAccessView(1);
-		rootParams[OutIndexCounterSlot].InitAsUnorderedAccessView(2);
+	ReadbackBuffer<BYTE> poolReadback;
+	poolReadback.Allocate(device, static_cast<UINT>(poolTotalBytes), 0, L"Brick Pool Readback");
 
-		D3DComputePipelineDesc desc;
-		desc.NumRootParameters = ARRAYSIZE(rootParams);
-		desc.RootParameters = rootParams;
-		desc.Shader = L"assets/shaders/compute/edit_tester.hlsl";
-		desc.EntryPoint = L"main";
-		desc.Defines = defines;
+	THROW_IF_FAIL(m_CommandAllocator->Reset());
+	THROW_IF_FAIL(m_CommandList->Reset(m_CommandAllocator.Get(), nullptr));
 
-		pipelineSet[SDFFactoryPipeline::EditTester] = std::make_unique<D3DComputePipeline>(&desc);
+	{
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(brickBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(aabbBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(indexBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(brickPool, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
 	}
 
+	m_CommandList->CopyBufferRegion(brickReadback.GetResource(), 0, brickBuffer, 0, static_cast<UINT64>(brickCount) * sizeof(Brick));
+	m_CommandList->CopyBufferRegion(aabbReadback.GetResource(), 0, aabbBuffer, 0, static_cast<UINT64>(brickCount) * sizeof(D3D12_RAYTRACING_AABB));
+	m_CommandList->CopyBufferRegion(indexReadback.GetResource(), 0, indexBuffer, 0, static_cast<UINT64>(indexCapacity) * sizeof(UINT));
+
 	{
-		using namespace AABBBuilderSignature;
+		const CD3DX12_TEXTURE_COPY_LOCATION dest(poolReadback.GetResource(), poolFootprint);
+		const CD3DX12_TEXTURE_COPY_LOCATION src(brickPool, 0);
+		m_CommandList->CopyTextureRegion(&dest, 0, 0, 0, &src, nullptr);
+	}
 
-		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
-		rootParams[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickEvaluationConstantBuffer), 0);
-		rootParams[BricksSlot].InitAsShaderResourceView(0);
-		rootParams[AABBsSlot].InitAsUnorderedAccessView(0);
+	{
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(brickBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(aabbBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(indexBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(brickPool, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
 
-		D3DComputePipelineDesc desc;
-		desc.NumRootParameters = ARRAYSIZE(rootParams);
-		desc.RootParameters = rootParams;
-		desc.Shader = L"assets/shaders/compute/aabb_builder.hlsl";
-		desc.EntryPoint = L"main";
-		desc.Defines = defines;
+	{
+		// Execute work and wait for it to complete
+		THROW_IF_FAIL(m_CommandList->Close());
+		ID3D12CommandList* ppCommandLists[] = { m_CommandList.Get() };
+		m_PreviousWorkFence = computeQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+		computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+	}
 
-		pipelineSet[SDFFactoryPipeline::AABBBuilder] = std::make_unique<D3DComputePipeline>(&desc);
+	outData.Bricks.resize(brickCount);
+	brickReadback.ReadElements(brickCount, outData.Bricks.data());
+	outData.AABBs.resize(brickCount);
+	aabbReadback.ReadElements(brickCount, outData.AABBs.data());
+
+	// Only keep the indices that are referenced by a brick
+	UINT indexCount = 0;
+	for (const auto& brick : outData.Bricks)
+	{
+		if (brick.IndexOffset != SDF_RELEASED_BRICK)
+			indexCount = max(indexCount, brick.IndexOffset + brick.IndexCount);
 	}
+	indexCount = min(indexCount, indexCapacity);
+	outData.Indices.resize(indexCount);
+	if (indexCount > 0)
+		indexReadback.ReadElements(indexCount, outData.Indices.data());
 
 	{
-		using namespace BrickEvaluatorSignature;
+		// Remove the row pitch from the brick pool data
+		std::vector<BYTE> pitchedPool(poolTotalBytes);
+		poolReadback.ReadElements(static_cast<UINT>(poolTotalBytes), pitchedPool.data());
 
-		CD3DX12_DESCRIPTOR_RANGE1 ranges[1];
-		ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+		const XMUINT3 resolution = outData.GetBrickPoolResolution();
+		const size_t tightRowSize = static_cast<size_t>(resolution.x) * 4;
+		ASSERT(tightRowSize == poolRowSize, "Unexpected brick pool format");
 
-		CD3DX12_ROOT_PARAMETER1 rootParameters[Count];
-		rootParameters[GroupOffsetSlot].InitAsConstants(1, 0);
-		rootParameters[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickEvaluationConstantBuffer), 1);
-		rootParameters[EditListSlot].InitAsShaderResourceView(0);
-		rootParameters[IndexBufferSlot].InitAsShaderResourceView(1);
-		rootParameters[BrickBufferSlot].InitAsShaderResourceView(2);
-		rootParameters[BrickPoolSlot].InitAsDescriptorTable(1, &ranges[0]);
+		outData.BrickPool.resize(tightRowSize * resolution.y * resolution.z);
+		for (UINT z = 0; z < resolution.z; z++)
+		for (UINT y = 0; y < resolution.y; y++)
+		{
+			const size_t srcOffset = poolFootprint.Offset + (static_cast<size_t>(z) * poolRowCount + y) * poolFootprint.Footprint.RowPitch;
+			const size_t destOffset = (static_cast<size_t>(z) * resolution.y + y) * tightRowSize;
+			memcpy(outData.BrickPool.data() + destOffset, pitchedPool.data() + srcOffset, tightRowSize);
+		}
+	}
+}
 
-		D3DComputePipelineDesc desc;
-		desc.NumRootParameters = ARRAYSIZE(rootParameters);
-		desc.RootParameters = rootParameters;
-		desc.Shader = L"assets/shaders/compute/brick_evaluator.hlsl";
-		desc.EntryPoint = L"main";
-		desc.Defines = defines;
+bool SDFFactoryHierarchical::LoadBakeFileSync(SDFObject* object, const SDFBakeFile& file)
+{
+	ASSERT(file.IsOpen(), "Bake file is not open!");
 
-		pipelineSet[SDFFactoryPipeline::BrickEvaluator] = std::make_unique<D3DComputePipeline>(&desc);
+	const auto& header = file.GetHeader();
+	if (header.BrickCount == 0)
+	{
+		LOG_WARN("Bake file has no bricks - it will not be loaded.");
+		return false;
 	}
-}
 
+	const auto state = object->GetResourcesState(SDFObject::RESOURCES_WRITE);
+	if (!(state == SDFObject::READY_COMPUTE || state == SDFObject::SWITCHING))
+	{
+		LOG_TRACE("Object in use by async bake - bake file cannot be loaded.");
+		return false;
+	}
 
-void SDFFactoryHierarchical::PerformSDFBake_CPUBlocking(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList)
-{
-	ASSERT(m_Pipelines.find(pipelineName) != m_Pipelines.end(), "Pipeline doesn't exist!");
-	const PipelineSet& pipelineSet = m_Pipelines.at(pipelineName);
+	LOG_TRACE("-----SDF Factory Bake File Load Begin--------");
+	PIXBeginEvent(PIX_COLOR_INDEX(12), L"SDF Bake File Load");
 
-	const UINT maxIterations = m_MaxBrickBuildIterations;
+	object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTING);
 
+	const auto device = g_D3DGraphicsContext->GetDevice();
+	const auto directQueue = g_D3DGraphicsContext->GetDirectCommandQueue();
 	const auto computeQueue = g_D3DGraphicsContext->GetComputeCommandQueue();
 
-	PROFILE_COMPUTE_BEGIN_PASS("SDF Bake");
+	computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+	computeQueue->InsertWaitForQueue(directQueue);
 
-	THROW_IF_FAIL(m_CommandAllocator->Reset());
-	THROW_IF_FAIL(m_CommandList->Reset(m_CommandAllocator.Get(), nullptr));
+	// The file holds a complete bake, so nothing is left to rebuild
+	object->TakeStaleRegion(SDFObject::RESOURCES_WRITE);
+	object->AllocateResourcesForBake(header.BrickPoolDimensions, file.GetPoolPlacement(), header.BrickCount, header.BrickSize, header.EvalSpaceSize, header.IndexCount, file.HasSharedPoolSlots(), SDFObject::RESOURCES_WRITE);
+	for (UINT slot = 0; slot < (std::min)(header.MaterialCount, SDFObject::GetMaxMaterialsPerObject()); slot++)
 	{
-		ID3D12DescriptorHeap* ppDescriptorHeaps[] = { g_D3DGraphicsContext->GetSRVHeap()->GetHeap() };
-		m_CommandList->SetDescriptorHeaps(_countof(ppDescriptorHeaps), ppDescriptorHeaps);
+		object->SetMaterialID(file.GetMaterials()[slot], slot);
 	}
 
-	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(40), L"SDF Bake");
-	PROFILE_COMPUTE_PUSH_RANGE("Bake", m_CommandList.Get());
-
-	PIXBeginEvent(PIX_COLOR_INDEX(51), L"Set up resources");
-	{
-		// Set up resources
+	ID3D12Resource* brickBuffer = object->GetBrickBuffer(SDFObject::RESOURCES_WRITE);
+	ID3D12Resource* aabbBuffer = object->GetAABBBuffer(SDFObject::RESOURCES_WRITE);
+	ID3D12Resource* indexBuffer = object->GetIndexBuffer(SDFObject::RESOURCES_WRITE);
+	ID3D12Resource* brickPool = object->GetBrickPool(SDFObject::RESOURCES_WRITE);
 
-		// Determine eval space size
-		// It should be a multiple of the smallest brick size
-		// Therefore the final iteration will build bricks of the desired size
-		float evalSpaceSize = object->GetNextRebuildBrickSize();
-		while (evalSpaceSize < editList.GetEvaluationRange())
-		{
-			evalSpaceSize *= 4.0f;
-		}
-		
-		m_Resources.AllocateResources(object->GetBrickBufferCapacity(), editList, evalSpaceSize);
-	}
-	PIXEndEvent();
+	// Every section is staged in one upload buffer
+	const UINT64 brickBytes = file.GetSectionSize(SDFBakeFileSection::Bricks);
+	const UINT64 aabbBytes = file.GetSectionSize(SDFBakeFileSection::AABBs);
+	const UINT64 indexBytes = file.GetSectionSize(SDFBakeFileSection::Indices);
 
-	BuildCommandList_Setup(pipelineSet, object, m_Resources);
-	BuildCommandList_HierarchicalBrickBuilding(pipelineSet, object, m_Resources, maxIterations);
+	const UINT64 aabbOffset = Align(brickBytes, static_cast<UINT64>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+	const UINT64 indexOffset = Align(aabbOffset + aabbBytes, static_cast<UINT64>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+	const UINT64 poolOffset = Align(indexOffset + indexBytes, static_cast<UINT64>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
 
-	{
-		// Execute work and wait for it to complete
-		THROW_IF_FAIL(m_CommandList->Close());
-		ID3D12CommandList* ppCommandLists[] = { m_CommandList.Get() };
-		const auto fenceValue = computeQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	const D3D12_RESOURCE_DESC poolDesc = brickPool->GetDesc();
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT poolFootprint;
+	UINT poolRowCount;
+	UINT64 poolRowSize;
+	UINT64 poolTotalBytes;
+	device->GetCopyableFootprints(&poolDesc, 0, 1, poolOffset, &poolFootprint, &poolRowCount, &poolRowSize, &poolTotalBytes);
 
-		// CPU wait until this work has been complete before continuing
-		computeQueue->WaitForFenceCPUBlocking(fenceValue);
+	const UINT64 uploadBytes = poolFootprint.Offset + poolTotalBytes;
+	ASSERT(uploadBytes <= UINT_MAX, "Bake file is too large to upload at once!");
 
-		THROW_IF_FAIL(m_CommandAllocator->Reset());
-		THROW_IF_FAIL(m_CommandList->Reset(m_CommandAllocator.Get(), nullptr));
+	UploadBuffer<BYTE> upload;
+	upload.Allocate(device, static_cast<UINT>(uploadBytes), 0, L"Bake File Upload");
 
-		ID3D12DescriptorHeap* ppDescriptorHeaps[] = { g_D3DGraphicsContext->GetSRVHeap()->GetHeap() };
-		m_CommandList->SetDescriptorHeaps(_countof(ppDescriptorHeaps), ppDescriptorHeaps);
-	}
+	upload.CopyElements(0, static_cast<UINT>(brickBytes), file.GetSection(SDFBakeFileSection::Bricks));
+	upload.CopyElements(static_cast<UINT>(aabbOffset), static_cast<UINT>(aabbBytes), file.GetSection(SDFBakeFileSection::AABBs));
+	if (indexBytes > 0)
+		upload.CopyElements(static_cast<UINT>(indexOffset), static_cast<UINT>(indexBytes), file.GetSection(SDFBakeFileSection::Indices));
 
 	{
-		// Read counter value
+		// Brick pool rows are tightly packed in the file, but must follow the row pitch of the footprint
+		const XMUINT3 resolution = file.GetBrickPoolResolution();
+		const UINT tightRowSize = resolution.x * 4;
+		ASSERT(tightRowSize == poolRowSize, "Unexpected brick pool format");
+
+		const BYTE* pool = file.GetSection(SDFBakeFileSection::BrickPool);
+		for (UINT z = 0; z < resolution.z; z++)
+		for (UINT y = 0; y < resolution.y; y++)
+		{
+			const UINT64 destOffset = poolFootprint.Offset + (static_cast<UINT64>(z) * poolRowCount + y) * poolFootprint.Footprint.RowPitch;
+			const UINT64 srcOffset = (static_cast<UINT64>(z) * resolution.y + y) * tightRowSize;
+			upload.CopyElements(static_cast<UINT>(destOffset), tightRowSize, pool + srcOffset);
+		}
+	}
 
-		// It is only safe to read the counter value after the GPU has finished its work
-		const UINT brickCount = m_Resources.GetBrickCounterReadbackBuffer().ReadElement(0);
-		const float brickSize = m_Resources.GetBrickBuildParams().BrickSize;
-		const UINT64 indexCount = m_Resources.GetIndexCounterReadbackBuffer().ReadElement(0);
-		object->AllocateOptimalResources(brickCount, brickSize, indexCount, SDFObject::RESOURCES_WRITE);
+	THROW_IF_FAIL(m_CommandAllocator->Reset());
+	THROW_IF_FAIL(m_CommandList->Reset(m_CommandAllocator.Get(), nullptr));
 
-		// Update build data required for the next stage
-		m_Resources.GetBrickEvalParams().EvalSpace_BrickSize = brickSize;
-		m_Resources.GetBrickEvalParams().BrickPool_BrickCapacityPerAxis = object->GetBrickPoolDimensions(SDFObject::RESOURCES_WRITE);
-		m_Resources.GetBrickEvalParams().EvalSpace_VoxelsPerUnit = SDF_BRICK_SIZE_VOXELS / brickSize;
-		m_Resources.GetBrickEvalParams().BrickCount = brickCount;
-		m_Resources.GetBrickEvalParams().SDFEditCount = editList.GetEditCount();
+	{
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(brickBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+			CD3DX12_RESOURCE_BARRIER::Transition(aabbBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+			CD3DX12_RESOURCE_BARRIER::Transition(indexBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+			CD3DX12_RESOURCE_BARRIER::Transition(brickPool, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
 	}
 
-	BuildCommandList_BrickEvaluation(pipelineSet, object, m_Resources);
+	m_CommandList->CopyBufferRegion(brickBuffer, 0, upload.GetResource(), 0, brickBytes);
+	m_CommandList->CopyBufferRegion(aabbBuffer, 0, upload.GetResource(), aabbOffset, aabbBytes);
+	if (indexBytes > 0)
+		m_CommandList->CopyBufferRegion(indexBuffer, 0, upload.GetResource(), indexOffset, indexBytes);
 
-	PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
-	PIXEndEvent(m_CommandList.Get()); // SDF Bake
+	{
+		const CD3DX12_TEXTURE_COPY_LOCATION dest(brickPool, 0);
+		const CD3DX12_TEXTURE_COPY_LOCATION src(upload.GetResource(), poolFootprint);
+		m_CommandList->CopyTextureRegion(&dest, 0, 0, 0, &src, nullptr);
+	}
 
 	{
-		// Execute command list
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(brickBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(aabbBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(indexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(brickPool, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
+
+	{
+		// The upload buffer must outlive the copies, so wait for them to complete
 		THROW_IF_FAIL(m_CommandList->Close());
 		ID3D12CommandList* ppCommandLists[] = { m_CommandList.Get() };
 		m_PreviousWorkFence = computeQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+		computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+	}
+
+	directQueue->InsertWaitForQueue(computeQueue);
+
+	object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTED);
+
+	PIXEndEvent();
+	LOG_TRACE("-----SDF Factory Bake File Load Complete-----");
+	return true;
+}
+
+bool SDFFactoryHierarchical::LoadBrickPageFileSync(SDFObject* object, const SDFBrickPageFile& file, const XMUINT3& brickPoolDimensions)
+{
+	ASSERT(file.IsOpen(), "Page file is not open!");
+	ASSERT(brickPoolDimensions.x % SDFBrickPageFile::s_PageBricks == 0, "Pages do not fit in the rows of the brick pool!");
+
+	const auto state = object->GetResourcesState(SDFObject::RESOURCES_WRITE);
+	if (!(state == SDFObject::READY_COMPUTE || state == SDFObject::SWITCHING))
+	{
+		LOG_TRACE("Object in use by async bake - page file cannot be loaded.");
+		return false;
+	}
+
+	LOG_TRACE("-----SDF Factory Page File Load Begin--------");
+	PIXBeginEvent(PIX_COLOR_INDEX(12), L"SDF Page File Load");
+
+	object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTING);
+
+	const auto device = g_D3DGraphicsContext->GetDevice();
+	const auto directQueue = g_D3DGraphicsContext->GetDirectCommandQueue();
+	const auto computeQueue = g_D3DGraphicsContext->GetComputeCommandQueue();
+
+	computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+	computeQueue->InsertWaitForQueue(directQueue);
+
+	const auto& header = file.GetHeader();
+	object->TakeStaleRegion(SDFObject::RESOURCES_WRITE);
+	object->AllocateResourcesForPaging(brickPoolDimensions, header.BrickCount, header.BrickSize, header.EvalSpaceSize, SDFObject::RESOURCES_WRITE);
+
+	ID3D12Resource* brickBuffer = object->GetBrickBuffer(SDFObject::RESOURCES_WRITE);
+	ID3D12Resource* aabbBuffer = object->GetAABBBuffer(SDFObject::RESOURCES_WRITE);
+
+	// The brick pool is left as it is, as no brick refers to it until its page is streamed in
+	const UINT64 brickBytes = file.GetSectionSize(SDFBrickPageFileSection::Bricks);
+	const UINT64 aabbBytes = file.GetSectionSize(SDFBrickPageFileSection::AABBs);
+	const UINT64 aabbOffset = Align(brickBytes, static_cast<UINT64>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+	ASSERT(aabbOffset + aabbBytes <= UINT_MAX, "Page file is too large to upload at once!");
+
+	UploadBuffer<BYTE> upload;
+	upload.Allocate(device, static_cast<UINT>(aabbOffset + aabbBytes), 0, L"Page File Upload");
+	upload.CopyElements(0, static_cast<UINT>(brickBytes), file.GetSection(SDFBrickPageFileSection::Bricks));
+	upload.CopyElements(static_cast<UINT>(aabbOffset), static_cast<UINT>(aabbBytes), file.GetSection(SDFBrickPageFileSection::AABBs));
+
+	THROW_IF_FAIL(m_CommandAllocator->Reset());
+	THROW_IF_FAIL(m_CommandList->Reset(m_CommandAllocator.Get(), nullptr));
+
+	{
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(brickBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+			CD3DX12_RESOURCE_BARRIER::Transition(aabbBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
+
+	m_CommandList->CopyBufferRegion(brickBuffer, 0, upload.GetResource(), 0, brickBytes);
+	m_CommandList->CopyBufferRegion(aabbBuffer, 0, upload.GetResource(), aabbOffset, aabbBytes);
+
+	{
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(brickBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(aabbBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
+
+	{
+		// The upload buffer must outlive the copies, so wait for them to complete
+		THROW_IF_FAIL(m_CommandList->Close());
+		ID3D12CommandList* ppCommandLists[] = { m_CommandList.Get() };
+		m_PreviousWorkFence = computeQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+		computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+	}
+
+	directQueue->InsertWaitForQueue(computeQueue);
+
+	object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTED);
+
+	PIXEndEvent();
+	LOG_TRACE("-----SDF Factory Page File Load Complete-----");
+	return true;
+}
+
+
+void SDFFactoryHierarchical::CreatePipelineSetAsync(const std::wstring& name, const std::vector<std::wstring>& defines)
+{
+	std::lock_guard lock(m_PipelineMutex);
+	if (m_Pipelines.find(name) != m_Pipelines.end())
+		return;
+
+	PipelineSetEntry& entry = m_Pipelines[name];
+	entry.Builder = std::make_unique<D3DPipelineBuilder>();
+	BuildPipelineSet(entry.Pipelines, defines, *entry.Builder);
+}
+
+bool SDFFactoryHierarchical::CreatePipelineSet(const std::wstring& name, const std::vector<std::wstring>& defines)
+{
+	ASSERT(!HasPipelineSet(name), "Pipeline already exists with that name!");
+
+	CreatePipelineSetAsync(name, defines);
+	return GetPipelineSet(name) != nullptr;
+}
+
+bool SDFFactoryHierarchical::HasPipelineSet(const std::wstring& name) const
+{
+	std::lock_guard lock(m_PipelineMutex);
+	return m_Pipelines.find(name) != m_Pipelines.end();
+}
+
+const SDFFactoryHierarchical::PipelineSet* SDFFactoryHierarchical::GetPipelineSet(const std::wstring& name)
+{
+	std::unique_lock lock(m_PipelineMutex);
+	auto it = m_Pipelines.find(name);
+	// If another thread is already waiting for the set, its outcome is waited for instead
+	while (it != m_Pipelines.end() && it->second.Waiting)
+	{
+		m_PipelineCondition.wait(lock);
+		it = m_Pipelines.find(name);
+	}
+	if (it == m_Pipelines.end())
+		return nullptr;
+
+	// Only sets that fail are removed, so a created set can be used after the lock is released
+	PipelineSetEntry& entry = it->second;
+	if (entry.Builder)
+	{
+		// The builder is waited on without the lock, so that other sets can be looked up and created in the meantime
+		const std::unique_ptr<D3DPipelineBuilder> builder = std::move(entry.Builder);
+		entry.Waiting = true;
+		lock.unlock();
+
+		if (!builder->IsComplete())
+		{
+			LOG_TRACE("Waiting for pipeline set to be created...");
+		}
+
+		bool created = true;
+		try
+		{
+			builder->Wait();
+		}
+		catch (const std::exception& e)
+		{
+			LOG_ERROR("Pipeline set could not be created: {}", e.what());
+			created = false;
+		}
+
+		lock.lock();
+		entry.Waiting = false;
+		if (!created)
+		{
+			// Every task has completed, so nothing can still write to the set
+			m_Pipelines.erase(name);
+		}
+		m_PipelineCondition.notify_all();
+
+		if (!created)
+			return nullptr;
+	}
+	return &entry.Pipelines;
+}
+
+const SDFFactoryHierarchical::PipelineSet& SDFFactoryHierarchical::GetPipelineSetForBake(const std::wstring& name)
+{
+	if (const PipelineSet* pipelineSet = GetPipelineSet(name))
+		return *pipelineSet;
+
+	// The default set is created before the factory can be used, so it is always available
+	LOG_TRACE("Pipeline set is not available - the default pipeline set is used instead.");
+	const PipelineSet* defaultSet = GetPipelineSet(L"Default");
+	ASSERT(defaultSet, "Default pipeline set doesn't exist!");
+	return *defaultSet;
+}
+
+void SDFFactoryHierarchical::BuildPipelineSet(PipelineSet& pipelineSet, const std::vector<std::wstring>& defines, D3DPipelineBuilder& builder) const
+{
+	{
+		using namespace BrickCounterSignature;
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
+		rootParams[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickBuildParametersConstantBuffer), 0);
+		rootParams[BrickCounterSlot].InitAsShaderResourceView(0);
+		rootParams[EditListSlot].InitAsShaderResourceView(1);
+		rootParams[IndexBufferSlot].InitAsShaderResourceView(2);
+		rootParams[BricksSlot].InitAsUnorderedAccessView(0);
+		rootParams[CountTableSlot].InitAsUnorderedAccessView(1);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParams);
+		desc.RootParameters = rootParams;
+		desc.Shader = L"assets/shaders/compute/sub_brick_counter.hlsl";
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		pipelineSet[SDFFactoryPipeline::BrickCounter] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+
+	{
+		using namespace ScanThreadGroupCalculatorSignature;
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
+		rootParams[BrickCounterSlot].InitAsShaderResourceView(0);
+		rootParams[IndirectCommandArgumentSlot].InitAsUnorderedAccessView(0);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParams);
+		desc.RootParameters = rootParams;
+		desc.Shader = L"assets/shaders/compute/scan_thread_group_calculator.hlsl";
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		pipelineSet[SDFFactoryPipeline::ScanGroupCountCalculator] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+
+	{
+		using namespace BrickScanSignature;
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
+		rootParams[CountTableSlot].InitAsShaderResourceView(0);
+		rootParams[NumberOfCountsSlot].InitAsShaderResourceView(1);
+		rootParams[BlockPrefixSumTableSlot].InitAsUnorderedAccessView(0);
+		rootParams[BlockPrefixSumOutputTableSlot].InitAsUnorderedAccessView(1);
+		rootParams[PrefixSumTableSlot].InitAsUnorderedAccessView(2);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParams);
+		desc.RootParameters = rootParams;
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		desc.Shader = L"assets/shaders/compute/prefix_sum/scan_blocks.hlsl";
+		pipelineSet[SDFFactoryPipeline::ScanBlocks] = std::make_unique<D3DComputePipeline>(&desc, builder);
+
+		desc.Shader = L"assets/shaders/compute/prefix_sum/scan_block_sums.hlsl";
+		pipelineSet[SDFFactoryPipeline::ScanBlockSums] = std::make_unique<D3DComputePipeline>(&desc, builder);
+
+		desc.Shader = L"assets/shaders/compute/prefix_sum/sum_scans.hlsl";
+		pipelineSet[SDFFactoryPipeline::SumScans] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+
+	{
+		using namespace BrickBuilderSignature;
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
+		rootParams[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickBuildParametersConstantBuffer), 0);
+		rootParams[InBrickCounterSlot].InitAsShaderResourceView(0);
+		rootParams[InBricksSlot].InitAsShaderResourceView(1);
+		rootParams[PrefixSumTableSlot].InitAsShaderResourceView(2);
+		rootParams[OutBrickCounterSlot].InitAsUnorderedAccessView(0);
+		rootParams[OutBricksSlot].InitAsUnorderedAccessView(1);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParams);
+		desc.RootParameters = rootParams;
+		desc.Shader = L"assets/shaders/compute/sub_brick_builder.hlsl";
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		pipelineSet[SDFFactoryPipeline::BrickBuilder] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+
+	{
+		using namespace EditTesterSignature;
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
+		rootParams[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickBuildParametersConstantBuffer), 0);
+		rootParams[EditListSlot].InitAsShaderResourceView(0);
+		rootParams[InIndexBufferSlot].InitAsShaderResourceView(1);
+		rootParams[EditDependencyIndicesSlot].InitAsShaderResourceView(2);
+		rootParams[EditDependencyOffsetsSlot].InitAsShaderResourceView(3);
+		rootParams[BrickSlot].InitAsUnorderedAccessView(0);
+		rootParams[OutIndexBufferSlot].InitAsUnorderedAccessView(1);
+		rootParams[OutIndexCounterSlot].InitAsUnorderedAccessView(2);
+		rootParams[OutIndexOverflowSlot].InitAsUnorderedAccessView(3);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParams);
+		desc.RootParameters = rootParams;
+		desc.Shader = L"assets/shaders/compute/edit_tester.hlsl";
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		pipelineSet[SDFFactoryPipeline::EditTester] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+
+	{
+		using namespace AABBBuilderSignature;
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
+		rootParams[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickEvaluationConstantBuffer), 0);
+		rootParams[BricksSlot].InitAsShaderResourceView(0);
+		rootParams[AABBsSlot].InitAsUnorderedAccessView(0);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParams);
+		desc.RootParameters = rootParams;
+		desc.Shader = L"assets/shaders/compute/aabb_builder.hlsl";
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		pipelineSet[SDFFactoryPipeline::AABBBuilder] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+
+	{
+		using namespace BrickReleaserSignature;
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
+		rootParams[IncrementalParameterSlot].InitAsConstants(SizeOfInUint32(IncrementalBakeConstantBuffer), 0);
+		rootParams[BricksSlot].InitAsShaderResourceView(0);
+		rootParams[FreeBricksSlot].InitAsUnorderedAccessView(0);
+		rootParams[FreeBrickCounterSlot].InitAsUnorderedAccessView(1);
+		rootParams[ReleasedIndexCounterSlot].InitAsUnorderedAccessView(2);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParams);
+		desc.RootParameters = rootParams;
+		desc.Shader = L"assets/shaders/compute/brick_releaser.hlsl";
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		pipelineSet[SDFFactoryPipeline::BrickReleaser] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+
+	{
+		using namespace BrickMergerSignature;
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[Count];
+		rootParams[IncrementalParameterSlot].InitAsConstants(SizeOfInUint32(IncrementalBakeConstantBuffer), 0);
+		rootParams[NewBricksSlot].InitAsShaderResourceView(0);
+		rootParams[FreeBricksSlot].InitAsShaderResourceView(1);
+		rootParams[BricksSlot].InitAsUnorderedAccessView(0);
+		rootParams[AABBsSlot].InitAsUnorderedAccessView(1);
+		rootParams[BrickSlotsSlot].InitAsUnorderedAccessView(2);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParams);
+		desc.RootParameters = rootParams;
+		desc.Shader = L"assets/shaders/compute/brick_merger.hlsl";
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		pipelineSet[SDFFactoryPipeline::BrickMerger] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+
+	{
+		using namespace BrickEvaluatorSignature;
+
+		CD3DX12_DESCRIPTOR_RANGE1 ranges[1];
+		ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+
+		CD3DX12_ROOT_PARAMETER1 rootParameters[Count];
+		rootParameters[GroupOffsetSlot].InitAsConstants(1, 0);
+		rootParameters[BuildParameterSlot].InitAsConstants(SizeOfInUint32(BrickEvaluationConstantBuffer), 1);
+		rootParameters[EditListSlot].InitAsShaderResourceView(0);
+		rootParameters[IndexBufferSlot].InitAsShaderResourceView(1);
+		rootParameters[BrickBufferSlot].InitAsShaderResourceView(2);
+		rootParameters[BrickSlotsSlot].InitAsShaderResourceView(3);
+		rootParameters[BrickPoolSlot].InitAsDescriptorTable(1, &ranges[0]);
+
+		D3DComputePipelineDesc desc;
+		desc.NumRootParameters = ARRAYSIZE(rootParameters);
+		desc.RootParameters = rootParameters;
+		desc.Shader = L"assets/shaders/compute/brick_evaluator.hlsl";
+		desc.EntryPoint = L"main";
+		desc.Defines = defines;
+
+		pipelineSet[SDFFactoryPipeline::BrickEvaluator] = std::make_unique<D3DComputePipeline>(&desc, builder);
+	}
+}
+
+
+void SDFFactoryHierarchical::PerformSDFBake_CPUBlocking(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion& staleRegion)
+{
+	SubmitSDFBake(pipelineName, object, editList, staleRegion);
+	g_D3DGraphicsContext->GetComputeCommandQueue()->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+}
+
+void SDFFactoryHierarchical::SubmitSDFBake(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion& staleRegion)
+{
+	const PipelineSet& pipelineSet = GetPipelineSetForBake(pipelineName);
+
+	AdvanceContext_CPUBlocking();
+	SDFConstructionResources& resources = *m_Contexts.at(m_CurrentContext).Resources;
+
+	PROFILE_COMPUTE_BEGIN_PASS("SDF Bake");
+
+	ResetCommandList();
+
+	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(40), L"SDF Bake");
+	PROFILE_COMPUTE_PUSH_RANGE("Bake", m_CommandList.Get());
+
+	BakeJob job;
+	job.Object = object;
+	job.EditList = &editList;
+	job.StaleRegion = staleRegion;
+	job.Resources = &resources;
+	BeginBakeJob(job);
+
+	PerformBrickBuilding_CPUBlocking(pipelineSet, job);
+
+	PrepareBrickEvaluation(job);
+	BuildCommandList_BrickEvaluation(pipelineSet, object, resources, job.Incremental);
+
+	PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+	PIXEndEvent(m_CommandList.Get()); // SDF Bake
+
+	SubmitCommandList();
+	PROFILE_COMPUTE_END_PASS();
+}
+
+void SDFFactoryHierarchical::PerformSDFBatchBake_CPUBlocking(const std::wstring& pipelineName, std::vector<BakeJob>& jobs)
+{
+	SubmitSDFBatchBake(pipelineName, jobs);
+	g_D3DGraphicsContext->GetComputeCommandQueue()->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+}
+
+void SDFFactoryHierarchical::SubmitSDFBatchBake(const std::wstring& pipelineName, std::vector<BakeJob>& jobs)
+{
+	const PipelineSet& pipelineSet = GetPipelineSetForBake(pipelineName);
+
+	const UINT maxIterations = m_MaxBrickBuildIterations;
+
+	AdvanceContext_CPUBlocking();
+	auto& batchResources = m_Contexts.at(m_CurrentContext).BatchResources;
+
+	// Each object in the batch needs its own construction resources, which are kept for later batches
+	while (batchResources.size() < jobs.size())
+	{
+		batchResources.push_back(std::make_unique<SDFConstructionResources>());
+	}
+
+	PROFILE_COMPUTE_BEGIN_PASS("SDF Batch Bake");
+
+	ResetCommandList();
+
+	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(40), L"SDF Batch Bake");
+	PROFILE_COMPUTE_PUSH_RANGE("Batch Bake", m_CommandList.Get());
+
+	PIXBeginEvent(PIX_COLOR_INDEX(51), L"Set up resources");
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		jobs.at(i).Resources = batchResources.at(i).get();
+		BeginBakeJob(jobs.at(i));
+		PrepareBrickBuilding(jobs.at(i));
+	}
+	PIXEndEvent();
+
+	{
+		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(42), L"Hierarchical brick building");
+		PROFILE_COMPUTE_PUSH_RANGE("Brick Building", m_CommandList.Get());
+
+		for (const auto& job : jobs)
+		{
+			BuildCommandList_Setup(pipelineSet, job.Object, *job.Resources);
+		}
+
+		// The same iteration of every object is recorded together
+		// The objects use separate resources, so their dispatches between each set of barriers are independent
+		UINT iteration = 0;
+		bool building = true;
+		while (building)
+		{
+			building = false;
+			for (const auto& job : jobs)
+			{
+				building |= BuildCommandList_BrickBuildingIteration(pipelineSet, job.Object, *job.Resources, iteration, maxIterations - job.SkippedIterations);
+			}
+			iteration++;
+		}
+
+		for (const auto& job : jobs)
+		{
+			BuildCommandList_BrickBuildingReadback(*job.Resources);
+			if (job.Incremental)
+			{
+				BuildCommandList_BrickRelease(pipelineSet, job.Object, *job.Resources);
+			}
+		}
+
+		PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+		PIXEndEvent(m_CommandList.Get());
+	}
+
+	ExecuteCommandList_CPUBlocking();
+
+	// Objects whose brick building must be repeated are baked alone after the rest of the batch
+	std::vector<BakeJob*> retryJobs;
+	for (auto& job : jobs)
+	{
+		if (!CheckBrickBuilding(job))
+		{
+			retryJobs.push_back(&job);
+			continue;
+		}
+
+		PrepareBrickEvaluation(job);
+		BuildCommandList_BrickEvaluation(pipelineSet, job.Object, *job.Resources, job.Incremental);
+	}
+
+	PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+	PIXEndEvent(m_CommandList.Get()); // SDF Batch Bake
+
+	SubmitCommandList();
+	PROFILE_COMPUTE_END_PASS();
+
+	if (!retryJobs.empty())
+	{
+		LOG_TRACE("{} of {} objects in the batch must be rebuilt alone.", retryJobs.size(), jobs.size());
+	}
+	for (BakeJob* job : retryJobs)
+	{
+		// The command allocator can only be reset once the GPU has finished with the last submission
+		g_D3DGraphicsContext->GetComputeCommandQueue()->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+
+		PROFILE_COMPUTE_BEGIN_PASS("SDF Bake");
+		ResetCommandList();
+
+		// The batch resources have been grown as required, so the retry continues to use them
+		PerformBrickBuilding_CPUBlocking(pipelineSet, *job);
+
+		PrepareBrickEvaluation(*job);
+		BuildCommandList_BrickEvaluation(pipelineSet, job->Object, *job->Resources, job->Incremental);
+
+		SubmitCommandList();
+		PROFILE_COMPUTE_END_PASS();
+	}
+}
+
+
+void SDFFactoryHierarchical::BeginBakeJob(BakeJob& job) const
+{
+	// Determine eval space size
+	// It should be a multiple of the smallest brick size
+	// Therefore the final iteration will build bricks of the desired size
+	job.EvalSpaceSize = job.Object->GetNextRebuildBrickSize();
+	while (job.EvalSpaceSize < job.EditList->GetEvaluationRange())
+	{
+		job.EvalSpaceSize *= 4.0f;
+	}
+
+	// Only the part of the object that has changed since the write resources were last baked needs to be rebuilt
+	job.Incremental = CanBakeIncrementally(job.Object, job.StaleRegion, job.EvalSpaceSize);
+}
+
+void SDFFactoryHierarchical::PrepareBrickBuilding(BakeJob& job) const
+{
+	SDFObject* object = job.Object;
+	SDFConstructionResources& resources = *job.Resources;
+	const UINT maxIterations = m_MaxBrickBuildIterations;
+
+	// Full bakes build every brick
+	XMFLOAT3 regionMin = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	XMFLOAT3 regionMax = { FLT_MAX, FLT_MAX, FLT_MAX };
+	if (job.Incremental)
+	{
+		SnapRegionToBricks(job.StaleRegion, job.EvalSpaceSize, object->GetBrickSize(SDFObject::RESOURCES_WRITE), regionMin, regionMax);
+	}
+
+	resources.AllocateResources(object->GetBrickBufferCapacity(), *job.EditList, job.EvalSpaceSize, regionMin, regionMax);
+	job.SkippedIterations = 0;
+	if (job.Incremental)
+	{
+		if (m_EnableHierarchySeeding)
+		{
+			// Outside of the region the bricks from the previous bake are kept,
+			// so the coarse levels of the hierarchy only need to be built where they overlap it
+			float seedBrickSize;
+			const UINT maxSeedCount = (std::min)(SDFConstructionResources::GetMaxSeedBrickCount(), resources.GetBrickCapacity());
+			job.SkippedIterations = FindSeedBrickSize(regionMin, regionMax, job.EvalSpaceSize, object->GetBrickSize(SDFObject::RESOURCES_WRITE), maxSeedCount, maxIterations, seedBrickSize);
+			if (job.SkippedIterations > 0)
+			{
+				resources.SeedBricks(*job.EditList, seedBrickSize);
+				LOG_TRACE("Seeded brick building with {} bricks of size {} and {} edits, skipping {} iterations.",
+					resources.GetInitialBrickCount(), seedBrickSize, resources.GetInitialIndexCount(), job.SkippedIterations);
+			}
+		}
+
+		resources.AllocateFreeBrickBuffer(object->GetBrickCount(SDFObject::RESOURCES_WRITE));
+
+		auto& incrementalParams = resources.GetIncrementalParams();
+		incrementalParams.RegionMin = regionMin;
+		incrementalParams.RegionMax = regionMax;
+		incrementalParams.BrickSize = object->GetBrickSize(SDFObject::RESOURCES_WRITE);
+		incrementalParams.BrickCount = object->GetBrickCount(SDFObject::RESOURCES_WRITE);
+	}
+}
+
+void SDFFactoryHierarchical::PerformBrickBuilding_CPUBlocking(const PipelineSet& pipelineSet, BakeJob& job)
+{
+	const UINT maxIterations = m_MaxBrickBuildIterations;
+
+	// The index buffers are not sized for the worst case, so brick building is repeated with larger buffers if it overflows them
+	do
+	{
+		PIXBeginEvent(PIX_COLOR_INDEX(51), L"Set up resources");
+		PrepareBrickBuilding(job);
+		PIXEndEvent();
+
+		BuildCommandList_Setup(pipelineSet, job.Object, *job.Resources);
+		BuildCommandList_HierarchicalBrickBuilding(pipelineSet, job.Object, *job.Resources, maxIterations - job.SkippedIterations);
+		if (job.Incremental)
+		{
+			BuildCommandList_BrickRelease(pipelineSet, job.Object, *job.Resources);
+		}
 
-		PROFILE_COMPUTE_END_PASS();
+		ExecuteCommandList_CPUBlocking();
+	} while (!CheckBrickBuilding(job));
+}
+
+bool SDFFactoryHierarchical::CheckBrickBuilding(BakeJob& job) const
+{
+	SDFObject* object = job.Object;
+	SDFConstructionResources& resources = *job.Resources;
+
+	const UINT requiredIndexCapacity = resources.GetIndexOverflowReadbackBuffer().ReadElement(0);
+	if (requiredIndexCapacity > 0)
+	{
+		LOG_TRACE("Index buffer overflowed: {} indices required, capacity is {}. Rebuilding bricks.", requiredIndexCapacity, resources.GetIndexCapacity());
+		resources.GrowIndexBuffers(requiredIndexCapacity);
+		return false;
+	}
+
+	if (job.Incremental)
+	{
+		// New bricks that don't fit in the free slots are appended to the object, and new indices are always appended
+		const UINT newBrickCount = resources.GetBrickCounterReadbackBuffer().ReadElement(0);
+		const UINT freeBrickCount = resources.GetFreeBrickCounterReadbackBuffer().ReadElement(0);
+		const UINT brickCount = object->GetBrickCount(SDFObject::RESOURCES_WRITE) + (newBrickCount > freeBrickCount ? newBrickCount - freeBrickCount : 0);
+		const UINT64 indexCount = object->GetIndexCount(SDFObject::RESOURCES_WRITE) + resources.GetIndexCounterReadbackBuffer().ReadElement(0);
+
+		if (brickCount > object->GetBrickPoolCapacity(SDFObject::RESOURCES_WRITE) || indexCount > object->GetIndexBufferCapacity(SDFObject::RESOURCES_WRITE))
+		{
+			LOG_TRACE("Incremental bake does not fit in the object's resources. Performing a full bake.");
+			job.Incremental = false;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void SDFFactoryHierarchical::PrepareBrickEvaluation(BakeJob& job) const
+{
+	SDFObject* object = job.Object;
+	SDFConstructionResources& resources = *job.Resources;
+
+	// Read counter value
+
+	// It is only safe to read the counter value after the GPU has finished its work
+	const UINT brickCount = resources.GetBrickCounterReadbackBuffer().ReadElement(0);
+	const float brickSize = resources.GetBrickBuildParams().BrickSize;
+	const UINT64 indexCount = resources.GetIndexCounterReadbackBuffer().ReadElement(0);
+
+	if (job.Incremental)
+	{
+		const UINT existingBrickCount = object->GetBrickCount(SDFObject::RESOURCES_WRITE);
+		const UINT freeBrickCount = resources.GetFreeBrickCounterReadbackBuffer().ReadElement(0);
+		const UINT64 existingIndexCount = object->GetIndexCount(SDFObject::RESOURCES_WRITE);
+
+		auto& incrementalParams = resources.GetIncrementalParams();
+		incrementalParams.NewBrickCount = brickCount;
+		incrementalParams.ReleasedBrickCount = freeBrickCount;
+		incrementalParams.IndexOffset = static_cast<UINT>(existingIndexCount);
+
+		const UINT totalBrickCount = existingBrickCount + (brickCount > freeBrickCount ? brickCount - freeBrickCount : 0);
+		const UINT64 releasedIndexCount = object->GetReleasedIndexCount(SDFObject::RESOURCES_WRITE) + resources.GetReleasedIndexCounterReadbackBuffer().ReadElement(0);
+		object->SetIncrementalBakeResult(totalBrickCount, existingIndexCount + indexCount, releasedIndexCount, SDFObject::RESOURCES_WRITE);
+
+		LOG_TRACE("Incremental bake rebuilt {} bricks and released {} slots.", brickCount, freeBrickCount);
+	}
+	else
+	{
+		object->AllocateOptimalResources(brickCount, brickSize, job.EvalSpaceSize, indexCount, SDFObject::RESOURCES_WRITE);
+	}
+
+	// Update build data required for the next stage
+	// Incremental bakes only evaluate the new bricks, through the slots they were placed in
+	resources.GetBrickEvalParams().EvalSpace_BrickSize = brickSize;
+	resources.GetBrickEvalParams().BrickPool_BrickCapacityPerAxis = object->GetBrickPoolDimensions(SDFObject::RESOURCES_WRITE);
+	resources.GetBrickEvalParams().EvalSpace_VoxelsPerUnit = SDF_BRICK_SIZE_VOXELS / brickSize;
+	resources.GetBrickEvalParams().BrickCount = brickCount;
+	resources.GetBrickEvalParams().SDFEditCount = job.EditList->GetEditCount();
+	resources.GetBrickEvalParams().UseBrickSlots = job.Incremental;
+	resources.GetBrickEvalParams().BrickPool_Placement = object->GetBrickPoolPlacement(SDFObject::RESOURCES_WRITE);
+}
+
+
+void SDFFactoryHierarchical::ResetCommandList()
+{
+	THROW_IF_FAIL(m_CommandAllocator->Reset());
+	THROW_IF_FAIL(m_CommandList->Reset(m_CommandAllocator.Get(), nullptr));
+
+	ID3D12DescriptorHeap* ppDescriptorHeaps[] = { g_D3DGraphicsContext->GetSRVHeap()->GetHeap() };
+	m_CommandList->SetDescriptorHeaps(_countof(ppDescriptorHeaps), ppDescriptorHeaps);
+}
+
+void SDFFactoryHierarchical::ExecuteCommandList_CPUBlocking()
+{
+	const auto computeQueue = g_D3DGraphicsContext->GetComputeCommandQueue();
+
+	// Execute work and wait for it to complete
+	THROW_IF_FAIL(m_CommandList->Close());
+	ID3D12CommandList* ppCommandLists[] = { m_CommandList.Get() };
+	const auto fenceValue = computeQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+	// CPU wait until this work has been complete before continuing
+	computeQueue->WaitForFenceCPUBlocking(fenceValue);
+
+	ResetCommandList();
+}
+
+void SDFFactoryHierarchical::SubmitCommandList()
+{
+	THROW_IF_FAIL(m_CommandList->Close());
+	ID3D12CommandList* ppCommandLists[] = { m_CommandList.Get() };
+	m_PreviousWorkFence = g_D3DGraphicsContext->GetComputeCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+	m_Contexts.at(m_CurrentContext).Fence = m_PreviousWorkFence;
+}
+
+
+void SDFFactoryHierarchical::AdvanceContext_CPUBlocking()
+{
+	const auto computeQueue = g_D3DGraphicsContext->GetComputeCommandQueue();
+
+	const UINT depth = m_RequestedPipelineDepth;
+	if (depth != m_Contexts.size())
+	{
+		// Contexts can only be destroyed once the GPU has finished with all of them
+		PIXBeginEvent(PIX_COLOR_INDEX(14), L"Wait for previous bakes");
 		computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
+		PIXEndEvent();
+
+		CreateContexts(depth);
+		return;
+	}
+
+	m_CurrentContext = (m_CurrentContext + 1) % static_cast<UINT>(m_Contexts.size());
+	BakeContext& context = m_Contexts.at(m_CurrentContext);
+
+	// Only the bake that last used this context must be complete
+	PIXBeginEvent(PIX_COLOR_INDEX(14), L"Wait for context");
+	computeQueue->WaitForFenceCPUBlocking(context.Fence);
+	PIXEndEvent();
+
+	m_CommandAllocator = context.CommandAllocator;
+	m_CommandList = context.CommandList;
+}
+
+void SDFFactoryHierarchical::CreateContexts(UINT depth)
+{
+	const auto device = g_D3DGraphicsContext->GetDevice();
+
+	m_Contexts.resize(depth);
+	for (UINT i = 0; i < depth; i++)
+	{
+		BakeContext& context = m_Contexts.at(i);
+		context.Fence = 0;
+		if (context.CommandAllocator)
+			continue;
+
+		THROW_IF_FAIL(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&context.CommandAllocator)));
+		context.CommandAllocator->SetName((L"Hierarchical Factory Command Allocator " + std::to_wstring(i)).c_str());
+		THROW_IF_FAIL(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, context.CommandAllocator.Get(), nullptr, IID_PPV_ARGS(&context.CommandList)));
+		context.CommandList->SetName((L"Hierarchical Factory Command List " + std::to_wstring(i)).c_str());
+		THROW_IF_FAIL(context.CommandList->Close());
+
+		context.Resources = std::make_unique<SDFConstructionResources>();
 	}
+
+	m_CurrentContext = 0;
+	m_CommandAllocator = m_Contexts.at(0).CommandAllocator;
+	m_CommandList = m_Contexts.at(0).CommandList;
 }
 
 void SDFFactoryHierarchical::BuildCommandList_Setup(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources) const
@@ -503,55 +1417,32 @@ void SDFFactoryHierarchical::BuildCommandList_Setup(const PipelineSet& pipeline,
 	resources.GetEditBuffer().CopyFromUpload(m_CommandList.Get());
 
 	{
-		// Build edit dependency data
+		// Copy edit dependency data into default heap
+		// Dependencies were found on the CPU when the resources were allocated
 		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(56), L"Edit Dependencies");
 
 		{
-			// Transition brick buffer for reading
-			const D3D12_RESOURCE_BARRIER barriers[] = {
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetEditDependencyBuffer().GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST),
-			};
-			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
-		}
-
-		const UINT64 numBytes = resources.GetEditDependencyUploadBuffer().GetElementCount() * resources.GetEditDependencyUploadBuffer().GetElementStride();
-		m_CommandList->CopyBufferRegion(resources.GetEditDependencyBuffer().GetResource(), 0, resources.GetEditDependencyUploadBuffer().GetResource(), 0, numBytes);
-
-		{
-			// Transition brick buffer for reading
 			const D3D12_RESOURCE_BARRIER barriers[] = {
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetEditDependencyBuffer().GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetEditDependencyOffsetBuffer().GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetEditDependencyIndexBuffer().GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST),
 			};
 			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
 		}
 
-		const UINT editCount = resources.GetBrickBuildParams().SDFEditCount;
+		const SDFEditDependencies& dependencies = resources.GetEditDependencies();
 
-		EditDependencyParameters params;
-		params.SDFEditCount = editCount;
-		params.DependencyPairsCount = editCount * (editCount - 1) / 2;
+		const UINT64 offsetBytes = static_cast<UINT64>(dependencies.GetEditCount() + 1) * resources.GetEditDependencyOffsetUploadBuffer().GetElementStride();
+		m_CommandList->CopyBufferRegion(resources.GetEditDependencyOffsetBuffer().GetResource(), 0, resources.GetEditDependencyOffsetUploadBuffer().GetResource(), 0, offsetBytes);
 
-		PROFILE_COMPUTE_PUSH_RANGE("Edit Dependencies", m_CommandList.Get());
-		if (params.DependencyPairsCount > 0)
-		{
-			pipeline[SDFFactoryPipeline::EditDependency]->Bind(m_CommandList.Get());
-			
-
-			m_CommandList->SetComputeRoot32BitConstants(EditDependencySignature::ParametersSlot, SizeOfInUint32(EditDependencyParameters), &params, 0);
-			m_CommandList->SetComputeRootUnorderedAccessView(EditDependencySignature::EditListSlot, resources.GetEditBuffer().GetAddress());
-			m_CommandList->SetComputeRootUnorderedAccessView(EditDependencySignature::DependencyIndicesSlot, resources.GetEditDependencyBuffer().GetAddress());
+		const UINT64 indexBytes = static_cast<UINT64>(dependencies.GetTotalDependencyCount()) * resources.GetEditDependencyIndexUploadBuffer().GetElementStride();
+		if (indexBytes > 0)
+			m_CommandList->CopyBufferRegion(resources.GetEditDependencyIndexBuffer().GetResource(), 0, resources.GetEditDependencyIndexUploadBuffer().GetResource(), 0, indexBytes);
 
-			// Calculate thread groups
-			// One thread for each pair
-			const UINT threadGroupX = (params.DependencyPairsCount + EDIT_DEPENDENCY_THREAD_COUNT - 1) / EDIT_DEPENDENCY_THREAD_COUNT;
-			m_CommandList->Dispatch(threadGroupX, 1, 1);
-		}
-		PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
-			
 		{
-			// Transition brick buffer for reading
+			// Transition edit data for reading
 			const D3D12_RESOURCE_BARRIER barriers[] = {
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetEditDependencyBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetEditDependencyOffsetBuffer().GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetEditDependencyIndexBuffer().GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
 				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetEditBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
 			};
 			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
@@ -571,12 +1462,15 @@ void SDFFactoryHierarchical::BuildCommandList_Setup(const PipelineSet& pipeline,
 	}
 
 	// Copy index upload data into index buffer
-	const UINT64 numBytes = resources.GetIndexUploadBuffer().GetElementCount() * resources.GetIndexUploadBuffer().GetElementStride();
-	m_CommandList->CopyBufferRegion(resources.GetReadIndexBuffer().GetResource(), 0, resources.GetIndexUploadBuffer().GetResource(), 0, numBytes);
+	const UINT64 numBytes = static_cast<UINT64>(resources.GetInitialIndexCount()) * resources.GetInitialIndexUploadBuffer().GetElementStride();
+	if (numBytes > 0)
+		m_CommandList->CopyBufferRegion(resources.GetReadIndexBuffer().GetResource(), 0, resources.GetInitialIndexUploadBuffer().GetResource(), 0, numBytes);
 	// Copy brick data into the brick buffer
-	m_CommandList->CopyBufferRegion(resources.GetReadBrickBuffer().GetResource(), 0, resources.GetBrickUploadBuffer().GetResource(), 0, 64 * sizeof(Brick));
+	m_CommandList->CopyBufferRegion(resources.GetReadBrickBuffer().GetResource(), 0, resources.GetBrickUploadBuffer().GetResource(), 0, resources.GetInitialBrickCount() * sizeof(Brick));
 	// Copy default command buffer into the command buffer
 	m_CommandList->CopyBufferRegion(resources.GetCommandBuffer().GetResource(), 0, m_CommandUploadBuffer.GetResource(), 0, s_NumCommands * sizeof(D3D12_DISPATCH_ARGUMENTS));
+	// The first dispatch has a group for each initial brick
+	m_CommandList->CopyBufferRegion(resources.GetCommandBuffer().GetResource(), 0, resources.GetInitialBrickCountUploadBuffer().GetResource(), 0, sizeof(UINT));
 
 	{
 		// Transition brick buffers into unordered access
@@ -590,8 +1484,9 @@ void SDFFactoryHierarchical::BuildCommandList_Setup(const PipelineSet& pipeline,
 	}
 
 	// Set initial counter values
-	resources.GetReadBrickCounter().SetValue(m_CommandList.Get(), m_CounterUpload64.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	resources.GetReadBrickCounter().SetValue(m_CommandList.Get(), resources.GetInitialBrickCountUploadBuffer().GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	resources.GetWriteBrickCounter().SetValue(m_CommandList.Get(), m_CounterUploadZero.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	resources.GetIndexOverflowCounter().SetValue(m_CommandList.Get(), m_CounterUploadZero.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 	{
 		// Put prefix sum buffers into correct state
@@ -613,219 +1508,239 @@ void SDFFactoryHierarchical::BuildCommandList_HierarchicalBrickBuilding(const Pi
 	PROFILE_COMPUTE_PUSH_RANGE("Brick Building", m_CommandList.Get());
 
 	// Multiple iterations will be made until the brick size is small enough
-	UINT iterations = 0;
-	while (resources.GetBrickBuildParams().SubBrickSize >= object->GetNextRebuildBrickSize() && iterations++ < maxIterations)
-	{
-		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(45), L"Brick Building Iteration");
-
-		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(46), L"Brick Counting");
-		// Step 3.1: Dispatch brick counter
-		pipeline[SDFFactoryPipeline::BrickCounter]->Bind(m_CommandList.Get());
-
-		// Set root parameters
-		m_CommandList->SetComputeRoot32BitConstants(BrickCounterSignature::BuildParameterSlot, SizeOfInUint32(BrickBuildParametersConstantBuffer), &resources.GetBrickBuildParams(), 0);
-		m_CommandList->SetComputeRootShaderResourceView(BrickCounterSignature::BrickCounterSlot, resources.GetReadBrickCounter().GetAddress());
-		m_CommandList->SetComputeRootShaderResourceView(BrickCounterSignature::EditListSlot, resources.GetEditBuffer().GetAddress());
-		m_CommandList->SetComputeRootShaderResourceView(BrickCounterSignature::IndexBufferSlot, resources.GetReadIndexBuffer().GetAddress());
-		m_CommandList->SetComputeRootUnorderedAccessView(BrickCounterSignature::BricksSlot, resources.GetReadBrickBuffer().GetAddress());
-		m_CommandList->SetComputeRootUnorderedAccessView(BrickCounterSignature::CountTableSlot, resources.GetSubBrickCountBuffer().GetAddress());
-
-		PROFILE_COMPUTE_PUSH_RANGE("Brick Counting", m_CommandList.Get(), iterations);
-		// Indirectly dispatch compute shader
-		// The number of groups to dispatch is contained in the processed command buffer
-		// The contents of this buffer will be updated after each iteration to dispatch the correct number of groups
-		m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 0, nullptr, 0);
-		PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+	UINT iteration = 0;
+	while (BuildCommandList_BrickBuildingIteration(pipeline, object, resources, iteration, maxIterations))
+	{
+		iteration++;
+	}
 
-		{
-			// Insert UAV barriers to make sure the first dispatch has finished writing to the brick buffer
-			const D3D12_RESOURCE_BARRIER uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(resources.GetReadBrickBuffer().GetResource());
-			m_CommandList->ResourceBarrier(1, &uavBarrier);
-		}
+	BuildCommandList_BrickBuildingReadback(resources);
+
+	PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+	PIXEndEvent(m_CommandList.Get());
+}
+
+bool SDFFactoryHierarchical::BuildCommandList_BrickBuildingIteration(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources, UINT iteration, UINT maxIterations) const
+{
+	if (resources.GetBrickBuildParams().SubBrickSize < object->GetNextRebuildBrickSize() || iteration >= maxIterations)
+		return false;
+
+	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(45), L"Brick Building Iteration");
+
+	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(46), L"Brick Counting");
+	// Step 3.1: Dispatch brick counter
+	pipeline[SDFFactoryPipeline::BrickCounter]->Bind(m_CommandList.Get());
+
+	// Set root parameters
+	m_CommandList->SetComputeRoot32BitConstants(BrickCounterSignature::BuildParameterSlot, SizeOfInUint32(BrickBuildParametersConstantBuffer), &resources.GetBrickBuildParams(), 0);
+	m_CommandList->SetComputeRootShaderResourceView(BrickCounterSignature::BrickCounterSlot, resources.GetReadBrickCounter().GetAddress());
+	m_CommandList->SetComputeRootShaderResourceView(BrickCounterSignature::EditListSlot, resources.GetEditBuffer().GetAddress());
+	m_CommandList->SetComputeRootShaderResourceView(BrickCounterSignature::IndexBufferSlot, resources.GetReadIndexBuffer().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(BrickCounterSignature::BricksSlot, resources.GetReadBrickBuffer().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(BrickCounterSignature::CountTableSlot, resources.GetSubBrickCountBuffer().GetAddress());
+
+	PROFILE_COMPUTE_PUSH_RANGE("Brick Counting", m_CommandList.Get(), iteration + 1);
+	// Indirectly dispatch compute shader
+	// The number of groups to dispatch is contained in the processed command buffer
+	// The contents of this buffer will be updated after each iteration to dispatch the correct number of groups
+	m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 0, nullptr, 0);
+	PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+
+	{
+		// Insert UAV barriers to make sure the first dispatch has finished writing to the brick buffer
+		const D3D12_RESOURCE_BARRIER uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(resources.GetReadBrickBuffer().GetResource());
+		m_CommandList->ResourceBarrier(1, &uavBarrier);
+	}
 
-		// Insert transition barriers for next stage of the pipeline
+	// Insert transition barriers for next stage of the pipeline
+	{
+		D3D12_RESOURCE_BARRIER barriers[] = {
+			// Transition brick buffers
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetReadBrickBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetWriteBrickBuffer().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetSubBrickCountBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
+
+	// Calculate thread group counts to dispatch for the prefix sum stages
+	{
 		{
 			D3D12_RESOURCE_BARRIER barriers[] = {
-				// Transition brick buffers
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetReadBrickBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetWriteBrickBuffer().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetSubBrickCountBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetCommandBuffer().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
 			};
 			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
 		}
 
-		// Calculate thread group counts to dispatch for the prefix sum stages
-		{
-			{
-				D3D12_RESOURCE_BARRIER barriers[] = {
-					CD3DX12_RESOURCE_BARRIER::Transition(resources.GetCommandBuffer().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-				};
-				m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
-			}
-
-			pipeline[SDFFactoryPipeline::ScanGroupCountCalculator]->Bind(m_CommandList.Get());
-			m_CommandList->SetComputeRootShaderResourceView(ScanThreadGroupCalculatorSignature::BrickCounterSlot, resources.GetReadBrickCounter().GetAddress());
-			m_CommandList->SetComputeRootUnorderedAccessView(ScanThreadGroupCalculatorSignature::IndirectCommandArgumentSlot, resources.GetCommandBuffer().GetAddress() + sizeof(D3D12_DISPATCH_ARGUMENTS));
-			m_CommandList->Dispatch(1, 1, 1);
-
-			{
-				D3D12_RESOURCE_BARRIER barriers[] = {
-					CD3DX12_RESOURCE_BARRIER::UAV(resources.GetCommandBuffer().GetResource()),
-					CD3DX12_RESOURCE_BARRIER::Transition(resources.GetCommandBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT)
-				};
-				m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
-			}
-		}
-
-		PIXEndEvent(m_CommandList.Get());
-		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(47), L"Calculate prefix sum");
+		pipeline[SDFFactoryPipeline::ScanGroupCountCalculator]->Bind(m_CommandList.Get());
+		m_CommandList->SetComputeRootShaderResourceView(ScanThreadGroupCalculatorSignature::BrickCounterSlot, resources.GetReadBrickCounter().GetAddress());
+		m_CommandList->SetComputeRootUnorderedAccessView(ScanThreadGroupCalculatorSignature::IndirectCommandArgumentSlot, resources.GetCommandBuffer().GetAddress() + sizeof(D3D12_DISPATCH_ARGUMENTS));
+		m_CommandList->Dispatch(1, 1, 1);
 
-		// Step 3.2: Calculate prefix sums. This is done with 3 dispatches
 		{
-			PROFILE_COMPUTE_PUSH_RANGE("Prefix Sum", m_CommandList.Get(), iterations);
-
-			pipeline[SDFFactoryPipeline::ScanBlocks]->Bind(m_CommandList.Get());
-			m_CommandList->SetComputeRootShaderResourceView(BrickScanSignature::CountTableSlot, resources.GetSubBrickCountBuffer().GetAddress());
-			m_CommandList->SetComputeRootShaderResourceView(BrickScanSignature::NumberOfCountsSlot, resources.GetReadBrickCounter().GetAddress());
-			m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::BlockPrefixSumTableSlot, resources.GetBlockPrefixSumsBuffer().GetAddress());
-			m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::PrefixSumTableSlot, resources.GetPrefixSumsBuffer().GetAddress());
-
-			m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 1 * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
-
-			{
-				const D3D12_RESOURCE_BARRIER uavBarriers[] = {
-					CD3DX12_RESOURCE_BARRIER::UAV(resources.GetBlockPrefixSumsBuffer().GetResource()),
-					CD3DX12_RESOURCE_BARRIER::UAV(resources.GetPrefixSumsBuffer().GetResource())
-				};
-				m_CommandList->ResourceBarrier(ARRAYSIZE(uavBarriers), uavBarriers);
-			}
-
-			pipeline[SDFFactoryPipeline::ScanBlockSums]->Bind(m_CommandList.Get());
-			m_CommandList->SetComputeRootShaderResourceView(BrickScanSignature::NumberOfCountsSlot, resources.GetReadBrickCounter().GetAddress());
-			m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::BlockPrefixSumTableSlot, resources.GetBlockPrefixSumsBuffer().GetAddress());
-			m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::BlockPrefixSumOutputTableSlot, resources.GetBlockPrefixSumsOutputBuffer().GetAddress());
-
-			// Execute this stage up to twice for support for up to 262,000 input bricks (output can be up to 64x this)
-			m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 2 * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
+			D3D12_RESOURCE_BARRIER barriers[] = {
+				CD3DX12_RESOURCE_BARRIER::UAV(resources.GetCommandBuffer().GetResource()),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetCommandBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT)
+			};
+			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+		}
+	}
 
-			{
-				const D3D12_RESOURCE_BARRIER uavBarriers[] = {
-					CD3DX12_RESOURCE_BARRIER::UAV(resources.GetBlockPrefixSumsBuffer().GetResource()),
-				};
-				m_CommandList->ResourceBarrier(ARRAYSIZE(uavBarriers), uavBarriers);
-			}
+	PIXEndEvent(m_CommandList.Get());
+	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(47), L"Calculate prefix sum");
 
-			pipeline[SDFFactoryPipeline::SumScans]->Bind(m_CommandList.Get());
-			m_CommandList->SetComputeRootShaderResourceView(BrickScanSignature::NumberOfCountsSlot, resources.GetReadBrickCounter().GetAddress());
-			m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::BlockPrefixSumOutputTableSlot, resources.GetBlockPrefixSumsOutputBuffer().GetAddress());
-			m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::PrefixSumTableSlot, resources.GetPrefixSumsBuffer().GetAddress());
+	// Step 3.2: Calculate prefix sums. This is done with 3 dispatches
+	{
+		PROFILE_COMPUTE_PUSH_RANGE("Prefix Sum", m_CommandList.Get(), iteration + 1);
 
-			m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 3 * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
+		pipeline[SDFFactoryPipeline::ScanBlocks]->Bind(m_CommandList.Get());
+		m_CommandList->SetComputeRootShaderResourceView(BrickScanSignature::CountTableSlot, resources.GetSubBrickCountBuffer().GetAddress());
+		m_CommandList->SetComputeRootShaderResourceView(BrickScanSignature::NumberOfCountsSlot, resources.GetReadBrickCounter().GetAddress());
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::BlockPrefixSumTableSlot, resources.GetBlockPrefixSumsBuffer().GetAddress());
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::PrefixSumTableSlot, resources.GetPrefixSumsBuffer().GetAddress());
 
-			{
-				const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resources.GetPrefixSumsBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-				m_CommandList->ResourceBarrier(1, &barrier);
-			}
+		m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 1 * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
 
-			PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+		{
+			const D3D12_RESOURCE_BARRIER uavBarriers[] = {
+				CD3DX12_RESOURCE_BARRIER::UAV(resources.GetBlockPrefixSumsBuffer().GetResource()),
+				CD3DX12_RESOURCE_BARRIER::UAV(resources.GetPrefixSumsBuffer().GetResource())
+			};
+			m_CommandList->ResourceBarrier(ARRAYSIZE(uavBarriers), uavBarriers);
 		}
 
-		PIXEndEvent(m_CommandList.Get());
-		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(48), L"Build sub-bricks");
-
-		// Step 3.3: Dispatch brick builder
-		// This step will make use of the ping-pong buffers to output the next collection of bricks to process
-		pipeline[SDFFactoryPipeline::BrickBuilder]->Bind(m_CommandList.Get());
-
-		// Set root parameters
-		m_CommandList->SetComputeRoot32BitConstants(BrickBuilderSignature::BuildParameterSlot, SizeOfInUint32(BrickBuildParametersConstantBuffer), &resources.GetBrickBuildParams(), 0);
-		m_CommandList->SetComputeRootShaderResourceView(BrickBuilderSignature::InBrickCounterSlot, resources.GetReadBrickCounter().GetAddress());
-		m_CommandList->SetComputeRootShaderResourceView(BrickBuilderSignature::InBricksSlot, resources.GetReadBrickBuffer().GetAddress());
-		m_CommandList->SetComputeRootShaderResourceView(BrickBuilderSignature::PrefixSumTableSlot, resources.GetPrefixSumsBuffer().GetAddress());
-		m_CommandList->SetComputeRootUnorderedAccessView(BrickBuilderSignature::OutBrickCounterSlot, resources.GetWriteBrickCounter().GetAddress());
-		m_CommandList->SetComputeRootUnorderedAccessView(BrickBuilderSignature::OutBricksSlot, resources.GetWriteBrickBuffer().GetAddress());
-
-		PROFILE_COMPUTE_PUSH_RANGE("Brick Building", m_CommandList.Get(), iterations);
-		// Indirectly dispatch compute shader
-		// The number of groups to dispatch is contained in the processed command buffer
-		// The contents of this buffer will be updated after each iteration to dispatch the correct number of groups
-		m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 0, nullptr, 0);
+		pipeline[SDFFactoryPipeline::ScanBlockSums]->Bind(m_CommandList.Get());
+		m_CommandList->SetComputeRootShaderResourceView(BrickScanSignature::NumberOfCountsSlot, resources.GetReadBrickCounter().GetAddress());
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::BlockPrefixSumTableSlot, resources.GetBlockPrefixSumsBuffer().GetAddress());
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::BlockPrefixSumOutputTableSlot, resources.GetBlockPrefixSumsOutputBuffer().GetAddress());
 
-		PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+		// Execute this stage up to twice for support for up to 262,000 input bricks (output can be up to 64x this)
+		m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 2 * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
 
 		{
-			// Insert UAV barriers to make sure the first dispatch has finished writing to the brick buffer
 			const D3D12_RESOURCE_BARRIER uavBarriers[] = {
-				CD3DX12_RESOURCE_BARRIER::UAV(resources.GetWriteBrickBuffer().GetResource()),
-				CD3DX12_RESOURCE_BARRIER::UAV(resources.GetWriteBrickCounter().GetResource())
+				CD3DX12_RESOURCE_BARRIER::UAV(resources.GetBlockPrefixSumsBuffer().GetResource()),
 			};
 			m_CommandList->ResourceBarrier(ARRAYSIZE(uavBarriers), uavBarriers);
 		}
 
-		// Insert transition barriers for next stage of the pipeline
+		pipeline[SDFFactoryPipeline::SumScans]->Bind(m_CommandList.Get());
+		m_CommandList->SetComputeRootShaderResourceView(BrickScanSignature::NumberOfCountsSlot, resources.GetReadBrickCounter().GetAddress());
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::BlockPrefixSumOutputTableSlot, resources.GetBlockPrefixSumsOutputBuffer().GetAddress());
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickScanSignature::PrefixSumTableSlot, resources.GetPrefixSumsBuffer().GetAddress());
+
+		m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 3 * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
+
 		{
-			D3D12_RESOURCE_BARRIER barriers[] = {
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetCommandBuffer().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST),
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetWriteBrickCounter().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE)
-			};
-			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+			const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resources.GetPrefixSumsBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_CommandList->ResourceBarrier(1, &barrier);
 		}
 
-		// Copy the counter that was just written to into the groups X of the dispatch args
-		m_CommandList->CopyBufferRegion(resources.GetCommandBuffer().GetResource(), 0, resources.GetWriteBrickCounter().GetResource(), 0, sizeof(UINT32));
-		// Reset the other counter to 0
-		resources.GetReadBrickCounter().SetValue(m_CommandList.Get(), m_CounterUploadZero.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		// Reset index counter to 0
-		resources.GetIndexCounter().SetValue(m_CommandList.Get(), m_CounterUploadZero.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+	}
+
+	PIXEndEvent(m_CommandList.Get());
+	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(48), L"Build sub-bricks");
+
+	// Step 3.3: Dispatch brick builder
+	// This step will make use of the ping-pong buffers to output the next collection of bricks to process
+	pipeline[SDFFactoryPipeline::BrickBuilder]->Bind(m_CommandList.Get());
+
+	// Set root parameters
+	m_CommandList->SetComputeRoot32BitConstants(BrickBuilderSignature::BuildParameterSlot, SizeOfInUint32(BrickBuildParametersConstantBuffer), &resources.GetBrickBuildParams(), 0);
+	m_CommandList->SetComputeRootShaderResourceView(BrickBuilderSignature::InBrickCounterSlot, resources.GetReadBrickCounter().GetAddress());
+	m_CommandList->SetComputeRootShaderResourceView(BrickBuilderSignature::InBricksSlot, resources.GetReadBrickBuffer().GetAddress());
+	m_CommandList->SetComputeRootShaderResourceView(BrickBuilderSignature::PrefixSumTableSlot, resources.GetPrefixSumsBuffer().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(BrickBuilderSignature::OutBrickCounterSlot, resources.GetWriteBrickCounter().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(BrickBuilderSignature::OutBricksSlot, resources.GetWriteBrickBuffer().GetAddress());
+
+	PROFILE_COMPUTE_PUSH_RANGE("Brick Building", m_CommandList.Get(), iteration + 1);
+	// Indirectly dispatch compute shader
+	// The number of groups to dispatch is contained in the processed command buffer
+	// The contents of this buffer will be updated after each iteration to dispatch the correct number of groups
+	m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 0, nullptr, 0);
 
-		PIXEndEvent(m_CommandList.Get());
-		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(49), L"Cull edits");
+	PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
 
-		{
-			D3D12_RESOURCE_BARRIER barriers[] = {
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetCommandBuffer().GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetSubBrickCountBuffer().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetPrefixSumsBuffer().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-			};
-			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
-		}
+	{
+		// Insert UAV barriers to make sure the first dispatch has finished writing to the brick buffer
+		const D3D12_RESOURCE_BARRIER uavBarriers[] = {
+			CD3DX12_RESOURCE_BARRIER::UAV(resources.GetWriteBrickBuffer().GetResource()),
+			CD3DX12_RESOURCE_BARRIER::UAV(resources.GetWriteBrickCounter().GetResource())
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(uavBarriers), uavBarriers);
+	}
+
+	// Insert transition barriers for next stage of the pipeline
+	{
+		D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetCommandBuffer().GetResource(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST),
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetWriteBrickCounter().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE)
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
 
-		pipeline[SDFFactoryPipeline::EditTester]->Bind(m_CommandList.Get());
+	// Copy the counter that was just written to into the groups X of the dispatch args
+	m_CommandList->CopyBufferRegion(resources.GetCommandBuffer().GetResource(), 0, resources.GetWriteBrickCounter().GetResource(), 0, sizeof(UINT32));
+	// Reset the other counter to 0
+	resources.GetReadBrickCounter().SetValue(m_CommandList.Get(), m_CounterUploadZero.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	// Reset index counter to 0
+	resources.GetIndexCounter().SetValue(m_CommandList.Get(), m_CounterUploadZero.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
-		m_CommandList->SetComputeRoot32BitConstants(EditTesterSignature::BuildParameterSlot, SizeOfInUint32(BrickBuildParametersConstantBuffer), &resources.GetBrickBuildParams(), 0);
-		m_CommandList->SetComputeRootShaderResourceView(EditTesterSignature::EditListSlot, resources.GetEditBuffer().GetAddress());
-		m_CommandList->SetComputeRootShaderResourceView(EditTesterSignature::InIndexBufferSlot, resources.GetReadIndexBuffer().GetAddress());
-		m_CommandList->SetComputeRootShaderResourceView(EditTesterSignature::EditDependenciesSlot, resources.GetEditDependencyBuffer().GetAddress());
-		m_CommandList->SetComputeRootUnorderedAccessView(EditTesterSignature::BrickSlot, resources.GetWriteBrickBuffer().GetAddress());
-		m_CommandList->SetComputeRootUnorderedAccessView(EditTesterSignature::OutIndexBufferSlot, resources.GetWriteIndexBuffer().GetAddress());
-		m_CommandList->SetComputeRootUnorderedAccessView(EditTesterSignature::OutIndexCounterSlot, resources.GetIndexCounter().GetAddress());
+	PIXEndEvent(m_CommandList.Get());
+	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(49), L"Cull edits");
 
-		PROFILE_COMPUTE_PUSH_RANGE("Edit Culling", m_CommandList.Get(), iterations);
-		// Dispatch edit tester
-		// Execute for the number of groups that were just written
-		m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 0, nullptr, 0);
+	{
+		D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetCommandBuffer().GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetSubBrickCountBuffer().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetPrefixSumsBuffer().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
 
-		PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+	pipeline[SDFFactoryPipeline::EditTester]->Bind(m_CommandList.Get());
 
-		// Barriers to wait for work to complete
-		{
-			D3D12_RESOURCE_BARRIER barriers[] = {
-				CD3DX12_RESOURCE_BARRIER::UAV(resources.GetWriteBrickBuffer().GetResource()),
-				CD3DX12_RESOURCE_BARRIER::UAV(resources.GetIndexCounter().GetResource()),
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetReadIndexBuffer().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetWriteIndexBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetWriteBrickCounter().GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-			};
-			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
-		}
+	m_CommandList->SetComputeRoot32BitConstants(EditTesterSignature::BuildParameterSlot, SizeOfInUint32(BrickBuildParametersConstantBuffer), &resources.GetBrickBuildParams(), 0);
+	m_CommandList->SetComputeRootShaderResourceView(EditTesterSignature::EditListSlot, resources.GetEditBuffer().GetAddress());
+	m_CommandList->SetComputeRootShaderResourceView(EditTesterSignature::InIndexBufferSlot, resources.GetReadIndexBuffer().GetAddress());
+	m_CommandList->SetComputeRootShaderResourceView(EditTesterSignature::EditDependencyIndicesSlot, resources.GetEditDependencyIndexBuffer().GetAddress());
+	m_CommandList->SetComputeRootShaderResourceView(EditTesterSignature::EditDependencyOffsetsSlot, resources.GetEditDependencyOffsetBuffer().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(EditTesterSignature::BrickSlot, resources.GetWriteBrickBuffer().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(EditTesterSignature::OutIndexBufferSlot, resources.GetWriteIndexBuffer().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(EditTesterSignature::OutIndexCounterSlot, resources.GetIndexCounter().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(EditTesterSignature::OutIndexOverflowSlot, resources.GetIndexOverflowCounter().GetAddress());
 
-		// Swap buffers and update brick size
-		resources.SwapBuffersAndRefineBrickSize();
+	PROFILE_COMPUTE_PUSH_RANGE("Edit Culling", m_CommandList.Get(), iteration + 1);
+	// Dispatch edit tester
+	// Execute for the number of groups that were just written
+	m_CommandList->ExecuteIndirect(m_CommandSignature.Get(), 1, resources.GetCommandBuffer().GetResource(), 0, nullptr, 0);
 
-		PIXEndEvent(m_CommandList.Get());
-		PIXEndEvent(m_CommandList.Get());
+	PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+
+	// Barriers to wait for work to complete
+	{
+		D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::UAV(resources.GetWriteBrickBuffer().GetResource()),
+			CD3DX12_RESOURCE_BARRIER::UAV(resources.GetIndexCounter().GetResource()),
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetReadIndexBuffer().GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetWriteIndexBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(resources.GetWriteBrickCounter().GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
 	}
 
+	// Swap buffers and update brick size
+	resources.SwapBuffersAndRefineBrickSize();
+
+	PIXEndEvent(m_CommandList.Get());
+	PIXEndEvent(m_CommandList.Get());
+
+	return true;
+}
+
+void SDFFactoryHierarchical::BuildCommandList_BrickBuildingReadback(SDFConstructionResources& resources) const
+{
 	// Once all bricks have been built,
 	// copy the final number of bricks back to the CPU for the next stage
 	resources.GetReadBrickCounter().ReadValue(m_CommandList.Get(), resources.GetBrickCounterReadbackBuffer().GetResource(), 
@@ -833,13 +1748,114 @@ void SDFFactoryHierarchical::BuildCommandList_HierarchicalBrickBuilding(const Pi
 	// Also copy the final number of indices
 	resources.GetIndexCounter().ReadValue(m_CommandList.Get(), resources.GetIndexCounterReadbackBuffer().GetResource(), 
 		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	// And whether any iteration ran out of space for indices
+	resources.GetIndexOverflowCounter().ReadValue(m_CommandList.Get(), resources.GetIndexOverflowReadbackBuffer().GetResource(), 
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+}
+
+void SDFFactoryHierarchical::BuildCommandList_BrickRelease(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources) const
+{
+	PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(57), L"Release bricks");
+
+	resources.GetFreeBrickCounter().SetValue(m_CommandList.Get(), m_CounterUploadZero.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	resources.GetReleasedIndexCounter().SetValue(m_CommandList.Get(), m_CounterUploadZero.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
+	{
+		const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resources.GetFreeBrickBuffer().GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_CommandList->ResourceBarrier(1, &barrier);
+	}
+
+	pipeline[SDFFactoryPipeline::BrickReleaser]->Bind(m_CommandList.Get());
+
+	m_CommandList->SetComputeRoot32BitConstants(BrickReleaserSignature::IncrementalParameterSlot, SizeOfInUint32(IncrementalBakeConstantBuffer), &resources.GetIncrementalParams(), 0);
+	m_CommandList->SetComputeRootShaderResourceView(BrickReleaserSignature::BricksSlot, object->GetBrickBufferAddress(SDFObject::RESOURCES_WRITE));
+	m_CommandList->SetComputeRootUnorderedAccessView(BrickReleaserSignature::FreeBricksSlot, resources.GetFreeBrickBuffer().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(BrickReleaserSignature::FreeBrickCounterSlot, resources.GetFreeBrickCounter().GetAddress());
+	m_CommandList->SetComputeRootUnorderedAccessView(BrickReleaserSignature::ReleasedIndexCounterSlot, resources.GetReleasedIndexCounter().GetAddress());
+
+	PROFILE_COMPUTE_PUSH_RANGE("Brick Releasing", m_CommandList.Get());
+	const UINT threadGroupX = (resources.GetIncrementalParams().BrickCount + BRICK_MERGING_THREADS - 1) / BRICK_MERGING_THREADS;
+	m_CommandList->Dispatch(threadGroupX, 1, 1);
 	PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+
+	{
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::UAV(resources.GetFreeBrickCounter().GetResource()),
+			CD3DX12_RESOURCE_BARRIER::UAV(resources.GetReleasedIndexCounter().GetResource()),
+		};
+		m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
+
+	// The number of free slots decides where the new bricks are placed, so it must be read back before they can be merged
+	resources.GetFreeBrickCounter().ReadValue(m_CommandList.Get(), resources.GetFreeBrickCounterReadbackBuffer().GetResource(),
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	resources.GetReleasedIndexCounter().ReadValue(m_CommandList.Get(), resources.GetReleasedIndexCounterReadbackBuffer().GetResource(),
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
 	PIXEndEvent(m_CommandList.Get());
 }
 
-void SDFFactoryHierarchical::BuildCommandList_BrickEvaluation(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources) const
+void SDFFactoryHierarchical::BuildCommandList_BrickEvaluation(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources, bool incremental) const
 {
+	if (incremental)
+	{
+		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(43), L"Merge Bricks");
+
+		{
+			D3D12_RESOURCE_BARRIER barriers[] =
+			{
+				CD3DX12_RESOURCE_BARRIER::Transition(object->GetAABBBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+				CD3DX12_RESOURCE_BARRIER::Transition(object->GetBrickBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetFreeBrickBuffer().GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetBrickSlotBuffer().GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+			};
+			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+		}
+
+		pipeline[SDFFactoryPipeline::BrickMerger]->Bind(m_CommandList.Get());
+
+		const IncrementalBakeConstantBuffer& incrementalParams = resources.GetIncrementalParams();
+		m_CommandList->SetComputeRoot32BitConstants(BrickMergerSignature::IncrementalParameterSlot, SizeOfInUint32(IncrementalBakeConstantBuffer), &incrementalParams, 0);
+		m_CommandList->SetComputeRootShaderResourceView(BrickMergerSignature::NewBricksSlot, resources.GetReadBrickBuffer().GetAddress());
+		m_CommandList->SetComputeRootShaderResourceView(BrickMergerSignature::FreeBricksSlot, resources.GetFreeBrickBuffer().GetAddress());
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickMergerSignature::BricksSlot, object->GetBrickBufferAddress(SDFObject::RESOURCES_WRITE));
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickMergerSignature::AABBsSlot, object->GetAABBBufferAddress(SDFObject::RESOURCES_WRITE));
+		m_CommandList->SetComputeRootUnorderedAccessView(BrickMergerSignature::BrickSlotsSlot, resources.GetBrickSlotBuffer().GetAddress());
+
+		PROFILE_COMPUTE_PUSH_RANGE("Brick Merging", m_CommandList.Get());
+
+		// Every new brick and every free slot needs a thread
+		const UINT threadCount = max(incrementalParams.NewBrickCount, incrementalParams.ReleasedBrickCount);
+		const UINT threadGroupX = (threadCount + BRICK_MERGING_THREADS - 1) / BRICK_MERGING_THREADS;
+		m_CommandList->Dispatch(threadGroupX, 1, 1);
+		PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
+
+		{
+			D3D12_RESOURCE_BARRIER barriers[] =
+			{
+				CD3DX12_RESOURCE_BARRIER::Transition(object->GetAABBBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(object->GetBrickBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(resources.GetBrickSlotBuffer().GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(object->GetIndexBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+			};
+			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+		}
+
+		{
+			// Append the indices of the new bricks to the object's index buffer
+			const UINT64 numBytes = (object->GetIndexCount(SDFObject::RESOURCES_WRITE) - incrementalParams.IndexOffset) * sizeof(UINT);
+			if (numBytes > 0)
+				m_CommandList->CopyBufferRegion(object->GetIndexBuffer(SDFObject::RESOURCES_WRITE), incrementalParams.IndexOffset * sizeof(UINT), resources.GetReadIndexBuffer().GetResource(), 0, numBytes);
+		}
+
+		{
+			const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(object->GetIndexBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			m_CommandList->ResourceBarrier(1, &barrier);
+		}
+
+		PIXEndEvent(m_CommandList.Get());
+	}
+	else
 	{
 		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(43), L"Build AABBs");
 
@@ -865,9 +1881,7 @@ void SDFFactoryHierarchical::BuildCommandList_BrickEvaluation(const PipelineSet&
 		PROFILE_COMPUTE_POP_RANGE(m_CommandList.Get());
 
 		PIXEndEvent(m_CommandList.Get());
-	}
 
-	{
 		PIXBeginEvent(m_CommandList.Get(), PIX_COLOR_INDEX(52), L"Copy Brick Data");
 
 		{
@@ -886,8 +1900,20 @@ void SDFFactoryHierarchical::BuildCommandList_BrickEvaluation(const PipelineSet&
 		}
 		{
 			// Copy index data from temp buffer into objects brick buffer
-			const UINT64 numBytes = object->GetIndexBuffer(SDFObject::RESOURCES_WRITE)->GetDesc().Width;
-			m_CommandList->CopyBufferRegion(object->GetIndexBuffer(SDFObject::RESOURCES_WRITE), 0, resources.GetReadIndexBuffer().GetResource(), 0, numBytes);
+			// The object's index buffer has room for incremental bakes, so only the used indices are copied
+			const UINT64 numBytes = object->GetIndexCount(SDFObject::RESOURCES_WRITE) * sizeof(UINT);
+			if (numBytes > 0)
+				m_CommandList->CopyBufferRegion(object->GetIndexBuffer(SDFObject::RESOURCES_WRITE), 0, resources.GetReadIndexBuffer().GetResource(), 0, numBytes);
+		}
+
+		{
+			D3D12_RESOURCE_BARRIER barriers[] =
+			{
+				CD3DX12_RESOURCE_BARRIER::Transition(object->GetAABBBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(object->GetBrickBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(object->GetIndexBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			};
+			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
 		}
 
 		PIXEndEvent(m_CommandList.Get());
@@ -904,9 +1930,6 @@ void SDFFactoryHierarchical::BuildCommandList_BrickEvaluation(const PipelineSet&
 			D3D12_RESOURCE_BARRIER barriers[] =
 			{
 				CD3DX12_RESOURCE_BARRIER::Transition(object->GetBrickPool(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-				CD3DX12_RESOURCE_BARRIER::Transition(object->GetAABBBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-				CD3DX12_RESOURCE_BARRIER::Transition(object->GetBrickBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-				CD3DX12_RESOURCE_BARRIER::Transition(object->GetIndexBuffer(SDFObject::RESOURCES_WRITE), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
 			};
 			m_CommandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
 		}
@@ -918,6 +1941,7 @@ void SDFFactoryHierarchical::BuildCommandList_BrickEvaluation(const PipelineSet&
 		m_CommandList->SetComputeRootShaderResourceView(BrickEvaluatorSignature::EditListSlot, resources.GetEditBuffer().GetAddress());
 		m_CommandList->SetComputeRootShaderResourceView(BrickEvaluatorSignature::IndexBufferSlot, object->GetIndexBufferAddress(SDFObject::RESOURCES_WRITE));
 		m_CommandList->SetComputeRootShaderResourceView(BrickEvaluatorSignature::BrickBufferSlot, object->GetBrickBufferAddress(SDFObject::RESOURCES_WRITE));
+		m_CommandList->SetComputeRootShaderResourceView(BrickEvaluatorSignature::BrickSlotsSlot, resources.GetBrickSlotBuffer().GetAddress());
 		m_CommandList->SetComputeRootDescriptorTable(BrickEvaluatorSignature::BrickPoolSlot, object->GetDescriptor(SDFObject::RESOURCES_WRITE, SDFObject::POOL_UAV));
 
 		PROFILE_COMPUTE_PUSH_RANGE("Brick Evaluation", m_CommandList.Get());
@@ -6,19 +6,24 @@
 #include "Renderer/Buffer/UploadBuffer.h"
 
 #include "SDFConstructionResources.h"
+#include "SDF/SDFObject.h"
+#include "SDF/SDFBakeData.h"
+#include "SDF/SDFDirtyRegion.h"
+
+#include <condition_variable>
 
 
 using Microsoft::WRL::ComPtr;
 
-class SDFObject;
 class SDFEditList;
+class SDFBakeFile;
+class SDFBrickPageFile;
 
 namespace SDFFactoryPipeline
 {
 	enum Value
 	{
-		EditDependency = 0,
-		BrickCounter,
+		BrickCounter = 0,
 		ScanGroupCountCalculator,
 		ScanBlocks,
 		ScanBlockSums,
@@ -27,6 +32,8 @@ namespace SDFFactoryPipeline
 		EditTester,
 		MortonEnumerator,
 		AABBBuilder,
+		BrickReleaser,
+		BrickMerger,
 		BrickEvaluator,
 		Count
 	};
@@ -44,28 +51,148 @@ public:
 	DISALLOW_COPY(SDFFactoryHierarchical)
 	DEFAULT_MOVE(SDFFactoryHierarchical)
 
-	virtual void BakeSDFSync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList);
+	// If a dirty region is given, only the bricks that overlap it (and any other region that is stale) are rebuilt
+	// Otherwise the whole object is rebuilt
+	virtual void BakeSDFSync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion* dirtyRegion = nullptr);
+
+	struct BatchItem
+	{
+		SDFObject* Object = nullptr;
+		const SDFEditList* EditList = nullptr;
+		const SDFDirtyRegion* DirtyRegion = nullptr;	// Rebuilds the whole object if null
+	};
+	// Bakes several objects together, with one submission for building all of their bricks and one for evaluating them,
+	// rather than two for each object. Objects that are being baked elsewhere are skipped.
+	// Returns once every object has been baked
+	virtual void BakeSDFBatchSync(const std::wstring& pipelineName, const std::vector<BatchItem>& items);
 
 	inline void SetMaxBrickBuildIterations(UINT maxIterations) { m_MaxBrickBuildIterations = maxIterations; }
 	inline UINT GetMaxBrickBuildIterations() const { return m_MaxBrickBuildIterations; }
 
-protected:
+	// Incremental bakes start brick building from the smallest bricks that cover the rebuilt region,
+	// rather than refining the whole evaluation space down from the root bricks
+	inline void SetHierarchySeedingEnabled(bool enabled) { m_EnableHierarchySeeding = enabled; }
+	inline bool GetHierarchySeedingEnabled() const { return m_EnableHierarchySeeding; }
+
+	// Bakes are recorded into a ring of contexts, each with its own command list and construction resources,
+	// so that the CPU can prepare a bake while the GPU is still executing the ones before it
+	// A context is only reused once the GPU has finished with it. A depth of 1 disables pipelining
+	// The new depth takes effect at the start of the next bake
+	inline void SetPipelineDepth(UINT depth) { m_RequestedPipelineDepth = (std::max)(depth, 1u); }
+	inline UINT GetPipelineDepth() const { return m_RequestedPipelineDepth; }
+
+	// Copies the baked resources of an object back to the CPU, for comparison against the CPU factory
+	// This blocks until the readback is complete, and the object must not be being baked into or rendered from
+	void ReadbackBakeData(SDFObject* object, SDFObject::ResourceGroup res, SDFBakeData& outData);
+
+	// Uploads a bake from a file into the write resources of an object, in place of baking it
+	// The sections of the file are copied straight from the mapping into one upload buffer. This blocks until the upload is complete
+	// Returns false if the object is being baked elsewhere, or the file has no bricks
+	virtual bool LoadBakeFileSync(SDFObject* object, const SDFBakeFile& file);
+	// Uploads the bricks and AABBs of a page file into the write resources of an object, and allocates a brick pool
+	// with the given dimensions that pages are streamed into. Every brick is non-resident until its page is streamed in
+	// This blocks until the upload is complete. Returns false if the object is being baked elsewhere
+	virtual bool LoadBrickPageFileSync(SDFObject* object, const SDFBrickPageFile& file, const XMUINT3& brickPoolDimensions);
+
+	// Starts creating a pipeline set for a permutation of defines on worker threads, and returns without waiting for it
+	// Bakes that use the set before it is complete wait for it. Does nothing if a set with that name already exists
+	void CreatePipelineSetAsync(const std::wstring& name, const std::vector<std::wstring>& defines);
+	bool HasPipelineSet(const std::wstring& name) const;
 
-	void CreatePipelineSet(const std::wstring& name, const std::vector<std::wstring>& defines);
+protected:
 
-	void PerformSDFBake_CPUBlocking(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList);
+	// Returns once the set has been created. Its pipelines are still created in parallel
+	// Returns false if the set could not be created, in which case the error has been logged
+	bool CreatePipelineSet(const std::wstring& name, const std::vector<std::wstring>& defines);
+	// Waits for the set if it is still being created. The lock is not held while waiting
+	// Returns null if there is no set with that name, or if it could not be created. A set that fails is logged and removed
+	const PipelineSet* GetPipelineSet(const std::wstring& name);
+	// Bakes that ask for a set that could not be created use the default set instead
+	const PipelineSet& GetPipelineSetForBake(const std::wstring& name);
+
+	// Called by synchronous bakes and batch bakes for each object they accept, before it is baked
+	// Objects that are being baked elsewhere are not accepted, and are left to a later bake
+	virtual void OnSyncBakeAccepted(const std::wstring& pipelineName, const SDFObject* object, const SDFEditList& editList) {}
+
+	// Only the bricks within the stale region are rebuilt, if the object's write resources allow it
+	// The stale region must be taken from the object at the same time as the edit list is captured
+	void PerformSDFBake_CPUBlocking(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion& staleRegion);
+	// As above, but returns once the evaluation of the bricks has been submitted rather than completed
+	// The bake is complete once the GPU reaches m_PreviousWorkFence
+	void SubmitSDFBake(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion& staleRegion);
+
+	// The state of one object's bake as it passes through the stages
+	struct BakeJob
+	{
+		SDFObject* Object = nullptr;
+		const SDFEditList* EditList = nullptr;
+		SDFDirtyRegion StaleRegion;
+		SDFConstructionResources* Resources = nullptr;
+
+		float EvalSpaceSize = 0.0f;
+		bool Incremental = false;
+		UINT SkippedIterations = 0;
+	};
+	// The iterations of every object's brick building are interleaved in one command list,
+	// and then every object's bricks are evaluated in another
+	void PerformSDFBatchBake_CPUBlocking(const std::wstring& pipelineName, std::vector<BakeJob>& jobs);
+	void SubmitSDFBatchBake(const std::wstring& pipelineName, std::vector<BakeJob>& jobs);
 
 
 private:
+	// Creates the root signature of each pipeline immediately, and compiles its shader as a task of the builder
+	void BuildPipelineSet(PipelineSet& pipelineSet, const std::vector<std::wstring>& defines, D3DPipelineBuilder& builder) const;
+
+	// Bake job stages, shared by single and batched bakes
+	void BeginBakeJob(BakeJob& job) const;
+	void PrepareBrickBuilding(BakeJob& job) const;
+	// Builds bricks until they fit the job's resources
+	void PerformBrickBuilding_CPUBlocking(const PipelineSet& pipelineSet, BakeJob& job);
+	// Returns false if brick building must be repeated, after adjusting the job so that it will succeed
+	bool CheckBrickBuilding(BakeJob& job) const;
+	void PrepareBrickEvaluation(BakeJob& job) const;
+
+	void ResetCommandList();
+	void ExecuteCommandList_CPUBlocking();
+	// Submits the command list at the end of a bake without waiting for it, and records the fence on the current context
+	void SubmitCommandList();
+
+	// Makes the next context in the ring current, waiting until the GPU has finished with it
+	void AdvanceContext_CPUBlocking();
+	void CreateContexts(UINT depth);
+
 	// SDF Bake stages
 	// Split into functions for readability and easy multi-threading
 	void BuildCommandList_Setup(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources) const;
 	void BuildCommandList_HierarchicalBrickBuilding(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources, UINT maxIterations) const;
-	void BuildCommandList_BrickEvaluation(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources) const;
+	// Returns false without recording anything once the bricks are small enough
+	bool BuildCommandList_BrickBuildingIteration(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources, UINT iteration, UINT maxIterations) const;
+	void BuildCommandList_BrickBuildingReadback(SDFConstructionResources& resources) const;
+	void BuildCommandList_BrickRelease(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources) const;
+	void BuildCommandList_BrickEvaluation(const PipelineSet& pipeline, SDFObject* object, SDFConstructionResources& resources, bool incremental) const;
 
 
 protected:
+	// Everything that a bake writes to on the CPU, which must not be modified while the GPU is executing the bake
+	struct BakeContext
+	{
+		ComPtr<ID3D12CommandAllocator> CommandAllocator;
+		ComPtr<ID3D12GraphicsCommandList> CommandList;
+
+		// Temporary resources used to construct an object
+		std::unique_ptr<SDFConstructionResources> Resources;
+		// Each object in a batch is constructed with its own resources
+		std::vector<std::unique_ptr<SDFConstructionResources>> BatchResources;
+
+		// Reached when the GPU has finished the last bake recorded into this context
+		UINT64 Fence = 0;
+	};
+	std::vector<BakeContext> m_Contexts;
+	UINT m_CurrentContext = 0;
+	std::atomic<UINT> m_RequestedPipelineDepth = 2;
+
 	// API objects
+	// These are the command allocator and list of the current context
 	ComPtr<ID3D12CommandAllocator> m_CommandAllocator;
 	ComPtr<ID3D12GraphicsCommandList> m_CommandList;
 
@@ -78,17 +205,26 @@ protected:
 	// Upload buffers that can be re-used for any build
 	// The counter reset buffers never have their contents changed so they can be part of the factory
 	UploadBuffer<UINT32> m_CounterUploadZero;	// Used to set a counter to 0
-	UploadBuffer<UINT32> m_CounterUpload64;	// Used to set a counter to 1
 
 	// Pipelines
-	std::map<std::wstring, PipelineSet> m_Pipelines;
+	struct PipelineSetEntry
+	{
+		PipelineSet Pipelines;
+		// Set until the pipelines have been created and waited on
+		// It is destroyed before the pipelines, so that no task can outlive the set it writes to
+		std::unique_ptr<D3DPipelineBuilder> Builder;
+		// Set while a thread waits on the builder, which it has taken out of the entry
+		bool Waiting = false;
+	};
+	std::map<std::wstring, PipelineSetEntry> m_Pipelines;
+	mutable std::mutex m_PipelineMutex;
+	// Signalled when a thread has finished waiting on a builder
+	std::condition_variable m_PipelineCondition;
 
 
 	// This fence is used to store when the last submitted work is complete
 	UINT64 m_PreviousWorkFence = 0;
 
 	std::atomic<UINT> m_MaxBrickBuildIterations = -1;
-
-	// Temporary resources used to construct an object
-	SDFConstructionResources m_Resources;
+	std::atomic<bool> m_EnableHierarchySeeding = true;
 };
@@ -6,6 +6,9 @@
 
 #include "pix3.h"
 
+#include <algorithm>
+#include <limits>
+
 
 SDFFactoryHierarchicalAsync::SDFFactoryHierarchicalAsync()
 {
@@ -17,41 +20,266 @@ SDFFactoryHierarchicalAsync::~SDFFactoryHierarchicalAsync()
 {
 	if (m_FactoryThread)
 	{
-		m_TerminateThread = true;
+		{
+			// Set under the lock so the thread can't miss the notification between checking and sleeping
+			std::lock_guard lockGuard(m_QueueMutex);
+			m_TerminateThread = true;
+		}
+		m_QueueCondition.notify_all();
 		m_FactoryThread->join();
 	}
 }
 
-void SDFFactoryHierarchicalAsync::BakeSDFSync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList)
+void SDFFactoryHierarchicalAsync::BakeSDFSync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion* dirtyRegion)
 {
 	if (m_AsyncInUse)
 	{
 		LOG_TRACE("Async compute in use - cannot perform sync bake.");
+		// The region must still be rebuilt by a later bake
+		object->InvalidateRegion(dirtyRegion ? *dirtyRegion : SDFDirtyRegion::Everything());
+		return;
+	}
+
+	SDFFactoryHierarchical::BakeSDFSync(pipelineName, object, std::move(editList), dirtyRegion);
+}
+
+void SDFFactoryHierarchicalAsync::BakeSDFBatchSync(const std::wstring& pipelineName, const std::vector<BatchItem>& items)
+{
+	if (m_AsyncInUse)
+	{
+		LOG_TRACE("Async compute in use - cannot perform sync batch bake.");
+		for (const auto& item : items)
+		{
+			item.Object->InvalidateRegion(item.DirtyRegion ? *item.DirtyRegion : SDFDirtyRegion::Everything());
+		}
 		return;
 	}
 
-	SDFFactoryHierarchical::BakeSDFSync(pipelineName, object, std::move(editList));
+	SDFFactoryHierarchical::BakeSDFBatchSync(pipelineName, items);
 }
 
+void SDFFactoryHierarchicalAsync::OnSyncBakeAccepted(const std::wstring& pipelineName, const SDFObject* object, const SDFEditList& editList)
+{
+	RecordRequest(pipelineName, object, editList, nullptr);
+}
 
-void SDFFactoryHierarchicalAsync::BakeSDFAsync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList)
+bool SDFFactoryHierarchicalAsync::LoadBakeFileSync(SDFObject* object, const SDFBakeFile& file)
 {
+	if (m_AsyncInUse)
+	{
+		LOG_TRACE("Async compute in use - cannot load bake file.");
+		return false;
+	}
+
+	m_LastRequests.erase(object);
+	return SDFFactoryHierarchical::LoadBakeFileSync(object, file);
+}
+
+bool SDFFactoryHierarchicalAsync::LoadBrickPageFileSync(SDFObject* object, const SDFBrickPageFile& file, const XMUINT3& brickPoolDimensions)
+{
+	if (m_AsyncInUse)
+	{
+		LOG_TRACE("Async compute in use - cannot load page file.");
+		return false;
+	}
+
+	m_LastRequests.erase(object);
+	return SDFFactoryHierarchical::LoadBrickPageFileSync(object, file, brickPoolDimensions);
+}
+
+
+void SDFFactoryHierarchicalAsync::BakeSDFAsync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion* dirtyRegion, const SDFBakeHints& hints)
+{
+	SDFDirtyRegion diffRegion;
+	const bool changed = RecordRequest(pipelineName, object, editList, &diffRegion);
+	if (!dirtyRegion)
+	{
+		if (!changed)
+		{
+			// The object would be baked from exactly the same inputs as last time
+			m_SkippedBakeCount++;
+			return;
+		}
+		dirtyRegion = &diffRegion;
+	}
+
+	const double time = GetTimeSeconds();
+	const float priority = CalculatePriority(hints);
+	const double deadlineTime = hints.Deadline > 0.0f ? time + hints.Deadline : std::numeric_limits<double>::infinity();
+
 	{
 		std::lock_guard lockGuard(m_QueueMutex);
 
+		// The region is invalidated along with queueing the edit list, so the factory thread never sees one without the other
+		object->InvalidateRegion(*dirtyRegion);
+
+		// The first request since the thread last took work is timed, whether it is queued or merged into a queued item
+		if (m_WakeRequestTime < 0.0)
+			m_WakeRequestTime = time;
+
 		// If this item has already been queued, then instead of queueing it again we can just update the arguments
+		// The stale request is dropped, but the object keeps its place in the queue from its first request
 		for (auto& item : m_BuildQueue)
 		{
 			if (item.Object == object)
 			{
 				item.PipelineName = pipelineName;
 				item.EditList = editList;
+				item.Priority = priority;
+				item.DeadlineTime = (std::min)(item.DeadlineTime, deadlineTime);
+				m_QueueStatistics.DroppedRequests++;
 				return;
 			}
 		}
 
-		m_BuildQueue.push_back({ pipelineName, object, editList });
+		m_BuildQueue.push_back({ pipelineName, object, editList, priority, time, deadlineTime });
 	}
+	m_QueueCondition.notify_one();
+}
+
+
+float SDFFactoryHierarchicalAsync::CalculatePriority(const SDFBakeHints& hints)
+{
+	// Large and nearby objects are the most noticeable when they are out of date
+	const float coverage = std::clamp(hints.ScreenCoverage, 0.0f, 1.0f);
+	const float proximity = 1.0f / (1.0f + (std::max)(hints.CameraDistance, 0.0f));
+	return coverage + proximity + (hints.Focused ? s_FocusedPriority : 0.0f);
+}
+
+
+SDFFactoryHierarchicalAsync::QueueStatistics SDFFactoryHierarchicalAsync::GetQueueStatistics() const
+{
+	std::lock_guard lockGuard(m_QueueMutex);
+	return m_QueueStatistics;
+}
+
+void SDFFactoryHierarchicalAsync::ResetQueueStatistics()
+{
+	std::lock_guard lockGuard(m_QueueMutex);
+	m_QueueStatistics = {};
+}
+
+double SDFFactoryHierarchicalAsync::GetThreadCPUTime() const
+{
+	if (!m_FactoryThread)
+		return 0.0;
+
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetThreadTimes(m_FactoryThread->native_handle(), &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0.0;
+
+	// Times are in 100 nanosecond intervals
+	auto toSeconds = [](const FILETIME& time)
+		{
+			const ULARGE_INTEGER value{ time.dwLowDateTime, time.dwHighDateTime };
+			return static_cast<double>(value.QuadPart) * 1.0e-7;
+		};
+	return toSeconds(kernelTime) + toSeconds(userTime);
+}
+
+
+void SDFFactoryHierarchicalAsync::SortBuildQueue(double time)
+{
+	const float agingRate = m_PriorityAgingRate;
+	auto getEffectivePriority = [time, agingRate](const BuildQueueItem& item)
+	{
+		float priority = item.Priority + agingRate * static_cast<float>(time - item.RequestTime);
+
+		// Boost requests as they approach their deadline
+		const double remaining = item.DeadlineTime - time;
+		if (remaining < s_DeadlineWindow)
+		{
+			const double urgency = 1.0 - (std::max)(remaining, 0.0) / s_DeadlineWindow;
+			priority += s_FocusedPriority * static_cast<float>(urgency);
+		}
+		return priority;
+	};
+
+	// Stable, so objects of equal priority are baked in the order they were requested
+	std::stable_sort(m_BuildQueue.begin(), m_BuildQueue.end(), [&](const BuildQueueItem& a, const BuildQueueItem& b)
+		{
+			return getEffectivePriority(a) > getEffectivePriority(b);
+		});
+}
+
+void SDFFactoryHierarchicalAsync::RecordCompletedBake(double requestTime, double deadlineTime, double beginTime, double endTime)
+{
+	const double waitTime = beginTime - requestTime;
+
+	std::lock_guard lockGuard(m_QueueMutex);
+	m_QueueStatistics.CompletedBakes++;
+	m_QueueStatistics.TotalWaitTime += waitTime;
+	m_QueueStatistics.MaxWaitTime = (std::max)(m_QueueStatistics.MaxWaitTime, waitTime);
+	if (endTime > deadlineTime)
+	{
+		m_QueueStatistics.DeadlineMisses++;
+	}
+}
+
+
+double SDFFactoryHierarchicalAsync::GetTimeSeconds()
+{
+	static const double s_SecondsPerCount = []()
+		{
+			LARGE_INTEGER frequency;
+			QueryPerformanceFrequency(&frequency);
+			return 1.0 / static_cast<double>(frequency.QuadPart);
+		}();
+
+	LARGE_INTEGER counts;
+	QueryPerformanceCounter(&counts);
+	return static_cast<double>(counts.QuadPart) * s_SecondsPerCount;
+}
+
+
+bool SDFFactoryHierarchicalAsync::RecordRequest(const std::wstring& pipelineName, const SDFObject* object, const SDFEditList& editList, SDFDirtyRegion* outDiffRegion)
+{
+	const float brickSize = object->GetNextRebuildBrickSize();
+	const UINT maxIterations = GetMaxBrickBuildIterations();
+
+	const auto it = m_LastRequests.find(object);
+	if (it == m_LastRequests.end())
+	{
+		m_LastRequests.emplace(object, BakeRequest{ pipelineName, brickSize, maxIterations, editList });
+		if (outDiffRegion)
+			*outDiffRegion = SDFDirtyRegion::Everything();
+		return true;
+	}
+
+	BakeRequest& last = it->second;
+
+	// Anything other than the edits changing requires the whole object to be rebuilt
+	const bool settingsChanged = last.PipelineName != pipelineName
+		|| last.BrickSize != brickSize
+		|| last.MaxIterations != maxIterations;
+
+	bool changed = true;
+	if (settingsChanged)
+	{
+		if (outDiffRegion)
+			*outDiffRegion = SDFDirtyRegion::Everything();
+	}
+	else
+	{
+		m_LastDiff.Compute(last.EditList, editList);
+		changed = !m_LastDiff.IsEmpty();
+
+		if (changed && outDiffRegion)
+		{
+			*outDiffRegion = m_LastDiff.BuildDirtyRegion(last.EditList, editList);
+			LOG_TRACE("Edit list diff: {} added, {} removed, {} modified.",
+				m_LastDiff.GetAdded().size(), m_LastDiff.GetRemoved().size(), m_LastDiff.GetModified().size());
+		}
+	}
+
+	if (changed)
+	{
+		last.PipelineName = pipelineName;
+		last.BrickSize = brickSize;
+		last.MaxIterations = maxIterations;
+		last.EditList = editList;
+	}
+	return changed;
 }
 
 
@@ -62,7 +290,6 @@ void SDFFactoryHierarchicalAsync::AsyncFactoryThreadProc()
 
 	LOG_INFO("Async Factory Thread Begin");
 
-	const auto computeQueue = g_D3DGraphicsContext->GetComputeCommandQueue();
 	const auto directQueue = g_D3DGraphicsContext->GetDirectCommandQueue();
 
 	m_Timer.Reset();
@@ -70,23 +297,48 @@ void SDFFactoryHierarchicalAsync::AsyncFactoryThreadProc()
 	std::wstring pipelineName;
 	SDFObject* object = nullptr;
 	SDFEditList editList(0); // max edits specified doesn't matter as this will be copy-constructed later
+	SDFDirtyRegion staleRegion;
+	double requestTime = 0.0;
+	double deadlineTime = 0.0;
 
 	while (!m_TerminateThread)
 	{
-		m_Timer.Tick();
+		// Objects whose bakes have completed are handed to the application as soon as possible
+		RetireBakes(false);
 
-		// Check for work
+		// Check for work, sleeping until some arrives
 		{
-			std::lock_guard lockGuard(m_QueueMutex);
-			if (!m_BuildQueue.empty())
+			std::unique_lock lock(m_QueueMutex);
+			if (m_BuildQueue.empty())
 			{
+				if (!m_InFlightBakes.empty())
+				{
+					// There is nothing to prepare, so wait for the GPU instead
+					lock.unlock();
+					RetireBakes(true);
+					continue;
+				}
 
-				pipelineName = std::move(m_BuildQueue.front().PipelineName);
-				object = m_BuildQueue.front().Object;
-				editList = std::move(m_BuildQueue.front().EditList);
+				m_QueueCondition.wait(lock, [this]() { return m_TerminateThread || !m_BuildQueue.empty(); });
+				if (m_TerminateThread)
+					break;
 
-				m_BuildQueue.pop_front();
+				const double latency = GetTimeSeconds() - m_WakeRequestTime;
+				m_QueueStatistics.WakeUps++;
+				m_QueueStatistics.TotalWakeUpLatency += latency;
+				m_QueueStatistics.MaxWakeUpLatency = (std::max)(m_QueueStatistics.MaxWakeUpLatency, latency);
 			}
+
+			SortBuildQueue(GetTimeSeconds());
+
+			pipelineName = std::move(m_BuildQueue.front().PipelineName);
+			object = m_BuildQueue.front().Object;
+			editList = std::move(m_BuildQueue.front().EditList);
+			requestTime = m_BuildQueue.front().RequestTime;
+			deadlineTime = m_BuildQueue.front().DeadlineTime;
+
+			m_BuildQueue.pop_front();
+			m_WakeRequestTime = -1.0;
 		}
 
 		if (object)
@@ -97,6 +349,7 @@ void SDFFactoryHierarchicalAsync::AsyncFactoryThreadProc()
 			// Make sure the resources for each object in the pipe are available to write
 			// When this fence value is reached, any resources being previously used by the GPU will now be available
 			const UINT64 fenceValue = directQueue->GetNextFenceValue() - 1;
+			const double resourceWaitBegin = GetTimeSeconds();
 			while (!m_TerminateThread)
 			{
 				const auto resourceState = object->GetResourcesState(SDFObject::RESOURCES_WRITE);
@@ -110,6 +363,21 @@ void SDFFactoryHierarchicalAsync::AsyncFactoryThreadProc()
 				{
 					break;
 				}
+
+				if (!m_InFlightBakes.empty())
+				{
+					// The object may be waiting on one of our own bakes to complete before the application can release it
+					RetireBakes(true);
+				}
+				else
+				{
+					// Sleep until the application flips or releases the resources
+					object->WaitForResourcesStateChange(SDFObject::RESOURCES_WRITE, resourceState, s_ResourceWaitTimeoutMs);
+				}
+			}
+			{
+				std::lock_guard lockGuard(m_QueueMutex);
+				m_QueueStatistics.TotalResourceWaitTime += GetTimeSeconds() - resourceWaitBegin;
 			}
 			PIXEndEvent();
 			// Just in case application exists while we were waiting for resources to be ready
@@ -121,30 +389,132 @@ void SDFFactoryHierarchicalAsync::AsyncFactoryThreadProc()
 
 			object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTING);
 
-			PIXBeginEvent(PIX_COLOR_INDEX(14), L"Wait for previous bake");
-			computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
-			PIXEndEvent();
+			{
+				// Regions may have been invalidated while waiting for resources, so the newest edit list for this object
+				// is taken along with the stale region of the resources that are about to be written
+				std::lock_guard lockGuard(m_QueueMutex);
+				for (auto it = m_BuildQueue.begin(); it != m_BuildQueue.end(); ++it)
+				{
+					if (it->Object == object)
+					{
+						pipelineName = std::move(it->PipelineName);
+						editList = std::move(it->EditList);
+						deadlineTime = (std::min)(deadlineTime, it->DeadlineTime);
+						m_BuildQueue.erase(it);
+						m_QueueStatistics.DroppedRequests++;
+						break;
+					}
+				}
 
-			PerformSDFBake_CPUBlocking(pipelineName, object, editList);
+				staleRegion = object->TakeStaleRegion(SDFObject::RESOURCES_WRITE);
 
-			// The CPU can optionally wait until the operations have completed too
-			PIXBeginEvent(PIX_COLOR_INDEX(13), L"Wait for bake completion");
-			computeQueue->WaitForFenceCPUBlocking(m_PreviousWorkFence);
-			PIXEndEvent();
+				// Other queued objects whose resources are ready to write are baked in the same batch
+				// Objects that would have to be waited on are left in the queue
+				// The queue is still in priority order, so if the batch is full the most important objects are taken
+				for (auto it = m_BuildQueue.begin(); it != m_BuildQueue.end() && m_BatchItems.size() + 1 < m_MaxBatchSize;)
+				{
+					if (it->PipelineName == pipelineName && it->Object->GetResourcesState(SDFObject::RESOURCES_WRITE) == SDFObject::READY_COMPUTE)
+					{
+						it->Object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTING);
+						m_BatchStaleRegions.push_back(it->Object->TakeStaleRegion(SDFObject::RESOURCES_WRITE));
+						m_BatchItems.push_back(std::move(*it));
+						it = m_BuildQueue.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+
+				// Requests made while waiting for resources have been taken, so they cannot wake the thread
+				m_WakeRequestTime = -1.0;
+			}
+
+			const double beginTime = GetTimeSeconds();
 
-			object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTED);
+			// Submitting only waits for the GPU to finish with the context the bake is recorded into,
+			// so this bake is prepared while the previous bakes are still executing
+			if (m_BatchItems.empty())
+			{
+				SubmitSDFBake(pipelineName, object, editList, staleRegion);
+			}
+			else
+			{
+				std::vector<BakeJob> jobs(m_BatchItems.size() + 1);
+				jobs.at(0).Object = object;
+				jobs.at(0).EditList = &editList;
+				jobs.at(0).StaleRegion = staleRegion;
+				for (size_t i = 0; i < m_BatchItems.size(); i++)
+				{
+					jobs.at(i + 1).Object = m_BatchItems.at(i).Object;
+					jobs.at(i + 1).EditList = &m_BatchItems.at(i).EditList;
+					jobs.at(i + 1).StaleRegion = m_BatchStaleRegions.at(i);
+				}
+
+				SubmitSDFBatchBake(pipelineName, jobs);
+			}
+
+			InFlightBake bake;
+			bake.Fence = m_PreviousWorkFence;
+			bake.BeginTime = beginTime;
+			bake.Items.push_back({ object, requestTime, deadlineTime });
+			for (const auto& item : m_BatchItems)
+			{
+				bake.Items.push_back({ item.Object, item.RequestTime, item.DeadlineTime });
+			}
+			m_InFlightBakes.push_back(std::move(bake));
+
+			// Ticked once per object in the batch, so the timer measures object builds per second
+			for (size_t i = 0; i <= m_BatchItems.size(); i++)
+			{
+				m_Timer.Tick();
+			}
 
 			// Clear resources
 			object = nullptr;
 			editList.Reset();
+			m_BatchItems.clear();
+			m_BatchStaleRegions.clear();
 
-			m_AsyncInUse = false;
 			PIXEndEvent();
 		}
+	}
 
-		// Yield to other threads
-		SwitchToThread();
+	// Leave every object in a consistent state
+	while (!m_InFlightBakes.empty())
+	{
+		RetireBakes(true);
 	}
 
 	LOG_INFO("Async Factory Thread Terminated");
 }
+
+
+void SDFFactoryHierarchicalAsync::RetireBakes(bool waitForOldest)
+{
+	const auto computeQueue = g_D3DGraphicsContext->GetComputeCommandQueue();
+
+	if (waitForOldest && !m_InFlightBakes.empty())
+	{
+		PIXBeginEvent(PIX_COLOR_INDEX(13), L"Wait for bake completion");
+		computeQueue->WaitForFenceCPUBlocking(m_InFlightBakes.front().Fence);
+		PIXEndEvent();
+	}
+
+	while (!m_InFlightBakes.empty() && computeQueue->IsFenceComplete(m_InFlightBakes.front().Fence))
+	{
+		const InFlightBake& bake = m_InFlightBakes.front();
+		const double endTime = GetTimeSeconds();
+		for (const auto& item : bake.Items)
+		{
+			item.Object->SetResourceState(SDFObject::RESOURCES_WRITE, SDFObject::COMPUTED);
+			RecordCompletedBake(item.RequestTime, item.DeadlineTime, bake.BeginTime, endTime);
+		}
+		m_InFlightBakes.pop_front();
+	}
+
+	if (m_InFlightBakes.empty())
+	{
+		m_AsyncInUse = false;
+	}
+}
@@ -3,9 +3,26 @@
 
 #include "SDFFactoryHierarchical.h"
 #include "SDF/SDFEditList.h"
+#include "SDF/SDFEditListDiff.h"
 
 #include "Framework/GameTimer.h"
 
+#include <condition_variable>
+
+
+// Hints from the caller that decide the order in which queued objects are baked
+struct SDFBakeHints
+{
+	// Fraction of the screen covered by the object, in [0, 1]
+	float ScreenCoverage = 0.0f;
+	// Distance from the camera to the object in world units
+	float CameraDistance = 0.0f;
+	// Set for objects the user is interacting with, such as the object being sculpted
+	bool Focused = false;
+	// Seconds from the request by which the bake should be complete, or 0 for no deadline
+	float Deadline = 0.0f;
+};
+
 
 class SDFFactoryHierarchicalAsync : public SDFFactoryHierarchical
 {
@@ -16,14 +33,82 @@ public:
 	DISALLOW_COPY(SDFFactoryHierarchicalAsync)
 	DEFAULT_MOVE(SDFFactoryHierarchicalAsync)
 
-	virtual void BakeSDFSync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList) override;
-	void BakeSDFAsync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList);
+	virtual void BakeSDFSync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion* dirtyRegion = nullptr) override;
+	virtual void BakeSDFBatchSync(const std::wstring& pipelineName, const std::vector<BatchItem>& items) override;
+	// The object's last request is forgotten, so that its next async bake rebuilds the whole object
+	virtual bool LoadBakeFileSync(SDFObject* object, const SDFBakeFile& file) override;
+	virtual bool LoadBrickPageFileSync(SDFObject* object, const SDFBrickPageFile& file, const XMUINT3& brickPoolDimensions) override;
+	// The dirty region is recorded on the object immediately, so bakes that are coalesced in the queue still rebuild every region
+	// If no region is given, the edit list is compared against the last one requested for the object:
+	// unchanged requests are skipped, and otherwise the region is found from the edits that changed
+	// Queued objects are baked in order of priority, which is calculated from the hints and increases the longer they wait
+	void BakeSDFAsync(const std::wstring& pipelineName, SDFObject* object, const SDFEditList& editList, const SDFDirtyRegion* dirtyRegion = nullptr, const SDFBakeHints& hints = {});
 
 	float GetAsyncBuildsPerSecond() const { return m_Timer.GetFPS(); };
+	inline UINT GetSkippedBakeCount() const { return m_SkippedBakeCount; }
+
+	// Queued objects are baked together in batches of up to this many objects. A size of 1 bakes each object alone
+	inline void SetMaxBatchSize(UINT maxBatchSize) { m_MaxBatchSize = (std::max)(maxBatchSize, 1u); }
+	inline UINT GetMaxBatchSize() const { return m_MaxBatchSize; }
+	// The differences found for the most recent request that was compared
+	inline const SDFEditListDiff& GetLastEditListDiff() const { return m_LastDiff; }
+
+	struct QueueStatistics
+	{
+		UINT64 CompletedBakes = 0;
+		// Requests that were replaced by a newer edit list for the same object before they were baked
+		UINT64 DroppedRequests = 0;
+		UINT64 DeadlineMisses = 0;
+
+		// Time from the first request for an object until its bake begins, in seconds
+		double TotalWaitTime = 0.0;
+		double MaxWaitTime = 0.0;
+
+		// The factory thread sleeps while the queue is empty
+		// Wake-up latency is the time from a request arriving to the thread taking it, in seconds
+		UINT64 WakeUps = 0;
+		double TotalWakeUpLatency = 0.0;
+		double MaxWakeUpLatency = 0.0;
+		// Time spent asleep waiting for the application to release the resources of an object, in seconds
+		double TotalResourceWaitTime = 0.0;
+
+		inline double GetAverageWaitTime() const { return CompletedBakes > 0 ? TotalWaitTime / static_cast<double>(CompletedBakes) : 0.0; }
+		inline double GetAverageWakeUpLatency() const { return WakeUps > 0 ? TotalWakeUpLatency / static_cast<double>(WakeUps) : 0.0; }
+	};
+	QueueStatistics GetQueueStatistics() const;
+	void ResetQueueStatistics();
+
+	// CPU time used by the factory thread since it was created, in seconds
+	double GetThreadCPUTime() const;
+
+	// How much the priority of a queued object increases per second it waits, so that background objects are never starved
+	inline void SetPriorityAgingRate(float agingRate) { m_PriorityAgingRate = agingRate; }
+	inline float GetPriorityAgingRate() const { return m_PriorityAgingRate; }
+
+	static float CalculatePriority(const SDFBakeHints& hints);
 
 private:
 	void AsyncFactoryThreadProc();
 
+	// Returns false if the request would bake the same object as the last request
+	bool RecordRequest(const std::wstring& pipelineName, const SDFObject* object, const SDFEditList& editList, SDFDirtyRegion* outDiffRegion);
+
+	// Orders the build queue from highest to lowest priority at the given time
+	// The queue mutex must be held
+	void SortBuildQueue(double time);
+	// Marks the objects of completed bakes as computed
+	// If waitForOldest is set, blocks until at least the oldest bake in flight is complete
+	void RetireBakes(bool waitForOldest);
+
+	// Records the wait time of a bake that has begun, and whether it missed its deadline once it is complete
+	void RecordCompletedBake(double requestTime, double deadlineTime, double beginTime, double endTime);
+
+	static double GetTimeSeconds();
+
+protected:
+	// The request is only recorded once the bake has been accepted, so that a bake that was never performed cannot cause a later one to be skipped
+	virtual void OnSyncBakeAccepted(const std::wstring& pipelineName, const SDFObject* object, const SDFEditList& editList) override;
+
 protected:
 	GameTimer m_Timer;
 
@@ -36,8 +121,66 @@ protected:
 		std::wstring PipelineName;
 		SDFObject* Object;
 		SDFEditList EditList;
+
+		float Priority = 0.0f;
+		// Time of the first request that has not yet been baked
+		double RequestTime = 0.0;
+		// Infinity if the request has no deadline
+		double DeadlineTime = 0.0;
 	};
 	// Queue of bakes to perform
 	std::deque<BuildQueueItem> m_BuildQueue;
-	std::mutex m_QueueMutex;
+	mutable std::mutex m_QueueMutex;
+	// Wakes the factory thread when work is queued or the thread should terminate
+	std::condition_variable m_QueueCondition;
+	// The time of the first request since the factory thread last took work from the queue, used to measure wake-up latency
+	// Only that request can be the one that wakes the thread. Negative when there has been no request since
+	double m_WakeRequestTime = -1.0;
+
+	// Waits for resources are woken by the object, and only time out so that termination is noticed
+	inline static constexpr UINT s_ResourceWaitTimeoutMs = 50;
+
+	inline static constexpr float s_FocusedPriority = 4.0f;
+	// Requests that are this close to their deadline are boosted, up to the priority of a focused object
+	inline static constexpr double s_DeadlineWindow = 0.1;
+	std::atomic<float> m_PriorityAgingRate = 1.0f;
+
+	// Protected by the queue mutex
+	QueueStatistics m_QueueStatistics;
+
+	// The objects baked along with the front of the queue
+	std::atomic<UINT> m_MaxBatchSize = 16;
+	std::vector<BuildQueueItem> m_BatchItems;
+	std::vector<SDFDirtyRegion> m_BatchStaleRegions;
+
+	// Bakes that have been submitted but not yet completed by the GPU, oldest first
+	// Only the factory thread accesses these
+	struct InFlightBake
+	{
+		struct Item
+		{
+			SDFObject* Object;
+			double RequestTime;
+			double DeadlineTime;
+		};
+
+		UINT64 Fence = 0;
+		double BeginTime = 0.0;
+		std::vector<Item> Items;
+	};
+	std::deque<InFlightBake> m_InFlightBakes;
+
+	// The most recent bake requested for each object
+	// Sync bakes are recorded too, as every scene bakes its objects synchronously when they are created
+	struct BakeRequest
+	{
+		std::wstring PipelineName;
+		float BrickSize;
+		UINT MaxIterations;
+		SDFEditList EditList;
+	};
+	std::map<const SDFObject*, BakeRequest> m_LastRequests;
+
+	SDFEditListDiff m_LastDiff;
+	UINT m_SkippedBakeCount = 0;
 };
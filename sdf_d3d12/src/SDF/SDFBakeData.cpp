@@ -0,0 +1,138 @@
+#include "pch.h"
+#include "SDFBakeData.h"
+
+#include "SDF/CPU/BrickHelpers.h"
+
+
+XMUINT3 SDFBakeData::GetBrickPoolResolution() const
+{
+	return {
+		BrickPoolDimensions.x * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+		BrickPoolDimensions.y * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+		BrickPoolDimensions.z * SDF_BRICK_SIZE_VOXELS_ADJACENCY
+	};
+}
+
+UINT SDFBakeData::GetPoolSlotCount() const
+{
+	const UINT capacity = BrickPoolDimensions.x * BrickPoolDimensions.y * BrickPoolDimensions.z;
+
+	std::vector<bool> used(capacity, false);
+	UINT count = 0;
+	for (const Brick& brick : Bricks)
+	{
+		if (brick.PoolSlot < capacity && !used.at(brick.PoolSlot))
+		{
+			used.at(brick.PoolSlot) = true;
+			count++;
+		}
+	}
+	return count;
+}
+
+float SDFBakeData::GetDeduplicationRatio() const
+{
+	const UINT slotCount = GetPoolSlotCount();
+	return slotCount > 0 ? static_cast<float>(GetBrickCount()) / static_cast<float>(slotCount) : 1.0f;
+}
+
+const INT8* SDFBakeData::GetBrickVoxel(UINT brickIndex, UINT x, UINT y, UINT z) const
+{
+	const XMUINT3 resolution = GetBrickPoolResolution();
+	const XMUINT3 brickTopLeft = BrickHelpers::CalculateBrickPoolPosition(Bricks.at(brickIndex).PoolSlot, BrickPoolDimensions, PoolPlacement);
+
+	const size_t voxel = (static_cast<size_t>(brickTopLeft.z + z) * resolution.y + (brickTopLeft.y + y)) * resolution.x + (brickTopLeft.x + x);
+	ASSERT(4 * voxel < BrickPool.size(), "Out of bounds voxel access");
+	return BrickPool.data() + 4 * voxel;
+}
+
+void SDFBakeData::Clear()
+{
+	BrickSize = 0.0f;
+	EvalSpaceSize = 0.0f;
+	BrickPoolDimensions = { 0, 0, 0 };
+	PoolPlacement = BrickPoolPlacement::Linear;
+
+	Bricks.clear();
+	Indices.clear();
+	AABBs.clear();
+	BrickPool.clear();
+	ReferenceDistances.clear();
+}
+
+
+void SDFBakeComparison::Log() const
+{
+	if (IsExactMatch())
+	{
+		LOG_INFO("Bakes match exactly ({} bricks).", BrickCountA);
+		return;
+	}
+
+	LOG_WARN("Bakes do not match:");
+	LOG_WARN("Brick count: {} vs {}", BrickCountA, BrickCountB);
+	LOG_WARN("Brick mismatches: {}", BrickMismatches);
+	LOG_WARN("Index list mismatches: {}", IndexListMismatches);
+	LOG_WARN("AABB mismatches: {}", AABBMismatches);
+	LOG_WARN("Voxel mismatches: {} (max channel difference: {})", VoxelMismatches, MaxChannelDifference);
+}
+
+
+SDFBakeComparison CompareBakeData(const SDFBakeData& a, const SDFBakeData& b)
+{
+	SDFBakeComparison result;
+	result.BrickCountA = a.GetBrickCount();
+	result.BrickCountB = b.GetBrickCount();
+
+	const UINT brickCount = min(result.BrickCountA, result.BrickCountB);
+	for (UINT brickIndex = 0; brickIndex < brickCount; brickIndex++)
+	{
+		const Brick& brickA = a.Bricks.at(brickIndex);
+		const Brick& brickB = b.Bricks.at(brickIndex);
+
+		if (memcmp(&brickA.TopLeft, &brickB.TopLeft, sizeof(XMFLOAT3)) != 0)
+		{
+			result.BrickMismatches++;
+		}
+
+		if (brickA.IndexCount != brickB.IndexCount
+			|| brickA.IndexOffset + brickA.IndexCount > a.Indices.size()
+			|| brickB.IndexOffset + brickB.IndexCount > b.Indices.size()
+			|| memcmp(a.Indices.data() + brickA.IndexOffset, b.Indices.data() + brickB.IndexOffset, brickA.IndexCount * sizeof(UINT)) != 0)
+		{
+			result.IndexListMismatches++;
+		}
+
+		if (brickIndex < a.AABBs.size() && brickIndex < b.AABBs.size()
+			&& memcmp(&a.AABBs.at(brickIndex), &b.AABBs.at(brickIndex), sizeof(D3D12_RAYTRACING_AABB)) != 0)
+		{
+			result.AABBMismatches++;
+		}
+
+		if (a.BrickPool.empty() || b.BrickPool.empty())
+			continue;
+
+		for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+		for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+		for (UINT x = 0; x < SDF_BRICK_SIZE_VOXELS_ADJACENCY; x++)
+		{
+			const INT8* voxelA = a.GetBrickVoxel(brickIndex, x, y, z);
+			const INT8* voxelB = b.GetBrickVoxel(brickIndex, x, y, z);
+
+			bool mismatch = false;
+			for (UINT channel = 0; channel < 4; channel++)
+			{
+				const UINT difference = static_cast<UINT>(std::abs(static_cast<INT>(voxelA[channel]) - static_cast<INT>(voxelB[channel])));
+				if (difference > 0)
+				{
+					mismatch = true;
+					result.MaxChannelDifference = max(result.MaxChannelDifference, difference);
+				}
+			}
+			if (mismatch)
+				result.VoxelMismatches++;
+		}
+	}
+
+	return result;
+}
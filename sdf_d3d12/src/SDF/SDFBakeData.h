@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Core.h"
+#include "HlslCompat/StructureHlslCompat.h"
+#include "HlslCompat/HlslDefines.h"
+#include "SDF/CPU/BrickHelpers.h"
+
+
+// The complete output of an SDF bake, laid out exactly as the factory writes it into an SDFObject
+// This is produced by the CPU factory, and can be read back from an object baked by the GPU factory
+struct SDFBakeData
+{
+	float BrickSize = 0.0f;
+	float EvalSpaceSize = 0.0f;
+	XMUINT3 BrickPoolDimensions = { 0, 0, 0 };	// In bricks
+	BrickPoolPlacement::Value PoolPlacement = BrickPoolPlacement::Linear;
+
+	std::vector<Brick> Bricks;
+	std::vector<UINT> Indices;
+	std::vector<D3D12_RAYTRACING_AABB> AABBs;
+
+	// R8G8B8A8_SNORM voxels of the brick pool texture
+	// Rows and slices are tightly packed (no pitch alignment)
+	std::vector<INT8> BrickPool;
+
+	// The distance stored in each voxel before it was quantized, in the same units as the distance channel
+	// Voxels are in brick order, and in x, y, z order within each brick.
+	// Only produced by the CPU factory when reference distances are enabled, for measuring the error of brick pool formats
+	std::vector<float> ReferenceDistances;
+
+	inline UINT GetBrickCount() const { return static_cast<UINT>(Bricks.size()); }
+	XMUINT3 GetBrickPoolResolution() const;
+
+	// The number of distinct pool slots used by the bricks
+	// This is less than the brick count when bricks with identical voxels share a slot
+	UINT GetPoolSlotCount() const;
+	// Bricks per pool slot
+	float GetDeduplicationRatio() const;
+
+	// Gets the 4 channels of a voxel within a brick, from the pool slot of the brick
+	const INT8* GetBrickVoxel(UINT brickIndex, UINT x, UINT y, UINT z) const;
+
+	void Clear();
+};
+
+
+// The result of comparing two bakes of the same edit list
+struct SDFBakeComparison
+{
+	UINT BrickCountA = 0;
+	UINT BrickCountB = 0;
+
+	UINT BrickMismatches = 0;		// Bricks with a different position
+	UINT IndexListMismatches = 0;	// Bricks with a different set of edits
+	UINT AABBMismatches = 0;
+
+	UINT64 VoxelMismatches = 0;		// Voxels that have any channel different
+	UINT MaxChannelDifference = 0;	// Largest difference of any channel, in SNORM units
+
+	inline bool IsExactMatch() const
+	{
+		return BrickCountA == BrickCountB && BrickMismatches == 0 && IndexListMismatches == 0 && AABBMismatches == 0 && VoxelMismatches == 0;
+	}
+
+	void Log() const;
+};
+
+// Compares bakes brick by brick
+// The location of a brick's indices in the index buffer and its location in the brick pool are ignored,
+// only the contents are compared, as they depend on the order the GPU executes work in
+SDFBakeComparison CompareBakeData(const SDFBakeData& a, const SDFBakeData& b);
@@ -0,0 +1,226 @@
+#include "pch.h"
+#include "SDFBakeFile.h"
+
+#include "Framework/Hash.h"
+#include "SDFEditList.h"
+
+#include <fstream>
+
+
+static_assert(std::is_trivially_copyable_v<SDFBakeFileHeader>, "The bake file header is written directly to disk!");
+
+
+const char* SDFBakeFileSection::GetName(Value section)
+{
+	static const char* names[] =
+	{
+		"Bricks",
+		"Indices",
+		"AABBs",
+		"Brick Pool",
+		"Materials"
+	};
+	static_assert(ARRAYSIZE(names) == Count);
+	return names[section];
+}
+
+
+UINT64 SDFBakeFile::CalculateSourceHash(const SDFEditList& editList, float brickSize, UINT maxBrickBuildIterations, bool editCulling, BrickPoolPlacement::Value placement)
+{
+	UINT64 hash = editList.GetHash();
+	hash = Hash::Value(brickSize, hash);
+	hash = Hash::Value(maxBrickBuildIterations, hash);
+	hash = Hash::Value(static_cast<UINT>(editCulling), hash);
+	hash = Hash::Value(static_cast<UINT>(placement), hash);
+	return hash;
+}
+
+
+bool SDFBakeFile::Write(const std::string& path, const SDFBakeData& data, const UINT* materials, UINT materialCount, UINT64 sourceHash)
+{
+	ASSERT(data.Bricks.size() == data.AABBs.size(), "Every brick must have an AABB!");
+	ASSERT(data.BrickPool.size() == 4ull * data.GetBrickPoolResolution().x * data.GetBrickPoolResolution().y * data.GetBrickPoolResolution().z,
+		"Brick pool does not match its dimensions!");
+
+	const std::pair<const void*, UINT64> sections[] = {
+		{ data.Bricks.data(), data.Bricks.size() * sizeof(Brick) },
+		{ data.Indices.data(), data.Indices.size() * sizeof(UINT) },
+		{ data.AABBs.data(), data.AABBs.size() * sizeof(D3D12_RAYTRACING_AABB) },
+		{ data.BrickPool.data(), data.BrickPool.size() },
+		{ materials, static_cast<UINT64>(materialCount) * sizeof(UINT) },
+	};
+	static_assert(ARRAYSIZE(sections) == SDFBakeFileSection::Count);
+
+	SDFBakeFileHeader header = {};
+	header.Magic = s_Magic;
+	header.Version = s_Version;
+	header.SourceHash = sourceHash;
+	header.BrickSize = data.BrickSize;
+	header.EvalSpaceSize = data.EvalSpaceSize;
+	header.BrickPoolDimensions = data.BrickPoolDimensions;
+	header.PoolPlacement = data.PoolPlacement;
+	header.BrickCount = data.GetBrickCount();
+	header.MaterialCount = materialCount;
+	header.IndexCount = data.Indices.size();
+	header.ContentHash = Hash::s_Seed;
+
+	UINT64 offset = Align(sizeof(SDFBakeFileHeader), s_SectionAlignment);
+	for (UINT i = 0; i < SDFBakeFileSection::Count; i++)
+	{
+		header.Sections[i] = { offset, sections[i].second };
+		header.ContentHash = Hash::Bytes(sections[i].first, sections[i].second, header.ContentHash);
+		offset = Align(offset + sections[i].second, s_SectionAlignment);
+	}
+
+	const std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG_ERROR("Failed to open bake file '{}' for writing.", tempPath);
+			return false;
+		}
+
+		static constexpr char padding[s_SectionAlignment] = {};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		UINT64 written = sizeof(header);
+		for (UINT i = 0; i < SDFBakeFileSection::Count; i++)
+		{
+			file.write(padding, static_cast<std::streamsize>(header.Sections[i].Offset - written));
+			file.write(static_cast<const char*>(sections[i].first), static_cast<std::streamsize>(sections[i].second));
+			written = header.Sections[i].Offset + sections[i].second;
+		}
+
+		if (!file.good())
+		{
+			LOG_ERROR("Failed to write bake file '{}'.", tempPath);
+			return false;
+		}
+	}
+
+	if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		LOG_ERROR("Failed to move bake file into place at '{}' (error {}).", path, GetLastError());
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+
+	LOG_INFO("Wrote bake file '{}': {} bricks, {} indices, {:.2f} MB.", path, header.BrickCount, header.IndexCount, static_cast<double>(offset) / (1024.0 * 1024.0));
+	return true;
+}
+
+
+bool SDFBakeFile::Open(const std::string& path)
+{
+	Close();
+
+	if (!m_File.Open(path))
+		return false;
+
+	auto fail = [this, &path](const char* reason)
+		{
+			LOG_WARN("Bake file '{}' cannot be used: {}", path, reason);
+			Close();
+			return false;
+		};
+
+	if (m_File.GetSize() < sizeof(SDFBakeFileHeader))
+		return fail("the file is too small to have a header.");
+
+	const auto header = reinterpret_cast<const SDFBakeFileHeader*>(m_File.GetData());
+	if (header->Magic != s_Magic)
+		return fail("it is not a bake file.");
+	if (header->Version != s_Version)
+		return fail("it was written by a different version.");
+	if (header->PoolPlacement >= BrickPoolPlacement::Count)
+		return fail("the brick pool placement is unknown.");
+
+	const UINT64 poolCapacity = static_cast<UINT64>(header->BrickPoolDimensions.x) * header->BrickPoolDimensions.y * header->BrickPoolDimensions.z;
+
+	// Every section must be the size that the header describes, and lie within the file
+	const UINT64 expectedSizes[] = {
+		static_cast<UINT64>(header->BrickCount) * sizeof(Brick),
+		header->IndexCount * sizeof(UINT),
+		static_cast<UINT64>(header->BrickCount) * sizeof(D3D12_RAYTRACING_AABB),
+		poolCapacity * SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY * 4,
+		static_cast<UINT64>(header->MaterialCount) * sizeof(UINT),
+	};
+	static_assert(ARRAYSIZE(expectedSizes) == SDFBakeFileSection::Count);
+
+	for (UINT i = 0; i < SDFBakeFileSection::Count; i++)
+	{
+		const auto& section = header->Sections[i];
+		if (section.Size != expectedSizes[i] || section.Offset % s_SectionAlignment != 0
+			|| section.Offset > m_File.GetSize() || section.Size > m_File.GetSize() - section.Offset)
+		{
+			LOG_WARN("Section '{}' of bake file '{}' is malformed.", SDFBakeFileSection::GetName(static_cast<SDFBakeFileSection::Value>(i)), path);
+			return fail("a section is malformed.");
+		}
+	}
+
+	m_Header = header;
+
+	// Deduplicated bricks share pool slots, so there can be more bricks than the pool holds, but every slot must be within it
+	const Brick* bricks = GetBricks();
+	std::vector<bool> usedSlots(poolCapacity, false);
+	for (UINT i = 0; i < header->BrickCount; i++)
+	{
+		if (bricks[i].IndexOffset == SDF_RELEASED_BRICK || bricks[i].PoolSlot == SDF_NON_RESIDENT_BRICK)
+			continue;
+		if (bricks[i].PoolSlot >= poolCapacity)
+			return fail("a brick is outside of the brick pool.");
+
+		m_SharedPoolSlots |= usedSlots[bricks[i].PoolSlot];
+		usedSlots[bricks[i].PoolSlot] = true;
+	}
+
+	return true;
+}
+
+void SDFBakeFile::Close()
+{
+	m_Header = nullptr;
+	m_SharedPoolSlots = false;
+	m_File.Close();
+}
+
+
+XMUINT3 SDFBakeFile::GetBrickPoolResolution() const
+{
+	return {
+		m_Header->BrickPoolDimensions.x * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+		m_Header->BrickPoolDimensions.y * SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+		m_Header->BrickPoolDimensions.z * SDF_BRICK_SIZE_VOXELS_ADJACENCY
+	};
+}
+
+
+bool SDFBakeFile::VerifyContents() const
+{
+	ASSERT(IsOpen(), "Bake file is not open!");
+
+	UINT64 hash = Hash::s_Seed;
+	for (UINT i = 0; i < SDFBakeFileSection::Count; i++)
+	{
+		const auto section = static_cast<SDFBakeFileSection::Value>(i);
+		hash = Hash::Bytes(GetSection(section), GetSectionSize(section), hash);
+	}
+	return hash == m_Header->ContentHash;
+}
+
+void SDFBakeFile::ReadBakeData(SDFBakeData& outData) const
+{
+	ASSERT(IsOpen(), "Bake file is not open!");
+
+	outData.Clear();
+	outData.BrickSize = m_Header->BrickSize;
+	outData.EvalSpaceSize = m_Header->EvalSpaceSize;
+	outData.BrickPoolDimensions = m_Header->BrickPoolDimensions;
+	outData.PoolPlacement = GetPoolPlacement();
+
+	outData.Bricks.assign(GetBricks(), GetBricks() + m_Header->BrickCount);
+	outData.Indices.assign(GetIndices(), GetIndices() + m_Header->IndexCount);
+	outData.AABBs.assign(GetAABBs(), GetAABBs() + m_Header->BrickCount);
+	outData.BrickPool.assign(GetBrickPool(), GetBrickPool() + GetSectionSize(SDFBakeFileSection::BrickPool));
+}
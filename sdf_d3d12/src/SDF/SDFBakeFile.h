@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Core.h"
+#include "Framework/MappedFile.h"
+#include "SDFBakeData.h"
+
+class SDFEditList;
+
+
+namespace SDFBakeFileSection
+{
+	enum Value
+	{
+		Bricks = 0,
+		Indices,
+		AABBs,
+		BrickPool,	// R8G8B8A8_SNORM voxels, with rows and slices tightly packed
+		Materials,	// The material table of the object
+		Count
+	};
+
+	const char* GetName(Value section);
+}
+
+
+// The header at the start of a bake file
+// Files are little-endian, and sections are stored in the same layout as the GPU buffers they are uploaded to
+struct SDFBakeFileHeader
+{
+	struct Section
+	{
+		UINT64 Offset;	// From the start of the file
+		UINT64 Size;	// In bytes
+	};
+
+	UINT Magic;
+	UINT Version;
+
+	// Identifies what the bake was made from, such as a hash of its edit list and brick size
+	// Chosen by whoever writes the file, so that a reader can tell whether the bake is out of date
+	UINT64 SourceHash;
+
+	float BrickSize;
+	float EvalSpaceSize;
+	XMUINT3 BrickPoolDimensions;
+	UINT PoolPlacement;
+	UINT BrickCount;
+	UINT MaterialCount;
+	UINT64 IndexCount;
+
+	// A hash of the contents of every section, in order
+	UINT64 ContentHash;
+
+	Section Sections[SDFBakeFileSection::Count];
+};
+
+
+// A baked SDF object stored on disk, so that it can be loaded instead of baked again
+// The file is memory-mapped when opened, and the sections are accessed in place.
+// Nothing is read from disk until a section is used, and sections can be copied straight into upload buffers.
+class SDFBakeFile
+{
+public:
+	inline static constexpr UINT s_Magic = 0x42464453;	// "SDFB"
+	// Increment this whenever the layout of the header or of any section changes, including the Brick struct
+	inline static constexpr UINT s_Version = 1;
+	// Sections start at this alignment, so that their contents can be used in place
+	inline static constexpr UINT64 s_SectionAlignment = 64;
+
+public:
+	SDFBakeFile() = default;
+	~SDFBakeFile() = default;
+
+	DISALLOW_COPY(SDFBakeFile)
+	DISALLOW_MOVE(SDFBakeFile)
+
+	// A source hash covering the edits and every setting that changes the bricks of a bake
+	// The CPU factory mirrors the GPU factory, so a file baked headlessly can stand in for a GPU bake of the same source
+	static UINT64 CalculateSourceHash(const SDFEditList& editList, float brickSize, UINT maxBrickBuildIterations, bool editCulling, BrickPoolPlacement::Value placement);
+
+	// Writes a bake and the material table that goes with it
+	// The file is written beside the path and then moved into place, so a reader never sees a partial file
+	static bool Write(const std::string& path, const SDFBakeData& data, const UINT* materials, UINT materialCount, UINT64 sourceHash);
+
+	// Maps a file and checks that its header and sections are consistent
+	// Returns false, and leaves the file closed, if it is missing, from another version or malformed
+	bool Open(const std::string& path);
+	void Close();
+
+	inline bool IsOpen() const { return m_Header != nullptr; }
+	inline const SDFBakeFileHeader& GetHeader() const { return *m_Header; }
+
+	inline BrickPoolPlacement::Value GetPoolPlacement() const { return static_cast<BrickPoolPlacement::Value>(m_Header->PoolPlacement); }
+	// Whether any pool slot is used by more than one brick, as in a deduplicated bake
+	inline bool HasSharedPoolSlots() const { return m_SharedPoolSlots; }
+	XMUINT3 GetBrickPoolResolution() const;
+
+	// Views of the sections, within the mapped file
+	inline const BYTE* GetSection(SDFBakeFileSection::Value section) const { return m_File.GetData() + m_Header->Sections[section].Offset; }
+	inline UINT64 GetSectionSize(SDFBakeFileSection::Value section) const { return m_Header->Sections[section].Size; }
+
+	inline const Brick* GetBricks() const { return reinterpret_cast<const Brick*>(GetSection(SDFBakeFileSection::Bricks)); }
+	inline const UINT* GetIndices() const { return reinterpret_cast<const UINT*>(GetSection(SDFBakeFileSection::Indices)); }
+	inline const D3D12_RAYTRACING_AABB* GetAABBs() const { return reinterpret_cast<const D3D12_RAYTRACING_AABB*>(GetSection(SDFBakeFileSection::AABBs)); }
+	inline const INT8* GetBrickPool() const { return reinterpret_cast<const INT8*>(GetSection(SDFBakeFileSection::BrickPool)); }
+	inline const UINT* GetMaterials() const { return reinterpret_cast<const UINT*>(GetSection(SDFBakeFileSection::Materials)); }
+
+	// Hashes every section and compares against the header
+	// This reads the whole file, so it is not done when opening
+	bool VerifyContents() const;
+
+	// Copies the bake out of the file, for use on the CPU
+	void ReadBakeData(SDFBakeData& outData) const;
+
+private:
+	MappedFile m_File;
+	const SDFBakeFileHeader* m_Header = nullptr;
+	bool m_SharedPoolSlots = false;
+};
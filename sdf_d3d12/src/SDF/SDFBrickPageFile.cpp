@@ -0,0 +1,301 @@
+#include "pch.h"
+#include "SDFBrickPageFile.h"
+
+#include <fstream>
+
+
+static_assert(std::is_trivially_copyable_v<SDFBrickPageFileHeader>, "The page file header is written directly to disk!");
+static_assert(std::is_trivially_copyable_v<SDFBrickPage>, "Pages are written directly to disk!");
+
+
+namespace
+{
+	// Spreads the low 21 bits of v so that there are 2 zeros after each bit
+	UINT64 ExpandBits21(UINT64 v)
+	{
+		v &= 0x1FFFFFull;
+		v = (v | (v << 32)) & 0x001F00000000FFFFull;
+		v = (v | (v << 16)) & 0x001F0000FF0000FFull;
+		v = (v | (v << 8)) & 0x100F00F00F00F00Full;
+		v = (v | (v << 4)) & 0x10C30C30C30C30C3ull;
+		v = (v | (v << 2)) & 0x1249249249249249ull;
+		return v;
+	}
+
+	// Morton codes of 64 bits, as the brick grid of a large object does not fit in the 10 bits per axis of morton3Du
+	UINT64 Morton3D64(UINT x, UINT y, UINT z)
+	{
+		return (ExpandBits21(x) << 2) | (ExpandBits21(y) << 1) | ExpandBits21(z);
+	}
+
+	UINT GridCoordinate(float value, float origin, float brickSize)
+	{
+		return static_cast<UINT>((std::max)(std::round((value - origin) / brickSize), 0.0f));
+	}
+}
+
+
+const char* SDFBrickPageFileSection::GetName(Value section)
+{
+	static const char* names[] =
+	{
+		"Bricks",
+		"AABBs",
+		"Pages",
+		"Page Voxels"
+	};
+	static_assert(ARRAYSIZE(names) == Count);
+	return names[section];
+}
+
+
+bool SDFBrickPageFile::Write(const std::string& path, const SDFBakeData& data)
+{
+	ASSERT(data.Bricks.size() == data.AABBs.size(), "Every brick must have an AABB!");
+
+	// Bricks released by an incremental bake are left out
+	std::vector<UINT> brickIndices;
+	brickIndices.reserve(data.Bricks.size());
+	XMFLOAT3 origin = { FLT_MAX, FLT_MAX, FLT_MAX };
+	for (UINT i = 0; i < data.GetBrickCount(); i++)
+	{
+		const Brick& brick = data.Bricks.at(i);
+		if (brick.IndexOffset == SDF_RELEASED_BRICK)
+			continue;
+
+		brickIndices.push_back(i);
+		origin.x = (std::min)(origin.x, brick.TopLeft.x);
+		origin.y = (std::min)(origin.y, brick.TopLeft.y);
+		origin.z = (std::min)(origin.z, brick.TopLeft.z);
+	}
+
+	if (brickIndices.empty())
+	{
+		LOG_ERROR("Cannot write page file '{}' as the bake has no bricks.", path);
+		return false;
+	}
+
+	// Order the bricks along a Morton curve through the grid of brick positions
+	{
+		std::vector<std::pair<UINT64, UINT>> mortonOrder;
+		mortonOrder.reserve(brickIndices.size());
+		for (const UINT i : brickIndices)
+		{
+			const XMFLOAT3& topLeft = data.Bricks.at(i).TopLeft;
+			mortonOrder.emplace_back(Morton3D64(
+				GridCoordinate(topLeft.x, origin.x, data.BrickSize),
+				GridCoordinate(topLeft.y, origin.y, data.BrickSize),
+				GridCoordinate(topLeft.z, origin.z, data.BrickSize)), i);
+		}
+		std::sort(mortonOrder.begin(), mortonOrder.end());
+
+		for (size_t i = 0; i < mortonOrder.size(); i++)
+			brickIndices.at(i) = mortonOrder.at(i).second;
+	}
+
+	const UINT brickCount = static_cast<UINT>(brickIndices.size());
+	const UINT pageCount = (brickCount + s_PageBricks - 1) / s_PageBricks;
+
+	std::vector<Brick> bricks(brickCount);
+	std::vector<D3D12_RAYTRACING_AABB> aabbs(brickCount);
+	for (UINT i = 0; i < brickCount; i++)
+	{
+		bricks.at(i) = data.Bricks.at(brickIndices.at(i));
+		bricks.at(i).PoolSlot = SDF_NON_RESIDENT_BRICK;
+		aabbs.at(i) = data.AABBs.at(brickIndices.at(i));
+	}
+
+	std::vector<SDFBrickPage> pages(pageCount);
+	for (UINT page = 0; page < pageCount; page++)
+	{
+		auto& outPage = pages.at(page);
+		outPage.FirstBrick = page * s_PageBricks;
+		outPage.BrickCount = (std::min)(s_PageBricks, brickCount - outPage.FirstBrick);
+		outPage.BoundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+		outPage.BoundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (UINT i = outPage.FirstBrick; i < outPage.FirstBrick + outPage.BrickCount; i++)
+		{
+			const auto& aabb = aabbs.at(i);
+			outPage.BoundsMin = { (std::min)(outPage.BoundsMin.x, aabb.MinX), (std::min)(outPage.BoundsMin.y, aabb.MinY), (std::min)(outPage.BoundsMin.z, aabb.MinZ) };
+			outPage.BoundsMax = { (std::max)(outPage.BoundsMax.x, aabb.MaxX), (std::max)(outPage.BoundsMax.y, aabb.MaxY), (std::max)(outPage.BoundsMax.z, aabb.MaxZ) };
+		}
+	}
+
+	SDFBrickPageFileHeader header = {};
+	header.Magic = s_Magic;
+	header.Version = s_Version;
+	header.BrickSize = data.BrickSize;
+	header.EvalSpaceSize = data.EvalSpaceSize;
+	header.BrickCount = brickCount;
+	header.PageCount = pageCount;
+
+	const UINT64 sectionSizes[] = {
+		bricks.size() * sizeof(Brick),
+		aabbs.size() * sizeof(D3D12_RAYTRACING_AABB),
+		pages.size() * sizeof(SDFBrickPage),
+		pageCount * s_PageVoxelBytes,
+	};
+	static_assert(ARRAYSIZE(sectionSizes) == SDFBrickPageFileSection::Count);
+
+	UINT64 offset = Align(sizeof(SDFBrickPageFileHeader), s_SectionAlignment);
+	for (UINT i = 0; i < SDFBrickPageFileSection::Count; i++)
+	{
+		header.Sections[i] = { offset, sectionSizes[i] };
+		offset = Align(offset + sectionSizes[i], s_SectionAlignment);
+	}
+
+	const std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG_ERROR("Failed to open page file '{}' for writing.", tempPath);
+			return false;
+		}
+
+		static constexpr char padding[s_SectionAlignment] = {};
+		UINT64 written = 0;
+		auto writeSection = [&](SDFBrickPageFileSection::Value section, const void* source)
+			{
+				file.write(padding, static_cast<std::streamsize>(header.Sections[section].Offset - written));
+				file.write(static_cast<const char*>(source), static_cast<std::streamsize>(header.Sections[section].Size));
+				written = header.Sections[section].Offset + header.Sections[section].Size;
+			};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		written = sizeof(header);
+
+		writeSection(SDFBrickPageFileSection::Bricks, bricks.data());
+		writeSection(SDFBrickPageFileSection::AABBs, aabbs.data());
+		writeSection(SDFBrickPageFileSection::Pages, pages.data());
+
+		// Pages are gathered out of the brick pool of the bake one at a time
+		file.write(padding, static_cast<std::streamsize>(header.Sections[SDFBrickPageFileSection::PageVoxels].Offset - written));
+
+		const XMUINT3 resolution = data.GetBrickPoolResolution();
+		std::vector<INT8> pageVoxels(s_PageVoxelBytes);
+		for (const auto& page : pages)
+		{
+			std::fill(pageVoxels.begin(), pageVoxels.end(), static_cast<INT8>(0));
+
+			for (UINT i = 0; i < page.BrickCount; i++)
+			{
+				const Brick& brick = data.Bricks.at(brickIndices.at(page.FirstBrick + i));
+				const XMUINT3 source = BrickHelpers::CalculateBrickPoolPosition(brick.PoolSlot, data.BrickPoolDimensions, data.PoolPlacement);
+
+				for (UINT z = 0; z < SDF_BRICK_SIZE_VOXELS_ADJACENCY; z++)
+				for (UINT y = 0; y < SDF_BRICK_SIZE_VOXELS_ADJACENCY; y++)
+				{
+					const size_t sourceOffset = 4 * ((static_cast<size_t>(source.z + z) * resolution.y + (source.y + y)) * resolution.x + source.x);
+					const size_t destOffset = (static_cast<size_t>(z) * SDF_BRICK_SIZE_VOXELS_ADJACENCY + y) * s_PageRowPitch + i * SDF_BRICK_SIZE_VOXELS_ADJACENCY * 4;
+					memcpy(pageVoxels.data() + destOffset, data.BrickPool.data() + sourceOffset, SDF_BRICK_SIZE_VOXELS_ADJACENCY * 4);
+				}
+			}
+
+			file.write(reinterpret_cast<const char*>(pageVoxels.data()), static_cast<std::streamsize>(pageVoxels.size()));
+		}
+
+		if (!file.good())
+		{
+			LOG_ERROR("Failed to write page file '{}'.", tempPath);
+			return false;
+		}
+	}
+
+	if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		LOG_ERROR("Failed to move page file into place at '{}' (error {}).", path, GetLastError());
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+
+	LOG_INFO("Wrote page file '{}': {} bricks in {} pages, {:.2f} MB.", path, brickCount, pageCount, static_cast<double>(offset) / (1024.0 * 1024.0));
+	return true;
+}
+
+
+XMUINT3 SDFBrickPageFile::CalculateBrickPoolDimensions(UINT pageCount)
+{
+	// Rows of up to 4 pages, which is the widest a 3D texture can be
+	constexpr UINT maxPagesPerRow = D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION / s_PageWidth;
+	constexpr UINT maxRows = D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION / SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+
+	pageCount = (std::max)(pageCount, 1u);
+	const UINT pagesPerRow = (std::min)(pageCount, maxPagesPerRow);
+	const UINT rowCount = (pageCount + pagesPerRow - 1) / pagesPerRow;
+	const UINT height = (std::min)(rowCount, maxRows);
+	const UINT depth = (std::min)((rowCount + height - 1) / height, maxRows);
+
+	return { pagesPerRow * s_PageBricks, height, depth };
+}
+
+UINT SDFBrickPageFile::CalculatePageSlotCount(const XMUINT3& brickPoolDimensions)
+{
+	return brickPoolDimensions.x / s_PageBricks * brickPoolDimensions.y * brickPoolDimensions.z;
+}
+
+
+bool SDFBrickPageFile::Open(const std::string& path)
+{
+	Close();
+
+	if (!m_File.Open(path))
+		return false;
+
+	auto fail = [this, &path](const char* reason)
+		{
+			LOG_WARN("Page file '{}' cannot be used: {}", path, reason);
+			Close();
+			return false;
+		};
+
+	if (m_File.GetSize() < sizeof(SDFBrickPageFileHeader))
+		return fail("the file is too small to have a header.");
+
+	const auto header = reinterpret_cast<const SDFBrickPageFileHeader*>(m_File.GetData());
+	if (header->Magic != s_Magic)
+		return fail("it is not a page file.");
+	if (header->Version != s_Version)
+		return fail("it was written by a different version.");
+	if (header->BrickCount == 0 || header->PageCount != (header->BrickCount + s_PageBricks - 1) / s_PageBricks)
+		return fail("the bricks do not match the pages.");
+
+	// Every section must be the size that the header describes, and lie within the file
+	const UINT64 expectedSizes[] = {
+		static_cast<UINT64>(header->BrickCount) * sizeof(Brick),
+		static_cast<UINT64>(header->BrickCount) * sizeof(D3D12_RAYTRACING_AABB),
+		static_cast<UINT64>(header->PageCount) * sizeof(SDFBrickPage),
+		header->PageCount * s_PageVoxelBytes,
+	};
+	static_assert(ARRAYSIZE(expectedSizes) == SDFBrickPageFileSection::Count);
+
+	for (UINT i = 0; i < SDFBrickPageFileSection::Count; i++)
+	{
+		const auto& section = header->Sections[i];
+		if (section.Size != expectedSizes[i] || section.Offset % s_SectionAlignment != 0
+			|| section.Offset > m_File.GetSize() || section.Size > m_File.GetSize() - section.Offset)
+		{
+			LOG_WARN("Section '{}' of page file '{}' is malformed.", SDFBrickPageFileSection::GetName(static_cast<SDFBrickPageFileSection::Value>(i)), path);
+			return fail("a section is malformed.");
+		}
+	}
+
+	// Pages are streamed in by their brick ranges, which must lie within the bricks
+	const auto pages = reinterpret_cast<const SDFBrickPage*>(m_File.GetData() + header->Sections[SDFBrickPageFileSection::Pages].Offset);
+	for (UINT page = 0; page < header->PageCount; page++)
+	{
+		if (pages[page].FirstBrick != page * s_PageBricks || pages[page].BrickCount > s_PageBricks
+			|| pages[page].FirstBrick + pages[page].BrickCount > header->BrickCount)
+			return fail("a page is malformed.");
+	}
+
+	m_Header = header;
+	return true;
+}
+
+void SDFBrickPageFile::Close()
+{
+	m_Header = nullptr;
+	m_File.Close();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Core.h"
+#include "Framework/MappedFile.h"
+#include "SDFBakeData.h"
+
+
+namespace SDFBrickPageFileSection
+{
+	enum Value
+	{
+		Bricks = 0,		// Every brick, in page order, with SDF_NON_RESIDENT_BRICK as their pool slot
+		AABBs,
+		Pages,
+		PageVoxels,		// The voxels of each page, in the layout of the box of the brick pool that the page is copied to
+		Count
+	};
+
+	const char* GetName(Value section);
+}
+
+
+// A group of bricks that are close together, which is made resident in the brick pool or evicted as a whole
+struct SDFBrickPage
+{
+	XMFLOAT3 BoundsMin;
+	XMFLOAT3 BoundsMax;
+	UINT FirstBrick;
+	UINT BrickCount;
+};
+
+
+struct SDFBrickPageFileHeader
+{
+	struct Section
+	{
+		UINT64 Offset;	// From the start of the file
+		UINT64 Size;	// In bytes
+	};
+
+	UINT Magic;
+	UINT Version;
+
+	float BrickSize;
+	float EvalSpaceSize;
+	UINT BrickCount;
+	UINT PageCount;
+
+	Section Sections[SDFBrickPageFileSection::Count];
+};
+
+
+// A baked object split into pages of bricks, for objects whose brick pools are too large to keep resident
+// Only the bricks and AABBs of every page are uploaded when the object is loaded. The voxels of each page are
+// copied into the brick pool when the page is made resident, straight from the memory-mapped file.
+//
+// A page occupies a run of s_PageBricks consecutive slots in a pool with linear placement,
+// and its voxels are stored as the box of the pool that those slots cover, so one copy streams in a whole page.
+// Bricks are assigned to pages in Morton order of their position, so the bricks of a page are close together.
+class SDFBrickPageFile
+{
+public:
+	inline static constexpr UINT s_Magic = 0x50464453;	// "SDFP"
+	// Increment this whenever the layout of the header or of any section changes, including the Brick struct
+	inline static constexpr UINT s_Version = 1;
+	inline static constexpr UINT64 s_SectionAlignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+
+	inline static constexpr UINT s_PageBricks = 64;
+	// The box of the brick pool covered by a page, in voxels
+	inline static constexpr UINT s_PageWidth = s_PageBricks * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+	inline static constexpr UINT s_PageRowPitch = s_PageWidth * 4;
+	inline static constexpr UINT64 s_PageVoxelBytes = static_cast<UINT64>(s_PageRowPitch) * SDF_BRICK_SIZE_VOXELS_ADJACENCY * SDF_BRICK_SIZE_VOXELS_ADJACENCY;
+
+	static_assert(s_PageRowPitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT == 0, "Pages must be copyable straight from the file!");
+
+public:
+	SDFBrickPageFile() = default;
+	~SDFBrickPageFile() = default;
+
+	DISALLOW_COPY(SDFBrickPageFile)
+	DISALLOW_MOVE(SDFBrickPageFile)
+
+	// Splits a bake into pages and writes them
+	// The file is written beside the path and then moved into place, so a reader never sees a partial file
+	static bool Write(const std::string& path, const SDFBakeData& data);
+
+	// The dimensions (in bricks) of a linear brick pool that holds at least pageCount pages
+	static XMUINT3 CalculateBrickPoolDimensions(UINT pageCount);
+	// The number of pages that fit in a brick pool with the given dimensions
+	static UINT CalculatePageSlotCount(const XMUINT3& brickPoolDimensions);
+	// The pool slot of the first brick of the page in a page slot
+	inline static UINT GetFirstPoolSlot(UINT pageSlot) { return pageSlot * s_PageBricks; }
+
+	// Maps a file and checks that its header and sections are consistent
+	// Returns false, and leaves the file closed, if it is missing, from another version or malformed
+	bool Open(const std::string& path);
+	void Close();
+
+	inline bool IsOpen() const { return m_Header != nullptr; }
+	inline const SDFBrickPageFileHeader& GetHeader() const { return *m_Header; }
+
+	inline const BYTE* GetSection(SDFBrickPageFileSection::Value section) const { return m_File.GetData() + m_Header->Sections[section].Offset; }
+	inline UINT64 GetSectionSize(SDFBrickPageFileSection::Value section) const { return m_Header->Sections[section].Size; }
+
+	inline const Brick* GetBricks() const { return reinterpret_cast<const Brick*>(GetSection(SDFBrickPageFileSection::Bricks)); }
+	inline const D3D12_RAYTRACING_AABB* GetAABBs() const { return reinterpret_cast<const D3D12_RAYTRACING_AABB*>(GetSection(SDFBrickPageFileSection::AABBs)); }
+	inline const SDFBrickPage* GetPages() const { return reinterpret_cast<const SDFBrickPage*>(GetSection(SDFBrickPageFileSection::Pages)); }
+	inline const BYTE* GetPageVoxels(UINT page) const { return GetSection(SDFBrickPageFileSection::PageVoxels) + page * s_PageVoxelBytes; }
+
+private:
+	MappedFile m_File;
+	const SDFBrickPageFileHeader* m_Header = nullptr;
+};
@@ -0,0 +1,168 @@
+#include "pch.h"
+#include "SDFBrickPageStreamer.h"
+
+#include "SDFObject.h"
+#include "Renderer/D3DGraphicsContext.h"
+
+#include <pix3.h>
+
+
+SDFBrickPageStreamer::~SDFBrickPageStreamer()
+{
+	Reset();
+}
+
+
+void SDFBrickPageStreamer::Init(const SDFBrickPageFile* file, SDFObject* object, const SDFBrickResidency::Settings& settings)
+{
+	ASSERT(file && file->IsOpen(), "Page file is not open!");
+	ASSERT(object, "Streamer has no object!");
+	ASSERT(object->GetBrickPoolPlacement(SDFObject::RESOURCES_READ) == BrickPoolPlacement::Linear, "Pages can only be streamed into a linear brick pool!");
+
+	Reset();
+
+	m_File = file;
+	m_Object = object;
+
+	SDFBrickResidency::Settings residencySettings = settings;
+	residencySettings.SlotCount = SDFBrickPageFile::CalculatePageSlotCount(object->GetBrickPoolDimensions(SDFObject::RESOURCES_READ));
+	m_Residency.Init(file->GetPages(), file->GetHeader().PageCount, residencySettings);
+
+	const UINT maxLoads = m_Residency.GetSettings().MaxLoadsPerUpdate;
+	// Every load can evict one page, and both rewrite the bricks of a page
+	m_BrickUploadOffset = maxLoads * SDFBrickPageFile::s_PageVoxelBytes;
+	const UINT64 uploadBytes = m_BrickUploadOffset + 2ull * maxLoads * SDFBrickPageFile::s_PageBricks * sizeof(Brick);
+	ASSERT(uploadBytes <= UINT_MAX, "Too many loads per update!");
+
+	const auto device = g_D3DGraphicsContext->GetDevice();
+	m_FrameResources.resize(D3DGraphicsContext::GetBackBufferCount());
+	for (auto& resources : m_FrameResources)
+	{
+		THROW_IF_FAIL(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&resources.CommandAllocator)));
+		THROW_IF_FAIL(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, resources.CommandAllocator.Get(), nullptr, IID_PPV_ARGS(&resources.CommandList)));
+		THROW_IF_FAIL(resources.CommandList->Close());
+
+		resources.Upload.Allocate(device, static_cast<UINT>(uploadBytes), 0, L"Brick Page Upload");
+	}
+}
+
+void SDFBrickPageStreamer::Reset()
+{
+	// Wait until work has completed to not destroy resources that are in use
+	if (m_LastWorkFence > 0)
+		g_D3DGraphicsContext->GetDirectCommandQueue()->WaitForFenceCPUBlocking(m_LastWorkFence);
+
+	m_FrameResources.clear();
+	m_Residency.Reset();
+	m_File = nullptr;
+	m_Object = nullptr;
+	m_LastWorkFence = 0;
+	m_LastUpdateBytes = 0;
+}
+
+
+void SDFBrickPageStreamer::Update(const XMFLOAT3& cameraPosition)
+{
+	ASSERT(IsInitialized(), "Streamer has not been initialized!");
+
+	m_LastUpdateBytes = 0;
+	m_Residency.Update(cameraPosition);
+
+	const auto& loads = m_Residency.GetLoads();
+	const auto& evictions = m_Residency.GetEvictions();
+	if (loads.empty())
+		return;
+
+	PIXBeginEvent(PIX_COLOR_INDEX(13), L"Brick Page Streaming");
+
+	const auto directQueue = g_D3DGraphicsContext->GetDirectCommandQueue();
+	auto& resources = m_FrameResources.at(g_D3DGraphicsContext->GetCurrentBackBuffer());
+
+	// The staging space of this frame may still be being read by the last time it was used
+	directQueue->WaitForFenceCPUBlocking(resources.Fence);
+
+	THROW_IF_FAIL(resources.CommandAllocator->Reset());
+	THROW_IF_FAIL(resources.CommandList->Reset(resources.CommandAllocator.Get(), nullptr));
+	const auto commandList = resources.CommandList.Get();
+
+	ID3D12Resource* brickBuffer = m_Object->GetBrickBuffer(SDFObject::RESOURCES_READ);
+	ID3D12Resource* brickPool = m_Object->GetBrickPool(SDFObject::RESOURCES_READ);
+	const XMUINT3& poolDimensions = m_Object->GetBrickPoolDimensions(SDFObject::RESOURCES_READ);
+
+	{
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(brickBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+			CD3DX12_RESOURCE_BARRIER::Transition(brickPool, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+		};
+		commandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
+
+	const Brick* fileBricks = m_File->GetBricks();
+	const SDFBrickPage* pages = m_File->GetPages();
+	UINT64 brickUploadOffset = m_BrickUploadOffset;
+
+	// The bricks of evicted pages already have no pool slot in the file, so they are copied as they are
+	for (const auto& eviction : evictions)
+	{
+		const SDFBrickPage& page = pages[eviction.Page];
+		const UINT bytes = page.BrickCount * sizeof(Brick);
+		resources.Upload.CopyElements(static_cast<UINT>(brickUploadOffset), bytes, reinterpret_cast<const BYTE*>(fileBricks + page.FirstBrick));
+		commandList->CopyBufferRegion(brickBuffer, static_cast<UINT64>(page.FirstBrick) * sizeof(Brick), resources.Upload.GetResource(), brickUploadOffset, bytes);
+		brickUploadOffset += bytes;
+	}
+
+	Brick pageBricks[SDFBrickPageFile::s_PageBricks];
+	for (UINT i = 0; i < static_cast<UINT>(loads.size()); i++)
+	{
+		const auto& load = loads.at(i);
+		const SDFBrickPage& page = pages[load.Page];
+		const UINT firstPoolSlot = SDFBrickPageFile::GetFirstPoolSlot(load.Slot);
+
+		// Page voxels are stored in the layout of their box of the pool, so they are staged with one copy
+		const UINT64 voxelOffset = i * SDFBrickPageFile::s_PageVoxelBytes;
+		resources.Upload.CopyElements(static_cast<UINT>(voxelOffset), static_cast<UINT>(SDFBrickPageFile::s_PageVoxelBytes), m_File->GetPageVoxels(load.Page));
+
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+		footprint.Offset = voxelOffset;
+		footprint.Footprint = CD3DX12_SUBRESOURCE_FOOTPRINT(
+			DXGI_FORMAT_R8G8B8A8_SNORM,
+			SDFBrickPageFile::s_PageWidth,
+			SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+			SDF_BRICK_SIZE_VOXELS_ADJACENCY,
+			SDFBrickPageFile::s_PageRowPitch);
+
+		const XMUINT3 destPosition = BrickHelpers::CalculateBrickPoolPosition(firstPoolSlot, poolDimensions, BrickPoolPlacement::Linear);
+		const CD3DX12_TEXTURE_COPY_LOCATION dest(brickPool, 0);
+		const CD3DX12_TEXTURE_COPY_LOCATION src(resources.Upload.GetResource(), footprint);
+		commandList->CopyTextureRegion(&dest, destPosition.x, destPosition.y, destPosition.z, &src, nullptr);
+
+		for (UINT brick = 0; brick < page.BrickCount; brick++)
+		{
+			pageBricks[brick] = fileBricks[page.FirstBrick + brick];
+			pageBricks[brick].PoolSlot = firstPoolSlot + brick;
+		}
+
+		const UINT bytes = page.BrickCount * sizeof(Brick);
+		resources.Upload.CopyElements(static_cast<UINT>(brickUploadOffset), bytes, reinterpret_cast<const BYTE*>(pageBricks));
+		commandList->CopyBufferRegion(brickBuffer, static_cast<UINT64>(page.FirstBrick) * sizeof(Brick), resources.Upload.GetResource(), brickUploadOffset, bytes);
+		brickUploadOffset += bytes;
+
+		m_LastUpdateBytes += SDFBrickPageFile::s_PageVoxelBytes;
+	}
+
+	{
+		const D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(brickBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+			CD3DX12_RESOURCE_BARRIER::Transition(brickPool, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		};
+		commandList->ResourceBarrier(ARRAYSIZE(barriers), barriers);
+	}
+
+	// Submitted before the frame's rendering, which is recorded into a later command list on the same queue
+	THROW_IF_FAIL(commandList->Close());
+	ID3D12CommandList* ppCommandLists[] = { commandList };
+	m_LastWorkFence = directQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	resources.Fence = m_LastWorkFence;
+
+	PIXEndEvent();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Core.h"
+#include "SDFBrickResidency.h"
+#include "Renderer/Buffer/UploadBuffer.h"
+
+
+class SDFObject;
+
+using Microsoft::WRL::ComPtr;
+
+
+// Streams the pages of a page file into the read resources of a paged object, as the camera moves
+// Each update, the loads and evictions decided by the residency are recorded into one command list on the direct queue,
+// ahead of the frame's rendering: the voxels of each loaded page are copied into its slot of the brick pool,
+// and the pool slots of its bricks are pointed at them. The bricks of evicted pages are marked non-resident.
+// The page table is the pool slots of the bricks, so the acceleration structure never needs to be rebuilt.
+class SDFBrickPageStreamer
+{
+public:
+	SDFBrickPageStreamer() = default;
+	~SDFBrickPageStreamer();
+
+	DISALLOW_COPY(SDFBrickPageStreamer)
+	DISALLOW_MOVE(SDFBrickPageStreamer)
+
+	// The object must have been loaded from the page file, and the file must stay open while the streamer is in use
+	// The slot count of the residency settings is taken from the brick pool of the object
+	void Init(const SDFBrickPageFile* file, SDFObject* object, const SDFBrickResidency::Settings& settings);
+	void Reset();
+
+	inline bool IsInitialized() const { return m_File != nullptr; }
+
+	// Streams pages in and out for the current frame
+	// The object's read resources must not be being switched
+	void Update(const XMFLOAT3& cameraPosition);
+
+	inline const SDFBrickResidency& GetResidency() const { return m_Residency; }
+	// Bytes of page voxels copied by the last update
+	inline UINT64 GetLastUpdateBytes() const { return m_LastUpdateBytes; }
+
+private:
+	const SDFBrickPageFile* m_File = nullptr;
+	SDFObject* m_Object = nullptr;
+	SDFBrickResidency m_Residency;
+
+	// Each frame in flight has its own command list and staging space, which is reused once the frame has completed
+	struct FrameResources
+	{
+		ComPtr<ID3D12CommandAllocator> CommandAllocator;
+		ComPtr<ID3D12GraphicsCommandList> CommandList;
+		UploadBuffer<BYTE> Upload;
+		UINT64 Fence = 0;
+	};
+	std::vector<FrameResources> m_FrameResources;
+	// Page voxels are staged first, followed by the bricks of loaded and evicted pages
+	UINT64 m_BrickUploadOffset = 0;
+
+	UINT64 m_LastWorkFence = 0;
+	UINT64 m_LastUpdateBytes = 0;
+};
@@ -0,0 +1,138 @@
+#include "pch.h"
+#include "SDFBrickResidency.h"
+
+#include <numeric>
+
+
+namespace
+{
+	float DistanceToPage(const SDFBrickPage& page, const XMFLOAT3& point)
+	{
+		const float dx = (std::max)((std::max)(page.BoundsMin.x - point.x, point.x - page.BoundsMax.x), 0.0f);
+		const float dy = (std::max)((std::max)(page.BoundsMin.y - point.y, point.y - page.BoundsMax.y), 0.0f);
+		const float dz = (std::max)((std::max)(page.BoundsMin.z - point.z, point.z - page.BoundsMax.z), 0.0f);
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+}
+
+
+void SDFBrickResidency::Init(const SDFBrickPage* pages, UINT pageCount, const Settings& settings)
+{
+	ASSERT(pages || pageCount == 0, "Pages are missing!");
+
+	m_Pages = pages;
+	m_Settings = settings;
+	m_Settings.MaxLoadsPerUpdate = (std::max)(m_Settings.MaxLoadsPerUpdate, 1u);
+	m_Settings.Hysteresis = std::clamp(m_Settings.Hysteresis, 0.0f, 1.0f);
+
+	m_PageSlots.assign(pageCount, s_NotResident);
+	m_SlotPages.assign(m_Settings.SlotCount, s_NotResident);
+	m_ResidentPageCount = 0;
+
+	m_Distances.resize(pageCount);
+	m_Order.resize(pageCount);
+	m_Wanted.assign(pageCount, false);
+
+	m_Loads.clear();
+	m_Evictions.clear();
+	m_WantedPageCount = 0;
+	m_WantedResidentPageCount = 0;
+	m_Statistics = {};
+}
+
+void SDFBrickResidency::Reset()
+{
+	Init(nullptr, 0, Settings{});
+}
+
+
+void SDFBrickResidency::Update(const XMFLOAT3& cameraPosition)
+{
+	m_Loads.clear();
+	m_Evictions.clear();
+	m_Statistics.Updates++;
+
+	const UINT pageCount = GetPageCount();
+	for (UINT page = 0; page < pageCount; page++)
+	{
+		const float distance = DistanceToPage(m_Pages[page], cameraPosition);
+		m_Distances[page] = m_PageSlots[page] == s_NotResident ? distance : distance * (1.0f - m_Settings.Hysteresis);
+	}
+
+	auto nearer = [this](UINT a, UINT b) { return m_Distances[a] < m_Distances[b]; };
+
+	// The nearest pages that fit in the pool are wanted
+	m_WantedPageCount = (std::min)(m_Settings.SlotCount, pageCount);
+	std::iota(m_Order.begin(), m_Order.end(), 0u);
+	if (m_WantedPageCount < pageCount)
+		std::nth_element(m_Order.begin(), m_Order.begin() + m_WantedPageCount, m_Order.end(), nearer);
+
+	std::fill(m_Wanted.begin(), m_Wanted.end(), false);
+	m_MissingPages.clear();
+	m_WantedResidentPageCount = 0;
+	for (UINT i = 0; i < m_WantedPageCount; i++)
+	{
+		const UINT page = m_Order[i];
+		m_Wanted[page] = true;
+
+		if (m_PageSlots[page] == s_NotResident)
+			m_MissingPages.push_back(page);
+		else
+			m_WantedResidentPageCount++;
+	}
+
+	if (m_MissingPages.empty())
+		return;
+
+	std::sort(m_MissingPages.begin(), m_MissingPages.end(), nearer);
+	if (m_MissingPages.size() > m_Settings.MaxLoadsPerUpdate)
+	{
+		m_Statistics.DeferredLoads += m_MissingPages.size() - m_Settings.MaxLoadsPerUpdate;
+		m_MissingPages.resize(m_Settings.MaxLoadsPerUpdate);
+	}
+
+	// Free slots are used first, and then the slots of the farthest pages that are no longer wanted
+	m_FreeSlots.clear();
+	m_EvictablePages.clear();
+	for (UINT slot = 0; slot < m_Settings.SlotCount; slot++)
+	{
+		const UINT page = m_SlotPages[slot];
+		if (page == s_NotResident)
+			m_FreeSlots.push_back(slot);
+		else if (!m_Wanted[page])
+			m_EvictablePages.push_back(page);
+	}
+	// Sorted nearest first, so that the farthest is popped off the back
+	std::sort(m_EvictablePages.begin(), m_EvictablePages.end(), nearer);
+
+	for (const UINT page : m_MissingPages)
+	{
+		UINT slot;
+		if (!m_FreeSlots.empty())
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			// There is always a page to evict, as there are no more wanted pages than slots
+			ASSERT(!m_EvictablePages.empty(), "No slot for a wanted page!");
+			const UINT evictedPage = m_EvictablePages.back();
+			m_EvictablePages.pop_back();
+
+			slot = m_PageSlots[evictedPage];
+			m_PageSlots[evictedPage] = s_NotResident;
+			m_ResidentPageCount--;
+			m_Evictions.push_back({ evictedPage, slot });
+		}
+
+		m_PageSlots[page] = slot;
+		m_SlotPages[slot] = page;
+		m_ResidentPageCount++;
+		m_Loads.push_back({ page, slot });
+	}
+
+	m_WantedResidentPageCount += static_cast<UINT>(m_Loads.size());
+	m_Statistics.Loads += m_Loads.size();
+	m_Statistics.Evictions += m_Evictions.size();
+}
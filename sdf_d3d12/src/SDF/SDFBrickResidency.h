@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Core.h"
+#include "SDFBrickPageFile.h"
+
+
+// Decides which pages of a page file are resident in the slots of a brick pool
+// This only tracks residency - the streamer carries out the loads and evictions it decides on.
+//
+// Each update, the pages nearest to the camera that fit in the budget are wanted resident.
+// Wanted pages that are not resident are loaded nearest first, up to a limit per update, into a free slot,
+// or else the slot of the resident page farthest from the camera that is no longer wanted.
+// Pages are only evicted to make room, so pages that drift out of the budget stay resident for as long as possible.
+class SDFBrickResidency
+{
+public:
+	inline static constexpr UINT s_NotResident = ~0u;
+
+	struct Settings
+	{
+		UINT SlotCount = 0;				// How many pages the brick pool can hold
+		UINT MaxLoadsPerUpdate = 16;	// Limits how much is streamed in each frame
+		// Resident pages are treated as this fraction closer than they are, so that pages on the edge of
+		// the budget do not thrash in and out as the camera moves back and forth
+		float Hysteresis = 0.1f;
+	};
+
+	struct PageAssignment
+	{
+		UINT Page;
+		UINT Slot;
+	};
+
+	struct Statistics
+	{
+		UINT64 Updates = 0;
+		UINT64 Loads = 0;
+		UINT64 Evictions = 0;
+		UINT64 DeferredLoads = 0;	// Wanted pages left for a later update by the load limit
+	};
+
+public:
+	SDFBrickResidency() = default;
+
+	// All pages start non-resident
+	void Init(const SDFBrickPage* pages, UINT pageCount, const Settings& settings);
+	void Reset();
+
+	// Decides the loads and evictions for this update. They are available until the next update
+	void Update(const XMFLOAT3& cameraPosition);
+
+	inline const std::vector<PageAssignment>& GetLoads() const { return m_Loads; }
+	inline const std::vector<PageAssignment>& GetEvictions() const { return m_Evictions; }
+
+	// The page table. Returns s_NotResident for pages that are not resident
+	inline UINT GetPageSlot(UINT page) const { return m_PageSlots.at(page); }
+	inline UINT GetPageCount() const { return static_cast<UINT>(m_PageSlots.size()); }
+	inline UINT GetResidentPageCount() const { return m_ResidentPageCount; }
+	// How many of the pages wanted by the last update are resident
+	inline UINT GetWantedPageCount() const { return m_WantedPageCount; }
+	inline UINT GetWantedResidentPageCount() const { return m_WantedResidentPageCount; }
+
+	inline const Settings& GetSettings() const { return m_Settings; }
+	inline const Statistics& GetStatistics() const { return m_Statistics; }
+
+private:
+	const SDFBrickPage* m_Pages = nullptr;
+	Settings m_Settings;
+
+	std::vector<UINT> m_PageSlots;
+	std::vector<UINT> m_SlotPages;	// The page in each slot, or s_NotResident for a free slot
+	UINT m_ResidentPageCount = 0;
+
+	// Scratch space that is kept between updates
+	std::vector<float> m_Distances;
+	std::vector<UINT> m_Order;
+	std::vector<bool> m_Wanted;
+	std::vector<UINT> m_MissingPages;
+	std::vector<UINT> m_FreeSlots;
+	std::vector<UINT> m_EvictablePages;
+
+	std::vector<PageAssignment> m_Loads;
+	std::vector<PageAssignment> m_Evictions;
+	UINT m_WantedPageCount = 0;
+	UINT m_WantedResidentPageCount = 0;
+
+	Statistics m_Statistics;
+};
@@ -0,0 +1,223 @@
+#include "pch.h"
+#include "SDFDirtyRegion.h"
+
+#include "SDFEditList.h"
+#include "SDF/CPU/SDFHelpers.h"
+
+#include <algorithm>
+
+
+using namespace SDFHelpers;
+
+
+// The sphere that an edit can change the field within
+// Returns false if the edit is unbounded
+static bool GetEditBounds(const SDFEditData& edit, float3& centre, float& radius)
+{
+	const SDFShape shape = GetShape(edit.EditParams);
+	if (shape >= SDF_SHAPE_FRACTAL)
+		return false;
+
+	centre = -float3(edit.InvTranslation);
+
+	// Apply blending range for smooth edits
+	// 1.74f == sqrt(3)
+	radius = boundingSphereRadius(shape, edit.ShapeParams) * edit.Scale;
+	if (IsSmoothEdit(edit.EditParams))
+		radius += 1.74f * edit.BlendingRange;
+	radius = max(radius, 0.0f);
+
+	return true;
+}
+
+// Two edits can only be dependent if the spheres of these radii around their centres overlap
+// These are the same bounds as the broad phase in SDFEditDependencies
+static float GetDependencyRadius(const SDFEditData& edit)
+{
+	return boundingSphereRadius(GetShape(edit.EditParams), edit.ShapeParams) * edit.Scale + edit.BlendingRange;
+}
+
+
+SDFDirtyRegion SDFDirtyRegion::Everything()
+{
+	SDFDirtyRegion region;
+	region.m_Everything = true;
+	return region;
+}
+
+void SDFDirtyRegion::Clear()
+{
+	*this = SDFDirtyRegion();
+}
+
+void SDFDirtyRegion::Union(const SDFDirtyRegion& other)
+{
+	if (other.m_Everything)
+	{
+		m_Everything = true;
+		return;
+	}
+	if (!other.IsEmpty())
+	{
+		AddBox(other.m_Min, other.m_Max);
+	}
+}
+
+void SDFDirtyRegion::AddBox(const XMFLOAT3& min, const XMFLOAT3& max)
+{
+	m_Min = { (std::min)(m_Min.x, min.x), (std::min)(m_Min.y, min.y), (std::min)(m_Min.z, min.z) };
+	m_Max = { (std::max)(m_Max.x, max.x), (std::max)(m_Max.y, max.y), (std::max)(m_Max.z, max.z) };
+}
+
+void SDFDirtyRegion::AddEdit(const SDFEditList& editList, UINT editIndex)
+{
+	ASSERT(editIndex < editList.GetEditCount(), "Invalid edit index");
+
+	const SDFEditData* edits = editList.GetEditData();
+	const SDFEditData& edit = edits[editIndex];
+
+	float3 centre;
+	float radius;
+	if (!GetEditBounds(edit, centre, radius))
+	{
+		m_Everything = true;
+		return;
+	}
+
+	auto addSphere = [this](const float3& c, float r)
+		{
+			AddBox({ c.x - r, c.y - r, c.z - r }, { c.x + r, c.y + r, c.z + r });
+		};
+	addSphere(centre, radius);
+
+	// Find the smooth edits that could depend on this edit
+	const float dependencyRadius = GetDependencyRadius(edit);
+	for (UINT i = 0; i < editList.GetEditCount(); i++)
+	{
+		const SDFEditData& other = edits[i];
+		if (i == editIndex || !IsSmoothEdit(other.EditParams))
+			continue;
+
+		float3 otherCentre;
+		float otherRadius;
+		if (!GetEditBounds(other, otherCentre, otherRadius))
+			continue;	// Unbounded edits are relevant to every brick anyway
+
+		if (length(otherCentre - centre) <= dependencyRadius + GetDependencyRadius(other))
+		{
+			addSphere(otherCentre, otherRadius);
+		}
+	}
+}
+
+void SDFDirtyRegion::AddEdits(const SDFEditList& editList, const std::vector<UINT>& editIndices)
+{
+	// A sweep is not worth sorting the whole list for
+	if (editIndices.size() <= s_MinSweepEditCount)
+	{
+		for (const UINT index : editIndices)
+		{
+			AddEdit(editList, index);
+		}
+		return;
+	}
+
+	const SDFEditData* edits = editList.GetEditData();
+
+	struct SweepBounds
+	{
+		float Min, Max;
+		float3 Centre;
+		float Radius;		// The radius of the region the edit can change
+		float DependencyRadius;
+		UINT Edit;
+		bool Changed;		// Otherwise it is a smooth edit that may depend on the changed edits
+	};
+	std::vector<SweepBounds> bounds;
+	bounds.reserve(editIndices.size() + editList.GetEditCount());
+
+	float3 centreMin(FLT_MAX), centreMax(-FLT_MAX);
+	auto addBounds = [&](UINT index, bool changed)
+		{
+			const SDFEditData& edit = edits[index];
+
+			SweepBounds b;
+			if (!GetEditBounds(edit, b.Centre, b.Radius))
+				return false;
+
+			b.DependencyRadius = GetDependencyRadius(edit);
+			b.Edit = index;
+			b.Changed = changed;
+			bounds.push_back(b);
+
+			centreMin = { (std::min)(centreMin.x, b.Centre.x), (std::min)(centreMin.y, b.Centre.y), (std::min)(centreMin.z, b.Centre.z) };
+			centreMax = { (std::max)(centreMax.x, b.Centre.x), (std::max)(centreMax.y, b.Centre.y), (std::max)(centreMax.z, b.Centre.z) };
+			return true;
+		};
+
+	for (const UINT index : editIndices)
+	{
+		ASSERT(index < editList.GetEditCount(), "Invalid edit index");
+		if (!addBounds(index, true))
+		{
+			m_Everything = true;
+			return;
+		}
+	}
+	// Unbounded smooth edits are relevant to every brick anyway
+	for (UINT i = 0; i < editList.GetEditCount(); i++)
+	{
+		if (IsSmoothEdit(edits[i].EditParams))
+			addBounds(i, false);
+	}
+
+	// Sweep along the axis that the edits are most spread out along
+	const float3 spread = centreMax - centreMin;
+	const int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+	for (auto& b : bounds)
+	{
+		const float c = axis == 0 ? b.Centre.x : (axis == 1 ? b.Centre.y : b.Centre.z);
+		b.Min = c - b.DependencyRadius;
+		b.Max = c + b.DependencyRadius;
+	}
+	std::sort(bounds.begin(), bounds.end(), [](const SweepBounds& a, const SweepBounds& b) { return a.Min < b.Min; });
+
+	auto addSphere = [this](const SweepBounds& b)
+		{
+			AddBox({ b.Centre.x - b.Radius, b.Centre.y - b.Radius, b.Centre.z - b.Radius }, { b.Centre.x + b.Radius, b.Centre.y + b.Radius, b.Centre.z + b.Radius });
+		};
+
+	// Changed edits are only tested against smooth edits, and each smooth edit is added once
+	std::vector<const SweepBounds*> activeChanged;
+	std::vector<const SweepBounds*> activeSmooth;
+	std::vector<bool> addedSmooth(editList.GetEditCount(), false);
+	for (const SweepBounds& b : bounds)
+	{
+		auto& others = b.Changed ? activeSmooth : activeChanged;
+		others.erase(std::remove_if(others.begin(), others.end(), [&b](const SweepBounds* other) { return other->Max < b.Min; }), others.end());
+
+		for (const SweepBounds* other : others)
+		{
+			const SweepBounds& changed = b.Changed ? b : *other;
+			const SweepBounds& smooth = b.Changed ? *other : b;
+			if (changed.Edit == smooth.Edit || addedSmooth.at(smooth.Edit))
+				continue;
+
+			if (length(smooth.Centre - changed.Centre) <= changed.DependencyRadius + smooth.DependencyRadius)
+			{
+				addSphere(smooth);
+				addedSmooth.at(smooth.Edit) = true;
+			}
+		}
+
+		if (b.Changed)
+		{
+			addSphere(b);
+			activeChanged.push_back(&b);
+		}
+		else
+		{
+			activeSmooth.push_back(&b);
+		}
+	}
+}
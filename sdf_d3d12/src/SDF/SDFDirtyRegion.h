@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Core.h"
+
+class SDFEditList;
+
+
+// An axis-aligned box in eval space in which a baked SDF object may no longer match its edit list
+// Incremental bakes only rebuild the bricks that overlap this region.
+// Bricks outside of the region keep their edit indices, so edits may only be added to or removed from the end of the list
+// unless the region covers everything.
+class SDFDirtyRegion
+{
+public:
+	SDFDirtyRegion() = default;
+	~SDFDirtyRegion() = default;
+
+	DEFAULT_COPY(SDFDirtyRegion)
+	DEFAULT_MOVE(SDFDirtyRegion)
+
+	// A region that covers all of space, which requires a full bake
+	static SDFDirtyRegion Everything();
+
+	void Clear();
+	void Union(const SDFDirtyRegion& other);
+	void AddBox(const XMFLOAT3& min, const XMFLOAT3& max);
+
+	// Adds the region that an edit can change, whether it was added, removed or modified.
+	// Smooth edits that blend with the edit include it in their dependencies,
+	// which can change their culling, so their regions are added too.
+	// Call before an edit is removed from the list, or after it is added.
+	void AddEdit(const SDFEditList& editList, UINT editIndex);
+	// The same as adding each edit in turn, but the smooth edits that blend with them are found with one sweep and prune
+	// rather than by testing every edit in the list against each of them
+	void AddEdits(const SDFEditList& editList, const std::vector<UINT>& editIndices);
+
+	// Getters
+	inline bool IsEmpty() const { return !m_Everything && (m_Min.x > m_Max.x || m_Min.y > m_Max.y || m_Min.z > m_Max.z); }
+	inline bool IsEverything() const { return m_Everything; }
+
+	inline const XMFLOAT3& GetMin() const { return m_Min; }
+	inline const XMFLOAT3& GetMax() const { return m_Max; }
+
+private:
+	// Fewer edits than this are added one at a time
+	inline static constexpr size_t s_MinSweepEditCount = 8;
+
+	bool m_Everything = false;
+
+	// An empty region has min > max
+	XMFLOAT3 m_Min = { FLT_MAX, FLT_MAX, FLT_MAX };
+	XMFLOAT3 m_Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+};
@@ -0,0 +1,130 @@
+#include "pch.h"
+#include "SDFEditDependencies.h"
+
+#include "SDF/CPU/SDFHelpers.h"
+
+#include <algorithm>
+#include <cfloat>
+
+
+using namespace SDFHelpers;
+
+
+void SDFEditDependencies::Build(const SDFEditData* edits, UINT editCount)
+{
+	m_Offsets.assign(static_cast<size_t>(editCount) + 1, 0);
+	m_Indices.clear();
+	m_Dependencies.clear();
+	m_CandidatePairCount = 0;
+
+	if (editCount < 2)
+		return;
+
+	// Edit A depends on edit B if their bounding spheres are within blending range of each other,
+	// evaluated from the centre of A. This is only tested where A is the later edit and is smooth.
+	auto dependent = [edits](UINT indexA, UINT indexB)
+		{
+			const SDFEditData& editA = edits[indexA];
+			const SDFEditData& editB = edits[indexB];
+
+			// get the world-space position of this edit
+			const float3 pA = -float3(editA.InvTranslation);
+			const float dA = EvaluateBoundingSphere(editA, pA);
+
+			// evaluate the distance to edit2
+			const float dB = EvaluateBoundingSphere(editB, pA);
+
+			return dB + dA <= editA.BlendingRange + editB.BlendingRange;
+		};
+
+	// Bound each edit by a sphere that contains its bounding sphere expanded by its blending range
+	// Two edits can only be dependent if these spheres overlap
+	std::vector<float3> centres(editCount);
+	std::vector<float> radii(editCount);
+	float3 centreMin(FLT_MAX), centreMax(-FLT_MAX);
+	for (UINT i = 0; i < editCount; i++)
+	{
+		const SDFEditData& edit = edits[i];
+		const float3 centre = -float3(edit.InvTranslation);
+
+		float radius = boundingSphereRadius(GetShape(edit.EditParams), edit.ShapeParams) * edit.Scale + edit.BlendingRange;
+		if (GetShape(edit.EditParams) > SDF_SHAPE_FRACTAL)
+			radius = FLT_MAX;	// Unknown shapes are considered to be everywhere
+		// Pad by the rounding error of the exact test
+		radius = max(radius, 0.0f);
+		radius += 1e-4f * (fabsf(centre.x) + fabsf(centre.y) + fabsf(centre.z) + radius) + 1e-6f;
+
+		centres.at(i) = centre;
+		radii.at(i) = radius;
+
+		centreMin = { min(centreMin.x, centre.x), min(centreMin.y, centre.y), min(centreMin.z, centre.z) };
+		centreMax = { max(centreMax.x, centre.x), max(centreMax.y, centre.y), max(centreMax.z, centre.z) };
+	}
+
+	// Sweep along the axis that the edits are most spread out along
+	const float3 spread = centreMax - centreMin;
+	const int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+	auto axisComponent = [axis](const float3& v) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); };
+
+	m_SweepBounds.resize(editCount);
+	for (UINT i = 0; i < editCount; i++)
+	{
+		const float c = axisComponent(centres.at(i));
+		m_SweepBounds.at(i) = { c - radii.at(i), c + radii.at(i), i };
+	}
+	std::sort(m_SweepBounds.begin(), m_SweepBounds.end(), [](const SweepBounds& a, const SweepBounds& b)
+		{
+			return a.Min < b.Min || (a.Min == b.Min && a.Edit < b.Edit);
+		});
+
+	m_ActiveEdits.clear();
+	for (const SweepBounds& bounds : m_SweepBounds)
+	{
+		// Remove edits that end before this one begins
+		m_ActiveEdits.erase(std::remove_if(m_ActiveEdits.begin(), m_ActiveEdits.end(), [&](UINT edit)
+			{
+				return axisComponent(centres.at(edit)) + radii.at(edit) < bounds.Min;
+			}), m_ActiveEdits.end());
+
+		const UINT edit = bounds.Edit;
+		for (const UINT other : m_ActiveEdits)
+		{
+			// Test the full spheres
+			const float3 d = centres.at(edit) - centres.at(other);
+			const float r = radii.at(edit) + radii.at(other);
+			if (dot(d, d) > r * r)
+				continue;
+
+			// The pair is processed with A as the later edit, only if A is smooth
+			const UINT indexA = max(edit, other);
+			const UINT indexB = min(edit, other);
+			if (!IsSmoothEdit(edits[indexA].EditParams))
+				continue;
+
+			m_CandidatePairCount++;
+			if (dependent(indexA, indexB))
+			{
+				m_Dependencies.push_back({ indexA, indexB });
+				// B also depends on A if B is smooth
+				if (IsSmoothEdit(edits[indexB].EditParams))
+					m_Dependencies.push_back({ indexB, indexA });
+			}
+		}
+
+		m_ActiveEdits.push_back(edit);
+	}
+
+	// Build the rows, with the dependencies of each edit in ascending order
+	std::sort(m_Dependencies.begin(), m_Dependencies.end());
+
+	m_Indices.resize(m_Dependencies.size());
+	for (size_t i = 0; i < m_Dependencies.size(); i++)
+	{
+		m_Offsets.at(m_Dependencies.at(i).first + 1)++;
+		m_Indices.at(i) = m_Dependencies.at(i).second;
+	}
+	for (UINT i = 0; i < editCount; i++)
+	{
+		m_Offsets.at(i + 1) += m_Offsets.at(i);
+	}
+}
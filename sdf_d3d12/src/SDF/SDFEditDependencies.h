@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Core.h"
+#include "HlslCompat/ComputeHlslCompat.h"
+
+
+// The other edits that each smooth edit blends into
+// When a smooth edit is relevant to a brick, its dependencies must not be culled from that brick.
+//
+// Dependencies are found with a sweep and prune over the bounding spheres of the edits, expanded by their blending range,
+// so only edits that are close together are tested rather than every pair.
+// Each candidate pair is then given the exact test, so the result is the same as testing every pair.
+//
+// The result is stored as compressed sparse rows:
+// the dependencies of edit i are Indices[Offsets[i]] to Indices[Offsets[i + 1] - 1], in ascending order
+class SDFEditDependencies
+{
+public:
+	SDFEditDependencies() = default;
+	~SDFEditDependencies() = default;
+
+	DEFAULT_COPY(SDFEditDependencies)
+	DEFAULT_MOVE(SDFEditDependencies)
+
+	void Build(const SDFEditData* edits, UINT editCount);
+
+	// Getters
+	inline UINT GetEditCount() const { return static_cast<UINT>(m_Offsets.size()) - 1; }
+	inline UINT GetTotalDependencyCount() const { return static_cast<UINT>(m_Indices.size()); }
+
+	inline const std::vector<UINT>& GetOffsets() const { return m_Offsets; }
+	inline const std::vector<UINT>& GetIndices() const { return m_Indices; }
+
+	inline UINT GetDependencyCount(UINT edit) const { return m_Offsets.at(edit + 1) - m_Offsets.at(edit); }
+	inline const UINT* GetDependencies(UINT edit) const { return m_Indices.data() + m_Offsets.at(edit); }
+
+	// The number of pairs that passed the broad phase in the last build
+	inline UINT64 GetCandidatePairCount() const { return m_CandidatePairCount; }
+
+private:
+	std::vector<UINT> m_Offsets = { 0 };
+	std::vector<UINT> m_Indices;
+
+	UINT64 m_CandidatePairCount = 0;
+
+	// Scratch data kept between builds to avoid re-allocation
+	struct SweepBounds
+	{
+		float Min, Max;
+		UINT Edit;
+	};
+	std::vector<SweepBounds> m_SweepBounds;
+	std::vector<UINT> m_ActiveEdits;
+	std::vector<std::pair<UINT, UINT>> m_Dependencies;	// (edit, dependency)
+};
@@ -0,0 +1,318 @@
+#include "pch.h"
+#include "SDFEditJournal.h"
+
+#include "Framework/Hash.h"
+
+#include <filesystem>
+
+
+namespace
+{
+	// Replay reads the journal in blocks of this size
+	constexpr size_t s_ReadBlockSize = 1 << 20;
+
+	UINT GetPayloadSize(SDFEditJournalOp::Value op)
+	{
+		switch (op)
+		{
+		case SDFEditJournalOp::AddEdit:				return sizeof(SDFEditData);
+		case SDFEditJournalOp::SetEvaluationRange:	return sizeof(float);
+		default:									return 0;
+		}
+	}
+
+	UINT CalculateChecksum(SDFEditJournalOp::Value op, const void* payload)
+	{
+		const UINT64 hash = Hash::Bytes(payload, GetPayloadSize(op), Hash::Value(op));
+		return static_cast<UINT>(hash ^ (hash >> 32));
+	}
+
+	void WriteRecord(std::ofstream& file, SDFEditJournalOp::Value op, const void* payload)
+	{
+		const SDFEditJournal::RecordHeader header{ op, CalculateChecksum(op, payload) };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(static_cast<const char*>(payload), GetPayloadSize(op));
+	}
+
+	bool ApplyRecord(SDFEditJournalOp::Value op, const BYTE* payload, SDFEditList& editList)
+	{
+		switch (op)
+		{
+		case SDFEditJournalOp::AddEdit:
+		{
+			SDFEditData editData;
+			memcpy(&editData, payload, sizeof(editData));
+			return editList.AddEditData(editData);
+		}
+		case SDFEditJournalOp::PopEdit:
+			return editList.PopEdit();
+		case SDFEditJournalOp::Reset:
+			editList.Reset();
+			return true;
+		case SDFEditJournalOp::SetEvaluationRange:
+		{
+			float evaluationRange;
+			memcpy(&evaluationRange, payload, sizeof(evaluationRange));
+			editList.SetEvaluationRange(evaluationRange);
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+}
+
+
+const char* SDFEditJournalOp::GetName(Value op)
+{
+	static const char* names[] =
+	{
+		"Add Edit",
+		"Pop Edit",
+		"Reset",
+		"Set Evaluation Range"
+	};
+	static_assert(ARRAYSIZE(names) == Count);
+	return names[op];
+}
+
+
+bool SDFEditJournal::Open(const std::string& path, SDFEditList& editList)
+{
+	Close();
+	m_Path = path;
+
+	std::error_code error;
+	if (!std::filesystem::exists(path, error))
+	{
+		LOG_INFO("Starting edit journal '{}'.", path);
+		return Rewrite(editList);
+	}
+
+	// Replayed into a copy, so that the list is untouched if the journal cannot be replayed
+	SDFEditList replayedList = editList;
+	ReplayStats stats;
+	if (!Replay(path, replayedList, &stats))
+		return false;
+	editList = std::move(replayedList);
+
+	LOG_INFO("Replayed {} records from edit journal '{}' to {} edits.", stats.RecordCount, path, editList.GetEditCount());
+
+	if (stats.RecordCount > s_CompactionMinRecords && stats.RecordCount > s_CompactionRatio * (editList.GetEditCount() + 1ull))
+	{
+		LOG_INFO("Compacting edit journal '{}'.", path);
+		return Rewrite(editList);
+	}
+
+	if (stats.TornRecord)
+	{
+		// Anything after the last valid record is dropped, so that new records follow on from it
+		LOG_WARN("Edit journal '{}' ends with a torn record, which has been dropped.", path);
+		std::filesystem::resize_file(path, stats.ValidSize, error);
+		if (error)
+		{
+			LOG_ERROR("Failed to truncate edit journal '{}': {}", path, error.message());
+			return false;
+		}
+	}
+
+	m_RecordCount = stats.RecordCount;
+	return OpenForAppend();
+}
+
+void SDFEditJournal::Close()
+{
+	if (m_File.is_open())
+		m_File.close();
+	m_RecordCount = 0;
+}
+
+
+void SDFEditJournal::RecordAddEdit(const SDFEditData& editData)
+{
+	Append(SDFEditJournalOp::AddEdit, &editData);
+}
+
+void SDFEditJournal::RecordPopEdit()
+{
+	Append(SDFEditJournalOp::PopEdit, nullptr);
+}
+
+void SDFEditJournal::RecordReset()
+{
+	Append(SDFEditJournalOp::Reset, nullptr);
+}
+
+void SDFEditJournal::RecordSetEvaluationRange(float evaluationRange)
+{
+	Append(SDFEditJournalOp::SetEvaluationRange, &evaluationRange);
+}
+
+
+bool SDFEditJournal::Rewrite(const SDFEditList& editList)
+{
+	ASSERT(!m_Path.empty(), "Journal has no path!");
+
+	// The file must be closed before it can be replaced
+	Close();
+	if (!WriteCompacted(m_Path, editList))
+		return false;
+
+	// Set evaluation range, and then every edit
+	m_RecordCount = 1ull + editList.GetEditCount();
+	return OpenForAppend();
+}
+
+
+bool SDFEditJournal::Replay(const std::string& path, SDFEditList& editList, ReplayStats* outStats)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		LOG_WARN("Failed to open edit journal '{}'.", path);
+		return false;
+	}
+
+	FileHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.Magic != s_Magic)
+	{
+		LOG_WARN("'{}' is not an edit journal.", path);
+		return false;
+	}
+	if (header.Version != s_Version)
+	{
+		LOG_WARN("Edit journal '{}' was written by a different version.", path);
+		return false;
+	}
+
+	editList.Reset();
+
+	ReplayStats stats;
+	stats.ValidSize = sizeof(FileHeader);
+
+	// Records are parsed out of a block at a time. A record that straddles the end of a block
+	// is moved to the front of the buffer, and the rest of the block is filled from the file.
+	std::vector<BYTE> buffer(s_ReadBlockSize);
+	size_t begin = 0;
+	size_t end = 0;
+	while (!stats.TornRecord)
+	{
+		memmove(buffer.data(), buffer.data() + begin, end - begin);
+		end -= begin;
+		begin = 0;
+
+		file.read(reinterpret_cast<char*>(buffer.data() + end), static_cast<std::streamsize>(buffer.size() - end));
+		const size_t readSize = static_cast<size_t>(file.gcount());
+		end += readSize;
+
+		while (end - begin >= sizeof(RecordHeader))
+		{
+			RecordHeader record;
+			memcpy(&record, buffer.data() + begin, sizeof(record));
+			if (record.Op >= SDFEditJournalOp::Count)
+			{
+				stats.TornRecord = true;
+				break;
+			}
+
+			const size_t recordSize = sizeof(RecordHeader) + GetPayloadSize(record.Op);
+			if (end - begin < recordSize)
+				break;
+
+			const BYTE* payload = buffer.data() + begin + sizeof(RecordHeader);
+			if (CalculateChecksum(record.Op, payload) != record.Checksum)
+			{
+				stats.TornRecord = true;
+				break;
+			}
+
+			if (!ApplyRecord(record.Op, payload, editList))
+			{
+				LOG_ERROR("Record {} of edit journal '{}' ({}) could not be applied to the edit list.",
+					stats.RecordCount, path, SDFEditJournalOp::GetName(record.Op));
+				return false;
+			}
+
+			begin += recordSize;
+			stats.ValidSize += recordSize;
+			stats.RecordCount++;
+		}
+
+		if (readSize == 0)
+		{
+			// Part of a record left at the end of the file was never finished
+			stats.TornRecord |= end > begin;
+			break;
+		}
+	}
+
+	if (outStats)
+		*outStats = stats;
+	return true;
+}
+
+
+bool SDFEditJournal::WriteCompacted(const std::string& path, const SDFEditList& editList)
+{
+	const std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG_ERROR("Failed to open edit journal '{}' for writing.", tempPath);
+			return false;
+		}
+
+		const FileHeader header{ s_Magic, s_Version };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		const float evaluationRange = editList.GetEvaluationRange();
+		WriteRecord(file, SDFEditJournalOp::SetEvaluationRange, &evaluationRange);
+		for (UINT i = 0; i < editList.GetEditCount(); i++)
+			WriteRecord(file, SDFEditJournalOp::AddEdit, editList.GetEditData() + i);
+
+		if (!file.good())
+		{
+			LOG_ERROR("Failed to write edit journal '{}'.", tempPath);
+			return false;
+		}
+	}
+
+	if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		LOG_ERROR("Failed to move edit journal into place at '{}' (error {}).", path, GetLastError());
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+void SDFEditJournal::Append(SDFEditJournalOp::Value op, const void* payload)
+{
+	if (!m_File.is_open())
+		return;
+
+	WriteRecord(m_File, op, payload);
+	// Flushed every record, so that a crash loses at most the record being written
+	m_File.flush();
+	m_RecordCount++;
+
+	if (!m_File.good())
+	{
+		LOG_ERROR("Failed to append to edit journal '{}'. Further edits will not be recorded.", m_Path);
+		m_File.close();
+	}
+}
+
+bool SDFEditJournal::OpenForAppend()
+{
+	m_File.open(m_Path, std::ios::binary | std::ios::app);
+	if (!m_File.is_open())
+	{
+		LOG_ERROR("Failed to open edit journal '{}' for appending.", m_Path);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Core.h"
+#include "SDFEditList.h"
+
+#include <fstream>
+
+
+namespace SDFEditJournalOp
+{
+	enum Value : UINT
+	{
+		AddEdit = 0,			// Followed by the SDFEditData of the edit
+		PopEdit,
+		Reset,
+		SetEvaluationRange,		// Followed by the new range
+		Count
+	};
+
+	const char* GetName(Value op);
+}
+
+
+// An append-only record of the operations made on an edit list
+// Each operation is appended as it is made, so saving costs the same however long the list is,
+// and loading replays the operations onto an edit list without going through the editor.
+// Every record is checksummed, so a record torn by a crash part way through a write is dropped when the journal is next opened.
+class SDFEditJournal
+{
+public:
+	inline static constexpr UINT s_Magic = 0x4A454453;	// "SDEJ"
+	// Increment this whenever the layout of a record or of SDFEditData changes
+	inline static constexpr UINT s_Version = 1;
+
+	// When opened, a journal with more records than this many per edit is rewritten with one record per edit
+	inline static constexpr UINT s_CompactionRatio = 2;
+	// Short journals are never worth rewriting
+	inline static constexpr UINT64 s_CompactionMinRecords = 4096;
+
+	struct FileHeader
+	{
+		UINT Magic;
+		UINT Version;
+	};
+
+	struct RecordHeader
+	{
+		SDFEditJournalOp::Value Op;
+		UINT Checksum;	// Of the op and its payload
+	};
+
+	struct ReplayStats
+	{
+		UINT64 RecordCount = 0;
+		UINT64 ValidSize = 0;		// Bytes up to the end of the last valid record
+		bool TornRecord = false;	// If anything after the last valid record was dropped
+	};
+
+public:
+	SDFEditJournal() = default;
+	~SDFEditJournal() = default;
+
+	DISALLOW_COPY(SDFEditJournal)
+	DISALLOW_MOVE(SDFEditJournal)
+
+	// Replays the journal at the path onto the edit list, and then opens it to append to
+	// If there is no journal at the path, a new one is started from the contents of the edit list.
+	// Returns false, and leaves the file untouched, if the journal is from another version or cannot be replayed
+	bool Open(const std::string& path, SDFEditList& editList);
+	void Close();
+
+	inline bool IsOpen() const { return m_File.is_open(); }
+	inline UINT64 GetRecordCount() const { return m_RecordCount; }
+
+	// Record an operation that has been made on the edit list
+	// Each record is flushed to the file before returning
+	void RecordAddEdit(const SDFEditData& editData);
+	void RecordPopEdit();
+	void RecordReset();
+	void RecordSetEvaluationRange(float evaluationRange);
+
+	// Replaces the journal with one that rebuilds the edit list in one record per edit
+	bool Rewrite(const SDFEditList& editList);
+
+	// Resets the edit list and applies every valid record in the journal to it
+	static bool Replay(const std::string& path, SDFEditList& editList, ReplayStats* outStats = nullptr);
+	// Writes a journal that rebuilds the edit list in one record per edit
+	static bool WriteCompacted(const std::string& path, const SDFEditList& editList);
+
+private:
+	void Append(SDFEditJournalOp::Value op, const void* payload);
+	bool OpenForAppend();
+
+private:
+	std::string m_Path;
+	std::ofstream m_File;
+	UINT64 m_RecordCount = 0;
+};
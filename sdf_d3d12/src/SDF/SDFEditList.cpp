@@ -2,6 +2,7 @@
 #include "SDFEditList.h"
 
 #include "Core.h"
+#include "Framework/Hash.h"
 #include "Renderer/D3DGraphicsContext.h"
 
 
@@ -17,17 +18,27 @@ SDFEditList::SDFEditList(UINT maxEdits, float evaluationRange)
 	: m_MaxEdits(maxEdits)
 	, m_EvaluationRange(evaluationRange)
 {
-	ASSERT(m_MaxEdits <= s_EditLimit, "Edit lists are limited to 1024 edits.");
+	ASSERT(m_MaxEdits <= s_EditLimit, "Edit lists are limited to SDF_EDIT_LIMIT edits.");
 
-	m_Edits.resize(m_MaxEdits);
+	m_Edits.reserve(m_MaxEdits);
+	m_SoA.Reserve(m_MaxEdits);
 }
 
 void SDFEditList::Reset()
 {
 	m_EditCount = 0;
+	m_Edits.clear();
+	m_SoA.Clear();
+	m_EditHashes.clear();
+	m_PrefixHashes.clear();
 }
 
 bool SDFEditList::AddEdit(const SDFEdit& edit)
+{
+	return AddEditData(BuildEditData(edit));
+}
+
+bool SDFEditList::AddEditData(const SDFEditData& editData)
 {
 	if (m_EditCount >= m_MaxEdits)
 	{
@@ -35,7 +46,13 @@ bool SDFEditList::AddEdit(const SDFEdit& edit)
 		return false;
 	}
 
-	m_Edits.at(m_EditCount++) = BuildEditData(edit);
+	m_Edits.push_back(editData);
+	m_EditCount++;
+	m_SoA.PushBack(editData);
+
+	const UINT64 editHash = Hash::Value(editData);
+	m_EditHashes.push_back(editHash);
+	m_PrefixHashes.push_back(Hash::Value(editHash, m_PrefixHashes.empty() ? Hash::s_Seed : m_PrefixHashes.back()));
 	return true;
 }
 
@@ -47,10 +64,21 @@ bool SDFEditList::PopEdit()
 		return false;
 	}
 	m_EditCount--;
+	m_Edits.pop_back();
+	m_SoA.PopBack();
+	m_EditHashes.pop_back();
+	m_PrefixHashes.pop_back();
 	return true;
 }
 
 
+UINT64 SDFEditList::GetHash() const
+{
+	const UINT64 editsHash = m_PrefixHashes.empty() ? Hash::s_Seed : m_PrefixHashes.back();
+	return Hash::Value(m_EvaluationRange, editsHash);
+}
+
+
 SDFEditData SDFEditList::BuildEditData(const SDFEdit& edit)
 {
 	SDFEditData primitiveData;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SDFTypes.h"
+#include "SDFEditListSoA.h"
 #include "Renderer/Buffer/StructuredBuffer.h"
 #include "Renderer/Buffer/UploadBuffer.h"
 #include "HlslCompat/ComputeHlslCompat.h"
@@ -18,6 +19,8 @@ public:
 	void Reset();
 
 	bool AddEdit(const SDFEdit& edit);
+	// Adds an edit that has already been built, such as one read from a file
+	bool AddEditData(const SDFEditData& editData);
 	bool PopEdit();
 
 	// Getters
@@ -25,17 +28,32 @@ public:
 	inline UINT GetMaxEdits() const { return m_MaxEdits; }
 
 	inline const SDFEditData* GetEditData() const { return m_Edits.data(); }
+	// The same edits as structure-of-arrays for CPU evaluation
+	inline const SDFEditListSoA& GetSoA() const { return m_SoA; }
 
 	inline void SetEvaluationRange(float evalRange) { m_EvaluationRange = evalRange; }
 	inline float GetEvaluationRange() const { return m_EvaluationRange; }
 
+	// Content hashes, for finding which edits differ between lists without comparing them
+	inline UINT64 GetEditHash(UINT index) const { return m_EditHashes.at(index); }
+	// A hash of every edit in order, and the evaluation range
+	UINT64 GetHash() const;
+
 private:
 	SDFEditData BuildEditData(const SDFEdit& edit);
 
 private:
-	inline static constexpr UINT s_EditLimit = 1024;
+	inline static constexpr UINT s_EditLimit = SDF_EDIT_LIMIT;
 
+	// Only the edits in use are stored, so that copying a list doesn't copy its whole capacity
 	std::vector<SDFEditData> m_Edits;
+	// Kept in sync with m_Edits by AddEdit and PopEdit
+	SDFEditListSoA m_SoA;
+
+	// The hash of each edit, and the hash of every edit up to and including each edit
+	// Prefix hashes let PopEdit restore the list hash without rehashing
+	std::vector<UINT64> m_EditHashes;
+	std::vector<UINT64> m_PrefixHashes;
 
 	// Buffer capacity
 	UINT m_MaxEdits = 0;
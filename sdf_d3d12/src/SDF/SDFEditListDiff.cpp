@@ -0,0 +1,58 @@
+#include "pch.h"
+#include "SDFEditListDiff.h"
+
+#include "SDFEditList.h"
+
+
+void SDFEditListDiff::Compute(const SDFEditList& oldList, const SDFEditList& newList)
+{
+	m_Added.clear();
+	m_Removed.clear();
+	m_Modified.clear();
+
+	m_EvaluationRangeChanged = oldList.GetEvaluationRange() != newList.GetEvaluationRange();
+
+	// Identical lists are common, and can be found from the list hashes alone
+	if (oldList.GetHash() == newList.GetHash())
+		return;
+
+	const UINT commonCount = min(oldList.GetEditCount(), newList.GetEditCount());
+	for (UINT i = 0; i < commonCount; i++)
+	{
+		if (oldList.GetEditHash(i) != newList.GetEditHash(i))
+			m_Modified.push_back(i);
+	}
+	for (UINT i = commonCount; i < newList.GetEditCount(); i++)
+	{
+		m_Added.push_back(i);
+	}
+	for (UINT i = commonCount; i < oldList.GetEditCount(); i++)
+	{
+		m_Removed.push_back(i);
+	}
+}
+
+SDFDirtyRegion SDFEditListDiff::BuildDirtyRegion(const SDFEditList& oldList, const SDFEditList& newList) const
+{
+	// Changing the evaluation range changes the brick grid
+	if (m_EvaluationRangeChanged)
+		return SDFDirtyRegion::Everything();
+
+	// An incremental bake of a change this large would rebuild most of the object anyway
+	const size_t changedCount = m_Modified.size() + m_Added.size() + m_Removed.size();
+	if (2 * changedCount > max(oldList.GetEditCount(), newList.GetEditCount()))
+		return SDFDirtyRegion::Everything();
+
+	// A modified edit changes the object where it used to be and where it is now
+	// Each list is swept once for all of the edits that changed in it
+	std::vector<UINT> oldEdits = m_Modified;
+	oldEdits.insert(oldEdits.end(), m_Removed.begin(), m_Removed.end());
+	std::vector<UINT> newEdits = m_Modified;
+	newEdits.insert(newEdits.end(), m_Added.begin(), m_Added.end());
+
+	SDFDirtyRegion region;
+	region.AddEdits(oldList, oldEdits);
+	region.AddEdits(newList, newEdits);
+
+	return region;
+}
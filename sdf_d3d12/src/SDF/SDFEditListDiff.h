@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Core.h"
+#include "SDFDirtyRegion.h"
+
+class SDFEditList;
+
+
+// The differences between two edit lists, found by comparing the content hashes of their edits
+// Edits are compared by position, as an edit's position in the list is part of how it is evaluated
+class SDFEditListDiff
+{
+public:
+	SDFEditListDiff() = default;
+	~SDFEditListDiff() = default;
+
+	DEFAULT_COPY(SDFEditListDiff)
+	DEFAULT_MOVE(SDFEditListDiff)
+
+	void Compute(const SDFEditList& oldList, const SDFEditList& newList);
+
+	// Whether the lists produce the same object
+	inline bool IsEmpty() const { return m_Added.empty() && m_Removed.empty() && m_Modified.empty() && !m_EvaluationRangeChanged; }
+
+	// The region of space in which the object can differ between the lists
+	// Must be called with the same lists that the diff was computed from
+	SDFDirtyRegion BuildDirtyRegion(const SDFEditList& oldList, const SDFEditList& newList) const;
+
+	// Getters
+	inline const std::vector<UINT>& GetAdded() const { return m_Added; }			// Indices into the new list
+	inline const std::vector<UINT>& GetRemoved() const { return m_Removed; }		// Indices into the old list
+	inline const std::vector<UINT>& GetModified() const { return m_Modified; }	// Indices into both lists
+	inline bool IsEvaluationRangeChanged() const { return m_EvaluationRangeChanged; }
+
+private:
+	std::vector<UINT> m_Added;
+	std::vector<UINT> m_Removed;
+	std::vector<UINT> m_Modified;
+	bool m_EvaluationRangeChanged = false;
+};
@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "SDFEditListFile.h"
+
+#include "Framework/Hash.h"
+
+#include <fstream>
+
+
+static_assert(std::is_trivially_copyable_v<SDFEditData>, "Edits are written directly to disk!");
+
+
+bool SDFEditListFile::Write(const std::string& path, const SDFEditList& editList)
+{
+	Header header = {};
+	header.Magic = s_Magic;
+	header.Version = s_Version;
+	header.EvaluationRange = editList.GetEvaluationRange();
+	header.EditCount = editList.GetEditCount();
+	header.ListHash = editList.GetHash();
+
+	const std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG_ERROR("Failed to open edit list file '{}' for writing.", tempPath);
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		// Each chunk is written straight from the edit list
+		for (UINT first = 0; first < header.EditCount; first += s_ChunkEdits)
+		{
+			ChunkHeader chunk;
+			chunk.FirstEdit = first;
+			chunk.EditCount = (std::min)(s_ChunkEdits, header.EditCount - first);
+
+			const SDFEditData* edits = editList.GetEditData() + first;
+			const size_t size = chunk.EditCount * sizeof(SDFEditData);
+			chunk.Hash = Hash::Bytes(edits, size);
+
+			file.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+			file.write(reinterpret_cast<const char*>(edits), static_cast<std::streamsize>(size));
+		}
+
+		if (!file.good())
+		{
+			LOG_ERROR("Failed to write edit list file '{}'.", tempPath);
+			return false;
+		}
+	}
+
+	if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		LOG_ERROR("Failed to move edit list file into place at '{}' (error {}).", path, GetLastError());
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+bool SDFEditListFile::Read(const std::string& path, SDFEditList& editList)
+{
+	editList.Reset();
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		LOG_WARN("Failed to open edit list file '{}'.", path);
+		return false;
+	}
+
+	auto fail = [&path, &editList](const char* reason)
+		{
+			LOG_WARN("Edit list file '{}' cannot be read: {}", path, reason);
+			editList.Reset();
+			return false;
+		};
+
+	Header header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return fail("the file is too small to have a header.");
+	if (header.Magic != s_Magic)
+		return fail("it is not an edit list file.");
+	if (header.Version != s_Version)
+		return fail("it was written by a different version.");
+	if (header.EditCount > editList.GetMaxEdits())
+		return fail("the edit list does not have capacity for every edit.");
+
+	editList.SetEvaluationRange(header.EvaluationRange);
+
+	std::vector<SDFEditData> edits(s_ChunkEdits);
+	while (editList.GetEditCount() < header.EditCount)
+	{
+		ChunkHeader chunk;
+		if (!file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk)))
+			return fail("the file ends part way through.");
+
+		const UINT expectedCount = (std::min)(s_ChunkEdits, header.EditCount - editList.GetEditCount());
+		if (chunk.FirstEdit != editList.GetEditCount() || chunk.EditCount != expectedCount)
+			return fail("a chunk is out of order.");
+
+		const size_t size = chunk.EditCount * sizeof(SDFEditData);
+		if (!file.read(reinterpret_cast<char*>(edits.data()), static_cast<std::streamsize>(size)))
+			return fail("the file ends part way through.");
+		if (Hash::Bytes(edits.data(), size) != chunk.Hash)
+			return fail("a chunk does not match its hash.");
+
+		for (UINT i = 0; i < chunk.EditCount; i++)
+			editList.AddEditData(edits.at(i));
+	}
+
+	if (editList.GetHash() != header.ListHash)
+		return fail("the edits do not match the hash of the list.");
+
+	return true;
+}
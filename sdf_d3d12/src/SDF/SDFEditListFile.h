@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Core.h"
+#include "SDFEditList.h"
+
+
+// Edit lists stored on disk, so that a sculpt can be saved and loaded again
+// Edits are stored as the SDFEditData that is evaluated, so a list that is read back has the same hash as the list that was written.
+// The edits are written and read a chunk at a time, so a reader never holds more of the file than one chunk beyond the list itself.
+class SDFEditListFile
+{
+public:
+	inline static constexpr UINT s_Magic = 0x4C454453;	// "SDEL"
+	// Increment this whenever the layout of the file or of SDFEditData changes
+	inline static constexpr UINT s_Version = 1;
+	// Every chunk holds this many edits, except the last
+	inline static constexpr UINT s_ChunkEdits = 4096;
+
+	struct Header
+	{
+		UINT Magic;
+		UINT Version;
+		float EvaluationRange;
+		UINT EditCount;
+		// The hash of the whole list, checked once every chunk has been read
+		UINT64 ListHash;
+	};
+
+	struct ChunkHeader
+	{
+		UINT FirstEdit;
+		UINT EditCount;
+		UINT64 Hash;	// Of the edits in this chunk
+	};
+
+public:
+	// The file is written beside the path and then moved into place, so a reader never sees a partial file
+	static bool Write(const std::string& path, const SDFEditList& editList);
+
+	// Replaces the contents of the edit list with the edits in the file
+	// Returns false, and leaves the list empty, if the file is missing or malformed or the list does not have capacity for it
+	static bool Read(const std::string& path, SDFEditList& editList);
+};
@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "SDFEditListSoA.h"
+
+#include "SDF/CPU/SDFHelpers.h"
+
+
+void SDFEditListSoA::Reserve(UINT capacity)
+{
+	for (auto& bucket : m_ShapeBuckets)
+	{
+		bucket.reserve(capacity);
+	}
+
+	const UINT paddedCapacity = (capacity + s_StreamPadding - 1) / s_StreamPadding * s_StreamPadding;
+	if (paddedCapacity > m_Shapes.size())
+		Resize(paddedCapacity);
+}
+
+void SDFEditListSoA::Clear()
+{
+	for (UINT i = 0; i < m_Count; i++)
+	{
+		ClearElement(i);
+	}
+	for (auto& bucket : m_ShapeBuckets)
+	{
+		bucket.clear();
+	}
+	m_Count = 0;
+}
+
+
+void SDFEditListSoA::PushBack(const SDFEditData& edit)
+{
+	if (m_Count >= m_Shapes.size())
+	{
+		// Grow by whole packets so that the padding remains valid
+		Resize(static_cast<UINT>(m_Shapes.size()) * 2 + s_StreamPadding);
+	}
+
+	const UINT index = m_Count++;
+
+	m_InvRotation[0].at(index) = edit.InvRotation.x;
+	m_InvRotation[1].at(index) = edit.InvRotation.y;
+	m_InvRotation[2].at(index) = edit.InvRotation.z;
+	m_InvRotation[3].at(index) = edit.InvRotation.w;
+
+	m_InvTranslation[0].at(index) = edit.InvTranslation.x;
+	m_InvTranslation[1].at(index) = edit.InvTranslation.y;
+	m_InvTranslation[2].at(index) = edit.InvTranslation.z;
+
+	m_Scale.at(index) = edit.Scale;
+
+	m_ShapeParams[0].at(index) = edit.ShapeParams.x;
+	m_ShapeParams[1].at(index) = edit.ShapeParams.y;
+	m_ShapeParams[2].at(index) = edit.ShapeParams.z;
+	m_ShapeParams[3].at(index) = edit.ShapeParams.w;
+
+	m_BlendingRange.at(index) = edit.BlendingRange;
+
+	const SDFShape shape = SDFHelpers::GetShape(edit.EditParams);
+	m_Shapes.at(index) = static_cast<UINT8>(shape);
+	m_Operations.at(index) = static_cast<UINT8>(SDFHelpers::GetOperation(edit.EditParams));
+	m_Materials.at(index) = static_cast<UINT8>(SDFHelpers::GetMaterialTableIndex(edit.EditParams));
+
+	if (shape < s_ShapeCount)
+		m_ShapeBuckets.at(shape).push_back(index);
+}
+
+void SDFEditListSoA::PopBack()
+{
+	ASSERT(m_Count > 0, "Empty edit list!");
+
+	const UINT index = --m_Count;
+
+	// Edits are only ever removed from the back, so they are also the last edit of their shape
+	const UINT shape = m_Shapes.at(index);
+	if (shape < s_ShapeCount)
+	{
+		auto& bucket = m_ShapeBuckets.at(shape);
+		ASSERT(!bucket.empty() && bucket.back() == index, "Shape bucket is out of sync with the edit list!");
+		bucket.pop_back();
+	}
+
+	ClearElement(index);
+}
+
+
+void SDFEditListSoA::Resize(UINT size)
+{
+	ASSERT(size % s_StreamPadding == 0, "Streams must be a whole number of packets!");
+
+	const UINT oldSize = static_cast<UINT>(m_Shapes.size());
+
+	for (auto& stream : m_InvRotation)
+		stream.resize(size);
+	for (auto& stream : m_InvTranslation)
+		stream.resize(size);
+	m_Scale.resize(size);
+	for (auto& stream : m_ShapeParams)
+		stream.resize(size);
+	m_BlendingRange.resize(size);
+
+	m_Shapes.resize(size);
+	m_Operations.resize(size);
+	m_Materials.resize(size);
+
+	for (UINT i = oldSize; i < size; i++)
+	{
+		ClearElement(i);
+	}
+}
+
+void SDFEditListSoA::ClearElement(UINT index)
+{
+	// Identity transform with unit scale, so that evaluating padding is harmless
+	m_InvRotation[0].at(index) = 0.0f;
+	m_InvRotation[1].at(index) = 0.0f;
+	m_InvRotation[2].at(index) = 0.0f;
+	m_InvRotation[3].at(index) = 1.0f;
+
+	m_InvTranslation[0].at(index) = 0.0f;
+	m_InvTranslation[1].at(index) = 0.0f;
+	m_InvTranslation[2].at(index) = 0.0f;
+
+	m_Scale.at(index) = 1.0f;
+
+	for (auto& stream : m_ShapeParams)
+		stream.at(index) = 0.0f;
+	m_BlendingRange.at(index) = 0.0f;
+
+	m_Shapes.at(index) = SDF_SHAPE_SPHERE;
+	m_Operations.at(index) = SDF_OP_UNION;
+	m_Materials.at(index) = 0;
+}
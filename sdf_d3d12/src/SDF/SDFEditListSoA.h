@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Core.h"
+#include "Framework/AlignedAllocator.h"
+#include "HlslCompat/ComputeHlslCompat.h"
+
+
+// A structure-of-arrays mirror of the edits in an SDFEditList
+// Each member of SDFEditData is kept in its own aligned stream, and the packed edit params are decoded up front,
+// so that CPU loops over edits can load whole packets of edits instead of gathering from the array of structs.
+// Streams are padded to a multiple of s_StreamPadding with an identity edit, so a packet never reads out of bounds.
+class SDFEditListSoA
+{
+public:
+	inline static constexpr UINT s_Alignment = 64;
+	inline static constexpr UINT s_StreamPadding = 16;
+	inline static constexpr UINT s_ShapeCount = SDF_SHAPE_FRACTAL + 1;
+
+	template<typename T>
+	using Stream = std::vector<T, AlignedAllocator<T, s_Alignment>>;
+
+public:
+	SDFEditListSoA() = default;
+	~SDFEditListSoA() = default;
+
+	DEFAULT_COPY(SDFEditListSoA)
+	DEFAULT_MOVE(SDFEditListSoA)
+
+	void Reserve(UINT capacity);
+	void Clear();
+
+	void PushBack(const SDFEditData& edit);
+	void PopBack();
+
+	// Getters
+	inline UINT GetCount() const { return m_Count; }
+	// The count rounded up to a whole number of packets
+	inline UINT GetPaddedCount() const { return (m_Count + s_StreamPadding - 1) / s_StreamPadding * s_StreamPadding; }
+
+	// Each getter takes the component of the vector (x = 0, y = 1, ...)
+	inline const float* GetInvRotation(UINT component) const { return m_InvRotation[component].data(); }
+	inline const float* GetInvTranslation(UINT component) const { return m_InvTranslation[component].data(); }
+	inline const float* GetShapeParams(UINT component) const { return m_ShapeParams[component].data(); }
+	inline const float* GetScale() const { return m_Scale.data(); }
+	inline const float* GetBlendingRange() const { return m_BlendingRange.data(); }
+
+	// Decoded edit params
+	inline const UINT8* GetShapes() const { return m_Shapes.data(); }
+	inline const UINT8* GetOperations() const { return m_Operations.data(); }
+	inline const UINT8* GetMaterials() const { return m_Materials.data(); }
+
+	inline SDFShape GetShape(UINT index) const { return static_cast<SDFShape>(m_Shapes.at(index)); }
+	inline SDFOperation GetOperation(UINT index) const { return static_cast<SDFOperation>(m_Operations.at(index)); }
+	inline bool IsSmooth(UINT index) const { return m_Operations.at(index) & 2; }
+
+	// The indices of every edit of a shape, in ascending order
+	inline const std::vector<UINT>& GetShapeBucket(SDFShape shape) const { return m_ShapeBuckets.at(shape); }
+
+private:
+	void Resize(UINT size);
+	// Write an identity edit into the padding
+	void ClearElement(UINT index);
+
+private:
+	UINT m_Count = 0;
+
+	Stream<float> m_InvRotation[4];
+	Stream<float> m_InvTranslation[3];
+	Stream<float> m_Scale;
+	Stream<float> m_ShapeParams[4];
+	Stream<float> m_BlendingRange;
+
+	Stream<UINT8> m_Shapes;
+	Stream<UINT8> m_Operations;
+	Stream<UINT8> m_Materials;
+
+	std::array<std::vector<UINT>, s_ShapeCount> m_ShapeBuckets;
+};
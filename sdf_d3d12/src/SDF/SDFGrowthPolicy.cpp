@@ -0,0 +1,89 @@
+#include "pch.h"
+#include "SDFGrowthPolicy.h"
+
+#include <cmath>
+
+
+SDFGrowthPolicy::Settings SDFGrowthPolicy::GetLegacySettings()
+{
+	Settings settings;
+	settings.GrowthHeadroom = 0.0f;
+	settings.ShrinkThreshold = 0.0f;
+	settings.ReuseSlack = 0.0f;
+	return settings;
+}
+
+
+SDFGrowthPolicy::SDFGrowthPolicy(const Settings& settings)
+	: m_Settings(settings)
+{
+}
+
+
+UINT64 SDFGrowthPolicy::Update(State& state, UINT64 required) const
+{
+	auto withHeadroom = [this](UINT64 capacity)
+		{
+			return capacity + static_cast<UINT64>(std::ceil(static_cast<double>(capacity) * m_Settings.GrowthHeadroom));
+		};
+
+	if (required > state.Capacity)
+	{
+		state.UnderusedCount = 0;
+		return withHeadroom(required);
+	}
+
+	if (static_cast<double>(required) < static_cast<double>(state.Capacity) * m_Settings.ShrinkThreshold)
+	{
+		state.UnderusedCount++;
+		if (state.UnderusedCount >= m_Settings.ShrinkDelay)
+		{
+			state.UnderusedCount = 0;
+			return withHeadroom(required);
+		}
+	}
+	else
+	{
+		state.UnderusedCount = 0;
+	}
+
+	return state.Capacity;
+}
+
+int SDFGrowthPolicy::FindReusable(const std::vector<UINT64>& retiredCapacities, UINT64 required, UINT64 targetCapacity) const
+{
+	const double maxCapacity = static_cast<double>(targetCapacity) * m_Settings.ReuseSlack;
+
+	int best = -1;
+	for (size_t i = 0; i < retiredCapacities.size(); i++)
+	{
+		const UINT64 capacity = retiredCapacities.at(i);
+		if (capacity < required || static_cast<double>(capacity) > maxCapacity)
+			continue;
+
+		if (best < 0 || capacity < retiredCapacities.at(best))
+			best = static_cast<int>(i);
+	}
+	return best;
+}
+
+
+XMUINT3 SDFGrowthPolicy::CalculateBrickPoolDimensions(UINT brickCount)
+{
+	const UINT64 count = (std::max)(brickCount, 1u);
+
+	// The smallest cube that holds every brick
+	UINT side = static_cast<UINT>(std::ceil(std::cbrt(static_cast<double>(count))));
+	while (static_cast<UINT64>(side) * side * side < count)
+		side++;
+	while (side > 1 && static_cast<UINT64>(side - 1) * (side - 1) * (side - 1) >= count)
+		side--;
+
+	// Shortening axes wastes less of the pool, if the bricks still fit
+	const UINT64 shorter = side - 1;
+	if (static_cast<UINT64>(side) * shorter * shorter >= count)
+		return { side, static_cast<UINT>(shorter), static_cast<UINT>(shorter) };
+	if (static_cast<UINT64>(side) * side * shorter >= count)
+		return { side, side, static_cast<UINT>(shorter) };
+	return { side, side, side };
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Core.h"
+
+
+// Decides when the resources of an SDF object are reallocated, and how large they become
+// Resources grow with headroom so that an object that grows slowly is not reallocated every bake,
+// and only shrink once they have been underused for a number of consecutive bakes,
+// so an object whose size oscillates around a boundary keeps the larger allocation.
+// This makes no graphics API calls, so it can be driven with recorded sizes on the CPU.
+class SDFGrowthPolicy
+{
+public:
+	struct Settings
+	{
+		// Extra capacity allocated when a resource grows, as a fraction of the required capacity
+		float GrowthHeadroom = 0.25f;
+		// A resource is shrunk once the required capacity has stayed below this fraction of its capacity
+		// for ShrinkDelay consecutive updates. A threshold of 0 never shrinks
+		float ShrinkThreshold = 0.5f;
+		UINT ShrinkDelay = 16;
+		// A retired resource can be reused if it fits the required capacity and is no more than this many times the target capacity
+		float ReuseSlack = 1.5f;
+	};
+
+	// The policy's view of one resource
+	struct State
+	{
+		UINT64 Capacity = 0;
+		UINT UnderusedCount = 0;
+	};
+
+	// The policy the factory used before growth was amortized: grow to fit exactly, and never shrink
+	static Settings GetLegacySettings();
+
+public:
+	SDFGrowthPolicy() = default;
+	SDFGrowthPolicy(const Settings& settings);
+
+	inline const Settings& GetSettings() const { return m_Settings; }
+	inline void SetSettings(const Settings& settings) { m_Settings = settings; }
+
+	// Returns the capacity the resource should be allocated with to hold the required count
+	// This is the current capacity unless the resource must grow, or has been underused for long enough to shrink.
+	// The state's capacity is not changed, as the allocation may be larger than requested
+	UINT64 Update(State& state, UINT64 required) const;
+
+	// Returns the index of the smallest retired capacity that can be reused, or -1 if there is none
+	int FindReusable(const std::vector<UINT64>& retiredCapacities, UINT64 required, UINT64 targetCapacity) const;
+
+	// The dimensions of a brick pool, in bricks, that holds at least brickCount bricks
+	// Pools are kept close to cubes, but may be one brick shorter on up to two axes to waste less space
+	static XMUINT3 CalculateBrickPoolDimensions(UINT brickCount);
+
+private:
+	Settings m_Settings;
+};
@@ -15,6 +15,10 @@ SDFObject::SDFObject(float brickSize, UINT brickCapacity, D3D12_RAYTRACING_GEOME
 
 	m_NextRebuildBrickSize = brickSize;
 
+	SDFGrowthPolicy::Settings indexSettings;
+	indexSettings.GrowthHeadroom = 0.5f;
+	m_IndexBufferPolicy.SetSettings(indexSettings);
+
 	const auto descriptorHeap = g_D3DGraphicsContext->GetSRVHeap();
 
 	for (auto& resources : m_Resources)
@@ -38,18 +42,135 @@ SDFObject::~SDFObject()
 		resources.ResourceViews.Free();
 }
 
-void SDFObject::AllocateOptimalResources(UINT brickCount, float brickSize, UINT64 indexCount, ResourceGroup res)
+void SDFObject::AllocateOptimalResources(UINT brickCount, float brickSize, float evalSpaceSize, UINT64 indexCount, ResourceGroup res)
+{
+	ASSERT(brickCount > 0, "SDF Object does not have any bricks!");
+
+	auto& resources = GetResources(res);
+	resources.BrickSize = brickSize;
+	resources.EvalSpaceSize = evalSpaceSize;
+	resources.PoolPlacement = m_NextBrickPoolPlacement;
+	resources.IndexCount = indexCount;
+	resources.ReleasedIndexCount = 0;
+	resources.SharedPoolSlots = false;
+
+	// The brick pool is allocated first, as the brick and AABB buffers are sized to fill it
+	AllocateOptimalBrickPool(brickCount, res);
+	AllocateOptimalAABBBuffer(GetBrickPoolCapacity(res), res);
+	AllocateOptimalBrickBuffer(GetBrickPoolCapacity(res), res);
+	AllocateOptimalIndexBuffer(indexCount, res);
+}
+
+void SDFObject::AllocateResourcesForBake(const XMUINT3& brickPoolDimensions, BrickPoolPlacement::Value placement, UINT brickCount, float brickSize, float evalSpaceSize, UINT64 indexCount, bool sharedPoolSlots, ResourceGroup res)
+{
+	ASSERT(brickCount > 0, "SDF Object does not have any bricks!");
+
+	auto& resources = GetResources(res);
+	resources.BrickSize = brickSize;
+	resources.EvalSpaceSize = evalSpaceSize;
+	resources.PoolPlacement = placement;
+	resources.IndexCount = indexCount;
+	resources.ReleasedIndexCount = 0;
+	resources.SharedPoolSlots = sharedPoolSlots;
+	resources.BrickCount = brickCount;
+
+	const auto& dims = resources.BrickPoolDimensions;
+	if (resources.BrickPool && (dims.x != brickPoolDimensions.x || dims.y != brickPoolDimensions.y || dims.z != brickPoolDimensions.z))
+	{
+		RetireBrickPool(std::move(resources.BrickPool), resources.BrickPoolDimensions);
+		resources.BrickPool = nullptr;
+	}
+	resources.BrickPoolDimensions = brickPoolDimensions;
+	resources.BrickPoolGrowth.Capacity = GetBrickPoolCapacity(res);
+	resources.BrickPoolGrowth.UnderusedCount = 0;
+	CreateBrickPool(res);
+
+	// Deduplicated bricks share pool slots, so there can be more bricks than the pool holds
+	// Otherwise the buffers are sized to fill the pool as they are for a bake, so that incremental bakes have room to append
+	const UINT bufferCapacity = (std::max)(brickCount, GetBrickPoolCapacity(res));
+	AllocateOptimalAABBBuffer(bufferCapacity, res);
+	AllocateOptimalBrickBuffer(bufferCapacity, res);
+	AllocateOptimalIndexBuffer(indexCount, res);
+}
+
+void SDFObject::AllocateResourcesForPaging(const XMUINT3& brickPoolDimensions, UINT brickCount, float brickSize, float evalSpaceSize, ResourceGroup res)
 {
 	ASSERT(brickCount > 0, "SDF Object does not have any bricks!");
 
-	GetResources(res).BrickSize = brickSize;
+	auto& resources = GetResources(res);
+	resources.BrickSize = brickSize;
+	resources.EvalSpaceSize = evalSpaceSize;
+	resources.PoolPlacement = BrickPoolPlacement::Linear;
+	resources.IndexCount = 0;
+	resources.ReleasedIndexCount = 0;
+	// Slots are handed out by the residency of the pages, not by a bake
+	resources.SharedPoolSlots = true;
+	resources.BrickCount = brickCount;
+
+	const auto& dims = resources.BrickPoolDimensions;
+	if (resources.BrickPool && (dims.x != brickPoolDimensions.x || dims.y != brickPoolDimensions.y || dims.z != brickPoolDimensions.z))
+	{
+		RetireBrickPool(std::move(resources.BrickPool), resources.BrickPoolDimensions);
+		resources.BrickPool = nullptr;
+	}
+	resources.BrickPoolDimensions = brickPoolDimensions;
+	resources.BrickPoolGrowth.Capacity = GetBrickPoolCapacity(res);
+	resources.BrickPoolGrowth.UnderusedCount = 0;
+	CreateBrickPool(res);
 
+	// Paged objects are never baked into, so they need no edit indices
 	AllocateOptimalAABBBuffer(brickCount, res);
 	AllocateOptimalBrickBuffer(brickCount, res);
-	AllocateOptimalBrickPool(brickCount, res);
-	AllocateOptimalIndexBuffer(indexCount, res);
+	AllocateOptimalIndexBuffer(0, res);
+}
+
+
+void SDFObject::InvalidateRegion(const SDFDirtyRegion& region)
+{
+	std::lock_guard lockGuard(m_StaleRegionMutex);
+	for (auto& resources : m_Resources)
+	{
+		resources.StaleRegion.Union(region);
+	}
+}
+
+SDFDirtyRegion SDFObject::TakeStaleRegion(ResourceGroup res)
+{
+	std::lock_guard lockGuard(m_StaleRegionMutex);
+
+	auto& resources = GetResources(res);
+	SDFDirtyRegion region = resources.StaleRegion;
+	resources.StaleRegion.Clear();
+	return region;
 }
 
+bool SDFObject::WaitForResourcesStateChange(ResourceGroup res, ResourceState state, UINT timeoutMs)
+{
+	std::unique_lock lock(m_StateMutex);
+	return m_StateCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this, res, state]()
+		{
+			return GetResourcesState(res) != state;
+		});
+}
+
+void SDFObject::SetIncrementalBakeResult(UINT brickCount, UINT64 indexCount, UINT64 releasedIndexCount, ResourceGroup res)
+{
+	ASSERT(brickCount <= GetBrickPoolCapacity(res), "Incremental bake overflowed the brick pool!");
+	ASSERT(indexCount <= GetIndexBufferCapacity(res), "Incremental bake overflowed the index buffer!");
+
+	auto& resources = GetResources(res);
+	resources.BrickCount = brickCount;
+	resources.IndexCount = indexCount;
+	resources.ReleasedIndexCount = releasedIndexCount;
+}
+
+
+XMUINT3 SDFObject::CalculateBrickPoolDimensions(UINT brickCount)
+{
+	// Calculate dimensions for the brick pool such that it contains at least brickCount entries
+	// but is also a useful shape
+	return SDFGrowthPolicy::CalculateBrickPoolDimensions(brickCount);
+}
 
 const XMUINT3& SDFObject::GetBrickPoolDimensions(ResourceGroup res) const
 {
@@ -73,6 +194,13 @@ UINT SDFObject::GetBrickPoolCapacity(ResourceGroup res) const
 }
 
 
+UINT64 SDFObject::GetIndexBufferCapacity(ResourceGroup res) const
+{
+	const auto& indexBuffer = GetResources(res).IndexBuffer;
+	return indexBuffer.GetResource() ? indexBuffer.GetResource()->GetDesc().Width / sizeof(UINT) : 0;
+}
+
+
 UINT SDFObject::GetMaterialID(UINT slot) const
 {
 	ASSERT(slot < s_MaxMaterialsPerObject, "Invalid material slot.");
@@ -87,6 +215,14 @@ void SDFObject::SetMaterial(const Material* material, UINT slot)
 	m_IsLocalArgsDirty = true;
 }
 
+void SDFObject::SetMaterialID(UINT materialID, UINT slot)
+{
+	ASSERT(slot < s_MaxMaterialsPerObject, "Invalid material slot.");
+	m_MaterialTable[slot] = materialID;
+
+	m_IsLocalArgsDirty = true;
+}
+
 
 UINT64 SDFObject::GetBrickPoolSizeBytes(bool distOnly) const
 {
@@ -154,6 +290,21 @@ UINT64 SDFObject::GetTotalMemoryUsageBytes(bool distOnly) const
 	return totalSize;
 }
 
+UINT64 SDFObject::GetRetiredMemoryUsageBytes() const
+{
+	UINT64 totalSize = 0;
+	const auto device = g_D3DGraphicsContext->GetDevice();
+
+	for (const auto& retired : m_RetiredBrickPools)
+	{
+		const auto desc = retired.BrickPool->GetDesc();
+		UINT64 copyableFootprint;
+		device->GetCopyableFootprints(&desc, 0, 1, 0, nullptr, nullptr, nullptr, &copyableFootprint);
+		totalSize += copyableFootprint;
+	}
+	return totalSize;
+}
+
 
 
 void SDFObject::AllocateOptimalAABBBuffer(UINT brickCount, ResourceGroup res)
@@ -162,7 +313,8 @@ void SDFObject::AllocateOptimalAABBBuffer(UINT brickCount, ResourceGroup res)
 
 	const auto device = g_D3DGraphicsContext->GetDevice();
 
-	if (resources.AABBBuffer.GetElementCount() < brickCount)
+	// The buffer matches the capacity of the brick pool, so it shrinks along with it
+	if (resources.AABBBuffer.GetElementCount() != brickCount)
 	{
 		resources.AABBBuffer.Allocate(device, brickCount, D3D12_RESOURCE_STATE_COMMON, L"SDF Object AABB Buffer");
 	}
@@ -174,7 +326,7 @@ void SDFObject::AllocateOptimalBrickBuffer(UINT brickCount, ResourceGroup res)
 
 	const auto device = g_D3DGraphicsContext->GetDevice();
 
-	if (resources.BrickBuffer.GetElementCount() < brickCount)
+	if (resources.BrickBuffer.GetElementCount() != brickCount)
 	{
 		resources.BrickBuffer.Allocate(device, brickCount, D3D12_RESOURCE_STATE_COMMON, L"SDF Object Brick Buffer");
 	}
@@ -184,37 +336,72 @@ void SDFObject::AllocateOptimalBrickPool(UINT brickCount, ResourceGroup res)
 {
 	auto& resources = GetResources(res);
 
+	resources.BrickCount = brickCount;
+
+	const UINT64 currentCapacity = resources.BrickPool ? GetBrickPoolCapacity(res) : 0;
+	resources.BrickPoolGrowth.Capacity = currentCapacity;
+	const UINT64 targetCapacity = m_BrickPoolPolicy.Update(resources.BrickPoolGrowth, brickCount);
+	if (resources.BrickPool && targetCapacity == currentCapacity)
+	{
+		// Existing brick pool is suitable, no allocation required
+		return;
+	}
+
 	if (resources.BrickPool)
 	{
-		// Brick pool has already been allocated
-		// A larger brick pool might be required
-		if (brickCount > GetBrickPoolCapacity(res))
+		if (targetCapacity > currentCapacity)
 		{
-			LOG_INFO("Brick pool is too small - reallocation required!");
+			LOG_TRACE("Brick pool is too small - reallocation required!");
 		}
 		else
 		{
-			// Existing brick pool is large enough, no allocation required
-			// Just update brick count
-			resources.BrickCount = brickCount;
-			return;
+			LOG_TRACE("Brick pool has been underused - shrinking.");
+			m_AllocationStatistics.BrickPoolShrinks++;
 		}
 	}
 
-	const auto device = g_D3DGraphicsContext->GetDevice();
+	// A pool retired by either resource group may already be a suitable size
+	std::vector<UINT64> retiredCapacities;
+	retiredCapacities.reserve(m_RetiredBrickPools.size());
+	for (const auto& retired : m_RetiredBrickPools)
+	{
+		retiredCapacities.push_back(static_cast<UINT64>(retired.Dimensions.x) * retired.Dimensions.y * retired.Dimensions.z);
+	}
+	const int reusable = m_BrickPoolPolicy.FindReusable(retiredCapacities, brickCount, targetCapacity);
 
-	resources.BrickCount = brickCount;
+	// The current pool is retired after searching, so that it is not immediately reused
+	RetiredBrickPool previous{ std::move(resources.BrickPool), resources.BrickPoolDimensions };
 
-	// Calculate dimensions for the brick pool such that it contains at least m_BrickCount entries
-	// but is also a useful shape
-	UINT nextCube = static_cast<UINT>(std::floor(std::cbrtf(static_cast<float>(resources.BrickCount)))) + 1;
-	resources.BrickPoolDimensions = { nextCube, nextCube, nextCube };
+	if (reusable >= 0)
+	{
+		resources.BrickPool = std::move(m_RetiredBrickPools.at(reusable).BrickPool);
+		resources.BrickPoolDimensions = m_RetiredBrickPools.at(reusable).Dimensions;
+		m_RetiredBrickPools.erase(m_RetiredBrickPools.begin() + reusable);
+		m_AllocationStatistics.BrickPoolReuses++;
+	}
+	else
+	{
+		resources.BrickPoolDimensions = CalculateBrickPoolDimensions(static_cast<UINT>((std::min)(targetCapacity, static_cast<UINT64>(UINT_MAX))));
+		resources.BrickPool = nullptr;
+	}
+
+	RetireBrickPool(std::move(previous.BrickPool), previous.Dimensions);
 
-	//UINT nextPow2 = 1U << (static_cast<UINT>(std::floor(log2(resources.BrickCount) / 3.0f)) + 1);
-	//resources.BrickPoolDimensions = { nextPow2, nextPow2, nextPow2 };
+	resources.BrickPoolGrowth.Capacity = GetBrickPoolCapacity(res);
+	CreateBrickPool(res);
+}
+
+void SDFObject::CreateBrickPool(ResourceGroup res)
+{
+	auto& resources = GetResources(res);
+
+	const auto device = g_D3DGraphicsContext->GetDevice();
 
 	// Create brick pool resource
+	if (!resources.BrickPool)
 	{
+		m_AllocationStatistics.BrickPoolAllocations++;
+
 		const auto heap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
 		const CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex3D(
 			DXGI_FORMAT_R8G8B8A8_SNORM,
@@ -242,13 +429,29 @@ void SDFObject::AllocateOptimalBrickPool(UINT brickCount, ResourceGroup res)
 	}
 }
 
+void SDFObject::RetireBrickPool(ComPtr<ID3D12Resource>&& brickPool, const XMUINT3& dimensions)
+{
+	if (!brickPool || m_BrickPoolPolicy.GetSettings().ReuseSlack <= 0.0f)
+		return;
+
+	m_RetiredBrickPools.push_back({ std::move(brickPool), dimensions });
+	while (m_RetiredBrickPools.size() > s_MaxRetiredBrickPools)
+	{
+		m_RetiredBrickPools.pop_front();
+	}
+}
+
 void SDFObject::AllocateOptimalIndexBuffer(UINT64 indexCount, ResourceGroup res)
 {
 	auto& resources = GetResources(res);
 
-	const UINT64 width = indexCount * sizeof(UINT16);
-	if (!resources.IndexBuffer.GetResource() || width > resources.IndexBuffer.GetResource()->GetDesc().Width)
+	resources.IndexBufferGrowth.Capacity = GetIndexBufferCapacity(res);
+	const UINT64 capacity = m_IndexBufferPolicy.Update(resources.IndexBufferGrowth, indexCount);
+	if (!resources.IndexBuffer.GetResource() || capacity != resources.IndexBufferGrowth.Capacity)
 	{
-		resources.IndexBuffer.Allocate(g_D3DGraphicsContext->GetDevice(), width, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"SDF Object Index Buffer");
+		// Leave room for incremental bakes to append indices
+		resources.IndexBuffer.Allocate(g_D3DGraphicsContext->GetDevice(), (std::max)(capacity, 1ull) * sizeof(UINT), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, L"SDF Object Index Buffer");
+		resources.IndexBufferGrowth.Capacity = GetIndexBufferCapacity(res);
+		m_AllocationStatistics.IndexBufferAllocations++;
 	}
 }
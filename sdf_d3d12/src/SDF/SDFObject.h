@@ -4,6 +4,12 @@
 #include "Renderer/Memory/MemoryAllocator.h"
 #include "HlslCompat/StructureHlslCompat.h"
 #include "Renderer/Buffer/StructuredBuffer.h"
+#include "SDFDirtyRegion.h"
+#include "SDFGrowthPolicy.h"
+#include "SDF/CPU/BrickHelpers.h"
+
+#include <mutex>
+#include <condition_variable>
 
 
 using Microsoft::WRL::ComPtr;
@@ -45,7 +51,14 @@ public:
 	DEFAULT_MOVE(SDFObject)
 
 	// Brick Pool
-	void AllocateOptimalResources(UINT brickCount, float brickSize, UINT64 indexCount, ResourceGroup res);
+	void AllocateOptimalResources(UINT brickCount, float brickSize, float evalSpaceSize, UINT64 indexCount, ResourceGroup res);
+	// Allocates resources for a bake that was made elsewhere, such as one loaded from a file
+	// The brick pool has exactly the given dimensions, as the positions of bricks within the pool depend on them
+	// Deduplicated bricks share pool slots, so there may be more bricks than the pool holds
+	void AllocateResourcesForBake(const XMUINT3& brickPoolDimensions, BrickPoolPlacement::Value placement, UINT brickCount, float brickSize, float evalSpaceSize, UINT64 indexCount, bool sharedPoolSlots, ResourceGroup res);
+	// Allocates resources for an object whose bricks are streamed into the brick pool a page at a time
+	// There are more bricks than the pool can hold, so the brick and AABB buffers are sized by the brick count instead
+	void AllocateResourcesForPaging(const XMUINT3& brickPoolDimensions, UINT brickCount, float brickSize, float evalSpaceSize, ResourceGroup res);
 	inline ID3D12Resource* GetBrickPool(ResourceGroup res) const { return GetResources(res).BrickPool.Get(); }
 
 	inline float GetBrickSize(ResourceGroup res) const { return GetResources(res).BrickSize; }
@@ -54,7 +67,15 @@ public:
 	inline float GetNextRebuildBrickSize() const { return m_NextRebuildBrickSize; }
 	inline void SetNextRebuildBrickSize(float size) { m_NextRebuildBrickSize = size; }
 
+	// How slots are placed in the brick pool of a resource group
+	// Changing the placement takes effect on the next full bake of each group, as every brick must then be evaluated again
+	inline BrickPoolPlacement::Value GetBrickPoolPlacement(ResourceGroup res) const { return GetResources(res).PoolPlacement; }
+	inline BrickPoolPlacement::Value GetNextBrickPoolPlacement() const { return m_NextBrickPoolPlacement; }
+	inline void SetNextBrickPoolPlacement(BrickPoolPlacement::Value placement) { m_NextBrickPoolPlacement = placement; }
+
 	inline UINT GetBrickCount(ResourceGroup res) const { return GetResources(res).BrickCount; }
+	// The dimensions (in bricks) of the brick pool that would be allocated for brickCount bricks
+	static XMUINT3 CalculateBrickPoolDimensions(UINT brickCount);
 	const XMUINT3& GetBrickPoolDimensions(ResourceGroup res) const;
 	XMUINT3 GetBrickPoolResolution(ResourceGroup res) const;
 	UINT GetBrickPoolCapacity(ResourceGroup res) const;
@@ -70,6 +91,28 @@ public:
 
 	inline ID3D12Resource* GetIndexBuffer(ResourceGroup res) const { return GetResources(res).IndexBuffer.GetResource(); }
 	inline D3D12_GPU_VIRTUAL_ADDRESS GetIndexBufferAddress(ResourceGroup res) const { return GetResources(res).IndexBuffer.GetAddress(); }
+	UINT64 GetIndexBufferCapacity(ResourceGroup res) const;
+
+	// Incremental baking
+
+	// Marks a region of both resource sets as no longer matching the edit list
+	void InvalidateRegion(const SDFDirtyRegion& region);
+	// Returns the region of a set that must be rebuilt, and marks the set as up to date
+	// Regions invalidated after this call will be rebuilt by the next bake into the set
+	SDFDirtyRegion TakeStaleRegion(ResourceGroup res);
+
+	inline float GetEvalSpaceSize(ResourceGroup res) const { return GetResources(res).EvalSpaceSize; }
+	// The end of the used range of the index buffer
+	inline UINT64 GetIndexCount(ResourceGroup res) const { return GetResources(res).IndexCount; }
+	// The number of indices in the used range that are no longer referenced by any brick
+	inline UINT64 GetReleasedIndexCount(ResourceGroup res) const { return GetResources(res).ReleasedIndexCount; }
+	// Whether a pool slot of the set may be used by more than one brick, or by bricks that a bake did not build
+	// An incremental bake releases and rewrites the slots of the bricks it rebuilds, so it would change bricks outside of its region
+	inline bool HasSharedPoolSlots(ResourceGroup res) const { return GetResources(res).SharedPoolSlots; }
+
+	// Records the bricks and indices that an incremental bake added to a set
+	// The brick count must fit within the existing brick pool
+	void SetIncrementalBakeResult(UINT brickCount, UINT64 indexCount, UINT64 releasedIndexCount, ResourceGroup res);
 
 	// Get Resource Views
 	inline D3D12_GPU_DESCRIPTOR_HANDLE GetDescriptor(ResourceGroup res, SDFObjectDescriptor descriptor) const { return GetResources(res).ResourceViews.GetGPUHandle(descriptor); }
@@ -80,6 +123,7 @@ public:
 	// Materials
 	UINT GetMaterialID(UINT slot) const;
 	void SetMaterial(const Material* material, UINT slot);
+	void SetMaterialID(UINT materialID, UINT slot);
 
 	inline static UINT GetMaxMaterialsPerObject() { return s_MaxMaterialsPerObject; }
 	const UINT* GetMaterialTablePtr() const { return m_MaterialTable.data(); }
@@ -103,6 +147,22 @@ public:
 	UINT64 GetIndexBufferSizeBytes() const;
 
 	UINT64 GetTotalMemoryUsageBytes(bool distOnly = false) const;
+	// Brick pools that were replaced and are kept to be reused by either resource group
+	UINT64 GetRetiredMemoryUsageBytes() const;
+
+	// Resource growth
+	struct AllocationStatistics
+	{
+		UINT BrickPoolAllocations = 0;
+		UINT BrickPoolReuses = 0;
+		UINT BrickPoolShrinks = 0;
+		UINT IndexBufferAllocations = 0;
+	};
+	inline const AllocationStatistics& GetAllocationStatistics() const { return m_AllocationStatistics; }
+
+	// Should only be changed while the object is not being baked
+	inline void SetBrickPoolGrowthPolicy(const SDFGrowthPolicy::Settings& settings) { m_BrickPoolPolicy.SetSettings(settings); }
+	inline const SDFGrowthPolicy::Settings& GetBrickPoolGrowthPolicy() const { return m_BrickPoolPolicy.GetSettings(); }
 
 
 	// ASync construction
@@ -110,8 +170,12 @@ public:
 	// Flips which set are being rendered from, and which are being written to
 	void FlipResources()
 	{
-		m_ReadIndex = 1 - m_ReadIndex;
+		{
+			std::lock_guard lockGuard(m_StateMutex);
+			m_ReadIndex = 1 - m_ReadIndex;
+		}
 		m_IsLocalArgsDirty = true;
+		m_StateCondition.notify_all();
 	}
 	inline ResourceState GetResourcesState(ResourceGroup res)
 	{
@@ -119,8 +183,15 @@ public:
 	}
 	inline void SetResourceState(ResourceGroup res, ResourceState state)
 	{
-		m_ResourcesStates.at(res == RESOURCES_READ ? ReadIndex() : WriteIndex()) = state;
+		{
+			std::lock_guard lockGuard(m_StateMutex);
+			m_ResourcesStates.at(res == RESOURCES_READ ? ReadIndex() : WriteIndex()) = state;
+		}
+		m_StateCondition.notify_all();
 	}
+	// Sleeps until the resources leave the given state, or the timeout elapses
+	// Returns false on timeout
+	bool WaitForResourcesStateChange(ResourceGroup res, ResourceState state, UINT timeoutMs);
 	inline bool CheckResourceState(ResourceGroup res, ResourceState state)
 	{
 		const bool match = GetResourcesState(res) == state;
@@ -145,6 +216,11 @@ private:
 	void AllocateOptimalBrickPool(UINT brickCount, ResourceGroup res);
 	void AllocateOptimalIndexBuffer(UINT64 indexCount, ResourceGroup res);
 
+	// Creates the brick pool resource if the resource group does not have one, and its views
+	void CreateBrickPool(ResourceGroup res);
+	// Keeps a replaced brick pool so that it can be reused, if the growth policy allows it
+	void RetireBrickPool(ComPtr<ID3D12Resource>&& brickPool, const XMUINT3& dimensions);
+
 private:
 	// A complete set of resources that make up this object
 	struct Resources
@@ -164,18 +240,56 @@ private:
 		// Brick count/pool related properties are only pertinent to a specific set
 		UINT BrickCount = 0; // The number of bricks that actually make up this object
 		XMUINT3 BrickPoolDimensions = { 0, 0, 0 }; // The dimensions of the brick pool in number of bricks
+		BrickPoolPlacement::Value PoolPlacement = BrickPoolPlacement::Linear;
 
 		float BrickSize = 0.0f;
+		float EvalSpaceSize = 0.0f;
+
+		// Incremental bakes append indices, so the indices of released bricks are not reclaimed until the next full bake
+		UINT64 IndexCount = 0;
+		UINT64 ReleasedIndexCount = 0;
+
+		// Set for bakes made elsewhere that share slots, and for paged objects, so that they are only ever fully rebaked
+		bool SharedPoolSlots = false;
+
+		// The region that must be rebuilt before this set matches the most recent edit list
+		SDFDirtyRegion StaleRegion = SDFDirtyRegion::Everything();
+
+		SDFGrowthPolicy::State BrickPoolGrowth;
+		SDFGrowthPolicy::State IndexBufferGrowth;
 	};
 	std::array<Resources, 2> m_Resources;
 	// Which index is to be read from
 	// implies that 1 - m_ReadIndex is the index to write to
 	std::atomic<size_t> m_ReadIndex = 0;
 	std::array<std::atomic<ResourceState>, 2> m_ResourcesStates = { READY_COMPUTE, READY_COMPUTE };
+	// Used to wake the factory when the application changes the state of the resources
+	std::mutex m_StateMutex;
+	std::condition_variable m_StateCondition;
+	// Regions are invalidated by the application while the factory may be baking
+	std::mutex m_StaleRegionMutex;
 
 	float m_NextRebuildBrickSize = 0.0f;
+	BrickPoolPlacement::Value m_NextBrickPoolPlacement = BrickPoolPlacement::Linear;
 	UINT m_BrickCapacity = 0; // The maximum possible number of bricks
 
+	// Resource growth
+	SDFGrowthPolicy m_BrickPoolPolicy;
+	// Incremental bakes append indices, so index buffers are given more headroom
+	SDFGrowthPolicy m_IndexBufferPolicy;
+
+	// Brick pools replaced by either resource group, which are only ever written to by the factory
+	// A pool is retired from the write resources, so the GPU is not rendering from it
+	struct RetiredBrickPool
+	{
+		ComPtr<ID3D12Resource> BrickPool;
+		XMUINT3 Dimensions;
+	};
+	inline static constexpr size_t s_MaxRetiredBrickPools = 2;
+	std::deque<RetiredBrickPool> m_RetiredBrickPools;
+
+	AllocationStatistics m_AllocationStatistics;
+
 	// Materials
 	inline static constexpr UINT s_MaxMaterialsPerObject = 4;
 	// Store a table of material IDs